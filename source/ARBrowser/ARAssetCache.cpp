@@ -0,0 +1,144 @@
+//
+//  ARAssetCache.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARAssetCache.h"
+
+#include <cstdlib>
+#include <climits>
+
+namespace ARBrowser {
+	AssetCache::Asset::~Asset () {
+	}
+	
+	AssetCache::AssetCache (std::size_t budget) : m_residentSize(0), m_budget(budget), m_hits(0), m_misses(0), m_evictions(0) {
+	}
+	
+	AssetCache::~AssetCache () {
+	}
+	
+	std::shared_ptr<AssetCache::Asset> AssetCache::lookup (const std::string & key) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		auto i = m_index.find(key);
+		
+		if (i == m_index.end()) {
+			m_misses += 1;
+			
+			return nullptr;
+		}
+		
+		m_hits += 1;
+		
+		// Move to the front:
+		m_entries.splice(m_entries.begin(), m_entries, i->second);
+		
+		return i->second->asset;
+	}
+	
+	std::shared_ptr<AssetCache::Asset> AssetCache::insert (const std::string & key, std::shared_ptr<Asset> asset) {
+		std::list<std::shared_ptr<Asset>> evicted;
+		
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			
+			auto i = m_index.find(key);
+			
+			if (i != m_index.end()) {
+				m_entries.splice(m_entries.begin(), m_entries, i->second);
+				
+				return i->second->asset;
+			}
+			
+			Entry entry = {key, asset, asset->residentSize()};
+			m_entries.push_front(entry);
+			m_index[key] = m_entries.begin();
+			
+			m_residentSize += entry.size;
+			
+			evict(evicted);
+		}
+		
+		// Evicted assets are released here, outside the lock, since their destructors may be expensive.
+		return asset;
+	}
+	
+	void AssetCache::evict (std::list<std::shared_ptr<Asset>> & evicted) {
+		if (m_residentSize <= m_budget) return;
+		
+		EntriesT::iterator i = m_entries.end();
+		
+		while (i != m_entries.begin() && m_residentSize > m_budget) {
+			--i;
+			
+			// Only the cache refers to this asset, so evicting it will free memory:
+			if (i->asset.use_count() == 1) {
+				m_residentSize -= i->size;
+				m_evictions += 1;
+				
+				evicted.push_back(i->asset);
+				m_index.erase(i->key);
+				
+				i = m_entries.erase(i);
+			}
+		}
+	}
+	
+	void AssetCache::remove (const std::string & key) {
+		std::shared_ptr<Asset> asset;
+		
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		auto i = m_index.find(key);
+		
+		if (i != m_index.end()) {
+			asset = i->second->asset;
+			m_residentSize -= i->second->size;
+			
+			m_entries.erase(i->second);
+			m_index.erase(i);
+		}
+	}
+	
+	void AssetCache::setBudget (std::size_t budget) {
+		std::list<std::shared_ptr<Asset>> evicted;
+		
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		m_budget = budget;
+		evict(evicted);
+	}
+	
+	void AssetCache::purge () {
+		std::list<std::shared_ptr<Asset>> evicted;
+		
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		std::size_t budget = m_budget;
+		
+		m_budget = 0;
+		evict(evicted);
+		m_budget = budget;
+	}
+	
+	AssetCache::Statistics AssetCache::statistics () const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		Statistics statistics = {m_hits, m_misses, m_evictions, m_residentSize, m_budget, m_entries.size()};
+		
+		return statistics;
+	}
+	
+	std::string AssetCache::canonicalPath (const std::string & path) {
+		char buffer[PATH_MAX];
+		
+		if (realpath(path.c_str(), buffer))
+			return buffer;
+		
+		return path;
+	}
+}
@@ -0,0 +1,103 @@
+//
+//  ARAssetCache.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_ASSET_CACHE_H
+#define _ARBROWSER_ASSET_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace ARBrowser {
+	/// A process wide cache of loaded assets (models, textures), keyed by canonical path, so that many points which use the same asset share one copy.
+	/// Assets are evicted in least recently used order once the resident size exceeds the budget. Assets which are still referenced outside the cache are never evicted, since evicting them would not free any memory.
+	class AssetCache {
+		public:
+			/// Something which can be cached.
+			class Asset {
+				public:
+					virtual ~Asset ();
+					
+					/// The number of bytes this asset keeps resident, e.g. vertex buffers or texture memory.
+					virtual std::size_t residentSize () const = 0;
+			};
+			
+			struct Statistics {
+				std::size_t hits, misses, evictions;
+				std::size_t residentSize, budget, count;
+			};
+			
+		protected:
+			struct Entry {
+				std::string key;
+				std::shared_ptr<Asset> asset;
+				std::size_t size;
+			};
+			
+			typedef std::list<Entry> EntriesT;
+			
+			mutable std::mutex m_mutex;
+			
+			/// Most recently used at the front.
+			EntriesT m_entries;
+			std::unordered_map<std::string, EntriesT::iterator> m_index;
+			
+			std::size_t m_residentSize;
+			std::size_t m_budget;
+			
+			std::atomic<std::size_t> m_hits, m_misses, m_evictions;
+			
+			/// Must be called with m_mutex held. Returns the evicted assets so that they can be released after the lock is dropped.
+			void evict (std::list<std::shared_ptr<Asset>> & evicted);
+			
+		public:
+			AssetCache (std::size_t budget);
+			~AssetCache ();
+			
+			/// Returns the cached asset and marks it as recently used, or NULL if it is not in the cache.
+			std::shared_ptr<Asset> lookup (const std::string & key);
+			
+			/// Returns the cached asset, converted to the given type.
+			template <typename AssetT>
+			std::shared_ptr<AssetT> lookup (const std::string & key) {
+				return std::dynamic_pointer_cast<AssetT>(lookup(key));
+			}
+			
+			/// Add an asset to the cache, evicting older assets if the budget is exceeded. If another asset was inserted with the same key in the meantime, that asset is kept and returned instead, so that all users share one copy.
+			std::shared_ptr<Asset> insert (const std::string & key, std::shared_ptr<Asset> asset);
+			
+			template <typename AssetT>
+			std::shared_ptr<AssetT> insert (const std::string & key, std::shared_ptr<AssetT> asset) {
+				return std::dynamic_pointer_cast<AssetT>(insert(key, std::shared_ptr<Asset>(asset)));
+			}
+			
+			/// Remove the asset from the cache. Existing references remain valid.
+			void remove (const std::string & key);
+			
+			/// Evict assets until the resident size is within the new budget.
+			void setBudget (std::size_t budget);
+			
+			/// Evict everything which is not currently referenced.
+			void purge ();
+			
+			Statistics statistics () const;
+			
+			/// Resolve symbolic links and relative components, so that the same file is always cached using the same key. Returns the path unchanged if it does not exist.
+			static std::string canonicalPath (const std::string & path);
+			
+		private:
+			AssetCache (const AssetCache &);
+			AssetCache & operator= (const AssetCache &);
+	};
+}
+
+#endif
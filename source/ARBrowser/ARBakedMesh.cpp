@@ -0,0 +1,486 @@
+//
+//  ARBakedMesh.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARBakedMesh.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace ARBrowser {
+	static_assert(sizeof(BakedMeshHeader) == 96, "BakedMeshHeader must match the file format");
+	static_assert(sizeof(BakedMeshRecord) == 72, "BakedMeshRecord must match the file format");
+	static_assert(sizeof(BakedMaterialRecord) == 24, "BakedMaterialRecord must match the file format");
+	static_assert(sizeof(BakedLevelRecord) == 8, "BakedLevelRecord must match the file format");
+	static_assert(sizeof(BakedIndexRecord) == 16, "BakedIndexRecord must match the file format");
+	static_assert(sizeof(HierarchyNode) == 32, "HierarchyNode must match the file format");
+	static_assert(sizeof(ObjMeshVertex) == sizeof(float) * 8, "ObjMeshVertex must be tightly packed");
+	static_assert(sizeof(QuantizedVertex) == 16, "QuantizedVertex must be tightly packed");
+	
+	static const char BAKED_MESH_MAGIC[8] = {'A', 'R', 'M', 'E', 'S', 'H', 0, 0};
+	static const std::uint64_t BAKED_MESH_ALIGNMENT = 16;
+	
+	static std::uint64_t alignOffset (std::uint64_t offset) {
+		return (offset + BAKED_MESH_ALIGNMENT - 1) & ~(BAKED_MESH_ALIGNMENT - 1);
+	}
+	
+	namespace {
+		/// Accumulates null terminated strings, sharing storage for duplicates.
+		struct StringTable {
+			std::string data;
+			
+			std::uint32_t insert (const std::string & value) {
+				std::size_t offset = 0;
+				
+				while (offset < data.size()) {
+					if (value == data.c_str() + offset)
+						return (std::uint32_t)offset;
+					
+					offset += std::strlen(data.c_str() + offset) + 1;
+				}
+				
+				data.append(value.c_str(), value.size() + 1);
+				
+				return (std::uint32_t)offset;
+			}
+		};
+		
+		/// Writes the file sequentially, padding up to the offsets that were computed in advance.
+		struct Writer {
+			std::FILE * file;
+			std::uint64_t offset;
+			
+			bool write (const void * data, std::size_t size) {
+				offset += size;
+				
+				return size == 0 || std::fwrite(data, size, 1, file) == 1;
+			}
+			
+			bool pad (std::uint64_t target) {
+				static const char zeros[BAKED_MESH_ALIGNMENT] = {0};
+				
+				while (offset < target) {
+					std::size_t size = std::min<std::uint64_t>(target - offset, sizeof(zeros));
+					if (!write(zeros, size)) return false;
+				}
+				
+				return true;
+			}
+		};
+	}
+	
+	bool writeBakedMesh (const std::string & path, const std::vector<IndexedMesh> & meshes, const std::vector<MaterialDescription> & materials, const std::vector<QuantizedMesh> & quantized, const LevelOfDetail * detail, const TriangleHierarchy * triangles) {
+		std::size_t levelCount = detail ? detail->levelCount() : 0;
+		
+		// Simplified levels share the vertices of the original meshes, so they must have the same meshes with the same index sizes:
+		for (std::size_t i = 1; i < levelCount; i += 1) {
+			const LevelOfDetail::Level & level = detail->level(i);
+			bool valid = level.meshes.size() == meshes.size();
+			
+			for (std::size_t j = 0; j < meshes.size() && valid; j += 1)
+				valid = level.meshes[j].shortIndices == meshes[j].usesShortIndices();
+			
+			if (!valid) {
+				std::cerr << "Level of detail " << i << " doesn't match the meshes of " << path << "!" << std::endl;
+				
+				return false;
+			}
+		}
+		
+		BakedMeshHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, BAKED_MESH_MAGIC, sizeof(header.magic));
+		
+		header.version = BAKED_MESH_VERSION;
+		header.meshCount = (std::uint32_t)meshes.size();
+		header.materialCount = (std::uint32_t)materials.size();
+		header.levelCount = (std::uint32_t)levelCount;
+		
+		StringTable strings;
+		std::vector<BakedMeshRecord> meshRecords(meshes.size());
+		std::vector<BakedMaterialRecord> materialRecords(materials.size());
+		std::vector<BakedLevelRecord> levelRecords(levelCount);
+		std::vector<BakedIndexRecord> indexRecords(levelCount ? (levelCount - 1) * meshes.size() : 0);
+		
+		std::uint64_t offset = sizeof(BakedMeshHeader) + sizeof(BakedMeshRecord) * meshes.size() + sizeof(BakedMaterialRecord) * materials.size() + sizeof(BakedLevelRecord) * levelRecords.size() + sizeof(BakedIndexRecord) * indexRecords.size();
+		
+		bool first = true;
+		
+		for (std::size_t i = 0; i < meshes.size(); i += 1) {
+			const IndexedMesh & mesh = meshes[i];
+			BakedMeshRecord & record = meshRecords[i];
+			
+			std::memset(&record, 0, sizeof(record));
+			record.material = strings.insert(mesh.material);
+			
+			if (!quantized.empty() && !quantized[i].vertices.empty()) {
+				record.vertexSize = sizeof(QuantizedVertex);
+				record.decode = quantized[i].decode;
+			} else {
+				record.vertexSize = sizeof(ObjMeshVertex);
+			}
+			
+			record.vertexCount = (std::uint32_t)mesh.vertices.size();
+			record.vertexOffset = offset = alignOffset(offset);
+			offset += record.vertexSize * mesh.vertices.size();
+			
+			record.indexCount = (std::uint32_t)mesh.indexCount();
+			record.indexSize = mesh.usesShortIndices() ? 2 : 4;
+			record.indexOffset = offset = alignOffset(offset);
+			offset += record.indexSize * record.indexCount;
+			
+			for (std::size_t j = 0; j < mesh.vertices.size(); j += 1) {
+				const Vec3 & pos = mesh.vertices[j].pos;
+				
+				for (std::size_t k = 0; k < 3; k += 1) {
+					if (first || pos[k] < header.boundsMin[k]) header.boundsMin[k] = pos[k];
+					if (first || pos[k] > header.boundsMax[k]) header.boundsMax[k] = pos[k];
+				}
+				
+				first = false;
+			}
+		}
+		
+		for (std::size_t i = 0; i < levelCount; i += 1) {
+			const LevelOfDetail::Level & level = detail->level(i);
+			
+			levelRecords[i].error = level.error;
+			levelRecords[i].triangleCount = (std::uint32_t)level.triangleCount;
+			
+			// The indices of level 0 are those of the meshes:
+			for (std::size_t j = 0; i > 0 && j < meshes.size(); j += 1) {
+				BakedIndexRecord & record = indexRecords[(i - 1) * meshes.size() + j];
+				
+				record.indexCount = (std::uint32_t)level.meshes[j].indexCount;
+				record.reserved = 0;
+				record.indexOffset = offset = alignOffset(offset);
+				offset += meshRecords[j].indexSize * record.indexCount;
+			}
+		}
+		
+		if (triangles && !triangles->empty()) {
+			header.hierarchyNodeCount = (std::uint32_t)triangles->nodeCount();
+			header.hierarchyNodeOffset = offset = alignOffset(offset);
+			offset += sizeof(HierarchyNode) * triangles->nodeCount();
+			
+			header.hierarchyTriangleCount = (std::uint32_t)triangles->triangleCount();
+			header.hierarchyTriangleOffset = offset = alignOffset(offset);
+			offset += sizeof(float) * 9 * triangles->triangleCount();
+		}
+		
+		for (std::size_t i = 0; i < materials.size(); i += 1) {
+			BakedMaterialRecord & record = materialRecords[i];
+			
+			record.name = strings.insert(materials[i].name);
+			record.diffuseMapPath = strings.insert(materials[i].diffuseMapPath);
+			
+			record.ambient[0] = materials[i].ambient.r;
+			record.ambient[1] = materials[i].ambient.g;
+			record.ambient[2] = materials[i].ambient.b;
+			record.ambient[3] = materials[i].ambient.a;
+		}
+		
+		header.stringTableOffset = (std::uint32_t)offset;
+		header.stringTableSize = (std::uint32_t)strings.data.size();
+		header.fileSize = offset + strings.data.size();
+		
+		Writer writer = {std::fopen(path.c_str(), "wb"), 0};
+		
+		if (!writer.file) {
+			std::cerr << "Couldn't open " << path << " for writing!" << std::endl;
+			
+			return false;
+		}
+		
+		bool success = writer.write(&header, sizeof(header));
+		
+		if (!meshRecords.empty())
+			success = success && writer.write(&meshRecords[0], sizeof(BakedMeshRecord) * meshRecords.size());
+		
+		if (!materialRecords.empty())
+			success = success && writer.write(&materialRecords[0], sizeof(BakedMaterialRecord) * materialRecords.size());
+		
+		if (!levelRecords.empty())
+			success = success && writer.write(&levelRecords[0], sizeof(BakedLevelRecord) * levelRecords.size());
+		
+		if (!indexRecords.empty())
+			success = success && writer.write(&indexRecords[0], sizeof(BakedIndexRecord) * indexRecords.size());
+		
+		for (std::size_t i = 0; i < meshes.size() && success; i += 1) {
+			const BakedMeshRecord & record = meshRecords[i];
+			MeshBuffer buffer = record.vertexSize == sizeof(QuantizedVertex) ? quantized[i].buffer(meshes[i]) : meshes[i].buffer();
+			
+			success = writer.pad(record.vertexOffset)
+				&& writer.write(buffer.vertexData(), record.vertexSize * buffer.vertexCount)
+				&& writer.pad(record.indexOffset)
+				&& writer.write(buffer.indices, record.indexSize * buffer.indexCount);
+		}
+		
+		for (std::size_t i = 0; i < indexRecords.size() && success; i += 1) {
+			const BakedIndexRecord & record = indexRecords[i];
+			const MeshBuffer & buffer = detail->level(i / meshes.size() + 1).meshes[i % meshes.size()];
+			
+			success = writer.pad(record.indexOffset)
+				&& writer.write(buffer.indices, meshRecords[i % meshes.size()].indexSize * record.indexCount);
+		}
+		
+		if (header.hierarchyNodeCount) {
+			success = success
+				&& writer.pad(header.hierarchyNodeOffset)
+				&& writer.write(triangles->nodes(), sizeof(HierarchyNode) * header.hierarchyNodeCount)
+				&& writer.pad(header.hierarchyTriangleOffset)
+				&& writer.write(triangles->triangles(), sizeof(float) * 9 * header.hierarchyTriangleCount);
+		}
+		
+		success = success && writer.write(strings.data.data(), strings.data.size());
+		success = (std::fclose(writer.file) == 0) && success;
+		
+		if (!success) {
+			std::cerr << "Couldn't write " << path << "!" << std::endl;
+			std::remove(path.c_str());
+		}
+		
+		return success;
+	}
+	
+	/// Whether the indices form whole triangles and only refer to the given number of vertices, so that neither drawing nor reading the triangles on the CPU goes outside the vertex array.
+	template <typename IndexT>
+	static bool validIndices (const IndexT * indices, std::size_t indexCount, std::uint32_t vertexCount) {
+		if (indexCount % 3 != 0)
+			return false;
+		
+		IndexT largest = 0;
+		
+		for (std::size_t i = 0; i < indexCount; i += 1)
+			largest = std::max(largest, indices[i]);
+		
+		return indexCount == 0 || largest < vertexCount;
+	}
+	
+	static bool validIndices (const char * indices, std::uint32_t indexSize, std::size_t indexCount, std::uint32_t vertexCount) {
+		if (indexSize == 2)
+			return validIndices((const std::uint16_t *)indices, indexCount, vertexCount);
+		else
+			return validIndices((const std::uint32_t *)indices, indexCount, vertexCount);
+	}
+	
+	BakedMesh::BakedMesh () : m_header(NULL), m_meshes(NULL), m_materials(NULL), m_levels(NULL), m_indices(NULL) {
+	}
+	
+	bool BakedMesh::open (const std::string & path) {
+		close();
+		
+		if (!m_file.open(path))
+			return false;
+		
+		if (!validate(path)) {
+			close();
+			
+			return false;
+		}
+		
+		return true;
+	}
+	
+	void BakedMesh::close () {
+		m_file.close();
+		
+		m_header = NULL;
+		m_meshes = NULL;
+		m_materials = NULL;
+		m_levels = NULL;
+		m_indices = NULL;
+		m_meshMaterials.clear();
+	}
+	
+	bool BakedMesh::validate (const std::string & path) {
+		const std::uint64_t size = m_file.size();
+		
+		if (size < sizeof(BakedMeshHeader)) {
+			std::cerr << "Baked mesh " << path << " is truncated!" << std::endl;
+			return false;
+		}
+		
+		const BakedMeshHeader * header = (const BakedMeshHeader *)m_file.begin();
+		
+		if (std::memcmp(header->magic, BAKED_MESH_MAGIC, sizeof(header->magic)) != 0) {
+			std::cerr << "Baked mesh " << path << " is not a .armesh file!" << std::endl;
+			return false;
+		}
+		
+		if (header->version != BAKED_MESH_VERSION) {
+			std::cerr << "Baked mesh " << path << " has unsupported version " << header->version << "!" << std::endl;
+			return false;
+		}
+		
+		std::uint64_t indexRecordCount = header->levelCount ? (std::uint64_t)(header->levelCount - 1) * header->meshCount : 0;
+		std::uint64_t recordsEnd = sizeof(BakedMeshHeader) + (std::uint64_t)sizeof(BakedMeshRecord) * header->meshCount + (std::uint64_t)sizeof(BakedMaterialRecord) * header->materialCount + (std::uint64_t)sizeof(BakedLevelRecord) * header->levelCount + sizeof(BakedIndexRecord) * indexRecordCount;
+		std::uint64_t stringsEnd = (std::uint64_t)header->stringTableOffset + header->stringTableSize;
+		
+		if (header->fileSize != size || recordsEnd > size || stringsEnd > size || (header->stringTableSize > 0 && m_file.begin()[stringsEnd - 1] != '\0')) {
+			std::cerr << "Baked mesh " << path << " is corrupt!" << std::endl;
+			return false;
+		}
+		
+		const BakedMeshRecord * meshes = (const BakedMeshRecord *)(header + 1);
+		
+		for (std::size_t i = 0; i < header->meshCount; i += 1) {
+			const BakedMeshRecord & record = meshes[i];
+			
+			bool valid = (record.indexSize == 2 || record.indexSize == 4)
+				&& (record.vertexSize == sizeof(ObjMeshVertex) || record.vertexSize == sizeof(QuantizedVertex))
+				&& record.material < header->stringTableSize
+				&& (record.vertexOffset % BAKED_MESH_ALIGNMENT) == 0
+				&& (record.indexOffset % BAKED_MESH_ALIGNMENT) == 0
+				&& record.vertexOffset + (std::uint64_t)record.vertexSize * record.vertexCount <= size
+				&& record.indexOffset + (std::uint64_t)record.indexSize * record.indexCount <= size
+				&& validIndices(m_file.begin() + record.indexOffset, record.indexSize, record.indexCount, record.vertexCount);
+			
+			if (!valid) {
+				std::cerr << "Baked mesh " << path << " has corrupt mesh " << i << "!" << std::endl;
+				return false;
+			}
+		}
+		
+		const BakedMaterialRecord * materials = (const BakedMaterialRecord *)(meshes + header->meshCount);
+		
+		for (std::size_t i = 0; i < header->materialCount; i += 1) {
+			if (materials[i].name >= header->stringTableSize || materials[i].diffuseMapPath >= header->stringTableSize) {
+				std::cerr << "Baked mesh " << path << " has corrupt material " << i << "!" << std::endl;
+				return false;
+			}
+		}
+		
+		const BakedLevelRecord * levels = (const BakedLevelRecord *)(materials + header->materialCount);
+		const BakedIndexRecord * indices = (const BakedIndexRecord *)(levels + header->levelCount);
+		
+		for (std::size_t i = 0; i < indexRecordCount; i += 1) {
+			const BakedIndexRecord & record = indices[i];
+			const BakedMeshRecord & mesh = meshes[i % header->meshCount];
+			
+			bool valid = (record.indexOffset % BAKED_MESH_ALIGNMENT) == 0
+				&& record.indexOffset + (std::uint64_t)mesh.indexSize * record.indexCount <= size
+				&& validIndices(m_file.begin() + record.indexOffset, mesh.indexSize, record.indexCount, mesh.vertexCount);
+			
+			if (!valid) {
+				std::cerr << "Baked mesh " << path << " has corrupt level of detail " << (i / header->meshCount + 1) << "!" << std::endl;
+				return false;
+			}
+		}
+		
+		if (header->hierarchyNodeCount) {
+			bool valid = (header->hierarchyNodeOffset % BAKED_MESH_ALIGNMENT) == 0
+				&& (header->hierarchyTriangleOffset % BAKED_MESH_ALIGNMENT) == 0
+				&& header->hierarchyNodeOffset + (std::uint64_t)sizeof(HierarchyNode) * header->hierarchyNodeCount <= size
+				&& header->hierarchyTriangleOffset + (std::uint64_t)sizeof(float) * 9 * header->hierarchyTriangleCount <= size;
+			
+			if (!valid) {
+				std::cerr << "Baked mesh " << path << " has a corrupt picking hierarchy!" << std::endl;
+				return false;
+			}
+		}
+		
+		m_header = header;
+		m_meshes = meshes;
+		m_materials = materials;
+		m_levels = levels;
+		m_indices = indices;
+		
+		m_meshMaterials.resize(header->meshCount);
+		for (std::size_t i = 0; i < header->meshCount; i += 1) {
+			m_meshMaterials[i] = string(meshes[i].material);
+		}
+		
+		return true;
+	}
+	
+	const char * BakedMesh::string (std::uint32_t offset) const {
+		return m_file.begin() + m_header->stringTableOffset + offset;
+	}
+	
+	MeshBuffer BakedMesh::mesh (std::size_t index) const {
+		const BakedMeshRecord & record = m_meshes[index];
+		MeshBuffer buffer;
+		
+		buffer.material = &m_meshMaterials[index];
+		
+		if (record.vertexSize == sizeof(QuantizedVertex)) {
+			buffer.vertices = NULL;
+			buffer.quantizedVertices = (const QuantizedVertex *)(m_file.begin() + record.vertexOffset);
+			buffer.decode = &record.decode;
+		} else {
+			buffer.vertices = (const ObjMeshVertex *)(m_file.begin() + record.vertexOffset);
+			buffer.quantizedVertices = NULL;
+			buffer.decode = NULL;
+		}
+		
+		buffer.vertexCount = record.vertexCount;
+		buffer.indices = m_file.begin() + record.indexOffset;
+		buffer.indexCount = record.indexCount;
+		buffer.shortIndices = (record.indexSize == 2);
+		
+		return buffer;
+	}
+	
+	bool BakedMesh::loadDetail (LevelOfDetail & detail) const {
+		if (m_header->levelCount == 0)
+			return false;
+		
+		std::vector<LevelOfDetail::Level> levels(m_header->levelCount);
+		
+		for (std::size_t i = 0; i < levels.size(); i += 1) {
+			LevelOfDetail::Level & level = levels[i];
+			
+			level.error = m_levels[i].error;
+			level.triangleCount = m_levels[i].triangleCount;
+			
+			for (std::size_t j = 0; j < m_header->meshCount; j += 1) {
+				MeshBuffer buffer = mesh(j);
+				
+				if (i > 0) {
+					const BakedIndexRecord & record = m_indices[(i - 1) * m_header->meshCount + j];
+					
+					buffer.indices = m_file.begin() + record.indexOffset;
+					buffer.indexCount = record.indexCount;
+				}
+				
+				level.meshes.push_back(buffer);
+			}
+		}
+		
+		detail.assign(levels);
+		
+		return true;
+	}
+	
+	bool BakedMesh::loadHierarchy (TriangleHierarchy & triangles) const {
+		if (m_header->hierarchyNodeCount == 0)
+			return false;
+		
+		const HierarchyNode * nodes = (const HierarchyNode *)(m_file.begin() + m_header->hierarchyNodeOffset);
+		const float * positions = (const float *)(m_file.begin() + m_header->hierarchyTriangleOffset);
+		
+		return triangles.assign(nodes, m_header->hierarchyNodeCount, positions, m_header->hierarchyTriangleCount);
+	}
+	
+	MaterialDescription BakedMesh::material (std::size_t index) const {
+		const BakedMaterialRecord & record = m_materials[index];
+		MaterialDescription material;
+		
+		material.name = string(record.name);
+		material.diffuseMapPath = string(record.diffuseMapPath);
+		
+		material.ambient.r = record.ambient[0];
+		material.ambient.g = record.ambient[1];
+		material.ambient.b = record.ambient[2];
+		material.ambient.a = record.ambient[3];
+		
+		return material;
+	}
+}
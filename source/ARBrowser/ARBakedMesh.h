@@ -0,0 +1,150 @@
+//
+//  ARBakedMesh.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_BAKED_MESH_H
+#define _ARBROWSER_BAKED_MESH_H
+
+#include "ARMesh.h"
+#include "ARMappedFile.h"
+#include "ARLevelOfDetail.h"
+#include "ARPicking.h"
+
+namespace ARBrowser {
+	/**
+	 * The .armesh format is a binary container of ready-to-draw meshes, which can be memory mapped and drawn without parsing or copying.
+	 *
+	 * All values are little endian. The file begins with a BakedMeshHeader, followed by meshCount BakedMeshRecords, materialCount BakedMaterialRecords, levelCount BakedLevelRecords and (levelCount - 1) * meshCount BakedIndexRecords, which hold the indices of each mesh for each simplified level in turn. Vertex, index and hierarchy arrays are 16-byte aligned, and vertices have the same layout as either ObjMeshVertex or QuantizedVertex. Strings are null terminated and stored in a string table, referenced by offset from the start of the table.
+	 *
+	 * The levels of detail and the picking hierarchy are built when the file is baked, as building them takes much longer than mapping the file. Either may be absent, in which case they are built when the model is loaded.
+	 */
+	
+	const std::uint32_t BAKED_MESH_VERSION = 4;
+	
+	struct BakedMeshHeader {
+		/// "ARMESH" followed by two null bytes.
+		char magic[8];
+		std::uint32_t version;
+		
+		std::uint32_t meshCount;
+		std::uint32_t materialCount;
+		
+		std::uint32_t stringTableOffset;
+		std::uint32_t stringTableSize;
+		
+		/// The bounding box of all vertices.
+		float boundsMin[3], boundsMax[3];
+		
+		/// The number of levels of detail, including the original meshes as level 0, or 0 if they were not baked.
+		std::uint32_t levelCount;
+		std::uint64_t fileSize;
+		
+		/// The TriangleHierarchy of the original meshes, which is absent if nodeCount is 0. There are 9 floats for each triangle.
+		std::uint32_t hierarchyNodeCount;
+		std::uint32_t hierarchyTriangleCount;
+		std::uint64_t hierarchyNodeOffset;
+		std::uint64_t hierarchyTriangleOffset;
+		
+		std::uint64_t reserved;
+	};
+	
+	struct BakedMeshRecord {
+		/// The material name, as an offset into the string table.
+		std::uint32_t material;
+		
+		std::uint32_t vertexCount;
+		std::uint64_t vertexOffset;
+		
+		std::uint32_t indexCount;
+		/// The size of each index in bytes, either 2 or 4.
+		std::uint32_t indexSize;
+		std::uint64_t indexOffset;
+		
+		/// The size of each vertex in bytes, either 32 for ObjMeshVertex or 16 for QuantizedVertex.
+		std::uint32_t vertexSize;
+		std::uint32_t reserved;
+		
+		/// How to decode quantized vertices, which is unused for ObjMeshVertex.
+		VertexDecode decode;
+	};
+	
+	struct BakedMaterialRecord {
+		/// The material name and diffuse map path, as offsets into the string table.
+		std::uint32_t name;
+		std::uint32_t diffuseMapPath;
+		
+		float ambient[4];
+	};
+	
+	struct BakedLevelRecord {
+		/// The geometric error in model units, relative to the original meshes.
+		float error;
+		std::uint32_t triangleCount;
+	};
+	
+	/// The indices of one mesh in a simplified level, which refer to the vertices of the original mesh and have the same size as its indices.
+	struct BakedIndexRecord {
+		std::uint32_t indexCount;
+		std::uint32_t reserved;
+		std::uint64_t indexOffset;
+	};
+	
+	/// Write meshes and materials to a .armesh file. If quantized is not empty, it has one element for each mesh, and meshes which have quantized vertices are stored using them.
+	/// If given, detail and triangles must have been built from the meshes as they are stored, i.e. using the quantized vertices where there are any.
+	/// @returns false if the file could not be written.
+	bool writeBakedMesh (const std::string & path, const std::vector<IndexedMesh> & meshes, const std::vector<MaterialDescription> & materials, const std::vector<QuantizedMesh> & quantized = std::vector<QuantizedMesh>(), const LevelOfDetail * detail = NULL, const TriangleHierarchy * triangles = NULL);
+	
+	/// A memory mapped .armesh file. Mesh buffers refer directly to the mapped data, so they are only valid while the file remains open.
+	class BakedMesh {
+		protected:
+			MappedFile m_file;
+			
+			const BakedMeshHeader * m_header;
+			const BakedMeshRecord * m_meshes;
+			const BakedMaterialRecord * m_materials;
+			const BakedLevelRecord * m_levels;
+			const BakedIndexRecord * m_indices;
+			
+			/// Material names are copied out of the string table so that MeshBuffer can refer to them.
+			std::vector<std::string> m_meshMaterials;
+			
+			const char * string (std::uint32_t offset) const;
+			bool validate (const std::string & path);
+			
+		public:
+			BakedMesh ();
+			
+			/// Map and validate the given file.
+			/// @returns false if the file does not exist, or is not a valid .armesh file of a supported version. Every index is checked against the vertices of its mesh.
+			bool open (const std::string & path);
+			void close ();
+			
+			bool isOpen () const { return m_header != NULL; }
+			
+			/// The size of the mapped file in bytes.
+			std::size_t fileSize () const { return m_file.size(); }
+			
+			std::size_t meshCount () const { return m_header->meshCount; }
+			MeshBuffer mesh (std::size_t index) const;
+			
+			std::size_t materialCount () const { return m_header->materialCount; }
+			MaterialDescription material (std::size_t index) const;
+			
+			const float * boundsMin () const { return m_header->boundsMin; }
+			const float * boundsMax () const { return m_header->boundsMax; }
+			
+			/// Assign the baked levels of detail, whose meshes refer to the mapped data.
+			/// @returns false if none were baked.
+			bool loadDetail (LevelOfDetail & detail) const;
+			
+			/// Assign the baked picking hierarchy, which refers to the mapped data.
+			/// @returns false if none was baked, or it is invalid.
+			bool loadHierarchy (TriangleHierarchy & triangles) const;
+	};
+}
+
+#endif
@@ -0,0 +1,217 @@
+//
+//  ARBakedTexture.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARBakedTexture.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace ARBrowser {
+	static_assert(sizeof(BakedTextureHeader) == 40, "BakedTextureHeader must match the file format");
+	static_assert(sizeof(BakedTextureLevel) == 32, "BakedTextureLevel must match the file format");
+	
+	static const char BAKED_TEXTURE_MAGIC[8] = {'A', 'R', 'T', 'E', 'X', 0, 0, 0};
+	static const std::uint64_t BAKED_TEXTURE_ALIGNMENT = 16;
+	
+	static std::uint64_t alignOffset (std::uint64_t offset) {
+		return (offset + BAKED_TEXTURE_ALIGNMENT - 1) & ~(BAKED_TEXTURE_ALIGNMENT - 1);
+	}
+	
+	/// The size in bytes of a level with the given format and size.
+	static std::uint64_t levelSize (std::uint32_t format, std::uint32_t width, std::uint32_t height) {
+		return format == BAKED_TEXTURE_PVRTC_4BPP ? pvrtcSize(width, height) : std::uint64_t(width) * height * 4;
+	}
+	
+	/// Whether the levels are a complete mip chain of a square image with power of two sides.
+	static bool isMipChain (const std::vector<TextureImage> & levels) {
+		if (levels.empty() || levels[0].width != levels[0].height || (levels[0].width & (levels[0].width - 1)) != 0)
+			return false;
+		
+		for (std::size_t i = 0; i < levels.size(); i += 1) {
+			std::uint32_t size = std::max(levels[0].width >> i, 1u);
+			
+			if (levels[i].width != size || levels[i].height != size || levels[i].pixels.size() != std::size_t(size) * size * 4)
+				return false;
+		}
+		
+		return levels.back().width == 1;
+	}
+	
+	bool writeBakedTexture (const std::string & path, const std::vector<TextureImage> & levels, bool fallback) {
+		if (!isMipChain(levels)) {
+			std::cerr << "Texture " << path << " must be a mip chain of a square image with power of two sides!" << std::endl;
+			return false;
+		}
+		
+		std::vector<std::uint32_t> formats(1, BAKED_TEXTURE_PVRTC_4BPP);
+		
+		if (fallback)
+			formats.push_back(BAKED_TEXTURE_RGBA8);
+		
+		BakedTextureHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, BAKED_TEXTURE_MAGIC, sizeof(header.magic));
+		
+		header.version = BAKED_TEXTURE_VERSION;
+		header.width = levels[0].width;
+		header.height = levels[0].height;
+		header.levelCount = (std::uint32_t)levels.size();
+		header.formatCount = (std::uint32_t)formats.size();
+		
+		std::vector<BakedTextureLevel> records;
+		std::vector<std::vector<std::uint8_t>> compressed(levels.size());
+		std::uint64_t offset = sizeof(BakedTextureHeader) + sizeof(BakedTextureLevel) * formats.size() * levels.size();
+		
+		for (std::size_t i = 0; i < formats.size(); i += 1) {
+			for (std::size_t j = 0; j < levels.size(); j += 1) {
+				BakedTextureLevel record = {formats[i], (std::uint32_t)j, levels[j].width, levels[j].height, 0, 0};
+				
+				if (formats[i] == BAKED_TEXTURE_PVRTC_4BPP)
+					encodePVRTC(levels[j], compressed[j]);
+				
+				record.offset = offset = alignOffset(offset);
+				record.size = levelSize(formats[i], levels[j].width, levels[j].height);
+				offset += record.size;
+				
+				records.push_back(record);
+			}
+		}
+		
+		header.fileSize = offset;
+		
+		std::FILE * file = std::fopen(path.c_str(), "wb");
+		
+		if (!file) {
+			std::cerr << "Couldn't open " << path << " for writing!" << std::endl;
+			
+			return false;
+		}
+		
+		static const char zeros[BAKED_TEXTURE_ALIGNMENT] = {0};
+		bool success = std::fwrite(&header, sizeof(header), 1, file) == 1 && std::fwrite(&records[0], sizeof(BakedTextureLevel) * records.size(), 1, file) == 1;
+		offset = sizeof(BakedTextureHeader) + sizeof(BakedTextureLevel) * records.size();
+		
+		for (std::size_t i = 0; i < records.size() && success; i += 1) {
+			const BakedTextureLevel & record = records[i];
+			const std::uint8_t * data = record.format == BAKED_TEXTURE_PVRTC_4BPP ? &compressed[record.level][0] : &levels[record.level].pixels[0];
+			
+			success = (record.offset == offset || std::fwrite(zeros, record.offset - offset, 1, file) == 1) && std::fwrite(data, record.size, 1, file) == 1;
+			offset = record.offset + record.size;
+		}
+		
+		success = (std::fclose(file) == 0) && success;
+		
+		if (!success) {
+			std::cerr << "Couldn't write " << path << "!" << std::endl;
+			std::remove(path.c_str());
+		}
+		
+		return success;
+	}
+	
+	std::string bakedTexturePath (const std::string & path) {
+		std::size_t extension = path.find_last_of('.'), directory = path.find_last_of('/');
+		
+		if (extension == std::string::npos || (directory != std::string::npos && extension < directory))
+			return path + ".artex";
+		
+		return path.substr(0, extension) + ".artex";
+	}
+	
+	BakedTexture::BakedTexture () : m_header(NULL), m_levels(NULL) {
+	}
+	
+	bool BakedTexture::open (const std::string & path) {
+		close();
+		
+		if (!m_file.open(path))
+			return false;
+		
+		if (!validate(path)) {
+			close();
+			
+			return false;
+		}
+		
+		return true;
+	}
+	
+	void BakedTexture::close () {
+		m_file.close();
+		
+		m_header = NULL;
+		m_levels = NULL;
+	}
+	
+	bool BakedTexture::validate (const std::string & path) {
+		const std::uint64_t size = m_file.size();
+		
+		if (size < sizeof(BakedTextureHeader)) {
+			std::cerr << "Baked texture " << path << " is truncated!" << std::endl;
+			return false;
+		}
+		
+		const BakedTextureHeader * header = (const BakedTextureHeader *)m_file.begin();
+		
+		if (std::memcmp(header->magic, BAKED_TEXTURE_MAGIC, sizeof(header->magic)) != 0) {
+			std::cerr << "Baked texture " << path << " is not a .artex file!" << std::endl;
+			return false;
+		}
+		
+		if (header->version != BAKED_TEXTURE_VERSION) {
+			std::cerr << "Baked texture " << path << " has unsupported version " << header->version << "!" << std::endl;
+			return false;
+		}
+		
+		std::uint64_t recordsEnd = sizeof(BakedTextureHeader) + (std::uint64_t)sizeof(BakedTextureLevel) * header->formatCount * header->levelCount;
+		bool squareChain = header->width == header->height && header->width != 0 && (header->width & (header->width - 1)) == 0 && header->levelCount > 0 && header->levelCount <= 32 && (header->width >> (header->levelCount - 1)) == 1;
+		
+		if (header->fileSize != size || recordsEnd > size || !squareChain) {
+			std::cerr << "Baked texture " << path << " is corrupt!" << std::endl;
+			return false;
+		}
+		
+		const BakedTextureLevel * levels = (const BakedTextureLevel *)(header + 1);
+		
+		for (std::size_t i = 0; i < std::size_t(header->formatCount) * header->levelCount; i += 1) {
+			const BakedTextureLevel & level = levels[i];
+			std::uint32_t index = (std::uint32_t)(i % header->levelCount), side = header->width >> index;
+			
+			bool valid = (level.format == BAKED_TEXTURE_PVRTC_4BPP || level.format == BAKED_TEXTURE_RGBA8)
+				&& level.format == levels[i - index].format
+				&& level.level == index
+				&& level.width == side && level.height == side
+				&& level.size == levelSize(level.format, side, side)
+				&& (level.offset % BAKED_TEXTURE_ALIGNMENT) == 0
+				&& level.offset + level.size <= size;
+			
+			if (!valid) {
+				std::cerr << "Baked texture " << path << " has corrupt level " << i << "!" << std::endl;
+				return false;
+			}
+		}
+		
+		m_header = header;
+		m_levels = levels;
+		
+		return true;
+	}
+	
+	const BakedTextureLevel * BakedTexture::levels (std::uint32_t format) const {
+		for (std::size_t i = 0; i < m_header->formatCount; i += 1) {
+			const BakedTextureLevel * levels = m_levels + i * m_header->levelCount;
+			
+			if (levels->format == format)
+				return levels;
+		}
+		
+		return NULL;
+	}
+}
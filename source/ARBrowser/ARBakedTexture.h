@@ -0,0 +1,100 @@
+//
+//  ARBakedTexture.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_BAKED_TEXTURE_H
+#define _ARBROWSER_BAKED_TEXTURE_H
+
+#include "ARMappedFile.h"
+#include "ARTextureCompression.h"
+
+#include <string>
+
+namespace ARBrowser {
+	/**
+	 * The .artex format stores a texture with every mip level, ready to be uploaded without decoding an image.
+	 *
+	 * All values are little endian. The file begins with a BakedTextureHeader, followed by formatCount * levelCount BakedTextureLevels, grouped by format and then from the largest level down to 1x1. The data of each level is 16-byte aligned. Textures are square with power of two sides, as iOS requires for PVRTC.
+	 */
+	
+	const std::uint32_t BAKED_TEXTURE_VERSION = 1;
+	
+	enum BakedTextureFormat {
+		/// GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG, which every iOS device supports.
+		BAKED_TEXTURE_PVRTC_4BPP = 1,
+		
+		/// GL_RGBA with GL_UNSIGNED_BYTE, used if PVRTC isn't supported.
+		BAKED_TEXTURE_RGBA8 = 2
+	};
+	
+	struct BakedTextureHeader {
+		/// "ARTEX" followed by three null bytes.
+		char magic[8];
+		std::uint32_t version;
+		
+		/// The size of level 0.
+		std::uint32_t width, height;
+		
+		std::uint32_t levelCount;
+		std::uint32_t formatCount;
+		
+		std::uint32_t reserved;
+		std::uint64_t fileSize;
+	};
+	
+	struct BakedTextureLevel {
+		/// One of BakedTextureFormat.
+		std::uint32_t format;
+		std::uint32_t level;
+		
+		std::uint32_t width, height;
+		
+		std::uint64_t offset;
+		std::uint64_t size;
+	};
+	
+	/// Compress the mip levels, which must start from a square image with power of two sides and end at 1x1 as made by buildMipChain, and write them to a .artex file. If fallback is true, the uncompressed levels are also stored.
+	/// @returns false if the levels are not a valid mip chain or the file could not be written.
+	bool writeBakedTexture (const std::string & path, const std::vector<TextureImage> & levels, bool fallback = true);
+	
+	/// The path of the baked version of the given image, i.e. with the extension replaced by .artex.
+	std::string bakedTexturePath (const std::string & path);
+	
+	/// A memory mapped .artex file. Level data refers directly to the mapped data, so it is only valid while the file remains open.
+	class BakedTexture {
+		protected:
+			MappedFile m_file;
+			
+			const BakedTextureHeader * m_header;
+			const BakedTextureLevel * m_levels;
+			
+			bool validate (const std::string & path);
+		
+		public:
+			BakedTexture ();
+			
+			/// Map and validate the given file.
+			/// @returns false if the file does not exist, or is not a valid .artex file of a supported version.
+			bool open (const std::string & path);
+			void close ();
+			
+			bool isOpen () const { return m_header != NULL; }
+			
+			std::size_t fileSize () const { return m_file.size(); }
+			
+			std::uint32_t width () const { return m_header->width; }
+			std::uint32_t height () const { return m_header->height; }
+			std::size_t levelCount () const { return m_header->levelCount; }
+			
+			/// The levelCount() levels stored in the given format, from the largest, or NULL if the file doesn't contain the format.
+			const BakedTextureLevel * levels (std::uint32_t format) const;
+			
+			const std::uint8_t * data (const BakedTextureLevel & level) const { return (const std::uint8_t *)m_file.begin() + level.offset; }
+	};
+}
+
+#endif
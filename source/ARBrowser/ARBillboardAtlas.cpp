@@ -0,0 +1,392 @@
+//
+//  ARBillboardAtlas.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARBillboardAtlas.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ARBrowser {
+	static const std::size_t PIXEL_SIZE = 4;
+	
+	SkylinePacker::SkylinePacker (std::uint32_t width, std::uint32_t height, std::uint32_t padding) : m_width(width), m_height(height), m_padding(padding) {
+		clear();
+	}
+	
+	void SkylinePacker::clear () {
+		// Rectangles are reserved with padding on their right and bottom edges, which may extend past the edge of the atlas:
+		Segment ground = {0, 0, m_width + m_padding};
+		
+		m_skyline.assign(1, ground);
+		m_free.clear();
+		
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+		m_statistics.totalArea = std::size_t(m_width) * m_height;
+	}
+	
+	bool SkylinePacker::fits (std::size_t index, std::uint32_t width, std::uint32_t height, std::uint32_t & y) const {
+		if (m_skyline[index].x + width > m_width + m_padding)
+			return false;
+		
+		std::uint32_t remaining = width;
+		y = 0;
+		
+		for (std::size_t i = index; remaining > 0; i += 1) {
+			if (i >= m_skyline.size())
+				return false;
+			
+			y = std::max(y, m_skyline[i].y);
+			
+			if (y + height > m_height + m_padding)
+				return false;
+			
+			remaining -= std::min(remaining, m_skyline[i].width);
+		}
+		
+		return true;
+	}
+	
+	void SkylinePacker::mergeSegments () {
+		for (std::size_t i = 1; i < m_skyline.size(); ) {
+			if (m_skyline[i - 1].y == m_skyline[i].y) {
+				m_skyline[i - 1].width += m_skyline[i].width;
+				m_skyline.erase(m_skyline.begin() + i);
+			} else {
+				i += 1;
+			}
+		}
+	}
+	
+	void SkylinePacker::splitSegment (std::uint32_t x) {
+		for (std::size_t i = 0; i < m_skyline.size(); i += 1) {
+			Segment & segment = m_skyline[i];
+			
+			if (segment.x < x && x < segment.x + segment.width) {
+				Segment right = {x, segment.y, segment.x + segment.width - x};
+				segment.width = x - segment.x;
+				
+				m_skyline.insert(m_skyline.begin() + i + 1, right);
+				
+				return;
+			}
+		}
+	}
+	
+	bool SkylinePacker::lowerSkyline (const AtlasRect & rect) {
+		const std::uint32_t top = rect.y + rect.height, end = rect.x + rect.width;
+		
+		// The rectangle must be on the surface, i.e. nothing has been placed above any part of it:
+		for (std::size_t i = 0; i < m_skyline.size(); i += 1) {
+			const Segment & segment = m_skyline[i];
+			
+			if (segment.x < end && segment.x + segment.width > rect.x && segment.y != top)
+				return false;
+		}
+		
+		splitSegment(rect.x);
+		splitSegment(end);
+		
+		for (std::size_t i = 0; i < m_skyline.size(); i += 1) {
+			if (m_skyline[i].x >= rect.x && m_skyline[i].x < end)
+				m_skyline[i].y = rect.y;
+		}
+		
+		mergeSegments();
+		
+		m_statistics.packedArea -= rect.area();
+		
+		return true;
+	}
+	
+	bool SkylinePacker::allocateFromSkyline (std::uint32_t width, std::uint32_t height, AtlasRect & rect) {
+		std::size_t best = m_skyline.size();
+		std::uint32_t bestY = 0, bestTop = ~std::uint32_t(0);
+		
+		// Bottom-left: the position where the top of the rectangle is lowest, then leftmost:
+		for (std::size_t i = 0; i < m_skyline.size(); i += 1) {
+			std::uint32_t y;
+			
+			if (fits(i, width, height, y) && y + height < bestTop) {
+				best = i;
+				bestY = y;
+				bestTop = y + height;
+			}
+		}
+		
+		if (best == m_skyline.size())
+			return false;
+		
+		Segment segment = {m_skyline[best].x, bestTop, width};
+		
+		// The area covered below the new rectangle, including any gaps which are lost:
+		for (std::size_t i = best; i < m_skyline.size() && m_skyline[i].x < segment.x + width; i += 1) {
+			std::uint32_t overlap = std::min(m_skyline[i].x + m_skyline[i].width, segment.x + width) - m_skyline[i].x;
+			m_statistics.packedArea += std::size_t(overlap) * (bestTop - m_skyline[i].y);
+		}
+		
+		m_skyline.insert(m_skyline.begin() + best, segment);
+		
+		// Trim the segments which are now covered by the new one:
+		for (std::size_t i = best + 1; i < m_skyline.size(); ) {
+			std::uint32_t end = m_skyline[i - 1].x + m_skyline[i - 1].width;
+			
+			if (m_skyline[i].x >= end)
+				break;
+			
+			std::uint32_t shrink = end - m_skyline[i].x;
+			
+			if (m_skyline[i].width <= shrink) {
+				m_skyline.erase(m_skyline.begin() + i);
+			} else {
+				m_skyline[i].x += shrink;
+				m_skyline[i].width -= shrink;
+				
+				break;
+			}
+		}
+		
+		mergeSegments();
+		
+		rect.x = segment.x;
+		rect.y = bestY;
+		
+		return true;
+	}
+	
+	bool SkylinePacker::allocateFromFree (std::uint32_t width, std::uint32_t height, AtlasRect & rect) {
+		std::size_t best = m_free.size();
+		
+		// The smallest released rectangle which fits:
+		for (std::size_t i = 0; i < m_free.size(); i += 1) {
+			const AtlasRect & candidate = m_free[i];
+			
+			if (candidate.width >= width && candidate.height >= height && (best == m_free.size() || candidate.area() < m_free[best].area()))
+				best = i;
+		}
+		
+		if (best == m_free.size())
+			return false;
+		
+		AtlasRect reused = m_free[best];
+		m_free[best] = m_free.back();
+		m_free.pop_back();
+		
+		m_statistics.freeArea -= reused.area();
+		
+		// Return the unused parts to the free list, splitting so that the part below is as wide as possible:
+		AtlasRect right = {reused.x + width, reused.y, reused.width - width, height};
+		AtlasRect below = {reused.x, reused.y + height, reused.width, reused.height - height};
+		
+		if (right.area()) {
+			m_free.push_back(right);
+			m_statistics.freeArea += right.area();
+		}
+		
+		if (below.area()) {
+			m_free.push_back(below);
+			m_statistics.freeArea += below.area();
+		}
+		
+		rect.x = reused.x;
+		rect.y = reused.y;
+		
+		m_statistics.recycled += 1;
+		
+		return true;
+	}
+	
+	bool SkylinePacker::allocate (std::uint32_t width, std::uint32_t height, AtlasRect & rect) {
+		if (width == 0 || height == 0 || width > m_width || height > m_height)
+			return false;
+		
+		std::uint32_t paddedWidth = width + m_padding, paddedHeight = height + m_padding;
+		
+		if (!allocateFromFree(paddedWidth, paddedHeight, rect) && !allocateFromSkyline(paddedWidth, paddedHeight, rect))
+			return false;
+		
+		rect.width = width;
+		rect.height = height;
+		
+		m_statistics.allocations += 1;
+		m_statistics.usedArea += rect.area();
+		
+		return true;
+	}
+	
+	bool SkylinePacker::repack (std::vector<AtlasRect> & rects) {
+		std::size_t recycled = m_statistics.recycled;
+		
+		clear();
+		m_statistics.recycled = recycled;
+		
+		m_order.resize(rects.size());
+		
+		for (std::size_t i = 0; i < rects.size(); i += 1)
+			m_order[i] = i;
+		
+		// Tallest first, which packs a skyline most tightly:
+		std::sort(m_order.begin(), m_order.end(), [&](std::size_t a, std::size_t b) {
+			if (rects[a].height != rects[b].height)
+				return rects[a].height > rects[b].height;
+			
+			return rects[a].width > rects[b].width;
+		});
+		
+		bool fitted = true;
+		
+		for (std::size_t i = 0; i < m_order.size(); i += 1) {
+			AtlasRect & rect = rects[m_order[i]];
+			
+			if (!allocate(rect.width, rect.height, rect)) {
+				rect.width = rect.height = 0;
+				fitted = false;
+			}
+		}
+		
+		return fitted;
+	}
+	
+	/// Whether the rectangles share a full edge, so that together they make a rectangle.
+	static bool adjacent (const AtlasRect & a, const AtlasRect & b) {
+		if (a.y == b.y && a.height == b.height)
+			return a.x + a.width == b.x || b.x + b.width == a.x;
+		
+		if (a.x == b.x && a.width == b.width)
+			return a.y + a.height == b.y || b.y + b.height == a.y;
+		
+		return false;
+	}
+	
+	void SkylinePacker::release (const AtlasRect & rect) {
+		m_statistics.allocations -= 1;
+		m_statistics.usedArea -= rect.area();
+		
+		// Once everything has been released, the skyline can start again from the ground:
+		if (m_statistics.allocations == 0) {
+			std::size_t recycled = m_statistics.recycled;
+			
+			clear();
+			m_statistics.recycled = recycled;
+			
+			return;
+		}
+		
+		AtlasRect reserved = {rect.x, rect.y, rect.width + m_padding, rect.height + m_padding};
+		
+		// Merge with released neighbours, which undoes the splits made by allocateFromFree when the pieces are released again:
+		for (std::size_t i = 0; i < m_free.size(); ) {
+			const AtlasRect & other = m_free[i];
+			
+			if (!adjacent(reserved, other)) {
+				i += 1;
+				continue;
+			}
+			
+			AtlasRect merged = {std::min(reserved.x, other.x), std::min(reserved.y, other.y), 0, 0};
+			merged.width = std::max(reserved.x + reserved.width, other.x + other.width) - merged.x;
+			merged.height = std::max(reserved.y + reserved.height, other.y + other.height) - merged.y;
+			
+			reserved = merged;
+			m_statistics.freeArea -= other.area();
+			
+			m_free[i] = m_free.back();
+			m_free.pop_back();
+			
+			// The merged rectangle may now be adjacent to ones which were already checked:
+			i = 0;
+		}
+		
+		if (!lowerSkyline(reserved)) {
+			m_free.push_back(reserved);
+			m_statistics.freeArea += reserved.area();
+			
+			return;
+		}
+		
+		// Released rectangles which were below this one may now be on the surface too:
+		for (std::size_t i = 0; i < m_free.size(); ) {
+			if (lowerSkyline(m_free[i])) {
+				m_statistics.freeArea -= m_free[i].area();
+				
+				m_free[i] = m_free.back();
+				m_free.pop_back();
+				
+				i = 0;
+			} else {
+				i += 1;
+			}
+		}
+	}
+	
+	bool UploadScheduler::request (const void * handle, std::size_t bytes) {
+		if (!m_pending.insert(handle).second)
+			return false;
+		
+		Request request = {handle, bytes};
+		m_queue.push_back(request);
+		
+		return true;
+	}
+	
+	void UploadScheduler::cancel (const void * handle) {
+		m_pending.erase(handle);
+		
+		if (m_pending.empty())
+			m_queue.clear();
+	}
+	
+	bool changedRect (const std::uint8_t * previous, std::size_t previousStride, const std::uint8_t * current, std::size_t currentStride, std::uint32_t width, std::uint32_t height, AtlasRect & rect) {
+		const std::size_t rowSize = width * PIXEL_SIZE;
+		
+		std::uint32_t top = 0, bottom = height;
+		
+		while (top < height && std::memcmp(previous + top * previousStride, current + top * currentStride, rowSize) == 0)
+			top += 1;
+		
+		if (top == height)
+			return false;
+		
+		while (bottom > top && std::memcmp(previous + (bottom - 1) * previousStride, current + (bottom - 1) * currentStride, rowSize) == 0)
+			bottom -= 1;
+		
+		// The columns only need to be searched outside the range found so far:
+		std::uint32_t left = width, right = 0;
+		
+		for (std::uint32_t y = top; y < bottom; y += 1) {
+			const std::uint8_t * a = previous + y * previousStride, * b = current + y * currentStride;
+			
+			for (std::uint32_t x = 0; x < left; x += 1) {
+				if (std::memcmp(a + x * PIXEL_SIZE, b + x * PIXEL_SIZE, PIXEL_SIZE) != 0) {
+					left = x;
+					break;
+				}
+			}
+			
+			for (std::uint32_t x = width; x > right; x -= 1) {
+				if (std::memcmp(a + (x - 1) * PIXEL_SIZE, b + (x - 1) * PIXEL_SIZE, PIXEL_SIZE) != 0) {
+					right = x;
+					break;
+				}
+			}
+		}
+		
+		rect.x = left;
+		rect.y = top;
+		rect.width = right - left;
+		rect.height = bottom - top;
+		
+		return true;
+	}
+	
+	void copyRect (const std::uint8_t * source, std::size_t sourceStride, const AtlasRect & rect, std::uint8_t * destination) {
+		const std::size_t rowSize = rect.width * PIXEL_SIZE;
+		
+		for (std::uint32_t y = 0; y < rect.height; y += 1)
+			std::memcpy(destination + y * rowSize, source + (rect.y + y) * sourceStride + rect.x * PIXEL_SIZE, rowSize);
+	}
+}
@@ -0,0 +1,169 @@
+//
+//  ARBillboardAtlas.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_BILLBOARD_ATLAS_H
+#define _ARBROWSER_BILLBOARD_ATLAS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_set>
+#include <vector>
+
+namespace ARBrowser {
+	/// A rectangle of pixels in an atlas.
+	struct AtlasRect {
+		std::uint32_t x, y, width, height;
+		
+		std::size_t area () const { return std::size_t(width) * height; }
+	};
+	
+	/// Allocates rectangles in a fixed size atlas, using the skyline bottom-left heuristic. A skyline can't reclaim space below its surface, so released rectangles are kept in a free list, and later allocations take the smallest one which fits, returning the rest of it to the list. Released neighbours are merged again where they make a rectangle, and released rectangles on the surface lower the skyline instead. A gap is left between rectangles so that linear filtering doesn't bleed between them.
+	class SkylinePacker {
+		public:
+			struct Statistics {
+				std::size_t allocations, recycled;
+				
+				/// The area of live allocations, excluding padding and waste within recycled rectangles.
+				std::size_t usedArea;
+				
+				/// The area of released rectangles waiting to be reused.
+				std::size_t freeArea;
+				
+				/// The area below the skyline, which is either allocated, free or lost.
+				std::size_t packedArea;
+				
+				std::size_t totalArea;
+				
+				/// The fraction of the atlas used by live allocations.
+				double occupancy () const { return totalArea ? double(usedArea) / totalArea : 0; }
+				
+				/// The fraction of the area below the skyline which isn't used by live allocations.
+				double fragmentation () const { return packedArea ? 1.0 - double(usedArea) / packedArea : 0; }
+			};
+		
+		protected:
+			/// A horizontal part of the skyline.
+			struct Segment {
+				std::uint32_t x, y, width;
+			};
+			
+			std::uint32_t m_width, m_height, m_padding;
+			
+			/// Ordered by x, covering the full width.
+			std::vector<Segment> m_skyline;
+			
+			/// Released rectangles, including their padding.
+			std::vector<AtlasRect> m_free;
+			
+			/// Reused by repack.
+			std::vector<std::size_t> m_order;
+			
+			Statistics m_statistics;
+			
+			/// Find the lowest position for a rectangle of the given size starting at the given segment.
+			bool fits (std::size_t index, std::uint32_t width, std::uint32_t height, std::uint32_t & y) const;
+			
+			void mergeSegments ();
+			
+			/// Split the segment which spans the given position, so that a segment starts there.
+			void splitSegment (std::uint32_t x);
+			
+			/// Lower the skyline to the bottom of the given rectangle, if nothing is above it.
+			/// @returns false if the rectangle isn't on the surface.
+			bool lowerSkyline (const AtlasRect & rect);
+			
+			bool allocateFromSkyline (std::uint32_t width, std::uint32_t height, AtlasRect & rect);
+			bool allocateFromFree (std::uint32_t width, std::uint32_t height, AtlasRect & rect);
+		
+		public:
+			SkylinePacker (std::uint32_t width, std::uint32_t height, std::uint32_t padding = 1);
+			
+			std::uint32_t width () const { return m_width; }
+			std::uint32_t height () const { return m_height; }
+			
+			/// Allocate a rectangle of the given size.
+			/// @returns false if there is no room for it.
+			bool allocate (std::uint32_t width, std::uint32_t height, AtlasRect & rect);
+			
+			/// Release a rectangle returned by allocate, so that it can be reused.
+			void release (const AtlasRect & rect);
+			
+			/// Release all rectangles and reset the skyline.
+			void clear ();
+			
+			/// Release all rectangles and allocate the given ones again, tallest first, which undoes any fragmentation left by releasing and allocating. Each rectangle is moved in place, and its contents must be uploaded again.
+			/// @returns false if some no longer fit, in which case their width and height are set to zero.
+			bool repack (std::vector<AtlasRect> & rects);
+			
+			const Statistics & statistics () const { return m_statistics; }
+	};
+	
+	/// Decides which pending uploads to do in each frame, so that the bytes uploaded per frame stay within a budget. Uploads are done in the order they were requested, and a handle which is already pending isn't queued again.
+	class UploadScheduler {
+		protected:
+			struct Request {
+				const void * handle;
+				std::size_t bytes;
+			};
+			
+			std::deque<Request> m_queue;
+			
+			/// Handles which are queued and not cancelled.
+			std::unordered_set<const void *> m_pending;
+		
+		public:
+			/// Queue an upload of at most the given number of bytes.
+			/// @returns false if the handle was already pending.
+			bool request (const void * handle, std::size_t bytes);
+			
+			/// Remove the handle's pending upload, e.g. because it is being destroyed.
+			void cancel (const void * handle);
+			
+			bool pending (const void * handle) const { return m_pending.count(handle) != 0; }
+			std::size_t pendingCount () const { return m_pending.size(); }
+			
+			/// Do pending uploads until the next would exceed the budget. At least one upload is done if any are pending, so an upload larger than the budget still makes progress. upload(handle) must return the number of bytes actually uploaded, which may be less than requested.
+			/// @returns the number of bytes uploaded.
+			template <typename UploadT>
+			std::size_t process (std::size_t budget, UploadT upload) {
+				std::size_t spent = 0;
+				bool first = true;
+				
+				while (!m_queue.empty()) {
+					Request request = m_queue.front();
+					
+					// Cancelled requests are removed lazily:
+					if (!m_pending.count(request.handle)) {
+						m_queue.pop_front();
+						continue;
+					}
+					
+					if (!first && spent + request.bytes > budget)
+						break;
+					
+					m_queue.pop_front();
+					m_pending.erase(request.handle);
+					
+					spent += upload(request.handle);
+					first = false;
+				}
+				
+				return spent;
+			}
+	};
+	
+	/// Find the bounding rectangle of the pixels which differ between two images of the same size, with 4 bytes per pixel and the given row strides in bytes.
+	/// @returns false if the images are identical.
+	bool changedRect (const std::uint8_t * previous, std::size_t previousStride, const std::uint8_t * current, std::size_t currentStride, std::uint32_t width, std::uint32_t height, AtlasRect & rect);
+	
+	/// Copy a rectangle of 4 byte pixels into a packed buffer, e.g. for glTexSubImage2D, which can't skip pixels between rows in OpenGL ES 1.
+	void copyRect (const std::uint8_t * source, std::size_t sourceStride, const AtlasRect & rect, std::uint8_t * destination);
+}
+
+#endif
@@ -12,7 +12,7 @@
 #import "ARVideoFrameController.h"
 #import "ARVideoBackground.h"
 
-@class ARBrowserView, ARWorldLocation, ARWorldPoint, ARLocationController;
+@class ARBrowserView, ARWorldLocation, ARWorldPoint, ARWorldPointTiles, ARLocationController;
 
 /// The main data source/delegate for ARBrowserView
 @protocol ARBrowserViewDelegate <ARGLViewDelegate>
@@ -22,9 +22,10 @@
 
 @optional
 /// Returns a list of world points that will be rendered from a given point
+/// If this is not implemented, the points come from the view's worldPointTiles if it is set, or otherwise the points returned by worldPoints are kept in an ARWorldPointIndex, which is rebuilt whenever the array changes.
 - (NSArray*)worldPointsFromLocation:(ARWorldLocation *)origin withinDistance:(float)distance;
 
-/// Called when an object is selected on screen by the user.
+/// Called on the main thread when an object is selected on screen by the user, either by tapping it or by moving the crosshair onto it.
 - (void)browserView: (ARBrowserView*)view didSelect:(ARWorldPoint*)point;
 
 /// Render things like grids, markers, etc:
@@ -38,6 +39,9 @@
 /// The delegate for the ARBrowserView must implement ARBrowserViewDelegate.
 @property(nonatomic,assign) id<ARBrowserViewDelegate> delegate;
 
+/// Points stored in a tiled file on disk, e.g. for a whole region, which are used instead of the delegate's worldPoints unless it implements worldPointsFromLocation:withinDistance:.
+@property(retain) ARWorldPointTiles * worldPointTiles;
+
 /// Controls culling of near objects. Objects closer than this distance are not rendered.
 @property(nonatomic,assign) float minimumDistance;
 
@@ -57,7 +61,20 @@
 /// (-1, -1) is the top left, (1, 1) is the bottom right. 
 @property(assign) CGPoint radarCenter;
 
+/// Draw only the nearest of the points beyond the near distance which overlap on screen, and show their count with the point's clusterSize. The point under the crosshair is always drawn. Defaults to NO.
+@property(assign) BOOL clustersWorldPoints;
+
+/// The maximum number of objects drawn per frame, and the maximum number of triangles they are drawn with, as reported by -triangleCountAtLevelOfDetail:. Beyond these, the objects which are smallest on screen are deferred, except for the selected object and objects within the near distance. Zero means there is no limit. Defaults to 256 objects and 250,000 triangles.
+@property(assign) NSUInteger maximumDrawsPerFrame;
+@property(assign) NSUInteger maximumTrianglesPerFrame;
+
 /// Display a background horizon grid.
 @property(assign) BOOL displayGrid;
 
+/// Display a graph of the time taken by each stage of recent frames. Only available in builds with AR_PROFILING enabled, i.e. debug builds by default.
+@property(assign) BOOL displayProfiler;
+
+/// Select the object in the center of the view when it changes, e.g. when a crosshair is drawn over the view.
+@property(assign) BOOL selectsWithCrosshair;
+
 @end
@@ -14,25 +14,96 @@
 #include <TransformFlow/HybridMotionModel.h>
 #include <Euclid/Numerics/Matrix.Inverse.h>
 
-#include <Euclid/Geometry/Eye.h>
-#include <Euclid/Geometry/Line.h>
-
 #import "ARRendering.h"
 #import "ARWorldPoint.h"
 #import "ARModel.h"
+#import "ARWorldPointIndex.h"
+#import "ARWorldPointTiles.h"
+
+#include "ARVisibility.h"
+#include "ARFrustum.h"
+#include "ARPicking.h"
+#include "ARFrameProfiler.h"
+#include "ARRenderBudget.h"
+
+#include <algorithm>
+#include <cmath>
+#include <mutex>
 
 using Euclid::Numerics::Vec2;
 
+/// The time spent uploading background loaded models per frame, in seconds.
+static const NSTimeInterval ARBrowserViewModelUploadBudget = 0.004;
+
+/// The number of bytes of billboard views uploaded per frame.
+static const NSUInteger ARBrowserViewBillboardUploadBudget = 256 * 1024;
+
+/// The number of frames the picking hierarchy is refit before it is rebuilt, since it becomes less efficient as objects move relative to the viewer.
+static const std::size_t ARBrowserViewMaximumRefits = 60;
+
+/// The half size of the marker drawn in place of a model which is still loading.
+static const float ARBrowserViewMarkerSize = 0.5;
+
+/// The size of the screen space grid used to cluster overlapping points, in points.
+static const float ARBrowserViewClusterCellSize = 48;
+
+/// The default number of objects and triangles drawn per frame, beyond which the least important objects are deferred.
+static const NSUInteger ARBrowserViewMaximumDrawsPerFrame = 256;
+static const NSUInteger ARBrowserViewMaximumTrianglesPerFrame = 250000;
+
 struct ARBrowserVisibleWorldPoint {
 	float distance;
 	Vec3 delta;
 	ARWorldPoint * point;
 	
-	bool operator< (const ARBrowserVisibleWorldPoint & other) const {
-		return this->distance > other.distance;
-	}
+	/// The complete object transform, i.e. the translation to delta, the point's rotation and then its local transform.
+	Mat44 transform;
+	
+	/// Whether the model is ready, otherwise a marker is drawn in its place.
+	bool ready;
+	
+	/// The level of detail chosen for the frame.
+	NSUInteger level;
 };
 
+/// Computes the same transform as glTranslatef(delta), glRotatef(rotation, 0, 0, 1), glMultMatrixf(local), in column-major order.
+static void objectTransform (Vec3 delta, float rotation, const Mat44 & local, float * matrix)
+{
+	const float * m = local.data();
+	float c = std::cos(rotation * ARBrowser::D2R), s = std::sin(rotation * ARBrowser::D2R);
+	
+	for (std::size_t column = 0; column < 4; column += 1) {
+		const float * in = m + (column * 4);
+		float * out = matrix + (column * 4);
+		
+		out[0] = c * in[0] - s * in[1] + delta[0] * in[3];
+		out[1] = s * in[0] + c * in[1] + delta[1] * in[3];
+		out[2] = in[2] + delta[2] * in[3];
+		out[3] = in[3];
+	}
+}
+
+/// Multiply the homogeneous point by the column-major matrix.
+static void transformPoint (const float * matrix, const float * point, float * result)
+{
+	for (std::size_t row = 0; row < 4; row += 1)
+		result[row] = matrix[row] * point[0] + matrix[4 + row] * point[1] + matrix[8 + row] * point[2] + matrix[12 + row] * point[3];
+}
+
+/// The largest scale factor of the given transform along any axis.
+static float objectScale (const Mat44 & transform)
+{
+	const float * m = transform.data();
+	float scale = 0;
+	
+	for (std::size_t column = 0; column < 3; column += 1) {
+		const float * axis = m + (column * 4);
+		scale = std::max(scale, std::sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]));
+	}
+	
+	return scale;
+}
+
 static Vec2 positionInView (UIView * view, UITouch * touch)
 {
 	CGPoint locationInView = [touch locationInView:view];
@@ -50,7 +121,77 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 
 	Mat44 _projectionMatrix, _viewMatrix;
 	
-	ARBrowser::VerticesT _grid;
+	/// The points on the radar, binned by bearing and distance, and updated as the viewer moves.
+	ARBrowser::RadarClusters _radarClusters;
+	
+	/// Points beyond the near distance, binned by where they are on screen, rebuilt every frame.
+	ARBrowser::ScreenClusters _screenClusters;
+	
+	/// The visible points, in the order of the visibility table, reused between frames.
+	std::vector<ARBrowserVisibleWorldPoint> _visiblePoints;
+	
+	/// The points which are drawn, far to near, kept between frames. Only these are ordered, after culling and the render budget, as they are at most the draw limit.
+	ARBrowser::DrawOrder _drawOrder;
+	
+	/// Limits the objects and triangles drawn per frame, deferring the smallest objects on screen.
+	ARBrowser::RenderBudget _renderBudget;
+	
+	/// The visible point of each item in the render budget, reused between frames.
+	std::vector<std::uint32_t> _budgetPoints;
+	
+	/// Used to find nearby points if the delegate doesn't implement worldPointsFromLocation:withinDistance:.
+	ARWorldPointIndex * _worldPointIndex;
+	NSArray * _indexedWorldPoints;
+	
+	/// The position of nearby points, calculated once per frame and shared by the 3D view and the radar.
+	ARBrowser::VisibilityStage _visibility;
+	std::vector<ARBrowser::VisibilityPoint> _visibilityPoints;
+	
+	/// Retains the points referred to by the visibility table for the duration of the frame.
+	NSArray * _visibleWorldPoints;
+	
+	/// Scratch buffers for frustum culling, in world space, reused between frames.
+	std::vector<float> _cullCenters[3], _cullExtents[3];
+	std::vector<std::uint8_t> _cullVisible;
+	
+	/// The models drawn in the previous frame, which are told when they are no longer drawn.
+	NSMutableSet * _drawnModels;
+	
+	/// The screen cluster of each visible point, reused between frames.
+	std::vector<std::uint32_t> _clusterIndices;
+	
+	/// The number of objects drawn and culled since the statistics were last logged.
+	std::size_t _drawnCount, _culledCount;
+	
+	/// The number of objects drawn within the render budget and deferred since the statistics were last logged.
+	std::size_t _budgetDrawnCount, _budgetDeferredCount;
+	
+	/// The number of camera frames which were never drawn since the statistics were last logged.
+	std::size_t _droppedFrameCount;
+	
+	/// The hierarchy of objects which were drawn in the current frame, used to find the object under a tap or the crosshair.
+	ARBrowser::InstanceHierarchy _picking;
+	std::size_t _pickingRefits;
+	
+	/// Keeps the triangle hierarchies referred to by _picking alive for the duration of the frame.
+	std::vector<std::shared_ptr<const ARBrowser::TriangleHierarchy>> _pickingTriangles;
+	
+	/// Taps are received on the main thread and picked on the render thread, in normalized device coordinates.
+	std::mutex _tapsMutex;
+	std::vector<Vec2> _taps;
+	
+	/// The point under the crosshair in the previous frame.
+	__weak ARWorldPoint * _crosshairPoint;
+	
+#if AR_PROFILING
+	/// The time taken by each stage of recent frames, recorded on the render thread.
+	ARBrowser::FrameProfiler _profiler;
+	std::vector<ARBrowser::FrameSample> _profilerSamples;
+#endif
+	
+	/// The meshes of the models drawn in the current frame, which are drawn together to minimise state changes.
+	ARBrowser::RenderQueue _renderQueue;
+	ARBrowser::GLRenderBackend _renderBackend;
 }
 
 /// The location controller to use for position information.
@@ -74,7 +215,7 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 		self.motionModelController.motionModel = new TransformFlow::HybridMotionModel;
 		//self.motionModelController.motionModel = new TransformFlow::BasicSensorMotionModel;
 
-		ARBrowser::generateGrid(_grid);
+		_worldPointIndex = [ARWorldPointIndex new];
 		
 		_minimumDistance = 2.0;
 		_nearDistance = _minimumDistance * 2.0;
@@ -84,6 +225,12 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 
 		_displayRadar = YES;
 		
+		_clustersWorldPoints = NO;
+		_screenClusters = ARBrowser::ScreenClusters(ARBrowserViewClusterCellSize);
+		
+		_maximumDrawsPerFrame = ARBrowserViewMaximumDrawsPerFrame;
+		_maximumTrianglesPerFrame = ARBrowserViewMaximumTrianglesPerFrame;
+		
 		_radarCenter.x = -1;
 		_radarCenter.y = -1;
 	}
@@ -91,52 +238,353 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 	return self;
 }
 
-- (void) drawRadar {
-	using namespace Euclid::Numerics;
+- (NSArray*) worldPointsFromLocation:(ARWorldLocation *)origin withinDistance:(float)distance {
+	if ([self.delegate respondsToSelector:@selector(worldPointsFromLocation:withinDistance:)])
+		return [self.delegate worldPointsFromLocation:origin withinDistance:distance];
+	
+	ARWorldPointTiles * worldPointTiles = self.worldPointTiles;
+	
+	if (worldPointTiles)
+		return [worldPointTiles pointsWithinDistance:distance ofLocation:origin];
+	
+	NSArray * worldPoints = [self.delegate worldPoints];
+	
+	if (worldPoints == nil)
+		return nil;
+	
+	// Every point is within an infinite distance, so the index isn't needed:
+	if (std::isinf(distance))
+		return worldPoints;
+	
+	// Rebuild the index if the points have changed. Copying an immutable array returns the same array, so in the common case this is a pointer comparison:
+	if (worldPoints != _indexedWorldPoints && ![worldPoints isEqualToArray:_indexedWorldPoints]) {
+		_indexedWorldPoints = [worldPoints copy];
+		[_worldPointIndex setWorldPoints:_indexedWorldPoints];
+	}
+	
+	return [_worldPointIndex pointsWithinDistance:distance ofLocation:origin];
+}
 
-	ARWorldLocation * origin = [self.motionModelController worldLocation];
-	Vec3 gravity = [self.motionModelController currentGravity];
+- (void) updateVisibilityFromLocation:(ARWorldLocation *)origin {
+	AR_PROFILE_SCOPE(_profiler, STAGE_VISIBILITY);
+	
+	// Delegates which only provide every point always had them drawn out to the maximum distance, and shown on the radar however far away they are. Otherwise, points are drawn out to the far distance and shown on the radar out to twice the maximum distance:
+	BOOL everyPoint = ![self.delegate respondsToSelector:@selector(worldPointsFromLocation:withinDistance:)] && !self.worldPointTiles;
+	
+	float visibleDistance = everyPoint ? _maximumDistance : std::min(_maximumDistance, _farDistance);
+	float radarDistance = _displayRadar ? (everyPoint ? INFINITY : _maximumDistance * 2.0) : -1.0;
+	
+	_visibleWorldPoints = [self worldPointsFromLocation:origin withinDistance:std::max(visibleDistance, radarDistance)];
+	_visibilityPoints.clear();
+	
+	for (ARWorldPoint * point in _visibleWorldPoints) {
+		CLLocationCoordinate2D coordinate = point.coordinate;
+		ARBrowser::VisibilityPoint visibilityPoint = {(__bridge const void *)point, coordinate.latitude, coordinate.longitude, point.altitude};
+		
+		_visibilityPoints.push_back(visibilityPoint);
+	}
+	
+	AR_PROFILE_COUNT(_profiler, COUNTER_CONSIDERED, _visibilityPoints.size());
+	
+	// Points beyond the visible distance are only shown on the radar, and those beyond the maximum distance on its edge:
+	ARBrowser::VisibilityParameters parameters = {_minimumDistance, visibleDistance, radarDistance};
+	
+	CLLocationCoordinate2D coordinate = origin.coordinate;
+	_visibility.update(coordinate.latitude, coordinate.longitude, origin.altitude, _visibilityPoints, parameters);
+}
 
-	NSArray * worldPoints = nil;
-	if ([self.delegate respondsToSelector:@selector(worldPointsFromLocation:withinDistance:)]) {
-		worldPoints = [self.delegate worldPointsFromLocation:origin withinDistance:self.maximumDistance * 2.0];
-	} else {
-		worldPoints = self.delegate.worldPoints;
+- (void) logStatistics {
+	const ARBrowser::VisibilityStage::Statistics & statistics = _visibility.statistics();
+	
+	NSLog(@"Visibility: %lu recomputed, %lu reused, %lu rebases in %lu frames", (unsigned long)statistics.recomputed, (unsigned long)statistics.reused, (unsigned long)statistics.rebases, (unsigned long)statistics.updates);
+	_visibility.resetStatistics();
+	
+	NSLog(@"Culling: %lu drawn, %lu culled", (unsigned long)_drawnCount, (unsigned long)_culledCount);
+	_drawnCount = _culledCount = 0;
+	
+	NSLog(@"Budget: %lu drawn, %lu deferred", (unsigned long)_budgetDrawnCount, (unsigned long)_budgetDeferredCount);
+	_budgetDrawnCount = _budgetDeferredCount = 0;
+	
+	NSLog(@"Video: %lu frames dropped", (unsigned long)_droppedFrameCount);
+	_droppedFrameCount = 0;
+	
+	ARImagePool::Statistics images = [self.motionModelController imagePoolStatistics];
+	NSLog(@"Images: %lu allocated, %lu reused, %lu not pooled", (unsigned long)images.allocations, (unsigned long)images.reuses, (unsigned long)images.overflows);
+	
+	ARBrowser::FusionStatistics fusion = [self.motionModelController fusionStatistics];
+	NSLog(@"Fusion: %lu updates, %lu images skipped, %lu late", (unsigned long)fusion.processed, (unsigned long)fusion.coalesced, (unsigned long)fusion.late);
+	
+#if AR_PROFILING
+	NSLog(@"Frames: %s", ARBrowser::FrameProfiler::describe(_profiler.summary()).c_str());
+	
+	// The frame rate is included in the profile:
+	[self resetStatistics];
+#else
+	[super logStatistics];
+#endif
+}
+
+- (void) cullWorldPoints:(std::vector<ARBrowserVisibleWorldPoint> &)visibleWorldPoints {
+	AR_PROFILE_SCOPE(_profiler, STAGE_CULL);
+	
+	const std::size_t count = visibleWorldPoints.size();
+	
+	for (std::size_t axis = 0; axis < 3; axis += 1) {
+		_cullCenters[axis].resize(count);
+		_cullExtents[axis].resize(count);
 	}
 	
-	ARBrowser::VerticesT radarPoints, radarEdgePoints;
+	_cullVisible.resize(count);
 	
-	if (worldPoints) {
-		for (ARWorldPoint * point in worldPoints) {
-			// Try to speed up:
-			//Vec3 delta = point.position - origin.position;
-			
-			// This method is pretty slow:
-			Vec3 delta = [origin calculateRelativePositionOf:point];
-			// Ignore altitude in distance calculations:
-			delta[Z] = 0;
+	const ARBrowser::BoundingBox markerBox(Vec3(-ARBrowserViewMarkerSize, -ARBrowserViewMarkerSize, -ARBrowserViewMarkerSize), Vec3(ARBrowserViewMarkerSize, ARBrowserViewMarkerSize, ARBrowserViewMarkerSize));
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		ARBrowserVisibleWorldPoint & p = visibleWorldPoints[i];
+		id<ARRenderable> model = p.point.model;
+		
+		p.ready = ![model respondsToSelector:@selector(isReady)] || [model isReady];
+		objectTransform(p.delta, p.point.rotation, p.point.transform, p.transform.data());
+		
+		ARBrowser::BoundingBox box = p.ready ? [model boundingBox] : markerBox;
+		
+		float min[3], max[3];
+		ARBrowser::transformBox(p.transform.data(), box.min.data(), box.max.data(), min, max);
+		
+		for (std::size_t axis = 0; axis < 3; axis += 1) {
+			_cullCenters[axis][i] = (min[axis] + max[axis]) * 0.5f;
+			_cullExtents[axis][i] = (max[axis] - min[axis]) * 0.5f;
+		}
+	}
+	
+	// The bounding boxes are relative to the origin, which is the same space as the captured view matrix:
+	ARBrowser::Frustum frustum(_projectionMatrix.data(), _viewMatrix.data());
+	
+	std::size_t drawn = frustum.cullBoxes(count, _cullCenters[0].data(), _cullCenters[1].data(), _cullCenters[2].data(), _cullExtents[0].data(), _cullExtents[1].data(), _cullExtents[2].data(), _cullVisible.data());
+	
+	_drawnCount += drawn;
+	_culledCount += count - drawn;
+	
+	AR_PROFILE_COUNT(_profiler, COUNTER_DRAWN, drawn);
+	AR_PROFILE_COUNT(_profiler, COUNTER_CULLED, count - drawn);
+}
+
+/// Hide points beyond the near distance which are on screen in the same cell as a nearer point, and record how many points each drawn point stands for. The point under the crosshair is never hidden.
+- (void) clusterWorldPoints:(std::vector<ARBrowserVisibleWorldPoint> &)visibleWorldPoints {
+	AR_PROFILE_SCOPE(_profiler, STAGE_CULL);
+	
+	const std::size_t count = visibleWorldPoints.size();
+	
+	if (!_clustersWorldPoints) {
+		for (std::size_t i = 0; i < count; i += 1) {
+			if (_cullVisible[i])
+				visibleWorldPoints[i].point.clusterSize = 1;
+		}
+		
+		return;
+	}
+	
+	CGSize viewSize = [self bounds].size;
+	_screenClusters.clear(viewSize.width, viewSize.height);
+	
+	_clusterIndices.assign(count, ARBrowser::ScreenClusters::NONE);
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		const ARBrowserVisibleWorldPoint & p = visibleWorldPoints[i];
+		
+		// Clustering runs before picking and the render budget, so hiding the point under the crosshair would change the selection:
+		if (!_cullVisible[i] || p.distance <= _nearDistance || p.point == _crosshairPoint)
+			continue;
+		
+		// The position of the point's origin in the view, with (0, 0) at the bottom left:
+		float eye[4], clip[4];
+		transformPoint(_viewMatrix.data(), p.transform.data() + 12, eye);
+		transformPoint(_projectionMatrix.data(), eye, clip);
+		
+		// Points behind the viewer may still be partly visible, and are drawn as they are:
+		if (clip[3] <= 0)
+			continue;
+		
+		float x = (clip[0] / clip[3] + 1) * 0.5 * viewSize.width, y = (clip[1] / clip[3] + 1) * 0.5 * viewSize.height;
+		
+		_clusterIndices[i] = _screenClusters.add(i, x, y, p.distance);
+	}
+	
+	std::size_t clustered = 0;
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		if (!_cullVisible[i])
+			continue;
+		
+		NSUInteger clusterSize = 1;
+		
+		if (_clusterIndices[i] != ARBrowser::ScreenClusters::NONE) {
+			const ARBrowser::ScreenClusters::Cluster & cluster = _screenClusters.cluster(_clusterIndices[i]);
 			
-			if (delta.length() == 0) {
-				radarPoints.push_back(delta);
-			} else {
-				// Normalize the distance of the point
-				//const float LF = 10.0;
-				//float length = log10f((delta.length() / LF) + 1) * LF;
-				float length = sqrt(delta.length() / _maximumDistance);
+			if (cluster.point != i) {
+				_cullVisible[i] = 0;
+				clustered += 1;
 				
-				// Normalize the vector so we can scale its length appropriately.
-				delta = delta.normalize();
-				
-				if (length <= 1.0) {
-					delta *= (length * (ARBrowser::RadarDiameter / 2.0));
-					radarPoints.push_back(delta);
-				} else {
-					delta *= (ARBrowser::RadarDiameter / 2.0);
-					radarEdgePoints.push_back(delta);
-				}
+				continue;
 			}
+			
+			clusterSize = cluster.count;
+		}
+		
+		visibleWorldPoints[i].point.clusterSize = clusterSize;
+	}
+	
+	AR_PROFILE_COUNT(_profiler, COUNTER_CLUSTERED, clustered);
+}
+
+- (void) updatePickingHierarchy:(const std::vector<ARBrowserVisibleWorldPoint> &)visibleWorldPoints {
+	typedef ARBrowser::InstanceHierarchy::Instance InstanceT;
+	
+	std::vector<InstanceT> & instances = _picking.instances();
+	std::size_t count = 0;
+	
+	// The hierarchy can be refit rather than rebuilt if the same points are drawn in the same order:
+	bool rebuild = _pickingRefits >= ARBrowserViewMaximumRefits;
+	
+	_pickingTriangles.clear();
+	
+	for (std::size_t i = 0; i < visibleWorldPoints.size(); i += 1) {
+		if (!_cullVisible[i])
+			continue;
+		
+		const ARBrowserVisibleWorldPoint & p = visibleWorldPoints[i];
+		id<ARRenderable> model = p.point.model;
+		
+		// Models without triangles, and markers, are hit using their bounding box:
+		std::shared_ptr<const ARBrowser::TriangleHierarchy> triangles;
+		
+		if (p.ready && [model respondsToSelector:@selector(triangleHierarchy)])
+			triangles = [model triangleHierarchy];
+		
+		if (count == instances.size()) {
+			instances.push_back(InstanceT());
+			rebuild = true;
+		}
+		
+		InstanceT & instance = instances[count++];
+		
+		if (instance.handle != (__bridge void *)p.point)
+			rebuild = true;
+		
+		for (std::size_t axis = 0; axis < 3; axis += 1) {
+			instance.min[axis] = _cullCenters[axis][i] - _cullExtents[axis][i];
+			instance.max[axis] = _cullCenters[axis][i] + _cullExtents[axis][i];
+		}
+		
+		std::copy(p.transform.data(), p.transform.data() + 16, instance.transform);
+		instance.triangles = triangles.get();
+		instance.handle = (__bridge void *)p.point;
+		
+		_pickingTriangles.push_back(triangles);
+	}
+	
+	if (count != instances.size()) {
+		instances.resize(count);
+		rebuild = true;
+	}
+	
+	if (rebuild) {
+		_picking.build();
+		_pickingRefits = 0;
+	} else {
+		_picking.refit();
+		_pickingRefits += 1;
+	}
+}
+
+/// Find the nearest drawn point under the given position in normalized device coordinates. Must be called after the picking hierarchy has been updated for the current frame.
+- (ARWorldPoint *) pickWorldPointAt:(Vec2)position {
+	float origin[3], direction[3];
+	
+	if (!ARBrowser::screenRay(_projectionMatrix.data(), _viewMatrix.data(), position[0], position[1], origin, direction))
+		return nil;
+	
+	ARBrowser::InstanceHierarchy::Hit hit;
+	
+	if (_picking.pick(origin, direction, _maximumDistance, hit))
+		return (__bridge ARWorldPoint *)hit.handle;
+	
+	return nil;
+}
+
+- (void) didSelectWorldPoint:(ARWorldPoint *)point {
+	id<ARBrowserViewDelegate> delegate = self.delegate;
+	
+	if (![delegate respondsToSelector:@selector(browserView:didSelect:)])
+		return;
+	
+	// We are called on the render thread, but the delegate expects to be called on the main thread:
+	dispatch_async(dispatch_get_main_queue(), ^{
+		[delegate browserView:self didSelect:point];
+	});
+}
+
+- (void) selectWorldPoints:(const std::vector<ARBrowserVisibleWorldPoint> &)visibleWorldPoints {
+	AR_PROFILE_SCOPE(_profiler, STAGE_PICK);
+	
+	std::vector<Vec2> taps;
+	
+	{
+		std::lock_guard<std::mutex> lock(_tapsMutex);
+		taps.swap(_taps);
+	}
+	
+	if (taps.empty() && !_selectsWithCrosshair)
+		return;
+	
+	[self updatePickingHierarchy:visibleWorldPoints];
+	
+	for (const Vec2 & tap : taps) {
+		ARWorldPoint * point = [self pickWorldPointAt:tap];
+		
+		if (point)
+			[self didSelectWorldPoint:point];
+	}
+	
+	if (_selectsWithCrosshair) {
+		ARWorldPoint * point = [self pickWorldPointAt:Vec2(0, 0)];
+		
+		// The point is only selected when the crosshair first moves onto it:
+		if (point != _crosshairPoint) {
+			_crosshairPoint = point;
+			
+			if (point)
+				[self didSelectWorldPoint:point];
 		}
 	}
+}
+
+- (void)touchesEnded: (NSSet *)touches withEvent: (UIEvent *)event
+{
+	CGSize size = [self bounds].size;
+	
+	{
+		std::lock_guard<std::mutex> lock(_tapsMutex);
+		
+		for (UITouch * touch in touches) {
+			Vec2 position = positionInView(self, touch);
+			
+			_taps.push_back(Vec2(position[0] / size.width * 2.0 - 1.0, position[1] / size.height * 2.0 - 1.0));
+		}
+	}
+	
+	[super touchesEnded:touches withEvent:event];
+}
+
+- (void) drawRadar {
+	using namespace Euclid::Numerics;
+	
+	AR_PROFILE_SCOPE(_profiler, STAGE_RADAR);
+
+	ARWorldLocation * origin = [self.motionModelController worldLocation];
+	Vec3 gravity = [self.motionModelController currentGravity];
+
+	// Points are binned by bearing and distance, ignoring altitude, and the points to draw are only rebuilt when the counts change:
+	_radarClusters.update(_visibility.entries(), _maximumDistance, ARBrowser::RadarDiameter / 2.0);
 	
 	glMatrixMode(GL_PROJECTION);
 	glPushMatrix();
@@ -199,7 +647,7 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 		glRotatef([origin rotation], 0, 0, 1);
 	}
 	
-	ARBrowser::renderRadar(radarPoints, radarEdgePoints, scale / 2.0);
+	ARBrowser::renderRadar(_radarClusters, scale / 2.0);
 	
 	if (!flat) {		
 		Mat44 inverseViewMatrix = inverse(_viewMatrix);
@@ -232,13 +680,159 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 	glPopMatrix();
 }
 
+#if AR_PROFILING
+- (void) drawProfiler {
+	using namespace Euclid::Numerics;
+	
+	_profilerSamples.resize(ARBrowser::FrameProfiler::CAPACITY);
+	std::size_t count = _profiler.recentFrames(_profilerSamples.data());
+	
+	CGSize viewSize = [self bounds].size;
+	
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	
+	auto projectionBox = Euclid::Geometry::AlignedBox3::from_center_and_size(ZERO, Vec3(viewSize.width, viewSize.height, 2));
+	Mat44 orthoProjection = Euclid::Geometry::orthographic_projection_matrix(projectionBox);
+	glMultMatrixf(orthoProjection.data());
+	
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	
+	// Along the bottom of the view:
+	glTranslatef(-viewSize.width / 2.0, -viewSize.height / 2.0, 0);
+	ARBrowser::renderFrameProfile(_profilerSamples.data(), count, viewSize.width, viewSize.height / 4.0);
+	
+	glPopMatrix();
+	
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	
+	glMatrixMode(GL_MODELVIEW);
+}
+#endif
+
+/// Choose the level of detail to draw the point's model at, and remember it for the next frame.
+- (NSUInteger) levelOfDetailForPoint:(ARBrowserVisibleWorldPoint &)p focalLength:(float)focalLength {
+	id<ARRenderable> model = p.point.model;
+	NSUInteger level = 0;
+	
+	// Points within the near distance are always drawn at full detail:
+	if (p.distance > _nearDistance && [model respondsToSelector:@selector(levelOfDetailForPixelsPerUnit:previous:)]) {
+		float pixelsPerUnit = focalLength * objectScale(p.transform) / std::max(p.delta.length(), 1e-3f);
+		level = [model levelOfDetailForPixelsPerUnit:pixelsPerUnit previous:p.point.levelOfDetail];
+	}
+	
+	p.point.levelOfDetail = level;
+	
+	return level;
+}
+
+/// Choose the level of detail of each point which is still visible, and defer the smallest points on screen which don't fit in the render budget. The selected point and points within the near distance are always drawn.
+- (void) budgetWorldPoints:(std::vector<ARBrowserVisibleWorldPoint> &)visibleWorldPoints focalLength:(float)focalLength {
+	AR_PROFILE_SCOPE(_profiler, STAGE_CULL);
+	
+	_renderBudget.clear();
+	_budgetPoints.clear();
+	
+	_renderBudget.setMaximumDraws(_maximumDrawsPerFrame);
+	_renderBudget.setMaximumTriangles(_maximumTrianglesPerFrame);
+	
+	for (std::size_t i = 0; i < visibleWorldPoints.size(); i += 1) {
+		if (!_cullVisible[i])
+			continue;
+		
+		ARBrowserVisibleWorldPoint & p = visibleWorldPoints[i];
+		id<ARRenderable> model = p.point.model;
+		
+		ARBrowser::RenderBudget::Item item = {0, 0, false};
+		
+		// Markers are cheap, but still count as a draw:
+		if (p.ready) {
+			p.level = [self levelOfDetailForPoint:p focalLength:focalLength];
+			
+			if ([model respondsToSelector:@selector(triangleCountAtLevelOfDetail:)])
+				item.triangles = (std::uint32_t)[model triangleCountAtLevelOfDetail:p.level];
+		}
+		
+		// The radius of the bounding box on screen, in pixels:
+		float radius = std::sqrt(_cullExtents[0][i] * _cullExtents[0][i] + _cullExtents[1][i] * _cullExtents[1][i] + _cullExtents[2][i] * _cullExtents[2][i]);
+		item.priority = focalLength * radius / std::max(p.delta.length(), 1e-3f);
+		
+		item.required = p.point == _crosshairPoint || p.distance <= _nearDistance;
+		
+		_renderBudget.add(item);
+		_budgetPoints.push_back((std::uint32_t)i);
+	}
+	
+	_renderBudget.select();
+	
+	for (std::uint32_t index : _renderBudget.deferred())
+		_cullVisible[_budgetPoints[index]] = 0;
+	
+	const ARBrowser::RenderBudget::Statistics & statistics = _renderBudget.statistics();
+	
+	_budgetDrawnCount += statistics.drawn;
+	_budgetDeferredCount += statistics.deferred;
+	
+	AR_PROFILE_COUNT(_profiler, COUNTER_DEFERRED, statistics.deferred);
+	AR_PROFILE_COUNT(_profiler, COUNTER_TRIANGLES, statistics.triangles);
+}
+
+/// Tell the models which were not drawn this frame, but were drawn in the previous frame or are within range, that they are hidden, so that they can release what they hold for drawing.
+- (void) hideWorldPoints:(const std::vector<ARBrowserVisibleWorldPoint> &)visibleWorldPoints {
+	NSMutableSet * drawnModels = [NSMutableSet set];
+	
+	for (std::size_t i = 0; i < visibleWorldPoints.size(); i += 1) {
+		id<ARRenderable> model = visibleWorldPoints[i].point.model;
+		
+		if (_cullVisible[i] && model)
+			[drawnModels addObject:model];
+	}
+	
+	// A model may be shared by several points, so it is only hidden if none of them were drawn:
+	for (std::size_t i = 0; i < visibleWorldPoints.size(); i += 1) {
+		id<ARRenderable> model = visibleWorldPoints[i].point.model;
+		
+		if (!_cullVisible[i] && [model respondsToSelector:@selector(didBecomeHidden)] && ![drawnModels containsObject:model])
+			[model didBecomeHidden];
+	}
+	
+	// Points which have left the visible range:
+	for (id<ARRenderable> model in _drawnModels) {
+		if ([model respondsToSelector:@selector(didBecomeHidden)] && ![drawnModels containsObject:model])
+			[model didBecomeHidden];
+	}
+	
+	_drawnModels = drawnModels;
+}
+
 - (void) update {
+	AR_PROFILE_BEGIN_FRAME(_profiler);
+	
+	[self updateFrame];
+	
+#if AR_PROFILING
+	if (_displayProfiler)
+		[self drawProfiler];
+#endif
+	
+	AR_PROFILE_END_FRAME(_profiler);
+}
+
+- (void) updateFrame {
 	using namespace Euclid::Numerics;
 
 	if (videoFrameController) {
+		AR_PROFILE_SCOPE(_profiler, STAGE_VIDEO);
+		
 		ARVideoFrame * videoFrame = [videoFrameController videoFrame];
 		
 		if (videoFrame && videoFrame->data) {
+			_droppedFrameCount += videoFrame->dropped;
+			
 			[videoBackground update:videoFrame];
 			[videoBackground drawWithViewportSize:self.bounds.size];
 		}
@@ -248,9 +842,20 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 	
 	glEnable(GL_DEPTH_TEST);
 	glClear(GL_DEPTH_BUFFER_BIT);
+	
+	// Finish models which have loaded in the background, and upload billboards which have changed, without stalling the frame:
+	{
+		AR_PROFILE_SCOPE(_profiler, STAGE_MODEL_UPLOAD);
+		[ARModel processPendingLoadsWithinTime:ARBrowserViewModelUploadBudget];
+		[ARModel processPendingBillboardUpdatesWithinBytes:ARBrowserViewBillboardUploadBudget];
+	}
 
-	if (![self.motionModelController localizationValid])
+	if (![self.motionModelController localizationValid]) {
+		// Nothing is drawn until the location is known again:
+		[self hideWorldPoints:std::vector<ARBrowserVisibleWorldPoint>()];
+		
 		return;
+	}
 
 	Vec3 gravity = [self.motionModelController currentGravity];
 	ARWorldLocation * origin = [self.motionModelController worldLocation];
@@ -279,7 +884,7 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 	glLineWidth(2.0);
 	
 	if (_displayGrid) {
-		ARBrowser::renderVertices(_grid);
+		ARBrowser::renderGrid();
 		ARBrowser::renderAxis();
 	}
 	
@@ -301,88 +906,88 @@ static Vec2 positionInView (UIView * view, UITouch * touch)
 		[self.delegate renderInLocalCoordinatesForBrowserView:self];
 	}
 	
-	NSArray * worldPoints = nil;
-	if ([self.delegate respondsToSelector:@selector(worldPointsFromLocation:withinDistance:)]) {
-		worldPoints = [self.delegate worldPointsFromLocation:origin withinDistance:self.farDistance];
-	} else {
-		worldPoints = [self.delegate worldPoints];
-	}
+	[self updateVisibilityFromLocation:origin];
 	
-	if (worldPoints == nil) {
-		return;
+	std::vector<ARBrowserVisibleWorldPoint> & visibleWorldPoints = _visiblePoints;
+	
+	visibleWorldPoints.clear();
+	
+	for (const ARBrowser::VisibilityEntry & entry : _visibility.entries()) {
+		if (entry.flags & ARBrowser::VisibilityEntry::VISIBLE)
+			visibleWorldPoints.push_back((ARBrowserVisibleWorldPoint){entry.distance, entry.delta, (__bridge ARWorldPoint *)entry.handle});
 	}
 	
-	std::vector<ARBrowserVisibleWorldPoint> visibleWorldPoints;
+	// Cull objects whose transformed bounding box is outside the view frustum:
+	[self cullWorldPoints:visibleWorldPoints];
+	
+	// Hide objects behind a nearer object on screen:
+	[self clusterWorldPoints:visibleWorldPoints];
+	
+	// The size in pixels of one unit at a distance of one unit, used to choose the level of detail:
+	const float focalLength = self.surfaceSize.height * 0.5 * _projectionMatrix.data()[5];
+	
+	// Defer the least important objects if there are too many to draw:
+	[self budgetWorldPoints:visibleWorldPoints focalLength:focalLength];
 
-	for (ARWorldPoint * point in worldPoints) {
-		Vec3 delta = [origin calculateRelativePositionOf:point];
-		
-		//NSLog(@"Delta: %0.3f, %0.3f, %0.3f", delta.x, delta.y, delta.z);
-		
-		// Distance as a bird flies (e.g. ignoring altitude)
-		Vec3 birdFlys = delta;
-		birdFlys[Z] = 0;
+	// Find the objects under any taps and the crosshair:
+	[self selectWorldPoints:visibleWorldPoints];
+	
+	{
+		AR_PROFILE_SCOPE(_profiler, STAGE_SORT);
 		
-		// Calculate actual (non-scaled) distance.
-		float distance = birdFlys.length();
+		// Depth sort the objects which are drawn, starting from the last frame's order:
+		_drawOrder.clear();
 		
-		if (distance < _minimumDistance || distance > _maximumDistance) {
-			continue;
+		for (std::size_t i = 0; i < visibleWorldPoints.size(); i += 1) {
+			const ARBrowserVisibleWorldPoint & p = visibleWorldPoints[i];
+			
+			if (_cullVisible[i])
+				_drawOrder.add((ARBrowser::DrawOrder::Item){(__bridge const void *)p.point, p.distance, (std::uint32_t)i});
 		}
 		
-		visibleWorldPoints.push_back((ARBrowserVisibleWorldPoint){distance, delta, point});
+		_drawOrder.sort();
 	}
 	
-	// Depth sort the visible objects.
-	std::sort(visibleWorldPoints.begin(), visibleWorldPoints.end());
-
-	Euclid::Geometry::Line3 forward;
-
 	{
-		using namespace Euclid::Geometry;
-
-		auto eye_transform = eye_transformation(_projectionMatrix, _viewMatrix);
-		auto eye = eye_transform.convert_from_normalized_space_to_object_space(Vec3(0, 0, -1));
-
-		forward = eye.forward;
-	}
-
-	for (std::size_t i = 0; i < visibleWorldPoints.size(); i += 1) {
-		ARBrowserVisibleWorldPoint & p = visibleWorldPoints[i];
-
-		auto t = forward.time_for_closest_point(p.delta);
-		auto closest = forward.point_at_time(t);
-		auto distance = (closest - p.delta).length();
-
-		if (distance < 0.05 && t > 0) {
-			// Randomly move the point somewhere else:
-			CLLocationCoordinate2D c = origin.coordinate;
-
-			AudioServicesPlaySystemSound(kSystemSoundID_Vibrate);
-
-			NSLog(@"Coordinate: %0.8f, %0.8f", c.latitude, c.longitude);
-
-			c.latitude += (((double(rand()) / RAND_MAX) * 2.0) - 1.0) * 0.0001;
-			c.longitude += (((double(rand()) / RAND_MAX) * 2.0) - 1.0) * 0.0001;
-
-			NSLog(@"Updated: %0.8f, %0.8f", c.latitude, c.longitude);
-
-			[p.point setCoordinate:c altitude:p.point.altitude];
-		} else if (distance < 2.0) {
-
-		}
-
-		glPushMatrix();
+		AR_PROFILE_SCOPE(_profiler, STAGE_DRAW);
+		
+		_renderQueue.clear();
 		
-		glTranslatef(p.delta[X], p.delta[Y], p.delta[Z]);
+		for (const ARBrowser::DrawOrder::Item & item : _drawOrder.items()) {
+			ARBrowserVisibleWorldPoint & p = visibleWorldPoints[item.index];
+			id<ARRenderable> model = p.point.model;
+			
+			// Models which can be queued are drawn together after the loop:
+			if (p.ready && [model respondsToSelector:@selector(enqueueAtLevelOfDetail:transform:depth:inQueue:)]) {
+				[model enqueueAtLevelOfDetail:p.level transform:p.transform.data() depth:p.distance inQueue:_renderQueue];
+				
+				continue;
+			}
+			
+			glPushMatrix();
+			glMultMatrixf(p.transform.data());
+			
+			if (!p.ready) {
+				ARBrowser::renderMarker(ARBrowserViewMarkerSize);
+				glColor4f(1.0, 1.0, 1.0, 1.0);
+			} else if ([model respondsToSelector:@selector(drawAtLevelOfDetail:)]) {
+				[model drawAtLevelOfDetail:p.level];
+			} else {
+				[model draw];
+			}
+			
+			glPopMatrix();
+		}
 		
-		glRotatef(p.point.rotation, 0.0, 0.0, 1.0);
-		glMultMatrixf(p.point.transform.data());
-		[p.point.model draw];
+		// Grouped by texture and vertex array, opaque meshes front to back and then translucent meshes back to front:
+		_renderQueue.submit(_renderBackend, _viewMatrix.data());
 		
-		glPopMatrix();
+		AR_PROFILE_COUNT(_profiler, COUNTER_DRAW_CALLS, _renderQueue.statistics().draws);
+		AR_PROFILE_COUNT(_profiler, COUNTER_STATE_CHANGES, _renderQueue.statistics().stateChanges());
 	}
 	
+	[self hideWorldPoints:visibleWorldPoints];
+	
 	if (_displayRadar)
 		[self drawRadar];
 	
@@ -46,6 +46,9 @@
 
 	[browserView addSubview:imageView];
 	imageView.center = browserView.center;
+	
+	// Select whatever is under the crosshair:
+	[browserView setSelectsWithCrosshair:YES];
 
 	[self setView:browserView];
 }
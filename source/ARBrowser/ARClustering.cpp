@@ -0,0 +1,161 @@
+//
+//  ARClustering.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARClustering.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace ARBrowser {
+	const std::size_t RadarClusters::SIZE_CLASSES;
+	const std::uint32_t ScreenClusters::NONE;
+	
+	RadarClusters::RadarClusters (std::size_t sectors, std::size_t rings) : m_sectors(sectors), m_rings(rings), m_maximumDistance(0), m_radius(0), m_sectorScale(sectors / 360.0f), m_ringScale(0), m_hidden(std::uint32_t(sectors * (rings + 1))) {
+		for (std::size_t i = 0; i < m_sectors; i += 1) {
+			// Clockwise from north, i.e. +Y, towards east, i.e. +X:
+			double angle = (i + 0.5) * (2.0 * M_PI / m_sectors);
+			
+			m_directions.push_back(Vec3(std::sin(angle), std::cos(angle), 0));
+		}
+		
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+	}
+	
+	std::uint32_t RadarClusters::binFor (const VisibilityEntry & entry) const {
+		// Written without branches, as the bins of neighbouring entries are unrelated and the branches would be mispredicted:
+		float bearing = entry.bearing + (entry.bearing < 0 ? 360.0f : 0.0f);
+		std::uint32_t sector = std::uint32_t(std::max(0.0f, std::min(float(m_sectors - 1), bearing * m_sectorScale)));
+		
+		// The radius is proportional to the square root of the distance, so that nearby points are spread out. Points beyond the maximum distance are in the extra ring:
+		std::uint32_t ring = std::uint32_t(std::min(float(m_rings - 1), std::sqrt(entry.distance * m_ringScale)));
+		ring += entry.distance > m_maximumDistance;
+		
+		std::uint32_t bin = ring * std::uint32_t(m_sectors) + sector;
+		
+		return (entry.flags & VisibilityEntry::RADAR) ? bin : m_hidden;
+	}
+	
+	std::size_t RadarClusters::sizeClass (std::uint32_t count) {
+		if (count < 2)
+			return 0;
+		else if (count < 4)
+			return 1;
+		else if (count < 16)
+			return 2;
+		else
+			return 3;
+	}
+	
+	void RadarClusters::rebuild () {
+		for (std::size_t edge = 0; edge < 2; edge += 1) {
+			for (std::size_t i = 0; i < SIZE_CLASSES; i += 1)
+				m_points[edge][i].clear();
+		}
+		
+		m_statistics.bins = 0;
+		
+		for (std::size_t ring = 0; ring <= m_rings; ring += 1) {
+			bool edge = ring == m_rings;
+			float radius = edge ? m_radius : (ring + 0.5f) * (m_radius / m_rings);
+			
+			for (std::size_t sector = 0; sector < m_sectors; sector += 1) {
+				std::uint32_t count = m_counts[ring * m_sectors + sector];
+				
+				if (count == 0)
+					continue;
+				
+				m_points[edge][sizeClass(count)].push_back(m_directions[sector] * radius);
+				m_statistics.bins += 1;
+			}
+		}
+	}
+	
+	bool RadarClusters::update (const std::vector<VisibilityEntry> & entries, float maximumDistance, float radius) {
+		bool changed = maximumDistance != m_maximumDistance || radius != m_radius;
+		
+		m_maximumDistance = maximumDistance;
+		m_radius = radius;
+		m_ringScale = m_rings * m_rings / maximumDistance;
+		
+		// Counting from scratch is a single pass, which is cheaper than tracking the bin of every point between updates:
+		m_counts.swap(m_previousCounts);
+		m_counts.assign(m_hidden + 1, 0);
+		
+		for (std::size_t i = 0; i < entries.size(); i += 1) {
+			m_counts[binFor(entries[i])] += 1;
+		}
+		
+		m_statistics.points = entries.size() - m_counts[m_hidden];
+		m_counts[m_hidden] = 0;
+		
+		// There are few bins, so the points to draw are rebuilt from the counts rather than patched:
+		if (changed || m_counts != m_previousCounts) {
+			rebuild();
+			
+			return true;
+		}
+		
+		return false;
+	}
+	
+	ScreenClusters::ScreenClusters (float cellSize) : m_cellSize(cellSize), m_columns(0), m_rows(0), m_generation(0) {
+	}
+	
+	void ScreenClusters::clear (float width, float height) {
+		m_columns = width > 0 ? std::size_t(std::ceil(width / m_cellSize)) : 0;
+		m_rows = height > 0 ? std::size_t(std::ceil(height / m_cellSize)) : 0;
+		
+		if (m_cells.size() < cellCount()) {
+			m_cells.resize(cellCount());
+			m_generations.resize(cellCount(), 0);
+		}
+		
+		m_generation += 1;
+		
+		// Start again once the generation wraps around, since stale cells could otherwise appear current:
+		if (m_generation == 0) {
+			std::fill(m_generations.begin(), m_generations.end(), 0);
+			m_generation = 1;
+		}
+		
+		m_clusters.clear();
+	}
+	
+	std::uint32_t ScreenClusters::add (std::uint32_t point, float x, float y, float depth) {
+		// Also rejects NaN:
+		if (!(x >= 0 && y >= 0))
+			return NONE;
+		
+		std::size_t column = std::size_t(x / m_cellSize), row = std::size_t(y / m_cellSize);
+		
+		if (column >= m_columns || row >= m_rows)
+			return NONE;
+		
+		std::size_t cell = row * m_columns + column;
+		
+		if (m_generations[cell] != m_generation) {
+			Cluster cluster = {point, depth, 1};
+			
+			m_generations[cell] = m_generation;
+			m_cells[cell] = std::uint32_t(m_clusters.size());
+			m_clusters.push_back(cluster);
+		} else {
+			Cluster & cluster = m_clusters[m_cells[cell]];
+			
+			if (depth < cluster.depth) {
+				cluster.point = point;
+				cluster.depth = depth;
+			}
+			
+			cluster.count += 1;
+		}
+		
+		return m_cells[cell];
+	}
+}
@@ -0,0 +1,118 @@
+//
+//  ARClustering.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_CLUSTERING_H
+#define _ARBROWSER_CLUSTERING_H
+
+#include "ARVisibility.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace ARBrowser {
+	/// Aggregates the points shown on the radar into polar bins, by bearing and distance, so that drawing the radar costs at most one point per bin however many points there are.
+	/// The points are counted again on every update, which is a single pass over the visibility table, but the points to draw are only rebuilt when the counts change.
+	class RadarClusters {
+		public:
+			/// Bins are drawn larger the more points they hold: 1, 2 to 3, 4 to 15, or more.
+			static const std::size_t SIZE_CLASSES = 4;
+			
+			struct Statistics {
+				/// Points on the radar in the last update.
+				std::size_t points;
+				/// Bins holding at least one point.
+				std::size_t bins;
+			};
+		
+		protected:
+			std::size_t m_sectors, m_rings;
+			float m_maximumDistance, m_radius;
+			
+			/// Convert a bearing to a sector, and a distance to the square of a ring.
+			float m_sectorScale, m_ringScale;
+			
+			/// The number of points in each bin, by ring and then sector. An extra ring holds points beyond the maximum distance, which are drawn on the edge.
+			std::vector<std::uint32_t> m_counts;
+			
+			/// The bin after the last ring, which counts the points that aren't on the radar, so that counting doesn't need to check.
+			std::uint32_t m_hidden;
+			
+			/// The counts of the previous update, to tell whether the points to draw changed.
+			std::vector<std::uint32_t> m_previousCounts;
+			
+			/// The unit direction of the centre of each sector.
+			std::vector<Vec3> m_directions;
+			
+			/// The centres of non-empty bins, by whether they are on the edge and their size class.
+			std::vector<Vec3> m_points[2][SIZE_CLASSES];
+			
+			Statistics m_statistics;
+			
+			std::uint32_t binFor (const VisibilityEntry & entry) const;
+			
+			void rebuild ();
+		
+		public:
+			RadarClusters (std::size_t sectors = 72, std::size_t rings = 16);
+			
+			/// Update the bins from the visibility table.
+			/// @param maximumDistance points further away than this are placed on the edge of the radar.
+			/// @param radius the radius of the radar, i.e. of the outermost bins.
+			/// @returns true if the points to draw changed.
+			bool update (const std::vector<VisibilityEntry> & entries, float maximumDistance, float radius);
+			
+			/// The points to draw for bins of the given size class, either within the maximum distance or on the edge.
+			const std::vector<Vec3> & points (bool edge, std::size_t sizeClass) const { return m_points[edge][sizeClass]; }
+			
+			static std::size_t sizeClass (std::uint32_t count);
+			
+			const Statistics & statistics () const { return m_statistics; }
+	};
+	
+	/// Groups points by the cell of a screen space grid they fall in, so that only the nearest point in each cell needs to be drawn.
+	class ScreenClusters {
+		public:
+			static const std::uint32_t NONE = ~std::uint32_t(0);
+			
+			struct Cluster {
+				/// The nearest point in the cell, which represents the others.
+				std::uint32_t point;
+				float depth;
+				
+				std::uint32_t count;
+			};
+		
+		protected:
+			float m_cellSize;
+			std::size_t m_columns, m_rows;
+			
+			/// The cluster in each cell, which is only valid if the cell's generation is current, so that the grid doesn't need to be cleared.
+			std::vector<std::uint32_t> m_cells, m_generations;
+			std::uint32_t m_generation;
+			
+			std::vector<Cluster> m_clusters;
+		
+		public:
+			/// @param cellSize the size of each cell, in the same units as the positions given to add.
+			ScreenClusters (float cellSize = 48);
+			
+			/// Remove all points, and resize the grid to cover a viewport of the given size.
+			void clear (float width, float height);
+			
+			/// Add a point at the given position within the viewport, with its distance from the viewer.
+			/// @returns the cluster the point was added to, or NONE if it is outside the viewport.
+			std::uint32_t add (std::uint32_t point, float x, float y, float depth);
+			
+			const Cluster & cluster (std::uint32_t index) const { return m_clusters[index]; }
+			const std::vector<Cluster> & clusters () const { return m_clusters; }
+			
+			std::size_t cellCount () const { return m_columns * m_rows; }
+	};
+}
+
+#endif
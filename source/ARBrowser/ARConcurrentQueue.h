@@ -0,0 +1,85 @@
+//
+//  ARConcurrentQueue.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_CONCURRENT_QUEUE_H
+#define _ARBROWSER_CONCURRENT_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+namespace ARBrowser {
+	/// An unbounded queue which any number of threads can push to without locking, and one thread pops from (Vyukov's intrusive MPSC queue). Pushing is a single atomic exchange, so producers never wait for each other or for the consumer.
+	template <typename ValueT>
+	class ConcurrentQueue {
+		protected:
+			struct Node {
+				std::atomic<Node *> next;
+				ValueT value;
+				
+				Node () : next(nullptr) {}
+				explicit Node (ValueT && value_) : next(nullptr), value(std::move(value_)) {}
+			};
+			
+			/// The most recently pushed node, shared by the producers.
+			std::atomic<Node *> m_head;
+			
+			/// A node whose value has already been popped. The next node is the first in the queue. Only used by the consumer.
+			Node * m_tail;
+		
+		public:
+			ConcurrentQueue () {
+				m_tail = new Node;
+				m_head.store(m_tail, std::memory_order_relaxed);
+			}
+			
+			~ConcurrentQueue () {
+				ValueT value;
+				
+				while (pop(value));
+				
+				delete m_tail;
+			}
+			
+			/// Push a value, from any thread.
+			void push (ValueT value) {
+				Node * node = new Node(std::move(value));
+				
+				Node * previous = m_head.exchange(node, std::memory_order_acq_rel);
+				
+				// Until this store, the consumer sees the queue as ending at previous:
+				previous->next.store(node, std::memory_order_release);
+			}
+			
+			/// Pop the oldest value, from the consumer thread only.
+			/// @returns false if the queue is empty, or a push is still in progress.
+			bool pop (ValueT & value) {
+				Node * next = m_tail->next.load(std::memory_order_acquire);
+				
+				if (next == nullptr)
+					return false;
+				
+				value = std::move(next->value);
+				
+				delete m_tail;
+				m_tail = next;
+				
+				return true;
+			}
+			
+			/// Whether there is a value to pop, from the consumer thread only.
+			bool empty () const {
+				return m_tail->next.load(std::memory_order_acquire) == nullptr;
+			}
+		
+		private:
+			ConcurrentQueue (const ConcurrentQueue &);
+			ConcurrentQueue & operator= (const ConcurrentQueue &);
+	};
+}
+
+#endif
@@ -0,0 +1,151 @@
+//
+//  ARFrameProfiler.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARFrameProfiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace ARBrowser {
+	const char * frameStageName (FrameStage stage) {
+		static const char * NAMES[FRAME_STAGES] = {"frame", "video", "model upload", "visibility", "sort", "cull", "pick", "draw", "radar"};
+		
+		return NAMES[stage];
+	}
+	
+	const char * frameCounterName (FrameCounter counter) {
+		static const char * NAMES[FRAME_COUNTERS] = {"considered", "culled", "drawn", "clustered", "deferred", "triangles", "draw calls", "state changes"};
+		
+		return NAMES[counter];
+	}
+	
+	/// Nearest rank percentiles of the given values, which are sorted in place.
+	static FrameProfiler::Percentiles percentiles (std::vector<double> & values) {
+		FrameProfiler::Percentiles result = {0, 0, 0, 0};
+		
+		if (values.empty())
+			return result;
+		
+		std::sort(values.begin(), values.end());
+		
+		const std::size_t last = values.size() - 1;
+		
+		result.p50 = values[last * 50 / 100];
+		result.p95 = values[last * 95 / 100];
+		result.p99 = values[last * 99 / 100];
+		result.maximum = values[last];
+		
+		return result;
+	}
+	
+	FrameProfiler::FrameProfiler () : m_count(0), m_started(false) {
+		std::memset(&m_current, 0, sizeof(m_current));
+	}
+	
+	void FrameProfiler::beginFrame () {
+		ClockT::time_point now = ClockT::now();
+		
+		std::memset(&m_current, 0, sizeof(m_current));
+		
+		if (m_started)
+			m_current.interval = (std::uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_start).count();
+		
+		m_start = now;
+		m_started = true;
+	}
+	
+	void FrameProfiler::endFrame () {
+		addTime(STAGE_FRAME, ClockT::now() - m_start);
+		
+		std::uint64_t count = m_count.load(std::memory_order_relaxed);
+		
+		m_frames[count % CAPACITY].store(m_current);
+		m_count.store(count + 1, std::memory_order_release);
+	}
+	
+	std::size_t FrameProfiler::recentFrames (FrameSample * samples, std::size_t count) const {
+		std::uint64_t end = frameCount();
+		
+		count = (std::size_t)std::min<std::uint64_t>(std::min<std::size_t>(count, CAPACITY), end);
+		
+		// If the recording thread overwrites the oldest frames while they are copied, a newer frame is copied instead, which doesn't matter for a summary:
+		for (std::size_t i = 0; i < count; i += 1)
+			samples[i] = m_frames[(end - count + i) % CAPACITY].load();
+		
+		return count;
+	}
+	
+	FrameProfiler::Summary FrameProfiler::summary () const {
+		std::vector<FrameSample> samples(CAPACITY);
+		std::size_t count = recentFrames(samples.data());
+		
+		Summary summary;
+		std::memset(&summary, 0, sizeof(summary));
+		summary.frames = count;
+		
+		std::vector<double> values;
+		values.reserve(count);
+		
+		for (std::size_t i = 0; i < count; i += 1) {
+			// The first frame recorded has no interval:
+			if (samples[i].interval)
+				values.push_back(samples[i].interval / 1e9);
+		}
+		
+		Percentiles interval = percentiles(values);
+		
+		if (interval.p50 > 0)
+			summary.framesPerSecond = 1.0 / interval.p50;
+		
+		for (std::size_t stage = 0; stage < FRAME_STAGES; stage += 1) {
+			values.clear();
+			
+			for (std::size_t i = 0; i < count; i += 1)
+				values.push_back(samples[i].stages[stage] / 1e6);
+			
+			summary.stages[stage] = percentiles(values);
+		}
+		
+		for (std::size_t counter = 0; counter < FRAME_COUNTERS; counter += 1) {
+			values.clear();
+			
+			for (std::size_t i = 0; i < count; i += 1)
+				values.push_back(samples[i].counters[counter]);
+			
+			summary.counters[counter] = percentiles(values);
+		}
+		
+		return summary;
+	}
+	
+	std::string FrameProfiler::describe (const Summary & summary) {
+		std::string description;
+		char line[160];
+		
+		std::snprintf(line, sizeof(line), "%lu frames, %0.1f frames per second\n", (unsigned long)summary.frames, summary.framesPerSecond);
+		description += line;
+		
+		for (std::size_t stage = 0; stage < FRAME_STAGES; stage += 1) {
+			const Percentiles & p = summary.stages[stage];
+			
+			std::snprintf(line, sizeof(line), "\t%-14s p50 %6.2fms  p95 %6.2fms  p99 %6.2fms  max %6.2fms\n", frameStageName((FrameStage)stage), p.p50, p.p95, p.p99, p.maximum);
+			description += line;
+		}
+		
+		for (std::size_t counter = 0; counter < FRAME_COUNTERS; counter += 1) {
+			const Percentiles & p = summary.counters[counter];
+			
+			std::snprintf(line, sizeof(line), "\t%-14s p50 %6.0f    p95 %6.0f    p99 %6.0f    max %6.0f\n", frameCounterName((FrameCounter)counter), p.p50, p.p95, p.p99, p.maximum);
+			description += line;
+		}
+		
+		return description;
+	}
+}
@@ -0,0 +1,197 @@
+//
+//  ARFrameProfiler.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_FRAME_PROFILER_H
+#define _ARBROWSER_FRAME_PROFILER_H
+
+#include "ARSeqlock.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// Profiling is compiled in to debug builds only, unless AR_PROFILING is defined. When it is 0, the AR_PROFILE macros expand to nothing and their arguments are not evaluated.
+#ifndef AR_PROFILING
+	#ifdef DEBUG
+		#define AR_PROFILING 1
+	#else
+		#define AR_PROFILING 0
+	#endif
+#endif
+
+namespace ARBrowser {
+	/// The stages of drawing a frame of ARBrowserView, which are timed separately.
+	enum FrameStage {
+		/// The whole frame, including stages which aren't timed separately.
+		STAGE_FRAME,
+		
+		/// Uploading and drawing the camera image.
+		STAGE_VIDEO,
+		
+		/// Finishing models which were loaded in the background.
+		STAGE_MODEL_UPLOAD,
+		
+		/// Finding nearby world points and calculating their positions relative to the viewer.
+		STAGE_VISIBILITY,
+		
+		/// Ordering the points which are drawn by distance, starting from the last frame's order.
+		STAGE_SORT,
+		
+		/// Frustum culling.
+		STAGE_CULL,
+		
+		/// Finding the points under taps and the crosshair.
+		STAGE_PICK,
+		
+		/// Drawing models and markers.
+		STAGE_DRAW,
+		
+		STAGE_RADAR,
+		
+		FRAME_STAGES
+	};
+	
+	enum FrameCounter {
+		/// Points returned by the world point query.
+		COUNTER_CONSIDERED,
+		COUNTER_CULLED,
+		COUNTER_DRAWN,
+		
+		/// Points hidden because a nearer point overlaps them on screen.
+		COUNTER_CLUSTERED,
+		
+		/// Points which didn't fit in the render budget, and the triangles drawn by those which did.
+		COUNTER_DEFERRED,
+		COUNTER_TRIANGLES,
+		
+		/// Draw calls and state changes made by the render queue.
+		COUNTER_DRAW_CALLS,
+		COUNTER_STATE_CHANGES,
+		
+		FRAME_COUNTERS
+	};
+	
+	const char * frameStageName (FrameStage stage);
+	const char * frameCounterName (FrameCounter counter);
+	
+	/// The stage timings and counters of one frame.
+	struct FrameSample {
+		/// The time since the start of the previous frame, in nanoseconds.
+		std::uint32_t interval;
+		
+		/// In nanoseconds.
+		std::uint32_t stages[FRAME_STAGES];
+		std::uint32_t counters[FRAME_COUNTERS];
+	};
+	
+	/// Records the time spent in each stage of recent frames, and counts of the work done. One thread records frames, and any thread can read a summary: completed frames are kept in a fixed size ring of seqlocks, so neither side ever waits for the other.
+	class FrameProfiler {
+		public:
+			typedef std::chrono::steady_clock ClockT;
+			
+			/// The number of frames kept, i.e. about 4 seconds at 60 frames per second.
+			enum { CAPACITY = 256 };
+			
+			struct Percentiles {
+				double p50, p95, p99, maximum;
+			};
+			
+			struct Summary {
+				std::size_t frames;
+				
+				/// Based on the median interval between frames.
+				double framesPerSecond;
+				
+				/// In milliseconds.
+				Percentiles stages[FRAME_STAGES];
+				
+				/// Per frame.
+				Percentiles counters[FRAME_COUNTERS];
+			};
+		
+		protected:
+			Seqlock<FrameSample> m_frames[CAPACITY];
+			
+			/// The number of frames recorded so far. Frame i is stored in m_frames[i % CAPACITY].
+			std::atomic<std::uint64_t> m_count;
+			
+			/// The frame being recorded, only used by the recording thread.
+			FrameSample m_current;
+			ClockT::time_point m_start;
+			bool m_started;
+		
+		public:
+			FrameProfiler ();
+			
+			/// Start recording a frame. Stage times and counts are added to the frame until it ends.
+			void beginFrame ();
+			
+			/// Finish the current frame and make it visible to readers.
+			void endFrame ();
+			
+			void addTime (FrameStage stage, ClockT::duration duration) {
+				m_current.stages[stage] += (std::uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+			}
+			
+			void addCount (FrameCounter counter, std::size_t count) {
+				m_current.counters[counter] += (std::uint32_t)count;
+			}
+			
+			/// The number of frames recorded since the profiler was created.
+			std::uint64_t frameCount () const { return m_count.load(std::memory_order_acquire); }
+			
+			/// Copy the most recent frames, oldest first, into samples, which must have room for CAPACITY frames.
+			/// @returns the number of frames copied.
+			std::size_t recentFrames (FrameSample * samples, std::size_t count = CAPACITY) const;
+			
+			/// Summarize the most recent frames, up to CAPACITY.
+			Summary summary () const;
+			
+			/// A description of the summary, with one line per stage and counter.
+			static std::string describe (const Summary & summary);
+	};
+	
+	/// Adds the time from construction to destruction to a stage of the current frame.
+	class ProfileScope {
+		protected:
+			FrameProfiler & m_profiler;
+			FrameStage m_stage;
+			FrameProfiler::ClockT::time_point m_start;
+		
+		public:
+			ProfileScope (FrameProfiler & profiler, FrameStage stage) : m_profiler(profiler), m_stage(stage), m_start(FrameProfiler::ClockT::now()) {
+			}
+			
+			~ProfileScope () {
+				m_profiler.addTime(m_stage, FrameProfiler::ClockT::now() - m_start);
+			}
+		
+		private:
+			ProfileScope (const ProfileScope &);
+			ProfileScope & operator= (const ProfileScope &);
+	};
+}
+
+#define AR_PROFILE_CONCATENATE_(a, b) a##b
+#define AR_PROFILE_CONCATENATE(a, b) AR_PROFILE_CONCATENATE_(a, b)
+
+#if AR_PROFILING
+	/// Time the rest of the enclosing scope as the given stage.
+	#define AR_PROFILE_SCOPE(profiler, stage) ARBrowser::ProfileScope AR_PROFILE_CONCATENATE(_profileScope, __LINE__)((profiler), ARBrowser::stage)
+	#define AR_PROFILE_COUNT(profiler, counter, count) (profiler).addCount(ARBrowser::counter, (count))
+	#define AR_PROFILE_BEGIN_FRAME(profiler) (profiler).beginFrame()
+	#define AR_PROFILE_END_FRAME(profiler) (profiler).endFrame()
+#else
+	#define AR_PROFILE_SCOPE(profiler, stage)
+	#define AR_PROFILE_COUNT(profiler, counter, count)
+	#define AR_PROFILE_BEGIN_FRAME(profiler)
+	#define AR_PROFILE_END_FRAME(profiler)
+#endif
+
+#endif
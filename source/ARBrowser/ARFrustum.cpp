@@ -0,0 +1,257 @@
+//
+//  ARFrustum.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARFrustum.h"
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(__SSE2__)
+	#include <xmmintrin.h>
+	#define AR_FRUSTUM_SSE
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define AR_FRUSTUM_NEON
+#endif
+
+namespace ARBrowser {
+	void transformBox (const float * matrix, const float * min, const float * max, float * transformedMin, float * transformedMax) {
+		for (std::size_t i = 0; i < 3; i += 1) {
+			// Start with the translation:
+			float lower = matrix[12 + i], upper = matrix[12 + i];
+			
+			for (std::size_t j = 0; j < 3; j += 1) {
+				float a = matrix[j*4 + i] * min[j];
+				float b = matrix[j*4 + i] * max[j];
+				
+				if (a < b) {
+					lower += a;
+					upper += b;
+				} else {
+					lower += b;
+					upper += a;
+				}
+			}
+			
+			transformedMin[i] = lower;
+			transformedMax[i] = upper;
+		}
+	}
+	
+	Frustum::Frustum () {
+		for (std::size_t i = 0; i < PLANES; i += 1) {
+			m_planes[i][0] = m_planes[i][1] = m_planes[i][2] = 0;
+			m_planes[i][3] = 1;
+		}
+	}
+	
+	Frustum::Frustum (const float * m) {
+		// Each plane is the sum or difference of the fourth row and one of the other rows (Gribb and Hartmann):
+		for (std::size_t i = 0; i < 3; i += 1) {
+			for (std::size_t j = 0; j < 4; j += 1) {
+				m_planes[i*2][j] = m[j*4 + 3] + m[j*4 + i];
+				m_planes[i*2 + 1][j] = m[j*4 + 3] - m[j*4 + i];
+			}
+		}
+		
+		for (std::size_t i = 0; i < PLANES; i += 1) {
+			float * plane = m_planes[i];
+			float length = std::sqrt(plane[0]*plane[0] + plane[1]*plane[1] + plane[2]*plane[2]);
+			
+			if (length > 0) {
+				plane[0] /= length; plane[1] /= length; plane[2] /= length; plane[3] /= length;
+			}
+		}
+	}
+	
+	static void multiply (const float * a, const float * b, float * result) {
+		for (std::size_t i = 0; i < 4; i += 1) {
+			for (std::size_t j = 0; j < 4; j += 1) {
+				float sum = 0;
+				
+				for (std::size_t k = 0; k < 4; k += 1)
+					sum += a[k*4 + i] * b[j*4 + k];
+				
+				result[j*4 + i] = sum;
+			}
+		}
+	}
+	
+	Frustum::Frustum (const float * projection, const float * view) {
+		float matrix[16];
+		multiply(projection, view, matrix);
+		
+		*this = Frustum(matrix);
+	}
+	
+	float Frustum::distance (Plane index, const float * point) const {
+		const float * plane = m_planes[index];
+		
+		return plane[0] * point[0] + plane[1] * point[1] + plane[2] * point[2] + plane[3];
+	}
+	
+	bool Frustum::intersectsSphere (const float * center, float radius) const {
+		for (std::size_t i = 0; i < PLANES; i += 1) {
+			if (distance((Plane)i, center) < -radius)
+				return false;
+		}
+		
+		return true;
+	}
+	
+	bool Frustum::intersectsBox (const float * min, const float * max) const {
+		for (std::size_t i = 0; i < PLANES; i += 1) {
+			const float * plane = m_planes[i];
+			
+			// The corner of the box furthest along the plane normal:
+			float corner[3] = {
+				plane[0] >= 0 ? max[0] : min[0],
+				plane[1] >= 0 ? max[1] : min[1],
+				plane[2] >= 0 ? max[2] : min[2]
+			};
+			
+			if (distance((Plane)i, corner) < 0)
+				return false;
+		}
+		
+		return true;
+	}
+	
+	std::size_t Frustum::cullSpheres (std::size_t count, const float * x, const float * y, const float * z, const float * radius, std::uint8_t * visible) const {
+		std::size_t i = 0, total = 0;
+		
+#if defined(AR_FRUSTUM_SSE)
+		for (; i + 4 <= count; i += 4) {
+			__m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+			__m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(radius + i));
+			__m128 outside = _mm_setzero_ps();
+			
+			for (std::size_t j = 0; j < PLANES; j += 1) {
+				const float * plane = m_planes[j];
+				
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(plane[0])), _mm_mul_ps(py, _mm_set1_ps(plane[1]))), _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(d, negativeRadius));
+			}
+			
+			int mask = _mm_movemask_ps(outside);
+			
+			for (std::size_t k = 0; k < 4; k += 1) {
+				visible[i + k] = !(mask & (1 << k));
+				total += visible[i + k];
+			}
+		}
+#elif defined(AR_FRUSTUM_NEON)
+		for (; i + 4 <= count; i += 4) {
+			float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i), pz = vld1q_f32(z + i);
+			float32x4_t negativeRadius = vnegq_f32(vld1q_f32(radius + i));
+			uint32x4_t outside = vdupq_n_u32(0);
+			
+			for (std::size_t j = 0; j < PLANES; j += 1) {
+				const float * plane = m_planes[j];
+				
+				float32x4_t d = vdupq_n_f32(plane[3]);
+				d = vmlaq_n_f32(d, px, plane[0]);
+				d = vmlaq_n_f32(d, py, plane[1]);
+				d = vmlaq_n_f32(d, pz, plane[2]);
+				
+				outside = vorrq_u32(outside, vcltq_f32(d, negativeRadius));
+			}
+			
+			std::uint32_t mask[4];
+			vst1q_u32(mask, outside);
+			
+			for (std::size_t k = 0; k < 4; k += 1) {
+				visible[i + k] = !mask[k];
+				total += visible[i + k];
+			}
+		}
+#endif
+		
+		for (; i < count; i += 1) {
+			float center[3] = {x[i], y[i], z[i]};
+			
+			visible[i] = intersectsSphere(center, radius[i]);
+			total += visible[i];
+		}
+		
+		return total;
+	}
+	
+	std::size_t Frustum::cullBoxes (std::size_t count, const float * x, const float * y, const float * z, const float * extentX, const float * extentY, const float * extentZ, std::uint8_t * visible) const {
+		std::size_t i = 0, total = 0;
+		
+		// A box is outside a plane if its center is further outside than the box's extent projected onto the plane normal.
+		float normals[PLANES][3];
+		
+		for (std::size_t j = 0; j < PLANES; j += 1) {
+			for (std::size_t k = 0; k < 3; k += 1)
+				normals[j][k] = std::fabs(m_planes[j][k]);
+		}
+		
+#if defined(AR_FRUSTUM_SSE)
+		for (; i + 4 <= count; i += 4) {
+			__m128 px = _mm_loadu_ps(x + i), py = _mm_loadu_ps(y + i), pz = _mm_loadu_ps(z + i);
+			__m128 ex = _mm_loadu_ps(extentX + i), ey = _mm_loadu_ps(extentY + i), ez = _mm_loadu_ps(extentZ + i);
+			__m128 outside = _mm_setzero_ps();
+			
+			for (std::size_t j = 0; j < PLANES; j += 1) {
+				const float * plane = m_planes[j];
+				
+				__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(plane[0])), _mm_mul_ps(py, _mm_set1_ps(plane[1]))), _mm_add_ps(_mm_mul_ps(pz, _mm_set1_ps(plane[2])), _mm_set1_ps(plane[3])));
+				__m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, _mm_set1_ps(normals[j][0])), _mm_mul_ps(ey, _mm_set1_ps(normals[j][1]))), _mm_mul_ps(ez, _mm_set1_ps(normals[j][2])));
+				
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+			}
+			
+			int mask = _mm_movemask_ps(outside);
+			
+			for (std::size_t k = 0; k < 4; k += 1) {
+				visible[i + k] = !(mask & (1 << k));
+				total += visible[i + k];
+			}
+		}
+#elif defined(AR_FRUSTUM_NEON)
+		for (; i + 4 <= count; i += 4) {
+			float32x4_t px = vld1q_f32(x + i), py = vld1q_f32(y + i), pz = vld1q_f32(z + i);
+			float32x4_t ex = vld1q_f32(extentX + i), ey = vld1q_f32(extentY + i), ez = vld1q_f32(extentZ + i);
+			uint32x4_t outside = vdupq_n_u32(0);
+			
+			for (std::size_t j = 0; j < PLANES; j += 1) {
+				const float * plane = m_planes[j];
+				
+				float32x4_t d = vdupq_n_f32(plane[3]);
+				d = vmlaq_n_f32(d, px, plane[0]);
+				d = vmlaq_n_f32(d, py, plane[1]);
+				d = vmlaq_n_f32(d, pz, plane[2]);
+				d = vmlaq_n_f32(d, ex, normals[j][0]);
+				d = vmlaq_n_f32(d, ey, normals[j][1]);
+				d = vmlaq_n_f32(d, ez, normals[j][2]);
+				
+				outside = vorrq_u32(outside, vcltq_f32(d, vdupq_n_f32(0)));
+			}
+			
+			std::uint32_t mask[4];
+			vst1q_u32(mask, outside);
+			
+			for (std::size_t k = 0; k < 4; k += 1) {
+				visible[i + k] = !mask[k];
+				total += visible[i + k];
+			}
+		}
+#endif
+		
+		for (; i < count; i += 1) {
+			float min[3] = {x[i] - extentX[i], y[i] - extentY[i], z[i] - extentZ[i]};
+			float max[3] = {x[i] + extentX[i], y[i] + extentY[i], z[i] + extentZ[i]};
+			
+			visible[i] = intersectsBox(min, max);
+			total += visible[i];
+		}
+		
+		return total;
+	}
+}
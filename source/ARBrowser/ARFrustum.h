@@ -0,0 +1,60 @@
+//
+//  ARFrustum.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_FRUSTUM_H
+#define _ARBROWSER_FRUSTUM_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace ARBrowser {
+	/// Transform an axis aligned box by an affine matrix (column major, as used by OpenGL), giving the axis aligned box which contains the transformed box.
+	/// Transforming only the two corners is wrong if the matrix has any rotation, so each axis is accumulated separately (Arvo's method).
+	void transformBox (const float * matrix, const float * min, const float * max, float * transformedMin, float * transformedMax);
+	
+	/// The planes of a view frustum, used to discard objects which are not on screen before they are drawn.
+	class Frustum {
+		public:
+			enum Plane {
+				LEFT, RIGHT, BOTTOM, TOP, NEAR, FAR, PLANES
+			};
+			
+		protected:
+			/// Normalized plane equations ax + by + cz + d = 0, where points inside the frustum are on the positive side.
+			float m_planes[PLANES][4];
+			
+		public:
+			/// A frustum which contains everything.
+			Frustum ();
+			
+			/// Extract the planes from the combined projection and view matrix, i.e. <tt>projection * view</tt>, in column major order. Objects tested against the frustum are in the coordinate system the view matrix is applied to.
+			explicit Frustum (const float * matrix);
+			
+			/// Extract the planes from separate projection and view matrices, in column major order.
+			Frustum (const float * projection, const float * view);
+			
+			const float * plane (Plane index) const { return m_planes[index]; }
+			
+			/// Signed distance from the plane to the point, positive inside.
+			float distance (Plane index, const float * point) const;
+			
+			bool intersectsSphere (const float * center, float radius) const;
+			bool intersectsBox (const float * min, const float * max) const;
+			
+			/// Test many spheres, given as separate arrays of coordinates and radii, several at a time using vector instructions where available.
+			/// Writes 1 to visible for spheres which intersect the frustum and 0 otherwise.
+			/// @returns the number of visible spheres.
+			std::size_t cullSpheres (std::size_t count, const float * x, const float * y, const float * z, const float * radius, std::uint8_t * visible) const;
+			
+			/// Test many axis aligned boxes, given as separate arrays of centers and half extents.
+			/// @returns the number of visible boxes.
+			std::size_t cullBoxes (std::size_t count, const float * x, const float * y, const float * z, const float * extentX, const float * extentY, const float * extentZ, std::uint8_t * visible) const;
+	};
+}
+
+#endif
@@ -0,0 +1,239 @@
+//
+//  ARFusionThread.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_FUSION_THREAD_H
+#define _ARBROWSER_FUSION_THREAD_H
+
+#include "ARConcurrentQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ARBrowser {
+	struct FusionStatistics {
+		std::size_t processed;
+		
+		/// Coalescable events which were skipped because a newer one was also due.
+		std::size_t coalesced;
+		
+		/// Events which arrived after a later event had already been processed, which are processed immediately.
+		std::size_t late;
+	};
+	
+	/// Processes sensor events on a dedicated thread in timestamp order. Events are pushed from any thread without locking, and held for a short reorder window so that events from different sources which arrive slightly out of order are processed in order.
+	/// EventT must have a <tt>double time</tt> member, in seconds, and a <tt>bool coalescable</tt> member. If the thread falls behind, so that several coalescable events are due at once (e.g. camera frames), only the newest one is processed.
+	template <typename EventT>
+	class FusionThread {
+		public:
+			typedef std::function<void (EventT &)> HandlerT;
+			typedef FusionStatistics Statistics;
+		
+		protected:
+			typedef std::chrono::steady_clock ClockT;
+			
+			struct Pending {
+				EventT event;
+				ClockT::time_point arrival;
+				
+				/// Breaks ties between events with the same time, so they are processed in the order they arrived.
+				std::uint64_t sequence;
+			};
+			
+			/// Orders the heap so the earliest event is at the front.
+			static bool later (const Pending & a, const Pending & b) {
+				if (a.event.time != b.event.time)
+					return a.event.time > b.event.time;
+				
+				return a.sequence > b.sequence;
+			}
+			
+			HandlerT m_handler;
+			ClockT::duration m_window;
+			double m_windowSeconds;
+			
+			ConcurrentQueue<EventT> m_queue;
+			
+			std::thread m_thread;
+			std::atomic<bool> m_running, m_sleeping;
+			std::mutex m_mutex;
+			std::condition_variable m_condition;
+			
+			/// Only used by the fusion thread:
+			std::vector<Pending> m_pending;
+			std::vector<EventT> m_ready;
+			std::uint64_t m_sequence;
+			double m_latest, m_released;
+			bool m_hasReleased;
+			
+			std::atomic<std::size_t> m_processed, m_coalesced, m_late;
+			
+			void process (EventT & event) {
+				m_handler(event);
+				m_processed.fetch_add(1, std::memory_order_relaxed);
+			}
+			
+			/// Move events from the queue into the reorder window.
+			void receive (ClockT::time_point now) {
+				EventT event;
+				
+				while (m_queue.pop(event)) {
+					if (m_hasReleased && event.time < m_released) {
+						m_late.fetch_add(1, std::memory_order_relaxed);
+						process(event);
+						
+						continue;
+					}
+					
+					m_latest = std::max(m_latest, event.time);
+					
+					Pending pending = {std::move(event), now, m_sequence++};
+					m_pending.push_back(std::move(pending));
+					std::push_heap(m_pending.begin(), m_pending.end(), later);
+				}
+			}
+			
+			/// Process the events which are due, i.e. the window has passed either in event time or since they arrived.
+			void release (ClockT::time_point now, bool flush) {
+				while (!m_pending.empty()) {
+					const Pending & front = m_pending.front();
+					
+					if (!flush && front.event.time > m_latest - m_windowSeconds && now - front.arrival < m_window)
+						break;
+					
+					std::pop_heap(m_pending.begin(), m_pending.end(), later);
+					m_ready.push_back(std::move(m_pending.back().event));
+					m_pending.pop_back();
+				}
+				
+				// Only the newest coalescable event which is due is processed:
+				std::size_t newest = m_ready.size();
+				
+				for (std::size_t i = m_ready.size(); i > 0; i -= 1) {
+					if (m_ready[i-1].coalescable) {
+						newest = i - 1;
+						break;
+					}
+				}
+				
+				for (std::size_t i = 0; i < m_ready.size(); i += 1) {
+					EventT & event = m_ready[i];
+					
+					m_released = event.time;
+					m_hasReleased = true;
+					
+					if (event.coalescable && i != newest) {
+						m_coalesced.fetch_add(1, std::memory_order_relaxed);
+						continue;
+					}
+					
+					process(event);
+				}
+				
+				m_ready.clear();
+			}
+			
+			void run () {
+				while (true) {
+					bool running = m_running.load(std::memory_order_acquire);
+					ClockT::time_point now = ClockT::now();
+					
+					receive(now);
+					release(now, !running);
+					
+					if (!running)
+						break;
+					
+					// Sleep until an event is pushed, or the oldest pending event is due:
+					ClockT::duration timeout = std::chrono::milliseconds(100);
+					
+					if (!m_pending.empty()) {
+						ClockT::time_point due = m_pending.front().arrival + m_window;
+						
+						for (std::size_t i = 1; i < m_pending.size(); i += 1)
+							due = std::min(due, m_pending[i].arrival + m_window);
+						
+						timeout = std::max(ClockT::duration::zero(), due - now);
+					}
+					
+					std::unique_lock<std::mutex> lock(m_mutex);
+					
+					m_sleeping.store(true, std::memory_order_relaxed);
+					std::atomic_thread_fence(std::memory_order_seq_cst);
+					
+					if (m_queue.empty() && m_running.load(std::memory_order_relaxed))
+						m_condition.wait_for(lock, timeout);
+					
+					m_sleeping.store(false, std::memory_order_relaxed);
+				}
+			}
+		
+		public:
+			/// The handler is called on the fusion thread for each event. The window is in seconds.
+			FusionThread (HandlerT handler, double window = 0.03) : m_handler(handler), m_window(std::chrono::duration_cast<ClockT::duration>(std::chrono::duration<double>(window))), m_windowSeconds(window), m_running(false), m_sleeping(false), m_sequence(0), m_latest(0), m_released(0), m_hasReleased(false), m_processed(0), m_coalesced(0), m_late(0)
+			{
+			}
+			
+			~FusionThread () {
+				stop();
+			}
+			
+			void start () {
+				if (m_running.exchange(true))
+					return;
+				
+				m_thread = std::thread(&FusionThread::run, this);
+			}
+			
+			/// Stop the thread after processing every event pushed so far, in order.
+			void stop () {
+				if (!m_running.exchange(false))
+					return;
+				
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_condition.notify_one();
+				}
+				
+				m_thread.join();
+			}
+			
+			bool running () const {
+				return m_running.load(std::memory_order_relaxed);
+			}
+			
+			/// Push an event from any thread. This never blocks unless the fusion thread is asleep, in which case it is woken up.
+			void push (EventT event) {
+				m_queue.push(std::move(event));
+				
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+				
+				if (m_sleeping.load(std::memory_order_relaxed)) {
+					std::lock_guard<std::mutex> lock(m_mutex);
+					m_condition.notify_one();
+				}
+			}
+			
+			Statistics statistics () const {
+				Statistics statistics = {m_processed.load(std::memory_order_relaxed), m_coalesced.load(std::memory_order_relaxed), m_late.load(std::memory_order_relaxed)};
+				
+				return statistics;
+			}
+		
+		private:
+			FusionThread (const FusionThread &);
+			FusionThread & operator= (const FusionThread &);
+	};
+}
+
+#endif
@@ -64,7 +64,9 @@
 
 - (void) update;
 
+/// Called about every 150 frames when debug is enabled. Subclasses which log their own statistics instead of the frame rate should call -resetStatistics.
 - (void) logStatistics;
+- (void) resetStatistics;
 
 - (CGPoint) convertPointFromViewToSurface:(CGPoint)point;
 - (CGRect) convertRectFromViewToSurface:(CGRect)rect;
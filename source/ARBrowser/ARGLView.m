@@ -233,6 +233,11 @@
 	
 	NSLog(@"FPS: %0.2f", (double)(_count) / interval);
 
+	[self resetStatistics];
+}
+
+- (void) resetStatistics
+{
 	_lastDate = [NSDate date];
 	_count = 0;
 }
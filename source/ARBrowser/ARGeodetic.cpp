@@ -0,0 +1,377 @@
+//
+//  ARGeodetic.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARGeodetic.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define AR_GEODETIC_AVX
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+	#define AR_GEODETIC_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	// 32-bit NEON has no double precision arithmetic, so armv7 uses the scalar path.
+	#include <arm_neon.h>
+	#define AR_GEODETIC_NEON
+#endif
+
+namespace ARBrowser {
+	// WGS 84 semi-major axis constant in meters:
+	static const double WGS84_A = 6378137.0;
+	// WGS 84 eccentricity:
+	static const double WGS84_E = 8.1819190842622e-2;
+	
+	static const double D2R = M_PI / 180.0;
+	static const double R2D = 180.0 / M_PI;
+	
+	namespace {
+		/// A single double, with the same interface as the vector types so that the kernels can also process the remainder of a batch. Comparisons return all bits set or clear, as the vector instructions do.
+		struct Double1 {
+			static const std::size_t SIZE = 1;
+			
+			double v;
+			
+			Double1 () {}
+			Double1 (double value) : v(value) {}
+			
+			static Double1 load (const double * p) { return Double1(*p); }
+			void store (double * p) const { *p = v; }
+			
+			static std::uint64_t bits (double value) { std::uint64_t result; std::memcpy(&result, &value, sizeof(result)); return result; }
+			static Double1 fromBits (std::uint64_t value) { Double1 result; std::memcpy(&result.v, &value, sizeof(value)); return result; }
+			static Double1 mask (bool value) { return fromBits(value ? ~std::uint64_t(0) : 0); }
+		};
+		
+		inline Double1 operator+ (Double1 a, Double1 b) { return a.v + b.v; }
+		inline Double1 operator- (Double1 a, Double1 b) { return a.v - b.v; }
+		inline Double1 operator* (Double1 a, Double1 b) { return a.v * b.v; }
+		inline Double1 operator/ (Double1 a, Double1 b) { return a.v / b.v; }
+		inline Double1 operator& (Double1 a, Double1 b) { return Double1::fromBits(Double1::bits(a.v) & Double1::bits(b.v)); }
+		inline Double1 operator| (Double1 a, Double1 b) { return Double1::fromBits(Double1::bits(a.v) | Double1::bits(b.v)); }
+		inline Double1 operator^ (Double1 a, Double1 b) { return Double1::fromBits(Double1::bits(a.v) ^ Double1::bits(b.v)); }
+		inline Double1 sqrt (Double1 a) { return std::sqrt(a.v); }
+		inline Double1 equal (Double1 a, Double1 b) { return Double1::mask(a.v == b.v); }
+		inline Double1 less (Double1 a, Double1 b) { return Double1::mask(a.v < b.v); }
+		inline Double1 lessEqual (Double1 a, Double1 b) { return Double1::mask(a.v <= b.v); }
+		inline Double1 select (Double1 mask, Double1 a, Double1 b) { return Double1::bits(mask.v) ? a : b; }
+		
+#if defined(AR_GEODETIC_AVX)
+		struct Double4 {
+			static const std::size_t SIZE = 4;
+			
+			__m256d v;
+			
+			Double4 () {}
+			Double4 (__m256d value) : v(value) {}
+			Double4 (double value) : v(_mm256_set1_pd(value)) {}
+			
+			static Double4 load (const double * p) { return _mm256_loadu_pd(p); }
+			void store (double * p) const { _mm256_storeu_pd(p, v); }
+		};
+		
+		inline Double4 operator+ (Double4 a, Double4 b) { return _mm256_add_pd(a.v, b.v); }
+		inline Double4 operator- (Double4 a, Double4 b) { return _mm256_sub_pd(a.v, b.v); }
+		inline Double4 operator* (Double4 a, Double4 b) { return _mm256_mul_pd(a.v, b.v); }
+		inline Double4 operator/ (Double4 a, Double4 b) { return _mm256_div_pd(a.v, b.v); }
+		inline Double4 operator& (Double4 a, Double4 b) { return _mm256_and_pd(a.v, b.v); }
+		inline Double4 operator| (Double4 a, Double4 b) { return _mm256_or_pd(a.v, b.v); }
+		inline Double4 operator^ (Double4 a, Double4 b) { return _mm256_xor_pd(a.v, b.v); }
+		inline Double4 sqrt (Double4 a) { return _mm256_sqrt_pd(a.v); }
+		inline Double4 equal (Double4 a, Double4 b) { return _mm256_cmp_pd(a.v, b.v, _CMP_EQ_OQ); }
+		inline Double4 less (Double4 a, Double4 b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ); }
+		inline Double4 lessEqual (Double4 a, Double4 b) { return _mm256_cmp_pd(a.v, b.v, _CMP_LE_OQ); }
+		inline Double4 select (Double4 mask, Double4 a, Double4 b) { return _mm256_blendv_pd(b.v, a.v, mask.v); }
+		
+		typedef Double4 VectorT;
+#elif defined(AR_GEODETIC_SSE2)
+		struct Double2 {
+			static const std::size_t SIZE = 2;
+			
+			__m128d v;
+			
+			Double2 () {}
+			Double2 (__m128d value) : v(value) {}
+			Double2 (double value) : v(_mm_set1_pd(value)) {}
+			
+			static Double2 load (const double * p) { return _mm_loadu_pd(p); }
+			void store (double * p) const { _mm_storeu_pd(p, v); }
+		};
+		
+		inline Double2 operator+ (Double2 a, Double2 b) { return _mm_add_pd(a.v, b.v); }
+		inline Double2 operator- (Double2 a, Double2 b) { return _mm_sub_pd(a.v, b.v); }
+		inline Double2 operator* (Double2 a, Double2 b) { return _mm_mul_pd(a.v, b.v); }
+		inline Double2 operator/ (Double2 a, Double2 b) { return _mm_div_pd(a.v, b.v); }
+		inline Double2 operator& (Double2 a, Double2 b) { return _mm_and_pd(a.v, b.v); }
+		inline Double2 operator| (Double2 a, Double2 b) { return _mm_or_pd(a.v, b.v); }
+		inline Double2 operator^ (Double2 a, Double2 b) { return _mm_xor_pd(a.v, b.v); }
+		inline Double2 sqrt (Double2 a) { return _mm_sqrt_pd(a.v); }
+		inline Double2 equal (Double2 a, Double2 b) { return _mm_cmpeq_pd(a.v, b.v); }
+		inline Double2 less (Double2 a, Double2 b) { return _mm_cmplt_pd(a.v, b.v); }
+		inline Double2 lessEqual (Double2 a, Double2 b) { return _mm_cmple_pd(a.v, b.v); }
+		inline Double2 select (Double2 mask, Double2 a, Double2 b) { return _mm_or_pd(_mm_and_pd(mask.v, a.v), _mm_andnot_pd(mask.v, b.v)); }
+		
+		typedef Double2 VectorT;
+#elif defined(AR_GEODETIC_NEON)
+		struct Double2 {
+			static const std::size_t SIZE = 2;
+			
+			float64x2_t v;
+			
+			Double2 () {}
+			Double2 (float64x2_t value) : v(value) {}
+			Double2 (double value) : v(vdupq_n_f64(value)) {}
+			
+			static Double2 load (const double * p) { return vld1q_f64(p); }
+			void store (double * p) const { vst1q_f64(p, v); }
+		};
+		
+		inline uint64x2_t bits (Double2 a) { return vreinterpretq_u64_f64(a.v); }
+		inline Double2 fromBits (uint64x2_t a) { return vreinterpretq_f64_u64(a); }
+		
+		inline Double2 operator+ (Double2 a, Double2 b) { return vaddq_f64(a.v, b.v); }
+		inline Double2 operator- (Double2 a, Double2 b) { return vsubq_f64(a.v, b.v); }
+		inline Double2 operator* (Double2 a, Double2 b) { return vmulq_f64(a.v, b.v); }
+		inline Double2 operator/ (Double2 a, Double2 b) { return vdivq_f64(a.v, b.v); }
+		inline Double2 operator& (Double2 a, Double2 b) { return fromBits(vandq_u64(bits(a), bits(b))); }
+		inline Double2 operator| (Double2 a, Double2 b) { return fromBits(vorrq_u64(bits(a), bits(b))); }
+		inline Double2 operator^ (Double2 a, Double2 b) { return fromBits(veorq_u64(bits(a), bits(b))); }
+		inline Double2 sqrt (Double2 a) { return vsqrtq_f64(a.v); }
+		inline Double2 equal (Double2 a, Double2 b) { return fromBits(vceqq_f64(a.v, b.v)); }
+		inline Double2 less (Double2 a, Double2 b) { return fromBits(vcltq_f64(a.v, b.v)); }
+		inline Double2 lessEqual (Double2 a, Double2 b) { return fromBits(vcleq_f64(a.v, b.v)); }
+		inline Double2 select (Double2 mask, Double2 a, Double2 b) { return vbslq_f64(bits(mask), a.v, b.v); }
+		
+		typedef Double2 VectorT;
+#else
+		typedef Double1 VectorT;
+#endif
+		
+		/// Round to the nearest integer, for |x| < 2^51, without converting to an integer register.
+		template <typename V>
+		inline V roundNearest (V x) {
+			const V MAGIC(6755399441055744.0);
+			
+			return (x + MAGIC) - MAGIC;
+		}
+		
+		/// Scalar code may be evaluated with extended precision (e.g. x87), which breaks the magic number.
+		template <>
+		inline Double1 roundNearest (Double1 x) {
+			return std::rint(x.v);
+		}
+		
+		template <typename V>
+		inline V polynomial (V x, const double * coefficients, std::size_t count) {
+			V result(coefficients[0]);
+			
+			for (std::size_t i = 1; i < count; i += 1)
+				result = result * x + V(coefficients[i]);
+			
+			return result;
+		}
+		
+		// Minimax polynomials for sin and cos on [-pi/4, pi/4], from the Cephes library:
+		const double SIN_COEFFICIENTS[] = {1.58962301576546568060E-10, -2.50507477628578072866E-8, 2.75573136213857245213E-6, -1.98412698295895385996E-4, 8.33333333332211858878E-3, -1.66666666666666307295E-1};
+		const double COS_COEFFICIENTS[] = {-1.13585365213876817300E-11, 2.08757008419747316778E-9, -2.75573141792967388112E-7, 2.48015872888517045348E-5, -1.38888888888730564116E-3, 4.16666666666665929218E-2};
+		
+		/// Calculate sin and cos together, accurate to within a couple of ulp for |x| < 2^30.
+		template <typename V>
+		inline void sinCos (V x, V & s, V & c) {
+			// pi/2 split into three parts, so that the reduction is exact:
+			const V PIO2_1(1.57079625129699707031E0), PIO2_2(7.54978941586159635336E-8), PIO2_3(5.39030285815811905290E-15);
+			
+			// x = k.pi/2 + z, where |z| <= pi/4:
+			V k = roundNearest(x * V(2.0 / M_PI));
+			V z = ((x - k * PIO2_1) - k * PIO2_2) - k * PIO2_3;
+			V zz = z * z;
+			
+			V sinZ = z + z * zz * polynomial(zz, SIN_COEFFICIENTS, 6);
+			V cosZ = V(1.0) - V(0.5) * zz + zz * zz * polynomial(zz, COS_COEFFICIENTS, 6);
+			
+			// The quadrant, k mod 4, determines which result to use and its sign:
+			V quadrant = k - V(4.0) * roundNearest(k * V(0.25) - V(0.375));
+			
+			V swap = equal(quadrant, V(1.0)) | equal(quadrant, V(3.0));
+			V sinNegative = lessEqual(V(2.0), quadrant);
+			V cosNegative = equal(quadrant, V(1.0)) | equal(quadrant, V(2.0));
+			
+			const V SIGN(-0.0);
+			
+			s = select(swap, cosZ, sinZ) ^ (sinNegative & SIGN);
+			c = select(swap, sinZ, cosZ) ^ (cosNegative & SIGN);
+		}
+		
+		// Rational approximation of atan on [0, 0.66], from the Cephes library:
+		const double ATAN_P[] = {-8.750608600031904122785E-1, -1.615753718733365076637E1, -7.500855792314704667340E1, -1.228866684490136173410E2, -6.485021904942025371773E1};
+		const double ATAN_Q[] = {1.0, 2.485846490142306297962E1, 1.650270098316988542046E2, 4.328810604912902668951E2, 4.853903996359136964868E2, 1.945506571482613964425E2};
+		
+		/// Calculate atan(x) for x >= 0, including infinity.
+		template <typename V>
+		inline V atanPositive (V x) {
+			const V TAN3PIO8(2.41421356237309504880), MOREBITS(6.123233995736765886130E-17);
+			
+			V large = less(TAN3PIO8, x);
+			V medium = less(V(0.66), x) ^ large;
+			
+			// Reduce the argument, using atan(x) = pi/2 - atan(1/x) and atan(x) = pi/4 + atan((x-1)/(x+1)):
+			V offset = select(large, V(M_PI_2), select(medium, V(M_PI_4), V(0.0)));
+			V correction = select(large, MOREBITS, select(medium, V(0.5) * MOREBITS, V(0.0)));
+			x = select(large, V(-1.0) / x, select(medium, (x - V(1.0)) / (x + V(1.0)), x));
+			
+			V z = x * x;
+			z = z * polynomial(z, ATAN_P, 5) / polynomial(z, ATAN_Q, 6);
+			
+			return offset + ((x * z + x) + correction);
+		}
+		
+		inline double fromBits (std::uint64_t value) {
+			double result;
+			std::memcpy(&result, &value, sizeof(result));
+			
+			return result;
+		}
+		
+		/// Calculate atan2(y, x), with the same results as the standard library for finite arguments, including signed zeros.
+		template <typename V>
+		inline V atan2 (V y, V x) {
+			const V SIGN(-0.0), MAGNITUDE(fromBits(0x7FFFFFFFFFFFFFFFull));
+			
+			V absoluteY = y & MAGNITUDE, absoluteX = x & MAGNITUDE;
+			V angle = atanPositive(absoluteY / absoluteX);
+			
+			// atan2(0, 0) is zero rather than NaN:
+			angle = select(equal(absoluteY, V(0.0)) & equal(absoluteX, V(0.0)), V(0.0), angle);
+			
+			// Reflect into the left half plane if x has its sign bit set, including x = -0:
+			V negativeX = less((x & SIGN) | V(1.0), V(0.0));
+			angle = select(negativeX, V(M_PI) - angle, angle);
+			
+			return angle | (y & SIGN);
+		}
+		
+		/// The origin constants shared by the kernels.
+		struct Origin {
+			double latitude, longitude, radius;
+			double sinLatitude, cosLatitude, sinLongitude, cosLongitude;
+			double x, y, z;
+		};
+		
+		/// Convert points [begin, end) in steps of V::SIZE, returning the index of the first point which was not converted.
+		template <typename V>
+		std::size_t convertToENU (const Origin & origin, std::size_t begin, std::size_t end, const double * latitudes, const double * longitudes, const double * altitudes, double * east, double * north, double * up) {
+			const V DEGREES(D2R), A(WGS84_A), E2(WGS84_E * WGS84_E), ONE(1.0);
+			const V X(origin.x), Y(origin.y), Z(origin.z);
+			const V SIN_LATITUDE(origin.sinLatitude), COS_LATITUDE(origin.cosLatitude), SIN_LONGITUDE(origin.sinLongitude), COS_LONGITUDE(origin.cosLongitude);
+			
+			std::size_t i = begin;
+			
+			for (; i + V::SIZE <= end; i += V::SIZE) {
+				V sinLatitude, cosLatitude, sinLongitude, cosLongitude;
+				sinCos(V::load(latitudes + i) * DEGREES, sinLatitude, cosLatitude);
+				sinCos(V::load(longitudes + i) * DEGREES, sinLongitude, cosLongitude);
+				
+				V altitude = V::load(altitudes + i);
+				
+				// Earth-centered earth-fixed, relative to the origin:
+				V n = A / sqrt(ONE - E2 * sinLatitude * sinLatitude);
+				V dx = (n + altitude) * cosLatitude * cosLongitude - X;
+				V dy = (n + altitude) * cosLatitude * sinLongitude - Y;
+				V dz = (n * (ONE - E2) + altitude) * sinLatitude - Z;
+				
+				(COS_LONGITUDE * dy - SIN_LONGITUDE * dx).store(east + i);
+				(COS_LATITUDE * dz - SIN_LATITUDE * COS_LONGITUDE * dx - SIN_LATITUDE * SIN_LONGITUDE * dy).store(north + i);
+				(COS_LATITUDE * COS_LONGITUDE * dx + COS_LATITUDE * SIN_LONGITUDE * dy + SIN_LATITUDE * dz).store(up + i);
+			}
+			
+			return i;
+		}
+		
+		template <typename V>
+		std::size_t calculateDistanceAndBearing (const Origin & origin, std::size_t begin, std::size_t end, const double * latitudes, const double * longitudes, double * distances, double * bearings) {
+			const V DEGREES(D2R), RADIANS(R2D), ONE(1.0), TWO(2.0), HALF(0.5);
+			const V MAGNITUDE(fromBits(0x7FFFFFFFFFFFFFFFull));
+			const V LATITUDE(origin.latitude), LONGITUDE(origin.longitude), RADIUS(origin.radius);
+			const V SIN_LATITUDE(origin.sinLatitude), COS_LATITUDE(origin.cosLatitude);
+			
+			std::size_t i = begin;
+			
+			for (; i + V::SIZE <= end; i += V::SIZE) {
+				V latitude = V::load(latitudes + i) * DEGREES;
+				V deltaLongitude = V::load(longitudes + i) * DEGREES - LONGITUDE;
+				
+				V sinLatitude, cosLatitude, sinHalfLatitude, cosHalfLatitude, sinHalfLongitude, cosHalfLongitude;
+				sinCos(latitude, sinLatitude, cosLatitude);
+				sinCos((latitude - LATITUDE) * HALF, sinHalfLatitude, cosHalfLatitude);
+				sinCos(deltaLongitude * HALF, sinHalfLongitude, cosHalfLongitude);
+				
+				if (distances) {
+					// Haversine formula:
+					V t = sinHalfLatitude * sinHalfLatitude + COS_LATITUDE * cosLatitude * sinHalfLongitude * sinHalfLongitude;
+					V c = TWO * atan2(sqrt(t), sqrt(ONE - t));
+					
+					((RADIUS * c) & MAGNITUDE).store(distances + i);
+				}
+				
+				if (bearings) {
+					// Double angle formulas, reusing the half angle of the longitude difference:
+					V sinDeltaLongitude = TWO * sinHalfLongitude * cosHalfLongitude;
+					V cosDeltaLongitude = ONE - TWO * sinHalfLongitude * sinHalfLongitude;
+					
+					V bearing = atan2(sinDeltaLongitude * cosLatitude, COS_LATITUDE * sinLatitude - SIN_LATITUDE * cosLatitude * cosDeltaLongitude);
+					
+					(bearing * RADIANS).store(bearings + i);
+				}
+			}
+			
+			return i;
+		}
+	}
+	
+	const char * geodeticInstructionSet () {
+#if defined(AR_GEODETIC_AVX)
+		return "AVX";
+#elif defined(AR_GEODETIC_SSE2)
+		return "SSE2";
+#elif defined(AR_GEODETIC_NEON)
+		return "NEON";
+#else
+		return "Scalar";
+#endif
+	}
+	
+	GeodeticOrigin::GeodeticOrigin (double latitude, double longitude, double altitude) : m_latitude(latitude), m_longitude(longitude), m_altitude(altitude) {
+		m_sinLatitude = std::sin(latitude * D2R);
+		m_cosLatitude = std::cos(latitude * D2R);
+		m_sinLongitude = std::sin(longitude * D2R);
+		m_cosLongitude = std::cos(longitude * D2R);
+		
+		double n = WGS84_A / std::sqrt(1.0 - WGS84_E * WGS84_E * m_sinLatitude * m_sinLatitude);
+		
+		m_x = (n + altitude) * m_cosLatitude * m_cosLongitude;
+		m_y = (n + altitude) * m_cosLatitude * m_sinLongitude;
+		m_z = (n * (1.0 - WGS84_E * WGS84_E) + altitude) * m_sinLatitude;
+	}
+	
+	void GeodeticOrigin::convertToENU (std::size_t count, const double * latitudes, const double * longitudes, const double * altitudes, double * east, double * north, double * up) const {
+		Origin origin = {m_latitude * D2R, m_longitude * D2R, WGS84_A + m_altitude, m_sinLatitude, m_cosLatitude, m_sinLongitude, m_cosLongitude, m_x, m_y, m_z};
+		
+		std::size_t i = ARBrowser::convertToENU<VectorT>(origin, 0, count, latitudes, longitudes, altitudes, east, north, up);
+		ARBrowser::convertToENU<Double1>(origin, i, count, latitudes, longitudes, altitudes, east, north, up);
+	}
+	
+	void GeodeticOrigin::calculateDistanceAndBearing (std::size_t count, const double * latitudes, const double * longitudes, double * distances, double * bearings) const {
+		Origin origin = {m_latitude * D2R, m_longitude * D2R, WGS84_A + m_altitude, m_sinLatitude, m_cosLatitude, m_sinLongitude, m_cosLongitude, m_x, m_y, m_z};
+		
+		std::size_t i = ARBrowser::calculateDistanceAndBearing<VectorT>(origin, 0, count, latitudes, longitudes, distances, bearings);
+		ARBrowser::calculateDistanceAndBearing<Double1>(origin, i, count, latitudes, longitudes, distances, bearings);
+	}
+}
@@ -0,0 +1,46 @@
+//
+//  ARGeodetic.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_GEODETIC_H
+#define _ARBROWSER_GEODETIC_H
+
+#include <cstddef>
+
+namespace ARBrowser {
+	/// The vector instruction set used by the batch functions, e.g. "SSE2", "AVX", "NEON" or "Scalar".
+	const char * geodeticInstructionSet ();
+	
+	/// Converts batches of points to coordinates relative to one origin. The trigonometry for the origin is done once, in the constructor, and the points are processed several at a time using vector instructions where available.
+	/// Inputs and outputs are separate arrays (structure of arrays) of the given count. Latitude and longitude are in degrees, altitude and distances in meters.
+	class GeodeticOrigin {
+		protected:
+			double m_latitude, m_longitude, m_altitude;
+			
+			double m_sinLatitude, m_cosLatitude;
+			double m_sinLongitude, m_cosLongitude;
+			
+			/// The origin in earth-centered earth-fixed coordinates.
+			double m_x, m_y, m_z;
+			
+		public:
+			GeodeticOrigin (double latitude, double longitude, double altitude);
+			
+			double latitude () const { return m_latitude; }
+			double longitude () const { return m_longitude; }
+			double altitude () const { return m_altitude; }
+			
+			/// Convert points to local east, north, up offsets from the origin. Equivalent to convertLocationToECEF followed by convertECEFtoENU.
+			void convertToENU (std::size_t count, const double * latitudes, const double * longitudes, const double * altitudes, double * east, double * north, double * up) const;
+			
+			/// Calculate the great circle distance at the altitude of the origin, and the bearing from north in degrees, to each point. Equivalent to calculateDistanceBetween and calculateBearingBetween.
+			/// Either output may be NULL if it is not required.
+			void calculateDistanceAndBearing (std::size_t count, const double * latitudes, const double * longitudes, double * distances, double * bearings) const;
+	};
+}
+
+#endif
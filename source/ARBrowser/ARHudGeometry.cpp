@@ -0,0 +1,98 @@
+//
+//  ARHudGeometry.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARHudGeometry.h"
+
+#include <cassert>
+#include <cstring>
+
+namespace ARBrowser {
+	/// cos and sin of i * 2pi / 32.
+	static const float UNIT_RING[HudGeometry::RING_STEPS][2] = {
+		{1.0, 0.0}, {0.98078528, 0.195090322}, {0.923879533, 0.382683432}, {0.831469612, 0.555570233},
+		{0.707106781, 0.707106781}, {0.555570233, 0.831469612}, {0.382683432, 0.923879533}, {0.195090322, 0.98078528},
+		{0.0, 1.0}, {-0.195090322, 0.98078528}, {-0.382683432, 0.923879533}, {-0.555570233, 0.831469612},
+		{-0.707106781, 0.707106781}, {-0.831469612, 0.555570233}, {-0.923879533, 0.382683432}, {-0.98078528, 0.195090322},
+		{-1.0, 0.0}, {-0.98078528, -0.195090322}, {-0.923879533, -0.382683432}, {-0.831469612, -0.555570233},
+		{-0.707106781, -0.707106781}, {-0.555570233, -0.831469612}, {-0.382683432, -0.923879533}, {-0.195090322, -0.98078528},
+		{0.0, -1.0}, {0.195090322, -0.98078528}, {0.382683432, -0.923879533}, {0.555570233, -0.831469612},
+		{0.707106781, -0.707106781}, {0.831469612, -0.555570233}, {0.923879533, -0.382683432}, {0.98078528, -0.195090322}
+	};
+	
+	static const HudVertex RADAR_CROSSHAIR[] = {
+		{{-20, 0, 0}, {1, 1, 1, 1}}, {{20, 0, 0}, {1, 1, 1, 1}},
+		{{0, -20, 0}, {1, 1, 1, 1}}, {{0, 0, 0}, {1, 1, 1, 1}}
+	};
+	
+	static const HudVertex RADAR_FORWARD[] = {
+		{{0, 0, 0}, {1, 1, 1, 1}}, {{0, 20, 0}, {1, 1, 1, 1}}
+	};
+	
+	static const HudVertex RADAR_FIELD_OF_VIEW[] = {
+		{{0, 0, 0}, {1, 1, 1, 1}}, {{-8, 20, 0}, {1, 1, 1, 1}}, {{8, 20, 0}, {1, 1, 1, 1}}
+	};
+	
+	static const HudVertex AXIS[] = {
+		{{0, 0, 0}, {1, 0, 0, 1}}, {{10, 0, 0}, {1, 0, 0, 1}},
+		{{0, 0, 0}, {0, 1, 0, 1}}, {{0, 10, 0}, {0, 1, 0, 1}},
+		{{0, 0, 0}, {0, 0, 1, 1}}, {{0, 0, 10}, {0, 0, 1, 1}}
+	};
+	
+	static const float GRID_LOWER = -10, GRID_UPPER = 10, GRID_STEP = 0.5;
+	
+	static void setVertex (HudVertex & vertex, float x, float y, float z) {
+		const HudVertex white = {{x, y, z}, {1, 1, 1, 1}};
+		
+		vertex = white;
+	}
+	
+	template <std::size_t N>
+	static void append (HudVertex * vertices, HudRange & range, std::size_t & count, const HudVertex (& source)[N]) {
+		std::memcpy(vertices + count, source, sizeof(source));
+		
+		range.first = count;
+		range.count = N;
+		count += N;
+	}
+	
+	HudGeometry::HudGeometry () {
+		std::size_t count = 0;
+		
+		m_ranges[HUD_RING].first = count;
+		m_ranges[HUD_RING].count = RING_STEPS;
+		
+		for (std::size_t i = 0; i < RING_STEPS; i += 1)
+			setVertex(m_vertices[count++], UNIT_RING[i][0], UNIT_RING[i][1], 0);
+		
+		append(m_vertices, m_ranges[HUD_RADAR_CROSSHAIR], count, RADAR_CROSSHAIR);
+		append(m_vertices, m_ranges[HUD_RADAR_FORWARD], count, RADAR_FORWARD);
+		append(m_vertices, m_ranges[HUD_RADAR_FIELD_OF_VIEW], count, RADAR_FIELD_OF_VIEW);
+		append(m_vertices, m_ranges[HUD_AXIS], count, AXIS);
+		
+		m_ranges[HUD_GRID].first = count;
+		m_ranges[HUD_GRID].count = GRID_LINES * 4;
+		
+		for (std::size_t i = 0; i < GRID_LINES; i += 1) {
+			float x = GRID_LOWER + i * GRID_STEP;
+			
+			setVertex(m_vertices[count++], x, GRID_LOWER, 0);
+			setVertex(m_vertices[count++], x, GRID_UPPER, 0);
+			
+			setVertex(m_vertices[count++], GRID_LOWER, x, 0);
+			setVertex(m_vertices[count++], GRID_UPPER, x, 0);
+		}
+		
+		assert(count == VERTEX_COUNT);
+	}
+	
+	const HudGeometry & HudGeometry::shared () {
+		static const HudGeometry geometry;
+		
+		return geometry;
+	}
+}
@@ -0,0 +1,81 @@
+//
+//  ARHudGeometry.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_HUD_GEOMETRY_H
+#define _ARBROWSER_HUD_GEOMETRY_H
+
+#include <cstddef>
+
+namespace ARBrowser {
+	/// The static shapes drawn by the heads up display, which are stored in one vertex buffer.
+	enum HudPrimitive {
+		/// A loop around the Z axis with radius 1, which is scaled to draw rings of any radius. GL_LINE_LOOP.
+		HUD_RING,
+		
+		/// The horizontal line and the lower half of the vertical line of the radar. GL_LINES.
+		HUD_RADAR_CROSSHAIR,
+		
+		/// The upper half of the vertical line of the radar, which points forward. GL_LINES.
+		HUD_RADAR_FORWARD,
+		
+		/// The field of view of the camera on the radar. GL_TRIANGLES.
+		HUD_RADAR_FIELD_OF_VIEW,
+		
+		/// The x, y and z axes, coloured red, green and blue. GL_LINES.
+		HUD_AXIS,
+		
+		/// A 20x20 grid on the ground with a line every 0.5 units. GL_LINES.
+		HUD_GRID,
+		
+		HUD_PRIMITIVES
+	};
+	
+	struct HudVertex {
+		float position[3];
+		
+		/// Only used by primitives which have a colour per vertex, otherwise white.
+		float color[4];
+	};
+	
+	/// A range of vertices, for glDrawArrays.
+	struct HudRange {
+		std::size_t first, count;
+	};
+	
+	/// The vertices of every HudPrimitive, generated once and shared, so that drawing the heads up display doesn't allocate or compute any geometry.
+	class HudGeometry {
+		public:
+			enum {
+				RING_STEPS = 32,
+				
+				/// Lines in each direction, from -10 to 10 inclusive.
+				GRID_LINES = 41,
+				
+				VERTEX_COUNT = RING_STEPS + 4 + 2 + 3 + 6 + GRID_LINES * 4
+			};
+		
+		protected:
+			HudVertex m_vertices[VERTEX_COUNT];
+			HudRange m_ranges[HUD_PRIMITIVES];
+			
+			HudGeometry ();
+			
+		public:
+			/// The geometry is generated on first use, which is thread safe.
+			static const HudGeometry & shared ();
+			
+			const HudVertex * vertices () const { return m_vertices; }
+			const HudRange & range (HudPrimitive primitive) const { return m_ranges[primitive]; }
+		
+		private:
+			HudGeometry (const HudGeometry &);
+			HudGeometry & operator= (const HudGeometry &);
+	};
+}
+
+#endif
@@ -0,0 +1,579 @@
+//
+//  ARLevelOfDetail.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARLevelOfDetail.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace ARBrowser {
+	namespace {
+		struct Point {
+			double x, y, z;
+			
+			Point operator- (const Point & other) const {
+				Point result = {x - other.x, y - other.y, z - other.z};
+				return result;
+			}
+			
+			double dot (const Point & other) const {
+				return x * other.x + y * other.y + z * other.z;
+			}
+			
+			Point cross (const Point & other) const {
+				Point result = {y * other.z - z * other.y, z * other.x - x * other.z, x * other.y - y * other.x};
+				return result;
+			}
+			
+			double length () const {
+				return std::sqrt(dot(*this));
+			}
+		};
+		
+		/// A symmetric 4x4 matrix which gives the sum of squared distances from a point to a set of planes.
+		struct Quadric {
+			double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+			
+			void addPlane (const Point & normal, double d) {
+				const double a = normal.x, b = normal.y, c = normal.z;
+				
+				a2 += a * a; ab += a * b; ac += a * c; ad += a * d;
+				b2 += b * b; bc += b * c; bd += b * d;
+				c2 += c * c; cd += c * d;
+				d2 += d * d;
+			}
+			
+			void add (const Quadric & other) {
+				a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+				b2 += other.b2; bc += other.bc; bd += other.bd;
+				c2 += other.c2; cd += other.cd;
+				d2 += other.d2;
+			}
+			
+			double evaluate (const Point & p) const {
+				double error = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+					+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+					+ c2 * p.z * p.z + 2 * cd * p.z
+					+ d2;
+				
+				// Rounding can produce a small negative error:
+				return std::max(error, 0.0);
+			}
+		};
+		
+		enum VertexKind {
+			/// The vertex is surrounded by triangles, and can be collapsed onto any neighbour.
+			MANIFOLD,
+			/// The vertex is on an open edge, and can only be collapsed along that edge.
+			BORDER,
+			/// The vertex is on a texture seam or non-manifold geometry, and is never moved.
+			LOCKED
+		};
+		
+		struct Collapse {
+			std::uint32_t from, to;
+			double error;
+			
+			bool operator< (const Collapse & other) const {
+				return error < other.error;
+			}
+		};
+		
+		inline std::uint64_t edgeKey (std::uint32_t a, std::uint32_t b) {
+			return ((std::uint64_t)a << 32) | b;
+		}
+		
+		/// Positions are compared by value, so +0.0 and -0.0 are considered equal and must hash the same.
+		inline std::uint32_t hashableBits (float value) {
+			if (value == 0) return 0;
+			
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			
+			return bits;
+		}
+		
+		struct PositionHash {
+			std::size_t operator() (const Vec3 & position) const {
+				std::size_t hash = 2166136261u;
+				
+				for (std::size_t i = 0; i < 3; i += 1) {
+					hash = (hash ^ hashableBits(position[i])) * 16777619u;
+				}
+				
+				return hash;
+			}
+		};
+		
+		struct PositionEqual {
+			bool operator() (const Vec3 & a, const Vec3 & b) const {
+				return a[X] == b[X] && a[Y] == b[Y] && a[Z] == b[Z];
+			}
+		};
+		
+		void readIndices (const MeshBuffer & source, std::vector<std::uint32_t> & indices) {
+			indices.resize(source.indexCount);
+			
+			for (std::size_t i = 0; i < source.indexCount; i += 1) {
+				indices[i] = source.shortIndices ? ((const std::uint16_t *)source.indices)[i] : ((const std::uint32_t *)source.indices)[i];
+			}
+		}
+		
+		/// Simplifies one mesh, where vertices are identified with the first vertex which has the same position.
+		class Simplifier {
+			protected:
+				std::size_t m_vertexCount;
+				std::vector<Point> m_positions;
+				
+				/// The first vertex with the same position, and the number of vertices which share it.
+				std::vector<std::uint32_t> m_group, m_groupSize;
+				
+				/// Indexed by group.
+				std::vector<Quadric> m_quadrics;
+				
+				std::vector<std::uint8_t> m_kind;
+				
+				/// The number of times each directed edge between groups occurs.
+				std::unordered_map<std::uint64_t, std::uint32_t> m_edges;
+				
+				/// Triangles adjacent to each vertex, which is rebuilt for each pass.
+				std::vector<std::uint32_t> m_offsets, m_adjacency;
+				
+				/// The vertex each vertex was collapsed onto during the current pass.
+				std::vector<std::uint32_t> m_collapse;
+				
+				bool isEdge (std::uint32_t a, std::uint32_t b) const {
+					return m_edges.count(edgeKey(m_group[a], m_group[b])) != 0;
+				}
+				
+				bool isBorderEdge (std::uint32_t a, std::uint32_t b) const {
+					return isEdge(a, b) != isEdge(b, a);
+				}
+				
+				void classify (const std::vector<std::uint32_t> & indices);
+				void computeQuadrics (const std::vector<std::uint32_t> & indices);
+				void buildAdjacency (const std::vector<std::uint32_t> & indices);
+				
+				/// Check that the collapse doesn't change the topology or flip any remaining triangles.
+				/// @returns the number of triangles removed by the collapse, or 0 if it is not allowed.
+				std::size_t validate (const std::vector<std::uint32_t> & indices, std::uint32_t from, std::uint32_t to) const;
+			
+			public:
+				Simplifier (const MeshBuffer & source);
+				
+				float simplify (std::vector<std::uint32_t> & indices, std::size_t targetIndexCount, float targetError);
+		};
+		
+		Simplifier::Simplifier (const MeshBuffer & source) : m_vertexCount(source.vertexCount) {
+			m_positions.resize(m_vertexCount);
+			m_group.resize(m_vertexCount);
+			m_groupSize.assign(m_vertexCount, 0);
+			
+			std::unordered_map<Vec3, std::uint32_t, PositionHash, PositionEqual> lookup;
+			lookup.reserve(m_vertexCount);
+			
+			for (std::size_t i = 0; i < m_vertexCount; i += 1) {
+				Vec3 pos = source.position(i);
+				Point point = {pos[X], pos[Y], pos[Z]};
+				
+				m_positions[i] = point;
+				m_group[i] = lookup.insert(std::make_pair(pos, (std::uint32_t)i)).first->second;
+				m_groupSize[m_group[i]] += 1;
+			}
+			
+			m_collapse.resize(m_vertexCount);
+			for (std::size_t i = 0; i < m_vertexCount; i += 1) {
+				m_collapse[i] = (std::uint32_t)i;
+			}
+		}
+		
+		void Simplifier::classify (const std::vector<std::uint32_t> & indices) {
+			m_edges.clear();
+			
+			for (std::size_t i = 0; i < indices.size(); i += 3) {
+				for (std::size_t j = 0; j < 3; j += 1) {
+					m_edges[edgeKey(m_group[indices[i + j]], m_group[indices[i + (j + 1) % 3]])] += 1;
+				}
+			}
+			
+			std::vector<std::uint8_t> borderIn(m_vertexCount, 0), borderOut(m_vertexCount, 0), locked(m_vertexCount, 0);
+			
+			for (auto & edge : m_edges) {
+				std::uint32_t a = (std::uint32_t)(edge.first >> 32), b = (std::uint32_t)edge.first;
+				
+				if (edge.second > 1) {
+					// More than two triangles share this edge:
+					locked[a] = locked[b] = 1;
+				} else if (m_edges.count(edgeKey(b, a)) == 0) {
+					borderOut[a] = std::min(borderOut[a] + 1, 2);
+					borderIn[b] = std::min(borderIn[b] + 1, 2);
+				}
+			}
+			
+			m_kind.resize(m_vertexCount);
+			
+			for (std::size_t i = 0; i < m_vertexCount; i += 1) {
+				std::uint32_t group = m_group[i];
+				
+				if (m_groupSize[group] > 1 || locked[group]) {
+					m_kind[i] = LOCKED;
+				} else if (borderIn[group] == 0 && borderOut[group] == 0) {
+					m_kind[i] = MANIFOLD;
+				} else if (borderIn[group] == 1 && borderOut[group] == 1) {
+					m_kind[i] = BORDER;
+				} else {
+					m_kind[i] = LOCKED;
+				}
+			}
+		}
+		
+		void Simplifier::computeQuadrics (const std::vector<std::uint32_t> & indices) {
+			m_quadrics.assign(m_vertexCount, Quadric());
+			
+			for (std::size_t i = 0; i < indices.size(); i += 3) {
+				const std::uint32_t v[3] = {indices[i], indices[i + 1], indices[i + 2]};
+				const Point & p0 = m_positions[v[0]];
+				
+				Point normal = (m_positions[v[1]] - p0).cross(m_positions[v[2]] - p0);
+				double length = normal.length();
+				
+				if (length == 0) continue;
+				
+				normal.x /= length; normal.y /= length; normal.z /= length;
+				
+				Quadric quadric = Quadric();
+				quadric.addPlane(normal, -normal.dot(p0));
+				
+				for (std::size_t j = 0; j < 3; j += 1) {
+					m_quadrics[m_group[v[j]]].add(quadric);
+					
+					std::uint32_t a = v[j], b = v[(j + 1) % 3];
+					
+					// Keep borders in place by penalising movement away from a plane through the edge, perpendicular to the triangle:
+					if (isBorderEdge(a, b)) {
+						Point edge = m_positions[b] - m_positions[a];
+						Point perpendicular = edge.cross(normal);
+						double perpendicularLength = perpendicular.length();
+						
+						if (perpendicularLength == 0) continue;
+						
+						perpendicular.x /= perpendicularLength; perpendicular.y /= perpendicularLength; perpendicular.z /= perpendicularLength;
+						
+						Quadric border = Quadric();
+						border.addPlane(perpendicular, -perpendicular.dot(m_positions[a]));
+						
+						m_quadrics[m_group[a]].add(border);
+						m_quadrics[m_group[b]].add(border);
+					}
+				}
+			}
+		}
+		
+		void Simplifier::buildAdjacency (const std::vector<std::uint32_t> & indices) {
+			m_offsets.assign(m_vertexCount + 1, 0);
+			
+			for (std::size_t i = 0; i < indices.size(); i += 1) {
+				m_offsets[indices[i] + 1] += 1;
+			}
+			
+			for (std::size_t i = 0; i < m_vertexCount; i += 1) {
+				m_offsets[i + 1] += m_offsets[i];
+			}
+			
+			m_adjacency.resize(indices.size());
+			std::vector<std::uint32_t> fill(m_offsets.begin(), m_offsets.end() - 1);
+			
+			for (std::size_t i = 0; i < indices.size(); i += 1) {
+				m_adjacency[fill[indices[i]]++] = (std::uint32_t)(i / 3);
+			}
+		}
+		
+		std::size_t Simplifier::validate (const std::vector<std::uint32_t> & indices, std::uint32_t from, std::uint32_t to) const {
+			std::size_t removed = 0;
+			std::vector<std::uint32_t> fromNeighbours, toNeighbours;
+			
+			for (std::uint32_t k = m_offsets[from]; k < m_offsets[from + 1]; k += 1) {
+				std::size_t triangle = m_adjacency[k] * 3;
+				std::uint32_t v[3];
+				
+				for (std::size_t j = 0; j < 3; j += 1) {
+					v[j] = m_collapse[indices[triangle + j]];
+				}
+				
+				// Triangles which were removed by an earlier collapse in this pass:
+				if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0]) continue;
+				
+				std::size_t corner = (v[0] == from) ? 0 : (v[1] == from) ? 1 : 2;
+				std::uint32_t a = v[(corner + 1) % 3], b = v[(corner + 2) % 3];
+				
+				fromNeighbours.push_back(m_group[a]);
+				fromNeighbours.push_back(m_group[b]);
+				
+				if (a == to || b == to) {
+					removed += 1;
+					continue;
+				}
+				
+				// The triangle must not flip, become degenerate or turn by more than 60 degrees when from moves to to, since small turns accumulate into folds over several collapses:
+				const Point & pa = m_positions[a], & pb = m_positions[b];
+				Point before = (pa - m_positions[from]).cross(pb - m_positions[from]);
+				Point after = (pa - m_positions[to]).cross(pb - m_positions[to]);
+				
+				if (before.dot(after) <= 0.5 * before.length() * after.length())
+					return 0;
+			}
+			
+			// The link condition: from and to must only share the neighbours opposite the edge, otherwise the collapse creates non-manifold geometry.
+			for (std::uint32_t k = m_offsets[to]; k < m_offsets[to + 1]; k += 1) {
+				std::size_t triangle = m_adjacency[k] * 3;
+				std::uint32_t v[3];
+				
+				for (std::size_t j = 0; j < 3; j += 1) {
+					v[j] = m_collapse[indices[triangle + j]];
+				}
+				
+				if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0]) continue;
+				
+				for (std::size_t j = 0; j < 3; j += 1) {
+					if (v[j] != to) toNeighbours.push_back(m_group[v[j]]);
+				}
+			}
+			
+			std::sort(fromNeighbours.begin(), fromNeighbours.end());
+			fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+			
+			std::sort(toNeighbours.begin(), toNeighbours.end());
+			toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+			
+			std::size_t shared = 0;
+			
+			for (std::size_t i = 0; i < fromNeighbours.size(); i += 1) {
+				if (fromNeighbours[i] != m_group[to] && std::binary_search(toNeighbours.begin(), toNeighbours.end(), fromNeighbours[i]))
+					shared += 1;
+			}
+			
+			if (shared != removed)
+				return 0;
+			
+			return removed;
+		}
+		
+		float Simplifier::simplify (std::vector<std::uint32_t> & indices, std::size_t targetIndexCount, float targetError) {
+			const double errorLimit = (double)targetError * targetError;
+			double error = 0;
+			
+			std::vector<Collapse> collapses;
+			std::vector<std::uint8_t> touched;
+			
+			classify(indices);
+			computeQuadrics(indices);
+			
+			while (indices.size() > targetIndexCount) {
+				collapses.clear();
+				
+				for (std::size_t i = 0; i < indices.size(); i += 3) {
+					for (std::size_t j = 0; j < 3; j += 1) {
+						std::uint32_t a = indices[i + j], b = indices[i + (j + 1) % 3];
+						
+						// Consider collapsing the edge in both directions:
+						for (std::size_t k = 0; k < 2; k += 1) {
+							std::uint32_t from = k ? b : a, to = k ? a : b;
+							
+							if (m_kind[from] == LOCKED || (m_kind[from] == BORDER && !isBorderEdge(from, to)))
+								continue;
+							
+							Quadric quadric = m_quadrics[m_group[from]];
+							quadric.add(m_quadrics[m_group[to]]);
+							
+							Collapse collapse = {from, to, quadric.evaluate(m_positions[to])};
+							
+							if (collapse.error <= errorLimit)
+								collapses.push_back(collapse);
+						}
+					}
+				}
+				
+				if (collapses.empty()) break;
+				
+				std::sort(collapses.begin(), collapses.end());
+				buildAdjacency(indices);
+				
+				// Collapse the cheapest edges first. Each vertex takes part in at most one collapse per pass, so the adjacency and quadrics stay valid:
+				touched.assign(m_vertexCount, 0);
+				
+				std::size_t triangleCount = indices.size() / 3, targetTriangleCount = targetIndexCount / 3, collapsed = 0;
+				
+				for (std::size_t i = 0; i < collapses.size() && triangleCount > targetTriangleCount; i += 1) {
+					const Collapse & collapse = collapses[i];
+					
+					if (touched[collapse.from] || touched[collapse.to]) continue;
+					
+					std::size_t removed = validate(indices, collapse.from, collapse.to);
+					
+					if (removed == 0) continue;
+					
+					m_collapse[collapse.from] = collapse.to;
+					m_quadrics[m_group[collapse.to]].add(m_quadrics[m_group[collapse.from]]);
+					
+					touched[collapse.from] = touched[collapse.to] = 1;
+					triangleCount -= removed;
+					collapsed += 1;
+					
+					error = std::max(error, collapse.error);
+				}
+				
+				if (collapsed == 0) break;
+				
+				// Remove the triangles which became degenerate:
+				std::size_t count = 0;
+				
+				for (std::size_t i = 0; i < indices.size(); i += 3) {
+					std::uint32_t a = m_collapse[indices[i]], b = m_collapse[indices[i + 1]], c = m_collapse[indices[i + 2]];
+					
+					if (a != b && b != c && c != a) {
+						indices[count++] = a;
+						indices[count++] = b;
+						indices[count++] = c;
+					}
+				}
+				
+				indices.resize(count);
+				
+				for (std::size_t i = 0; i < m_vertexCount; i += 1) {
+					m_collapse[i] = (std::uint32_t)i;
+				}
+				
+				// Collapses change which vertices are on a border:
+				classify(indices);
+			}
+			
+			return (float)std::sqrt(error);
+		}
+	}
+	
+	float simplifyMesh (const MeshBuffer & source, std::size_t targetIndexCount, float targetError, std::vector<std::uint32_t> & indices) {
+		readIndices(source, indices);
+		
+		if (indices.size() <= targetIndexCount)
+			return 0;
+		
+		Simplifier simplifier(source);
+		float error = simplifier.simplify(indices, targetIndexCount, targetError);
+		
+		optimizeVertexCache(indices, source.vertexCount);
+		
+		return error;
+	}
+	
+	LevelOfDetail::LevelOfDetail () {
+	}
+	
+	void LevelOfDetail::clear () {
+		m_levels.clear();
+		m_storage.clear();
+	}
+	
+	void LevelOfDetail::build (const std::vector<MeshBuffer> & meshes, float maximumError, std::size_t maximumLevels) {
+		// A level must remove at least this fraction of the previous level's triangles to be worth keeping:
+		const float MINIMUM_REDUCTION = 0.2;
+		
+		clear();
+		
+		Level original = {meshes, 0, 0};
+		
+		for (std::size_t i = 0; i < meshes.size(); i += 1) {
+			original.triangleCount += meshes[i].indexCount / 3;
+		}
+		
+		m_levels.push_back(original);
+		
+		while (m_levels.size() < maximumLevels) {
+			const Level & previous = m_levels.back();
+			
+			Level level = {std::vector<MeshBuffer>(), previous.error, 0};
+			std::vector<std::vector<std::uint32_t>> indices(previous.meshes.size());
+			
+			// Simplify the previous level, so the errors of each level accumulate:
+			for (std::size_t i = 0; i < previous.meshes.size(); i += 1) {
+				const MeshBuffer & mesh = previous.meshes[i];
+				std::size_t targetIndexCount = (mesh.indexCount / 6) * 3;
+				
+				float error = simplifyMesh(mesh, targetIndexCount, maximumError - previous.error, indices[i]);
+				
+				level.error = std::max(level.error, previous.error + error);
+				level.triangleCount += indices[i].size() / 3;
+			}
+			
+			if (level.triangleCount > previous.triangleCount * (1.0 - MINIMUM_REDUCTION))
+				break;
+			
+			for (std::size_t i = 0; i < previous.meshes.size(); i += 1) {
+				MeshBuffer mesh = previous.meshes[i];
+				
+				m_storage.push_back(IndexedMesh());
+				IndexedMesh & storage = m_storage.back();
+				
+				// Keep the index type of the original mesh, since the vertices are shared with it:
+				if (mesh.shortIndices) {
+					storage.shortIndices.assign(indices[i].begin(), indices[i].end());
+					mesh.indices = storage.shortIndices.empty() ? NULL : &storage.shortIndices[0];
+				} else {
+					storage.longIndices.swap(indices[i]);
+					mesh.indices = storage.longIndices.empty() ? NULL : &storage.longIndices[0];
+				}
+				
+				mesh.indexCount = storage.indexCount();
+				level.meshes.push_back(mesh);
+			}
+			
+			m_levels.push_back(level);
+		}
+	}
+	
+	void LevelOfDetail::assign (const std::vector<Level> & levels) {
+		clear();
+		
+		m_levels = levels;
+	}
+	
+	std::size_t LevelOfDetail::select (float pixelsPerUnit, std::size_t previous, float threshold, float hysteresis) const {
+		if (m_levels.empty())
+			return 0;
+		
+		previous = std::min(previous, m_levels.size() - 1);
+		
+		if (m_levels[previous].error * pixelsPerUnit > threshold) {
+			// The previous level is now too coarse, so switch to a finer level straight away. Level 0 has no error.
+			std::size_t level = previous;
+			
+			while (level > 0 && m_levels[level].error * pixelsPerUnit > threshold)
+				level -= 1;
+			
+			return level;
+		} else {
+			std::size_t level = previous;
+			
+			while (level + 1 < m_levels.size() && m_levels[level + 1].error * pixelsPerUnit <= threshold * (1.0 - hysteresis))
+				level += 1;
+			
+			return level;
+		}
+	}
+	
+	std::size_t LevelOfDetail::residentSize () const {
+		std::size_t size = 0;
+		
+		for (std::size_t i = 0; i < m_storage.size(); i += 1) {
+			size += m_storage[i].shortIndices.size() * sizeof(std::uint16_t) + m_storage[i].longIndices.size() * sizeof(std::uint32_t);
+		}
+		
+		return size;
+	}
+}
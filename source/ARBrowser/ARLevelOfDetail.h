@@ -0,0 +1,71 @@
+//
+//  ARLevelOfDetail.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_LEVEL_OF_DETAIL_H
+#define _ARBROWSER_LEVEL_OF_DETAIL_H
+
+#include "ARMesh.h"
+
+#include <deque>
+
+namespace ARBrowser {
+	/// Simplify a mesh by repeatedly collapsing the edge with the lowest quadric error (Garland & Heckbert, 1997) until there are at most targetIndexCount indices, or no edge can be collapsed without exceeding targetError.
+	/// Each edge is collapsed onto one of its existing vertices, so the result refers to the vertices of the source mesh and their texture coordinates are preserved. Vertices on a texture seam are never moved, and vertices on the border of the mesh (e.g. where one material meets another) only move along the border.
+	/// @returns the geometric error of the result, which is an upper bound on the distance of any moved vertex from the planes of the triangles it was merged with.
+	float simplifyMesh (const MeshBuffer & source, std::size_t targetIndexCount, float targetError, std::vector<std::uint32_t> & indices);
+	
+	/// The largest error of a simplified level, relative to the radius of the model's bounding box.
+	const float MAXIMUM_DETAIL_ERROR = 0.05;
+	
+	/// A chain of progressively simplified versions of a model. Simplified levels only store indices, and refer to the vertices of the original meshes.
+	class LevelOfDetail {
+		public:
+			struct Level {
+				std::vector<MeshBuffer> meshes;
+				
+				/// The geometric error in model units, relative to the original meshes.
+				float error;
+				
+				std::size_t triangleCount;
+			};
+		
+		protected:
+			std::vector<Level> m_levels;
+			
+			/// The index buffers of the simplified levels.
+			std::deque<IndexedMesh> m_storage;
+		
+		public:
+			LevelOfDetail ();
+			
+			/// Build the chain from the given meshes, which become level 0 and must outlive the chain. Each subsequent level has about half the triangles of the previous one. No level exceeds maximumError, and the chain stops early when simplification no longer removes a significant number of triangles.
+			void build (const std::vector<MeshBuffer> & meshes, float maximumError, std::size_t maximumLevels = 5);
+			
+			/// Use levels which were built elsewhere, e.g. mapped from an .armesh file, whose meshes must outlive the chain.
+			void assign (const std::vector<Level> & levels);
+			
+			void clear ();
+			
+			std::size_t levelCount () const { return m_levels.size(); }
+			const Level & level (std::size_t index) const { return m_levels[index]; }
+			
+			/// Choose the coarsest level whose error is at most threshold pixels on screen, given the size of one model unit in pixels.
+			/// Moving to a coarser level than previous requires the error to be below threshold * (1 - hysteresis), so that levels don't alternate when the size is close to a boundary.
+			std::size_t select (float pixelsPerUnit, std::size_t previous, float threshold = 1.0, float hysteresis = 0.25) const;
+			
+			/// The size of the index buffers of levels which were built. Assigned levels are owned by whoever assigned them.
+			std::size_t residentSize () const;
+		
+		private:
+			/// Simplified levels refer to their own storage, so the chain can't be copied.
+			LevelOfDetail (const LevelOfDetail &);
+			LevelOfDetail & operator= (const LevelOfDetail &);
+	};
+}
+
+#endif
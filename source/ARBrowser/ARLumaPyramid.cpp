@@ -0,0 +1,276 @@
+//
+//  ARLumaPyramid.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARLumaPyramid.h"
+
+#include <algorithm>
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define AR_LUMA_AVX2
+#elif defined(__SSE2__)
+	#include <emmintrin.h>
+	#define AR_LUMA_SSE2
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	#include <arm_neon.h>
+	#define AR_LUMA_NEON
+#endif
+
+namespace ARBrowser {
+	// The BT.601 weights scaled by 256, which add up to 256 so that white stays white:
+	enum : std::uint32_t {
+		RED = 77, GREEN = 150, BLUE = 29
+	};
+	
+	static void convertRowScalar (const std::uint8_t * bgra, std::size_t begin, std::size_t end, std::uint8_t * luma) {
+		for (std::size_t x = begin; x < end; x += 1) {
+			const std::uint8_t * pixel = bgra + (x * 4);
+			
+			luma[x] = (std::uint8_t)((BLUE * pixel[0] + GREEN * pixel[1] + RED * pixel[2] + 128) >> 8);
+		}
+	}
+	
+	static void downsampleRowScalar (const std::uint8_t * top, const std::uint8_t * bottom, std::size_t begin, std::size_t end, std::uint8_t * destination) {
+		for (std::size_t x = begin; x < end; x += 1) {
+			std::uint32_t sum = top[x*2] + top[x*2 + 1] + bottom[x*2] + bottom[x*2 + 1];
+			
+			destination[x] = (std::uint8_t)((sum + 2) >> 2);
+		}
+	}
+	
+	/// Convert one row, returning the number of pixels converted, which is a multiple of the vector width.
+	static std::size_t convertRowVector (const std::uint8_t * bgra, std::size_t width, std::uint8_t * luma) {
+		std::size_t x = 0;
+		
+#if defined(AR_LUMA_AVX2)
+		// Blue and red are in alternate 16-bit lanes after masking, and green and alpha after shifting, so one multiply-add of each gives the weighted sum in 32-bit lanes:
+		const __m256i mask = _mm256_set1_epi32(0x00FF00FF), blueRed = _mm256_set1_epi32((RED << 16) | BLUE), greenAlpha = _mm256_set1_epi32(GREEN), rounding = _mm256_set1_epi32(128);
+		
+		// The packing instructions work within each 128-bit half, which leaves groups of four pixels in this order:
+		const __m256i order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+		
+		for (; x + 32 <= width; x += 32) {
+			__m256i y[4];
+			
+			for (std::size_t i = 0; i < 4; i += 1) {
+				__m256i pixels = _mm256_loadu_si256((const __m256i *)(bgra + (x + i * 8) * 4));
+				__m256i sum = _mm256_add_epi32(_mm256_madd_epi16(_mm256_and_si256(pixels, mask), blueRed), _mm256_madd_epi16(_mm256_srli_epi16(pixels, 8), greenAlpha));
+				
+				y[i] = _mm256_srli_epi32(_mm256_add_epi32(sum, rounding), 8);
+			}
+			
+			__m256i packed = _mm256_packus_epi16(_mm256_packs_epi32(y[0], y[1]), _mm256_packs_epi32(y[2], y[3]));
+			_mm256_storeu_si256((__m256i *)(luma + x), _mm256_permutevar8x32_epi32(packed, order));
+		}
+#elif defined(AR_LUMA_SSE2)
+		const __m128i mask = _mm_set1_epi32(0x00FF00FF), blueRed = _mm_set1_epi32((RED << 16) | BLUE), greenAlpha = _mm_set1_epi32(GREEN), rounding = _mm_set1_epi32(128);
+		
+		for (; x + 16 <= width; x += 16) {
+			__m128i y[4];
+			
+			for (std::size_t i = 0; i < 4; i += 1) {
+				__m128i pixels = _mm_loadu_si128((const __m128i *)(bgra + (x + i * 4) * 4));
+				__m128i sum = _mm_add_epi32(_mm_madd_epi16(_mm_and_si128(pixels, mask), blueRed), _mm_madd_epi16(_mm_srli_epi16(pixels, 8), greenAlpha));
+				
+				y[i] = _mm_srli_epi32(_mm_add_epi32(sum, rounding), 8);
+			}
+			
+			_mm_storeu_si128((__m128i *)(luma + x), _mm_packus_epi16(_mm_packs_epi32(y[0], y[1]), _mm_packs_epi32(y[2], y[3])));
+		}
+#elif defined(AR_LUMA_NEON)
+		const uint8x8_t red = vdup_n_u8(RED), green = vdup_n_u8(GREEN), blue = vdup_n_u8(BLUE);
+		
+		for (; x + 16 <= width; x += 16) {
+			// Loading with deinterleaving gives the blue, green, red and alpha channels in separate registers:
+			uint8x16x4_t pixels = vld4q_u8(bgra + x * 4);
+			
+			uint16x8_t low = vmull_u8(vget_low_u8(pixels.val[0]), blue);
+			low = vmlal_u8(low, vget_low_u8(pixels.val[1]), green);
+			low = vmlal_u8(low, vget_low_u8(pixels.val[2]), red);
+			
+			uint16x8_t high = vmull_u8(vget_high_u8(pixels.val[0]), blue);
+			high = vmlal_u8(high, vget_high_u8(pixels.val[1]), green);
+			high = vmlal_u8(high, vget_high_u8(pixels.val[2]), red);
+			
+			// The rounding shift adds 128 before shifting, which can't overflow since the largest sum is 255 * 256:
+			vst1q_u8(luma + x, vcombine_u8(vrshrn_n_u16(low, 8), vrshrn_n_u16(high, 8)));
+		}
+#else
+		(void)bgra; (void)width; (void)luma;
+#endif
+		
+		return x;
+	}
+	
+	/// Downsample one row, returning the number of destination pixels written, which is a multiple of the vector width.
+	static std::size_t downsampleRowVector (const std::uint8_t * top, const std::uint8_t * bottom, std::size_t width, std::uint8_t * destination) {
+		std::size_t x = 0;
+		
+#if defined(AR_LUMA_AVX2)
+		// Adding the even and odd bytes of each 16-bit lane gives the horizontal sums, without overflow:
+		const __m256i mask = _mm256_set1_epi16(0x00FF), rounding = _mm256_set1_epi16(2);
+		
+		for (; x + 32 <= width; x += 32) {
+			__m256i sums[2];
+			
+			for (std::size_t i = 0; i < 2; i += 1) {
+				__m256i a = _mm256_loadu_si256((const __m256i *)(top + (x + i * 16) * 2)), b = _mm256_loadu_si256((const __m256i *)(bottom + (x + i * 16) * 2));
+				__m256i sum = _mm256_add_epi16(_mm256_add_epi16(_mm256_and_si256(a, mask), _mm256_srli_epi16(a, 8)), _mm256_add_epi16(_mm256_and_si256(b, mask), _mm256_srli_epi16(b, 8)));
+				
+				sums[i] = _mm256_srli_epi16(_mm256_add_epi16(sum, rounding), 2);
+			}
+			
+			__m256i packed = _mm256_packus_epi16(sums[0], sums[1]);
+			_mm256_storeu_si256((__m256i *)(destination + x), _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+		}
+#elif defined(AR_LUMA_SSE2)
+		const __m128i mask = _mm_set1_epi16(0x00FF), rounding = _mm_set1_epi16(2);
+		
+		for (; x + 16 <= width; x += 16) {
+			__m128i sums[2];
+			
+			for (std::size_t i = 0; i < 2; i += 1) {
+				__m128i a = _mm_loadu_si128((const __m128i *)(top + (x + i * 8) * 2)), b = _mm_loadu_si128((const __m128i *)(bottom + (x + i * 8) * 2));
+				__m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8)), _mm_add_epi16(_mm_and_si128(b, mask), _mm_srli_epi16(b, 8)));
+				
+				sums[i] = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 2);
+			}
+			
+			_mm_storeu_si128((__m128i *)(destination + x), _mm_packus_epi16(sums[0], sums[1]));
+		}
+#elif defined(AR_LUMA_NEON)
+		for (; x + 16 <= width; x += 16) {
+			// Pairwise adds of the top row, accumulating the bottom row:
+			uint16x8_t low = vpadalq_u8(vpaddlq_u8(vld1q_u8(top + x * 2)), vld1q_u8(bottom + x * 2));
+			uint16x8_t high = vpadalq_u8(vpaddlq_u8(vld1q_u8(top + x * 2 + 16)), vld1q_u8(bottom + x * 2 + 16));
+			
+			vst1q_u8(destination + x, vcombine_u8(vrshrn_n_u16(low, 2), vrshrn_n_u16(high, 2)));
+		}
+#else
+		(void)top; (void)bottom; (void)width; (void)destination;
+#endif
+		
+		return x;
+	}
+	
+	const char * lumaKernelName () {
+#if defined(AR_LUMA_AVX2)
+		return "AVX2";
+#elif defined(AR_LUMA_SSE2)
+		return "SSE2";
+#elif defined(AR_LUMA_NEON)
+		return "NEON";
+#else
+		return "scalar";
+#endif
+	}
+	
+	void convertBGRAToLuma (const std::uint8_t * bgra, std::size_t bytesPerRow, std::size_t width, std::size_t height, std::uint8_t * luma, std::size_t lumaStride) {
+		for (std::size_t y = 0; y < height; y += 1) {
+			const std::uint8_t * row = bgra + y * bytesPerRow;
+			std::uint8_t * output = luma + y * lumaStride;
+			
+			convertRowScalar(row, convertRowVector(row, width, output), width, output);
+		}
+	}
+	
+	void downsampleLuma (const std::uint8_t * source, std::size_t sourceStride, std::size_t width, std::size_t height, std::uint8_t * destination, std::size_t destinationStride) {
+		for (std::size_t y = 0; y < height / 2; y += 1) {
+			const std::uint8_t * top = source + (y * 2) * sourceStride;
+			std::uint8_t * output = destination + y * destinationStride;
+			
+			downsampleRowScalar(top, top + sourceStride, downsampleRowVector(top, top + sourceStride, width / 2, output), width / 2, output);
+		}
+	}
+	
+	void convertBGRAToLumaScalar (const std::uint8_t * bgra, std::size_t bytesPerRow, std::size_t width, std::size_t height, std::uint8_t * luma, std::size_t lumaStride) {
+		for (std::size_t y = 0; y < height; y += 1)
+			convertRowScalar(bgra + y * bytesPerRow, 0, width, luma + y * lumaStride);
+	}
+	
+	void downsampleLumaScalar (const std::uint8_t * source, std::size_t sourceStride, std::size_t width, std::size_t height, std::uint8_t * destination, std::size_t destinationStride) {
+		for (std::size_t y = 0; y < height / 2; y += 1) {
+			const std::uint8_t * top = source + (y * 2) * sourceStride;
+			
+			downsampleRowScalar(top, top + sourceStride, 0, width / 2, destination + y * destinationStride);
+		}
+	}
+	
+	void LumaPyramid::resize (std::size_t width, std::size_t height, std::size_t levels) {
+		std::vector<Level> sizes;
+		
+		for (std::size_t i = 0; i < levels && width > 0 && height > 0; i += 1) {
+			Level level = {width, height, NULL};
+			sizes.push_back(level);
+			
+			width /= 2;
+			height /= 2;
+		}
+		
+		bool changed = sizes.size() != m_levels.size();
+		
+		for (std::size_t i = 0; i < sizes.size() && !changed; i += 1)
+			changed = sizes[i].width != m_levels[i].width || sizes[i].height != m_levels[i].height;
+		
+		if (!changed)
+			return;
+		
+		std::size_t total = 0;
+		
+		for (std::size_t i = 0; i < sizes.size(); i += 1)
+			total += sizes[i].width * sizes[i].height;
+		
+		m_storage.resize(total);
+		m_levels = sizes;
+		
+		std::uint8_t * data = m_storage.data();
+		
+		for (std::size_t i = 0; i < m_levels.size(); i += 1) {
+			m_levels[i].data = data;
+			data += m_levels[i].width * m_levels[i].height;
+		}
+	}
+	
+	bool LumaPyramid::update (const std::uint8_t * bgra, std::size_t bytesPerRow, std::size_t width, std::size_t height, std::size_t levels, const Region * region) {
+		std::size_t left = 0, top = 0, right = width, bottom = height;
+		
+		if (region) {
+			left = std::min(region->x, width);
+			top = std::min(region->y, height);
+			right = std::min(left + region->width, width);
+			bottom = std::min(top + region->height, height);
+		}
+		
+		resize(right - left, bottom - top, levels);
+		
+		if (m_levels.empty())
+			return false;
+		
+		const std::uint8_t * origin = bgra + top * bytesPerRow + left * 4;
+		
+		for (std::size_t y = 0; y < m_levels[0].height; y += 1) {
+			convertBGRAToLuma(origin + y * bytesPerRow, bytesPerRow, m_levels[0].width, 1, m_levels[0].data + y * m_levels[0].width, m_levels[0].width);
+			
+			// Each completed pair of rows makes one row of the next level, and so on, while the rows are still in the cache:
+			std::size_t row = y;
+			
+			for (std::size_t i = 1; i < m_levels.size() && (row & 1); i += 1) {
+				const Level & source = m_levels[i-1], & destination = m_levels[i];
+				
+				row /= 2;
+				
+				if (row >= destination.height)
+					break;
+				
+				downsampleLuma(source.data + (row * 2) * source.width, source.width, source.width, 2, destination.data + row * destination.width, destination.width);
+			}
+		}
+		
+		return true;
+	}
+}
@@ -0,0 +1,61 @@
+//
+//  ARLumaPyramid.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_LUMA_PYRAMID_H
+#define _ARBROWSER_LUMA_PYRAMID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ARBrowser {
+	/// Convert rows of BGRA pixels to 8-bit luminance using the BT.601 weights, i.e. <tt>(77R + 150G + 29B + 128) / 256</tt>, using vector instructions where available.
+	void convertBGRAToLuma (const std::uint8_t * bgra, std::size_t bytesPerRow, std::size_t width, std::size_t height, std::uint8_t * luma, std::size_t lumaStride);
+	
+	/// Halve the size of a luminance image by averaging each 2x2 block, rounding to nearest. If the width or height is odd, the last column or row is ignored.
+	void downsampleLuma (const std::uint8_t * source, std::size_t sourceStride, std::size_t width, std::size_t height, std::uint8_t * destination, std::size_t destinationStride);
+	
+	/// The scalar implementations, which the vector implementations match exactly.
+	void convertBGRAToLumaScalar (const std::uint8_t * bgra, std::size_t bytesPerRow, std::size_t width, std::size_t height, std::uint8_t * luma, std::size_t lumaStride);
+	void downsampleLumaScalar (const std::uint8_t * source, std::size_t sourceStride, std::size_t width, std::size_t height, std::uint8_t * destination, std::size_t destinationStride);
+	
+	/// The name of the vector instructions used by convertBGRAToLuma and downsampleLuma, e.g. "NEON", or "scalar".
+	const char * lumaKernelName ();
+	
+	/// A luminance image of a camera frame at full size, and successively at half the size of the previous level. The pyramid is built in one pass over the frame: each pair of rows is downsampled into the next level as soon as it has been converted.
+	class LumaPyramid {
+		public:
+			struct Region {
+				std::size_t x, y, width, height;
+			};
+			
+			struct Level {
+				std::size_t width, height;
+				
+				/// The rows of each level are tightly packed, i.e. the stride is the width.
+				std::uint8_t * data;
+			};
+		
+		protected:
+			std::vector<Level> m_levels;
+			std::vector<std::uint8_t> m_storage;
+			
+			void resize (std::size_t width, std::size_t height, std::size_t levels);
+		
+		public:
+			/// Build the pyramid from a BGRA frame. If a region is given, only that part of the frame is used, clipped to the frame. Storage is reused while the size of the frame and the number of levels don't change.
+			/// @returns false if the region is empty, in which case the pyramid has no levels.
+			bool update (const std::uint8_t * bgra, std::size_t bytesPerRow, std::size_t width, std::size_t height, std::size_t levels, const Region * region = NULL);
+			
+			/// The number of levels, which may be fewer than requested if the frame is too small.
+			std::size_t levelCount () const { return m_levels.size(); }
+			const Level & level (std::size_t index) const { return m_levels[index]; }
+	};
+}
+
+#endif
@@ -0,0 +1,127 @@
+//
+//  ARMappedFile.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARMappedFile.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace ARBrowser {
+	// A valid pointer used for mapping empty files, which mmap refuses to map.
+	static const char EMPTY_FILE[1] = {0};
+	
+	MappedFile::MappedFile () : m_data(NULL), m_size(0) {
+	}
+	
+	MappedFile::~MappedFile () {
+		close();
+	}
+	
+	bool MappedFile::open (const std::string & path) {
+		close();
+		
+		int descriptor = ::open(path.c_str(), O_RDONLY);
+		
+		if (descriptor == -1) {
+			return false;
+		}
+		
+		struct stat status;
+		
+		if (fstat(descriptor, &status) == -1) {
+			::close(descriptor);
+			
+			return false;
+		}
+		
+		if (status.st_size == 0) {
+			m_data = EMPTY_FILE;
+		} else {
+			void * data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+			
+			if (data == MAP_FAILED) {
+				std::cerr << "Couldn't map file: " << path << std::endl;
+			} else {
+				m_data = (const char *)data;
+				m_size = status.st_size;
+			}
+		}
+		
+		// The mapping remains valid after the descriptor is closed.
+		::close(descriptor);
+		
+		return m_data != NULL;
+	}
+	
+	void MappedFile::close () {
+		if (m_data && m_data != EMPTY_FILE) {
+			munmap((void *)m_data, m_size);
+		}
+		
+		m_data = NULL;
+		m_size = 0;
+	}
+	
+	void MappedFile::adviseSequential () const {
+		if (m_size > 0) {
+			posix_madvise((void *)m_data, m_size, POSIX_MADV_SEQUENTIAL);
+		}
+	}
+	
+	void MappedFile::adviseRandom () const {
+		if (m_size > 0) {
+			posix_madvise((void *)m_data, m_size, POSIX_MADV_RANDOM);
+		}
+	}
+	
+	void MappedFile::adviseWillNeed (std::size_t offset, std::size_t size) const {
+		if (offset >= m_size || size == 0) {
+			return;
+		}
+		
+		// The address must be page aligned:
+		const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+		std::size_t begin = offset - (offset % pageSize), end = std::min(offset + size, m_size);
+		
+		posix_madvise((void *)(m_data + begin), end - begin, POSIX_MADV_WILLNEED);
+	}
+	
+	std::size_t MappedFile::residentSize () const {
+		if (m_size == 0) {
+			return 0;
+		}
+		
+		const std::size_t pageSize = sysconf(_SC_PAGESIZE);
+		std::vector<unsigned char> pages((m_size + pageSize - 1) / pageSize);
+		
+#if defined(__APPLE__)
+		int result = mincore(m_data, m_size, (char *)pages.data());
+#else
+		int result = mincore((void *)m_data, m_size, pages.data());
+#endif
+		
+		if (result == -1) {
+			return 0;
+		}
+		
+		std::size_t resident = 0;
+		
+		for (std::size_t i = 0; i < pages.size(); i += 1) {
+			if (pages[i] & 1)
+				resident += 1;
+		}
+		
+		return resident * pageSize;
+	}
+}
@@ -0,0 +1,57 @@
+//
+//  ARMappedFile.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_MAPPED_FILE_H
+#define _ARBROWSER_MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace ARBrowser {
+	/// A read-only memory mapping of an entire file.
+	/// The mapping is released when the object is destroyed, so any pointers into the file must not outlive it.
+	class MappedFile {
+		protected:
+			const char * m_data;
+			std::size_t m_size;
+			
+		public:
+			MappedFile ();
+			~MappedFile ();
+			
+			/// Map the given file, closing any previously mapped file.
+			/// @returns false if the file could not be opened or mapped.
+			bool open (const std::string & path);
+			void close ();
+			
+			/// Hint to the kernel that the file will be read from start to finish.
+			void adviseSequential () const;
+			
+			/// Hint to the kernel that the file will be read in small pieces, so that reading one page doesn't read the pages around it.
+			void adviseRandom () const;
+			
+			/// Ask the kernel to start reading the given range of the file in the background, before it is needed.
+			void adviseWillNeed (std::size_t offset, std::size_t size) const;
+			
+			/// The number of bytes of the file which are in memory, rounded up to whole pages.
+			std::size_t residentSize () const;
+			
+			bool isOpen () const { return m_data != NULL; }
+			
+			const char * begin () const { return m_data; }
+			const char * end () const { return m_data + m_size; }
+			
+			std::size_t size () const { return m_size; }
+			
+		private:
+			MappedFile (const MappedFile &);
+			MappedFile & operator= (const MappedFile &);
+	};
+}
+
+#endif
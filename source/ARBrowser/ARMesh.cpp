@@ -0,0 +1,457 @@
+//
+//  ARMesh.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARMesh.h"
+
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace ARBrowser {
+	MaterialDescription::MaterialDescription () {
+		ambient.r = ambient.g = ambient.b = ambient.a = 1.0;
+	}
+	
+	MeshBuffer IndexedMesh::buffer () const {
+		MeshBuffer buffer;
+		
+		buffer.material = &material;
+		buffer.vertices = vertices.empty() ? NULL : &vertices[0];
+		buffer.quantizedVertices = NULL;
+		buffer.decode = NULL;
+		buffer.vertexCount = vertices.size();
+		buffer.shortIndices = usesShortIndices();
+		buffer.indexCount = indexCount();
+		
+		if (buffer.indexCount == 0) {
+			buffer.indices = NULL;
+		} else if (buffer.shortIndices) {
+			buffer.indices = &shortIndices[0];
+		} else {
+			buffer.indices = &longIndices[0];
+		}
+		
+		return buffer;
+	}
+	
+	/// The largest magnitude of a quantized position or texture coordinate component, which keeps the range symmetric about the offset.
+	static const float QUANTIZED_RANGE = 32767;
+	
+	Vec3 VertexDecode::position (const QuantizedVertex & vertex) const {
+		return Vec3(positionOffset[X] + positionScale * vertex.pos[X], positionOffset[Y] + positionScale * vertex.pos[Y], positionOffset[Z] + positionScale * vertex.pos[Z]);
+	}
+	
+	Vec2 VertexDecode::texcoord (const QuantizedVertex & vertex) const {
+		return Vec2(texcoordOffset[X] + texcoordScale[X] * vertex.texcoord[X], texcoordOffset[Y] + texcoordScale[Y] * vertex.texcoord[Y]);
+	}
+	
+	Vec3 VertexDecode::normal (const QuantizedVertex & vertex) const {
+		return Vec3((2 * vertex.normal[X] + 1) / 255.0f, (2 * vertex.normal[Y] + 1) / 255.0f, (2 * vertex.normal[Z] + 1) / 255.0f);
+	}
+	
+	void VertexDecode::positionMatrix (float * matrix) const {
+		std::fill(matrix, matrix + 16, 0.0f);
+		
+		matrix[0] = matrix[5] = matrix[10] = positionScale;
+		matrix[12] = positionOffset[X];
+		matrix[13] = positionOffset[Y];
+		matrix[14] = positionOffset[Z];
+		matrix[15] = 1;
+	}
+	
+	void VertexDecode::texcoordMatrix (float * matrix) const {
+		std::fill(matrix, matrix + 16, 0.0f);
+		
+		matrix[0] = texcoordScale[X];
+		matrix[5] = texcoordScale[Y];
+		matrix[10] = 1;
+		matrix[12] = texcoordOffset[X];
+		matrix[13] = texcoordOffset[Y];
+		matrix[15] = 1;
+	}
+	
+	MeshBuffer QuantizedMesh::buffer (const IndexedMesh & indexed) const {
+		MeshBuffer buffer = indexed.buffer();
+		
+		buffer.vertices = NULL;
+		buffer.quantizedVertices = vertices.empty() ? NULL : &vertices[0];
+		buffer.decode = &decode;
+		
+		return buffer;
+	}
+	
+	static std::int16_t quantizeComponent (float value, float offset, float scale) {
+		float component = std::floor((value - offset) / scale + 0.5f);
+		
+		return (std::int16_t)std::max(-QUANTIZED_RANGE, std::min(QUANTIZED_RANGE, component));
+	}
+	
+	/// The inverse of the conversion OpenGL applies to signed byte normals.
+	static std::int8_t quantizeNormal (float value) {
+		float component = std::floor((value * 255.0f - 1.0f) / 2.0f + 0.5f);
+		
+		return (std::int8_t)std::max(-128.0f, std::min(127.0f, component));
+	}
+	
+	/// The offset and scale which map the range of values onto the quantized range. If the range is empty, any scale is exact.
+	static void quantizationRange (float minimum, float maximum, float & offset, float & scale) {
+		offset = (minimum + maximum) / 2;
+		scale = maximum > minimum ? (maximum - minimum) / (2 * QUANTIZED_RANGE) : 1;
+	}
+	
+	bool quantizeMesh (const IndexedMesh & source, QuantizedMesh & result, const QuantizationError & tolerance, QuantizationError & error) {
+		const std::vector<ObjMeshVertex> & vertices = source.vertices;
+		VertexDecode & decode = result.decode;
+		
+		float positionMin[3] = {0, 0, 0}, positionMax[3] = {0, 0, 0};
+		float texcoordMin[2] = {0, 0}, texcoordMax[2] = {0, 0};
+		
+		for (std::size_t i = 0; i < vertices.size(); i += 1) {
+			for (std::size_t k = 0; k < 3; k += 1) {
+				if (i == 0 || vertices[i].pos[k] < positionMin[k]) positionMin[k] = vertices[i].pos[k];
+				if (i == 0 || vertices[i].pos[k] > positionMax[k]) positionMax[k] = vertices[i].pos[k];
+			}
+			
+			for (std::size_t k = 0; k < 2; k += 1) {
+				if (i == 0 || vertices[i].texcoord[k] < texcoordMin[k]) texcoordMin[k] = vertices[i].texcoord[k];
+				if (i == 0 || vertices[i].texcoord[k] > texcoordMax[k]) texcoordMax[k] = vertices[i].texcoord[k];
+			}
+		}
+		
+		// Positions use the largest extent of the bounding box on every axis:
+		float extent = 0;
+		
+		for (std::size_t k = 0; k < 3; k += 1) {
+			decode.positionOffset[k] = (positionMin[k] + positionMax[k]) / 2;
+			extent = std::max(extent, positionMax[k] - positionMin[k]);
+		}
+		
+		decode.positionScale = extent > 0 ? extent / (2 * QUANTIZED_RANGE) : 1;
+		
+		for (std::size_t k = 0; k < 2; k += 1)
+			quantizationRange(texcoordMin[k], texcoordMax[k], decode.texcoordOffset[k], decode.texcoordScale[k]);
+		
+		result.vertices.resize(vertices.size());
+		std::memset(&error, 0, sizeof(error));
+		
+		for (std::size_t i = 0; i < vertices.size(); i += 1) {
+			const ObjMeshVertex & vertex = vertices[i];
+			QuantizedVertex & quantized = result.vertices[i];
+			
+			std::memset(&quantized, 0, sizeof(quantized));
+			
+			for (std::size_t k = 0; k < 3; k += 1)
+				quantized.pos[k] = quantizeComponent(vertex.pos[k], decode.positionOffset[k], decode.positionScale);
+			
+			for (std::size_t k = 0; k < 2; k += 1)
+				quantized.texcoord[k] = quantizeComponent(vertex.texcoord[k], decode.texcoordOffset[k], decode.texcoordScale[k]);
+			
+			float length = vertex.normal.length();
+			
+			if (length > 0) {
+				for (std::size_t k = 0; k < 3; k += 1)
+					quantized.normal[k] = quantizeNormal(vertex.normal[k] / length);
+			}
+			
+			// Measure the error of the vertex as it will be drawn:
+			Vec3 position = decode.position(quantized), normal = decode.normal(quantized);
+			Vec2 texcoord = decode.texcoord(quantized);
+			
+			float distance = 0, cosine = 0;
+			
+			for (std::size_t k = 0; k < 3; k += 1) {
+				distance += (position[k] - vertex.pos[k]) * (position[k] - vertex.pos[k]);
+				cosine += normal[k] * vertex.normal[k];
+			}
+			
+			error.position = std::max(error.position, std::sqrt(distance));
+			
+			if (length > 0) {
+				cosine /= length * normal.length();
+				error.normal = std::max(error.normal, (float)(std::acos(std::max(-1.0f, std::min(1.0f, cosine))) * 180.0 / M_PI));
+			}
+			
+			for (std::size_t k = 0; k < 2; k += 1)
+				error.texcoord = std::max(error.texcoord, std::fabs(texcoord[k] - vertex.texcoord[k]));
+		}
+		
+		return error.position <= tolerance.position && error.normal <= tolerance.normal && error.texcoord <= tolerance.texcoord;
+	}
+	
+	void IndexedMesh::assignIndices (const std::vector<std::uint32_t> & indices) {
+		shortIndices.clear();
+		longIndices.clear();
+		
+		if (vertices.size() <= 0x10000) {
+			shortIndices.assign(indices.begin(), indices.end());
+		} else {
+			longIndices = indices;
+		}
+	}
+	
+	namespace {
+		/// Vertices are compared by value, so +0.0 and -0.0 are considered equal and must hash the same.
+		inline std::uint32_t hashableBits (float value) {
+			if (value == 0) return 0;
+			
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			
+			return bits;
+		}
+		
+		struct VertexHash {
+			std::size_t operator() (const ObjMeshVertex & vertex) const {
+				const float components[8] = {
+					vertex.pos[X], vertex.pos[Y], vertex.pos[Z],
+					vertex.texcoord[X], vertex.texcoord[Y],
+					vertex.normal[X], vertex.normal[Y], vertex.normal[Z]
+				};
+				
+				// FNV-1a over each component:
+				std::size_t hash = 2166136261u;
+				for (std::size_t i = 0; i < 8; i += 1) {
+					hash = (hash ^ hashableBits(components[i])) * 16777619u;
+				}
+				
+				return hash;
+			}
+		};
+		
+		struct VertexEqual {
+			bool operator() (const ObjMeshVertex & a, const ObjMeshVertex & b) const {
+				return a.pos[X] == b.pos[X] && a.pos[Y] == b.pos[Y] && a.pos[Z] == b.pos[Z]
+					&& a.texcoord[X] == b.texcoord[X] && a.texcoord[Y] == b.texcoord[Y]
+					&& a.normal[X] == b.normal[X] && a.normal[Y] == b.normal[Y] && a.normal[Z] == b.normal[Z];
+			}
+		};
+	}
+	
+	void weldMesh (const ObjMesh & source, IndexedMesh & result, bool optimize) {
+		typedef std::unordered_map<ObjMeshVertex, std::uint32_t, VertexHash, VertexEqual> VertexMapT;
+		
+		result.material = source.material;
+		result.vertices.clear();
+		
+		VertexMapT lookup;
+		lookup.reserve(source.faces.size() * 3);
+		
+		std::vector<std::uint32_t> indices;
+		indices.reserve(source.faces.size() * 3);
+		
+		for (std::size_t i = 0; i < source.faces.size(); i += 1) {
+			for (std::size_t j = 0; j < 3; j += 1) {
+				const ObjMeshVertex & vertex = source.faces[i].vertices[j];
+				
+				std::pair<VertexMapT::iterator, bool> insertion = lookup.insert(std::make_pair(vertex, (std::uint32_t)result.vertices.size()));
+				
+				if (insertion.second) {
+					result.vertices.push_back(vertex);
+				}
+				
+				indices.push_back(insertion.first->second);
+			}
+		}
+		
+		if (optimize) {
+			optimizeVertexCache(indices, result.vertices.size());
+			
+			// Reorder the vertices in the order they are first referenced, which improves locality of vertex fetches:
+			std::vector<std::uint32_t> remap(result.vertices.size(), (std::uint32_t)-1);
+			std::vector<ObjMeshVertex> vertices;
+			vertices.reserve(result.vertices.size());
+			
+			for (std::size_t i = 0; i < indices.size(); i += 1) {
+				std::uint32_t & index = remap[indices[i]];
+				
+				if (index == (std::uint32_t)-1) {
+					index = (std::uint32_t)vertices.size();
+					vertices.push_back(result.vertices[indices[i]]);
+				}
+				
+				indices[i] = index;
+			}
+			
+			result.vertices.swap(vertices);
+		}
+		
+		result.assignIndices(indices);
+	}
+	
+	namespace {
+		const std::size_t CACHE_SIZE = 32;
+		const float CACHE_DECAY_POWER = 1.5;
+		const float LAST_TRIANGLE_SCORE = 0.75;
+		const float VALENCE_BOOST_SCALE = 2.0;
+		const float VALENCE_BOOST_POWER = 0.5;
+		
+		float vertexScore (int cachePosition, std::uint32_t remainingTriangles) {
+			if (remainingTriangles == 0) {
+				// No triangles left which use this vertex.
+				return -1.0;
+			}
+			
+			float score = 0;
+			
+			if (cachePosition >= 0) {
+				if (cachePosition < 3) {
+					// This vertex was used in the last triangle, so it has a fixed score, irrespective of which of the three it was.
+					score = LAST_TRIANGLE_SCORE;
+				} else {
+					const float scaler = 1.0 / (CACHE_SIZE - 3);
+					score = std::pow(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+				}
+			}
+			
+			// Bonus points for having a low number of triangles left, so that lone vertices are cleared up quickly.
+			score += VALENCE_BOOST_SCALE * std::pow((float)remainingTriangles, -VALENCE_BOOST_POWER);
+			
+			return score;
+		}
+	}
+	
+	void optimizeVertexCache (std::vector<std::uint32_t> & indices, std::size_t vertexCount) {
+		const std::size_t triangleCount = indices.size() / 3;
+		
+		if (triangleCount == 0) return;
+		
+		// Build the vertex -> triangle adjacency:
+		std::vector<std::uint32_t> remaining(vertexCount, 0), offsets(vertexCount + 1, 0);
+		
+		for (std::size_t i = 0; i < triangleCount * 3; i += 1) {
+			remaining[indices[i]] += 1;
+		}
+		
+		for (std::size_t v = 0; v < vertexCount; v += 1) {
+			offsets[v + 1] = offsets[v] + remaining[v];
+		}
+		
+		std::vector<std::uint32_t> adjacency(triangleCount * 3), fill(offsets.begin(), offsets.end() - 1);
+		
+		for (std::size_t t = 0; t < triangleCount; t += 1) {
+			for (std::size_t j = 0; j < 3; j += 1) {
+				std::uint32_t v = indices[t * 3 + j];
+				adjacency[fill[v]++] = (std::uint32_t)t;
+			}
+		}
+		
+		std::vector<int> cachePosition(vertexCount, -1);
+		std::vector<float> score(vertexCount);
+		
+		for (std::size_t v = 0; v < vertexCount; v += 1) {
+			score[v] = vertexScore(-1, remaining[v]);
+		}
+		
+		std::vector<float> triangleScore(triangleCount);
+		std::vector<bool> emitted(triangleCount, false);
+		
+		for (std::size_t t = 0; t < triangleCount; t += 1) {
+			triangleScore[t] = score[indices[t*3]] + score[indices[t*3+1]] + score[indices[t*3+2]];
+		}
+		
+		std::vector<std::uint32_t> output;
+		output.reserve(triangleCount * 3);
+		
+		// The simulated cache has room for the new triangle's vertices at the front.
+		std::uint32_t cache[CACHE_SIZE + 3];
+		std::size_t cacheCount = 0;
+		
+		std::size_t nextCandidate = 0;
+		long best = -1;
+		
+		for (std::size_t emittedCount = 0; emittedCount < triangleCount; emittedCount += 1) {
+			if (best < 0) {
+				// Nothing useful in the cache, find the best remaining triangle. Scanning from the last position keeps this linear overall.
+				float bestScore = -1;
+				
+				for (std::size_t t = nextCandidate; t < triangleCount; t += 1) {
+					if (!emitted[t]) {
+						if (best < 0) nextCandidate = t;
+						
+						if (triangleScore[t] > bestScore) {
+							bestScore = triangleScore[t];
+							best = (long)t;
+						}
+						
+						// The first few triangles are good enough, there is no need to scan the whole mesh.
+						if (t > nextCandidate + 64) break;
+					}
+				}
+			}
+			
+			std::size_t triangle = best;
+			emitted[triangle] = true;
+			
+			// Emit the triangle and move its vertices to the front of the cache:
+			std::uint32_t newCache[CACHE_SIZE + 3];
+			std::size_t newCount = 0;
+			
+			for (std::size_t j = 0; j < 3; j += 1) {
+				std::uint32_t v = indices[triangle * 3 + j];
+				output.push_back(v);
+				newCache[newCount++] = v;
+				
+				// Remove the triangle from the vertex's list of remaining triangles:
+				std::uint32_t * begin = &adjacency[offsets[v]], * end = begin + remaining[v];
+				std::uint32_t * position = std::find(begin, end, (std::uint32_t)triangle);
+				std::swap(*position, *(end - 1));
+				remaining[v] -= 1;
+			}
+			
+			for (std::size_t i = 0; i < cacheCount; i += 1) {
+				std::uint32_t v = cache[i];
+				
+				if (v != newCache[0] && v != newCache[1] && v != newCache[2]) {
+					newCache[newCount++] = v;
+				}
+			}
+			
+			// Vertices which fall out of the cache lose their cache score:
+			for (std::size_t i = CACHE_SIZE; i < newCount; i += 1) {
+				cachePosition[newCache[i]] = -1;
+			}
+			
+			cacheCount = std::min(newCount, CACHE_SIZE);
+			std::copy(newCache, newCache + cacheCount, cache);
+			
+			// Update the scores of all vertices that were affected, and find the best triangle that uses them:
+			for (std::size_t i = 0; i < newCount; i += 1) {
+				std::uint32_t v = newCache[i];
+				
+				if (i < CACHE_SIZE) cachePosition[v] = (int)i;
+				
+				float newScore = vertexScore(cachePosition[v], remaining[v]);
+				float delta = newScore - score[v];
+				score[v] = newScore;
+				
+				for (std::size_t k = 0; k < remaining[v]; k += 1) {
+					triangleScore[adjacency[offsets[v] + k]] += delta;
+				}
+			}
+			
+			best = -1;
+			float bestScore = -1;
+			
+			for (std::size_t i = 0; i < cacheCount; i += 1) {
+				std::uint32_t v = cache[i];
+				
+				for (std::size_t k = 0; k < remaining[v]; k += 1) {
+					std::uint32_t t = adjacency[offsets[v] + k];
+					
+					if (triangleScore[t] > bestScore) {
+						bestScore = triangleScore[t];
+						best = (long)t;
+					}
+				}
+			}
+		}
+		
+		indices.swap(output);
+	}
+}
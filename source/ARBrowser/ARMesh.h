@@ -0,0 +1,168 @@
+//
+//  ARMesh.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_MESH_H
+#define _ARBROWSER_MESH_H
+
+#include <Euclid/Numerics/Vector.h>
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace ARBrowser {
+	using namespace Euclid::Numerics;
+	
+	/// Simple representation of 4-component colour.
+	struct Color4f {
+		float r, g, b, a;
+	};
+	
+	/// The position, texture coordinate and normal of a vertex.
+	struct ObjMeshVertex {
+		Vec3 pos;
+		Vec2 texcoord;
+		Vec3 normal;
+	};
+
+	/// A vertex which is half the size of ObjMeshVertex, so that drawing a mesh reads half as much memory.
+	/// Positions and texture coordinates are decoded by the VertexDecode of the mesh, which OpenGL applies using the model-view and texture matrices. Normals are converted by OpenGL, which maps each signed byte c to (2c + 1) / 255.
+	struct QuantizedVertex {
+		/// The fourth component is padding, so that each attribute is 4-byte aligned.
+		std::int16_t pos[4];
+		std::int16_t texcoord[2];
+		std::int8_t normal[4];
+	};
+	
+	/// Converts the components of a QuantizedVertex back into model coordinates.
+	struct VertexDecode {
+		/// position = positionOffset + positionScale * pos. The scale is the same on every axis, so that the model-view matrix doesn't change the direction of normals.
+		float positionOffset[3];
+		float positionScale;
+		
+		/// texcoord = texcoordOffset + texcoordScale * texcoord.
+		float texcoordOffset[2];
+		float texcoordScale[2];
+		
+		Vec3 position (const QuantizedVertex & vertex) const;
+		Vec2 texcoord (const QuantizedVertex & vertex) const;
+		
+		/// The normal as OpenGL converts it, which is not quite unit length.
+		Vec3 normal (const QuantizedVertex & vertex) const;
+		
+		/// The column major matrices which apply the position and texture coordinate decoding.
+		void positionMatrix (float * matrix) const;
+		void texcoordMatrix (float * matrix) const;
+	};
+	
+	/// A triangle that can be rendered as part of an object model.
+	struct ObjMeshFace{
+		ObjMeshVertex vertices[3];
+	};
+
+	/// A mesh consists of a list of triangle faces and an associated material
+	struct ObjMesh{
+		std::string material;
+		std::vector<ObjMeshFace> faces;
+	};
+	
+	/// The properties of a material as described by a .mtl file.
+	struct MaterialDescription {
+		MaterialDescription ();
+		
+		std::string name;
+		
+		Color4f ambient;
+		
+		/// Path to the diffuse map texture, relative to the model directory.
+		std::string diffuseMapPath;
+	};
+	
+	/// A view of vertex and index data which is ready to be drawn.
+	/// The data is not owned by the view, it may refer to an IndexedMesh or a memory mapped file.
+	struct MeshBuffer {
+		const std::string * material;
+		
+		const ObjMeshVertex * vertices;
+		
+		/// If not NULL, the vertices are quantized and are used instead of vertices, which is NULL.
+		const QuantizedVertex * quantizedVertices;
+		const VertexDecode * decode;
+		
+		std::size_t vertexCount;
+		
+		/// Either 16-bit or 32-bit indices, depending on shortIndices.
+		const void * indices;
+		std::size_t indexCount;
+		bool shortIndices;
+		
+		/// The vertex array, in whichever format it is stored.
+		const void * vertexData () const { return quantizedVertices ? (const void *)quantizedVertices : (const void *)vertices; }
+		
+		/// The position of the given vertex, decoded if necessary.
+		Vec3 position (std::size_t index) const { return quantizedVertices ? decode->position(quantizedVertices[index]) : vertices[index].pos; }
+	};
+	
+	/// A mesh where identical vertices are shared between triangles.
+	/// Meshes with at most 65536 vertices use 16-bit indices, larger meshes use 32-bit indices.
+	struct IndexedMesh {
+		std::string material;
+		std::vector<ObjMeshVertex> vertices;
+		
+		std::vector<std::uint16_t> shortIndices;
+		std::vector<std::uint32_t> longIndices;
+		
+		bool usesShortIndices () const { return longIndices.empty(); }
+		
+		std::size_t indexCount () const { return shortIndices.size() + longIndices.size(); }
+		std::size_t triangleCount () const { return indexCount() / 3; }
+		
+		std::uint32_t index (std::size_t i) const { return usesShortIndices() ? shortIndices[i] : longIndices[i]; }
+		
+		/// Store the given indices using the smallest index type which can address all vertices.
+		void assignIndices (const std::vector<std::uint32_t> & indices);
+		
+		/// A view of this mesh, which is valid until the mesh is modified.
+		MeshBuffer buffer () const;
+	};
+	
+	/// The largest differences between the vertices of a mesh and their quantized versions, which are also used as the largest acceptable differences.
+	struct QuantizationError {
+		/// In model units.
+		float position;
+		
+		/// The angle between normals, in degrees.
+		float normal;
+		
+		/// In texture coordinates, i.e. as a fraction of the size of the texture.
+		float texcoord;
+	};
+	
+	/// The quantized vertices of an IndexedMesh, which are drawn using the indices of the original mesh.
+	struct QuantizedMesh {
+		std::vector<QuantizedVertex> vertices;
+		VertexDecode decode;
+		
+		/// A view of the vertices of this mesh with the material and indices of the given mesh, which is valid until either mesh is modified.
+		MeshBuffer buffer (const IndexedMesh & indexed) const;
+	};
+	
+	/// Quantize the vertices of the given mesh, using 16 bits for each position and texture coordinate component, relative to their bounds, and 8 bits for each normal component.
+	/// @returns false if the error of the decoded vertices is larger than the tolerance in any respect, in which case the mesh should be drawn using the original vertices.
+	bool quantizeMesh (const IndexedMesh & source, QuantizedMesh & result, const QuantizationError & tolerance, QuantizationError & error);
+	
+	/// Merge vertices which have identical position, texture coordinate and normal, producing a vertex and index buffer.
+	/// If optimize is true, triangles are reordered to improve post-transform vertex cache hits, and vertices are reordered to match.
+	void weldMesh (const ObjMesh & source, IndexedMesh & result, bool optimize = true);
+	
+	/// Reorder triangles using Tom Forsyth's linear-speed vertex cache optimisation.
+	/// See https://tomforsyth1000.github.io/papers/fast_vert_cache_opt.html
+	void optimizeVertexCache (std::vector<std::uint32_t> & indices, std::size_t vertexCount);
+}
+
+#endif
@@ -18,7 +18,18 @@
 + (id<ARRenderable>) objectModelWithName:(NSString*)name inDirectory:(NSString*)directory;
 
 /// Create a billboad mesh with the given view.
-/// Currently, for best results, the view must be a 2^n size.
+/// The view must be no larger than the atlas pages, which are 1024x1024 pixels.
 + (id<ARRenderable>) viewModelWithView: (UIView*)view;
 
+/// Object models are loaded in the background. Once loaded, their textures must be uploaded on the rendering thread, which is done by this method until the given time budget has been used.
+/// @returns the number of models which became ready.
++ (NSUInteger) processPendingLoadsWithinTime: (NSTimeInterval)budget;
+
+/// Billboards are uploaded to a shared atlas on the rendering thread when their views change, which is done by this method until the given number of bytes has been uploaded.
+/// @returns the number of bytes uploaded.
++ (NSUInteger) processPendingBillboardUpdatesWithinBytes: (NSUInteger)budget;
+
+/// Object models and their textures are shared between points which use the same files. The least recently drawn models are evicted once the memory used exceeds this budget, which defaults to 32MB.
++ (void) setCacheBudget: (NSUInteger)bytes;
+
 @end
@@ -27,4 +27,19 @@
 	return model;
 }
 
++ (NSUInteger) processPendingLoadsWithinTime: (NSTimeInterval)budget
+{
+	return [ARObjectModel processPendingLoadsWithinTime:budget];
+}
+
++ (NSUInteger) processPendingBillboardUpdatesWithinBytes: (NSUInteger)budget
+{
+	return [ARViewModel processPendingUpdatesWithinBytes:budget];
+}
+
++ (void) setCacheBudget: (NSUInteger)bytes
+{
+	[ARObjectModel setCacheBudget:bytes];
+}
+
 @end
@@ -15,6 +15,19 @@
 #import "ARVideoFrameController.h"
 #import "ARWorldLocation.h"
 
+#include "ARFusionThread.h"
+#include "ARRecyclingPool.h"
+
+namespace ARBrowser {
+	template <>
+	struct RecyclingTraits<Dream::Ref<Dream::Imaging::Image>> {
+		static bool unique (const Dream::Ref<Dream::Imaging::Image> & image) { return image->reference_count() == 1; }
+	};
+}
+
+/// Recycles the images passed to the motion model.
+typedef ARBrowser::RecyclingPool<Dream::Ref<Dream::Imaging::Image>> ARImagePool;
+
 @interface ARMotionModelController : NSObject <ARVideoFrameControllerDelegate, CLLocationManagerDelegate>
 
 @property(nonatomic,assign) Dream::Ref<TransformFlow::MotionModel> motionModel;
@@ -28,6 +41,15 @@
 
 @property(nonatomic,assign) double cameraFieldOfView;
 
+/// The level of the luminance pyramid passed to the motion model, where 0 is full size and each level is half the size of the previous one. If negative, the color image is passed unchanged, which is the default.
+@property(nonatomic,assign) NSInteger imageLevel;
+
+/// The part of the camera frame passed to the motion model when imageLevel isn't negative, in pixels. If empty, the whole frame is used. The region should be centered in the frame, since the motion model assumes the optical axis passes through the middle of the image.
+@property(nonatomic,assign) CGRect imageRegion;
+
+/// If set when tracking starts, every update passed to the motion model is appended to this .arsensors file until tracking stops, so that it can be replayed with the sensor-replay tool. Camera images are recorded as they are passed to the motion model, i.e. as luminance if imageLevel isn't negative, which makes the log much smaller.
+@property(nonatomic,copy) NSString * recordingPath;
+
 - (ARWorldLocation *) worldLocation;
 - (Vec3) currentGravity;
 
@@ -36,4 +58,10 @@
 
 - (BOOL) localizationValid;
 
+/// How often camera images were reused rather than allocated. The pool is used on the camera queue, so this is approximate when read from another thread.
+- (ARImagePool::Statistics) imagePoolStatistics;
+
+/// How many sensor updates were passed to the motion model, and how many camera images were skipped because the fusion thread fell behind.
+- (ARBrowser::FusionStatistics) fusionStatistics;
+
 @end
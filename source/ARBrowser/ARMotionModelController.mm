@@ -8,6 +8,93 @@
 
 #import "ARMotionModelController.h"
 
+#include "ARLumaPyramid.h"
+#include "ARSensorLog.h"
+#include "ARSeqlock.h"
+
+#include <memory>
+
+namespace {
+	/// One update for the motion model, of the given kind. Only the matching update is used.
+	struct ARSensorEvent {
+		enum Kind {MOTION, LOCATION, HEADING, IMAGE} kind;
+
+		double time;
+
+		/// Camera images are skipped if a newer one is waiting, since the motion model only needs the latest frame.
+		bool coalescable;
+
+		TransformFlow::MotionUpdate motion_update;
+		TransformFlow::LocationUpdate location_update;
+		TransformFlow::HeadingUpdate heading_update;
+		TransformFlow::ImageUpdate image_update;
+
+		/// The image is described again for recording, since the update only holds the field of view as an angle.
+		ARBrowser::SensorImage image;
+	};
+
+	void recordEvent (ARBrowser::SensorLogWriter & log, const ARSensorEvent & event) {
+		switch (event.kind) {
+			case ARSensorEvent::MOTION: {
+				const TransformFlow::MotionUpdate & update = event.motion_update;
+				ARBrowser::SensorMotion motion;
+
+				for (std::size_t i = 0; i < 3; i += 1) {
+					motion.gravity[i] = update.gravity[i];
+					motion.rotationRate[i] = update.rotation_rate[i];
+					motion.acceleration[i] = update.acceleration[i];
+				}
+
+				log.writeMotion(event.time, motion);
+				break;
+			}
+			case ARSensorEvent::LOCATION: {
+				const TransformFlow::LocationUpdate & update = event.location_update;
+				ARBrowser::SensorLocation location = {update.latitude, update.longitude, update.horizontal_accuracy, update.vertical_accuracy};
+
+				log.writeLocation(event.time, location);
+				break;
+			}
+			case ARSensorEvent::HEADING: {
+				ARBrowser::SensorHeading heading = {event.heading_update.true_bearing, event.heading_update.magnetic_bearing};
+
+				log.writeHeading(event.time, heading);
+				break;
+			}
+			case ARSensorEvent::IMAGE:
+				log.writeImage(event.time, event.image, (const std::uint8_t *)event.image_update.image_buffer->buffer().begin());
+				break;
+		}
+	}
+
+	/// The state of the motion model after the most recent update, which is read from other threads.
+	struct ARMotionSnapshot {
+		double position[3];
+		double gravity[3];
+		double bearing;
+		bool valid;
+	};
+}
+
+@interface ARMotionModelController () {
+	/// Sensor updates arrive on several threads and slightly out of order, and are passed to the motion model in time order on this thread.
+	std::unique_ptr<ARBrowser::FusionThread<ARSensorEvent>> _fusionThread;
+	ARBrowser::Seqlock<ARMotionSnapshot> _snapshot;
+
+	/// Only used on the fusion thread while tracking.
+	ARBrowser::SensorLogWriter _sensorLog;
+
+	/// Images passed to the motion model, which are reused once it has released them. The motion model may keep recent frames for tracking, so a few are needed.
+	ARImagePool _imagePool;
+	CGSize _imageSize;
+	Dream::Imaging::PixelFormat _imageFormat;
+	
+	/// Used to convert camera frames to luminance and reduce their size, when imageLevel isn't negative.
+	ARBrowser::LumaPyramid _pyramid;
+}
+
+@end
+
 @implementation ARMotionModelController
 
 - (id)init
@@ -16,31 +103,80 @@
 
 	if (self) {
         self.cameraFieldOfView = 55.0;
+		self.imageLevel = -1;
+		self.imageRegion = CGRectZero;
+
+		[self createFusionThread];
     }
 
     return self;
 }
 
-- (void)videoFrameController:(ARVideoFrameController *)controller didCaptureFrame:(CGImageRef)buffer atTime:(CMTime)time {
+- (void)videoFrameController:(ARVideoFrameController *)controller didCaptureFrame:(ARVideoFrame *)frame atTime:(CMTime)time {
 	TransformFlow::ImageUpdate image_update;
 
-	ARVideoFrame * frame = [controller videoFrame];
+	const unsigned char * pixels = frame->data;
+	std::size_t size = frame->bytesPerRow * frame->size.height;
+	CGSize imageSize = frame->size;
+	Dream::Imaging::PixelFormat pixelFormat = Dream::Imaging::PixelFormat::BGRA;
+	double fieldOfView = _cameraFieldOfView;
+
+	if (_imageLevel >= 0) {
+		ARBrowser::LumaPyramid::Region region = {(std::size_t)_imageRegion.origin.x, (std::size_t)_imageRegion.origin.y, (std::size_t)_imageRegion.size.width, (std::size_t)_imageRegion.size.height};
+
+		if (!_pyramid.update(frame->data, frame->bytesPerRow, frame->size.width, frame->size.height, _imageLevel + 1, CGRectIsEmpty(_imageRegion) ? NULL : &region))
+			return;
+
+		// If the region is too small for the requested level, the smallest one is used:
+		const ARBrowser::LumaPyramid::Level & level = _pyramid.level(_pyramid.levelCount() - 1);
+
+		pixels = level.data;
+		size = level.width * level.height;
+		imageSize = CGSizeMake(level.width, level.height);
+		pixelFormat = Dream::Imaging::PixelFormat::L;
+
+		// Cropping the frame narrows the field of view:
+		double scale = (double)_pyramid.level(0).width / frame->size.width;
+		fieldOfView = atan(tan(fieldOfView * M_PI / 360.0) * scale) * 360.0 / M_PI;
+	}
+
+	// The pooled images all have the same size and format:
+	if (!CGSizeEqualToSize(imageSize, _imageSize) || pixelFormat != _imageFormat) {
+		_imagePool.clear();
+		_imageSize = imageSize;
+		_imageFormat = pixelFormat;
+	}
 
-	image_update.image_buffer = new Dream::Imaging::Image({frame->size.width, frame->size.height}, Dream::Imaging::PixelFormat::BGRA, Dream::Imaging::DataType::BYTE);
+	image_update.image_buffer = _imagePool.acquire([&]() {
+		return Dream::Ref<Dream::Imaging::Image>(new Dream::Imaging::Image({imageSize.width, imageSize.height}, pixelFormat, Dream::Imaging::DataType::BYTE));
+	});
 
-	Dream::Core::StaticBuffer pixel_buffer(frame->data, (frame->bytesPerRow * frame->size.height));
+	// A reused image already has storage of the right size, so this is a copy without an allocation:
+	Dream::Core::StaticBuffer pixel_buffer(pixels, size);
 	image_update.image_buffer->buffer().assign(pixel_buffer);
 
 	image_update.time_offset = frame->timestamp;
 
 	// This is +/- 2 degrees for most iOS devices.
-	image_update.field_of_view = TransformFlow::degrees(_cameraFieldOfView);
+	image_update.field_of_view = TransformFlow::degrees(fieldOfView);
 
-	_motionModel->update(image_update);
+	ARSensorEvent event;
+	event.kind = ARSensorEvent::IMAGE;
+	event.time = image_update.time_offset;
+	event.coalescable = true;
+	event.image_update = image_update;
 
-	//for (auto & note : image_update.notes) {
-	//	NSLog(@"Note: %s", note.c_str());
-	//}
+	ARBrowser::SensorImage image = {(std::uint32_t)imageSize.width, (std::uint32_t)imageSize.height, pixelFormat == Dream::Imaging::PixelFormat::L ? 1u : 4u, 0, fieldOfView};
+	event.image = image;
+
+	[self pushEvent:event];
+}
+
+- (void) pushEvent:(ARSensorEvent &)event
+{
+	// Updates which arrive while tracking is stopped are ignored:
+	if (_fusionThread->running())
+		_fusionThread->push(std::move(event));
 }
 
 - (void) calculateTimestampOffset
@@ -50,11 +186,57 @@
 	self.timestampOffset = nowTimeIntervalSince1970 - uptime;
 }
 
+- (void)createFusionThread
+{
+	// The motion model is only used on the fusion thread while tracking, so it must not be replaced between startTracking and stopTracking:
+	Dream::Ref<TransformFlow::MotionModel> * model = &_motionModel;
+	ARBrowser::Seqlock<ARMotionSnapshot> * snapshot = &_snapshot;
+	ARBrowser::SensorLogWriter * sensorLog = &_sensorLog;
+
+	// The fusion thread must not retain self, since it is stopped when self is deallocated:
+	_fusionThread.reset(new ARBrowser::FusionThread<ARSensorEvent>([model, snapshot, sensorLog](ARSensorEvent & event) {
+		Dream::Ref<TransformFlow::MotionModel> motionModel = *model;
+
+		if (!motionModel)
+			return;
+
+		if (sensorLog->isOpen())
+			recordEvent(*sensorLog, event);
+
+		switch (event.kind) {
+			case ARSensorEvent::MOTION:
+				motionModel->update(event.motion_update);
+				break;
+			case ARSensorEvent::LOCATION:
+				motionModel->update(event.location_update);
+				break;
+			case ARSensorEvent::HEADING:
+				motionModel->update(event.heading_update);
+				break;
+			case ARSensorEvent::IMAGE:
+				motionModel->update(event.image_update);
+				break;
+		}
+
+		auto position = motionModel->position();
+		auto gravity = motionModel->gravity();
+
+		ARMotionSnapshot state = {{position[0], position[1], position[2]}, {gravity[0], gravity[1], gravity[2]}, motionModel->bearing(), motionModel->localization_valid()};
+		snapshot->store(state);
+	}));
+}
+
 - (void)startTracking
 {
+	if (self.recordingPath && !_fusionThread->running()) {
+		_sensorLog.open(self.recordingPath.fileSystemRepresentation);
+	}
+
+	_fusionThread->start();
+
+	// The handler only queues the update, so it doesn't need to run on the main thread:
 	if (self.motionQueue == nil) {
-		_motionQueue = [NSOperationQueue mainQueue];
-		//_motionQueue = [[NSOperationQueue alloc] init];
+		_motionQueue = [[NSOperationQueue alloc] init];
 	}
 	
 	if (self.motionManager == nil) {
@@ -87,7 +269,13 @@
 
 		motion_update.time_offset = motion.timestamp;
 
-		_motionModel->update(motion_update);
+		ARSensorEvent event;
+		event.kind = ARSensorEvent::MOTION;
+		event.time = motion_update.time_offset;
+		event.coalescable = false;
+		event.motion_update = motion_update;
+
+		[self pushEvent:event];
 	}];
 
 	if (self.locationManager == nil) {
@@ -128,7 +316,13 @@
 	location_update.horizontal_accuracy = newLocation.horizontalAccuracy;
 	location_update.vertical_accuracy = newLocation.verticalAccuracy;
 
-	_motionModel->update(location_update);
+	ARSensorEvent event;
+	event.kind = ARSensorEvent::LOCATION;
+	event.time = location_update.time_offset;
+	event.coalescable = false;
+	event.location_update = location_update;
+
+	[self pushEvent:event];
 }
 
 - (void)locationManager:(CLLocationManager *)manager didUpdateHeading:(CLHeading *)newHeading {
@@ -141,29 +335,37 @@
 	heading_update.true_bearing = newHeading.trueHeading;
 	heading_update.magnetic_bearing = newHeading.magneticHeading;
 
-	_motionModel->update(heading_update);
+	ARSensorEvent event;
+	event.kind = ARSensorEvent::HEADING;
+	event.time = heading_update.time_offset;
+	event.coalescable = false;
+	event.heading_update = heading_update;
+
+	[self pushEvent:event];
 }
 
 - (ARWorldLocation *) worldLocation
 {
 	ARWorldLocation * worldLocation = [ARWorldLocation new];
 
-	auto position = _motionModel->position();
+	ARMotionSnapshot state = _snapshot.load();
 
 	CLLocationCoordinate2D coordinate;
-	coordinate.latitude = position[0];
-	coordinate.longitude = position[1];
-	ARLocationAltitude altitude = position[2];
+	coordinate.latitude = state.position[0];
+	coordinate.longitude = state.position[1];
+	ARLocationAltitude altitude = state.position[2];
 
 	[worldLocation setCoordinate:coordinate altitude:altitude];
-	[worldLocation setBearing:_motionModel->bearing() * TransformFlow::R2D];
+	[worldLocation setBearing:state.bearing * TransformFlow::R2D];
 
 	return worldLocation;
 }
 
 - (Vec3) currentGravity
 {
-	return _motionModel->gravity();
+	ARMotionSnapshot state = _snapshot.load();
+
+	return Vec3(state.gravity[0], state.gravity[1], state.gravity[2]);
 }
 
 - (void)stopTracking
@@ -171,11 +373,34 @@
 	[self.locationManager stopUpdatingHeading];
 	[self.locationManager stopUpdatingLocation];
 	[self.motionManager stopDeviceMotionUpdates];
+
+	// Process the remaining updates, so the motion model isn't used after this returns:
+	_fusionThread->stop();
+
+	if (_sensorLog.isOpen()) {
+		NSLog(@"Recorded %llu sensor updates to %@", (unsigned long long)_sensorLog.recordCount(), self.recordingPath);
+		_sensorLog.close();
+	}
+}
+
+- (void)dealloc
+{
+	_fusionThread->stop();
 }
 
 - (BOOL) localizationValid
 {
-	return _motionModel && _motionModel->localization_valid();
+	return _motionModel && _snapshot.load().valid;
+}
+
+- (ARImagePool::Statistics) imagePoolStatistics
+{
+	return _imagePool.statistics();
+}
+
+- (ARBrowser::FusionStatistics) fusionStatistics
+{
+	return _fusionThread->statistics();
 }
 
 @end
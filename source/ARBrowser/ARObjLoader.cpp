@@ -0,0 +1,397 @@
+//
+//  ARObjLoader.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARObjLoader.h"
+#include "ARMappedFile.h"
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+
+namespace ARBrowser {
+	/**
+	 * Lines beginning with:
+	 * '#'      are comments can be ignored
+	 * 'v'      are vertices positions (3 floats that can be positive or negative)
+	 * 'vt'     are vertices texcoords (2 floats that can be positive or negative)
+	 * 'vn'     are vertices normals   (3 floats that can be positive or negative)
+	 * 'f'      are faces, 3 or more vertices which are separated by <space>, each of which is a set of indices separated by /
+	 * 'usemtl' selects the material for subsequent faces
+	 * Everything else is ignored.
+	 */
+	
+	namespace {
+		inline bool isSpace (char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+		
+		inline bool isDigit (char c) {
+			return c >= '0' && c <= '9';
+		}
+		
+		inline void skipSpace (const char *& p, const char * end) {
+			while (p != end && isSpace(*p)) ++p;
+		}
+		
+		inline void skipLine (const char *& p, const char * end) {
+			while (p != end && *p != '\n') ++p;
+			if (p != end) ++p;
+		}
+		
+		inline bool atEndOfLine (const char * p, const char * end) {
+			return p == end || *p == '\n' || *p == '#';
+		}
+		
+		// Exact powers of ten, which is sufficient to convert any mantissa with at most 19 digits.
+		const double POWERS_OF_TEN[] = {
+			1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+			1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+		
+		/// Parse a decimal floating point number, e.g. <tt>-1.25e-3</tt>. The number is parsed in place and is not locale dependent.
+		bool parseFloat (const char *& p, const char * end, float & value) {
+			skipSpace(p, end);
+			
+			const char * start = p;
+			bool negative = false;
+			
+			if (p != end && (*p == '-' || *p == '+')) {
+				negative = (*p == '-');
+				++p;
+			}
+			
+			std::uint64_t mantissa = 0;
+			int digits = 0, exponent = 0;
+			bool any = false;
+			
+			for (; p != end && isDigit(*p); ++p, any = true) {
+				if (digits < 19) {
+					mantissa = mantissa * 10 + (*p - '0');
+					if (mantissa) digits += 1;
+				} else {
+					exponent += 1;
+				}
+			}
+			
+			if (p != end && *p == '.') {
+				for (++p; p != end && isDigit(*p); ++p, any = true) {
+					if (digits < 19) {
+						mantissa = mantissa * 10 + (*p - '0');
+						if (mantissa) digits += 1;
+						exponent -= 1;
+					}
+				}
+			}
+			
+			if (!any) {
+				p = start;
+				return false;
+			}
+			
+			if (p != end && (*p == 'e' || *p == 'E')) {
+				const char * mark = p++;
+				bool negativeExponent = false;
+				
+				if (p != end && (*p == '-' || *p == '+')) {
+					negativeExponent = (*p == '-');
+					++p;
+				}
+				
+				if (p != end && isDigit(*p)) {
+					int e = 0;
+					
+					for (; p != end && isDigit(*p); ++p) {
+						if (e < 1000) e = e * 10 + (*p - '0');
+					}
+					
+					exponent += negativeExponent ? -e : e;
+				} else {
+					// Not an exponent, e.g. "1.0e" - leave it for the caller.
+					p = mark;
+				}
+			}
+			
+			double result = (double)mantissa;
+			
+			if (exponent < 0) {
+				result = (exponent >= -22) ? result / POWERS_OF_TEN[-exponent] : result * std::pow(10.0, exponent);
+			} else if (exponent > 0) {
+				result = (exponent <= 22) ? result * POWERS_OF_TEN[exponent] : result * std::pow(10.0, exponent);
+			}
+			
+			value = (float)(negative ? -result : result);
+			
+			return true;
+		}
+		
+		bool parseInteger (const char *& p, const char * end, long & value) {
+			const char * start = p;
+			bool negative = false;
+			
+			if (p != end && (*p == '-' || *p == '+')) {
+				negative = (*p == '-');
+				++p;
+			}
+			
+			if (p == end || !isDigit(*p)) {
+				p = start;
+				return false;
+			}
+			
+			long result = 0;
+			for (; p != end && isDigit(*p); ++p) {
+				result = result * 10 + (*p - '0');
+			}
+			
+			value = negative ? -result : result;
+			
+			return true;
+		}
+		
+		/// Convert a 1-based (or negative, relative) .obj index into a 0-based index.
+		/// @returns false if the index does not refer to an existing element.
+		inline bool resolveIndex (long index, std::size_t count, std::size_t & result) {
+			if (index > 0 && (std::size_t)index <= count) {
+				result = index - 1;
+				return true;
+			} else if (index < 0 && (std::size_t)(-index) <= count) {
+				result = count + index;
+				return true;
+			}
+			
+			return false;
+		}
+		
+		/// Compare the keyword [begin, end) with a null terminated token.
+		inline bool keywordIs (const char * begin, const char * end, const char * token) {
+			for (; begin != end; ++begin, ++token) {
+				if (*token == '\0' || *begin != *token) return false;
+			}
+			
+			return *token == '\0';
+		}
+		
+		/// Parse the next whitespace delimited token on the current line.
+		inline bool parseToken (const char *& p, const char * end, std::string & token) {
+			skipSpace(p, end);
+			
+			const char * start = p;
+			while (p != end && !isSpace(*p) && *p != '\n') ++p;
+			
+			token.assign(start, p);
+			
+			return start != p;
+		}
+		
+		struct ObjParser {
+			std::vector<Vec3> positions;
+			std::vector<Vec2> texcoords;
+			std::vector<Vec3> normals;
+			
+			std::vector<ObjMesh> & mesh;
+			
+			std::string currentMaterial;
+			bool materialChanged;
+			
+			/// The triangles of the face being parsed, which are only added to the mesh once the whole face is valid.
+			std::vector<ObjMeshFace> triangles;
+			
+			std::size_t errorCount;
+			
+			ObjParser (std::vector<ObjMesh> & _mesh) : mesh(_mesh), materialChanged(true), errorCount(0) {
+			}
+			
+			/// Parse a single face vertex reference, e.g. <tt>1/2/3</tt>, <tt>1//3</tt> or <tt>1</tt>.
+			bool parseVertex (const char *& p, const char * end, ObjMeshVertex & vertex) {
+				long index;
+				std::size_t resolved;
+				
+				if (!parseInteger(p, end, index) || !resolveIndex(index, positions.size(), resolved))
+					return false;
+				
+				vertex.pos = positions[resolved];
+				vertex.texcoord = Vec2(0, 0);
+				vertex.normal = Vec3(0, 0, 0);
+				
+				if (p != end && *p == '/') {
+					++p;
+					
+					if (p != end && *p != '/') {
+						if (!parseInteger(p, end, index) || !resolveIndex(index, texcoords.size(), resolved))
+							return false;
+						
+						vertex.texcoord = texcoords[resolved];
+					}
+					
+					if (p != end && *p == '/') {
+						++p;
+						
+						if (!parseInteger(p, end, index) || !resolveIndex(index, normals.size(), resolved))
+							return false;
+						
+						vertex.normal = normals[resolved];
+					}
+				}
+				
+				return true;
+			}
+			
+			ObjMesh & currentMesh () {
+				if (materialChanged) {
+					if (mesh.empty() || mesh.back().material != currentMaterial) {
+						mesh.resize(mesh.size() + 1);
+						mesh.back().material = currentMaterial;
+					}
+					
+					materialChanged = false;
+				}
+				
+				return mesh.back();
+			}
+			
+			void parseFace (const char *& p, const char * end) {
+				ObjMeshVertex first, previous, current;
+				std::size_t count = 0;
+				
+				triangles.clear();
+				
+				while (true) {
+					skipSpace(p, end);
+					
+					if (atEndOfLine(p, end))
+						break;
+					
+					if (!parseVertex(p, end, count == 0 ? first : current)) {
+						errorCount += 1;
+						return;
+					}
+					
+					count += 1;
+					
+					if (count >= 3) {
+						ObjMeshFace face;
+						face.vertices[0] = first;
+						face.vertices[1] = previous;
+						face.vertices[2] = current;
+						
+						triangles.push_back(face);
+					}
+					
+					if (count >= 2) {
+						previous = current;
+					} else {
+						previous = first;
+					}
+				}
+				
+				if (count < 3) {
+					errorCount += 1;
+					return;
+				}
+				
+				std::vector<ObjMeshFace> & faces = currentMesh().faces;
+				faces.insert(faces.end(), triangles.begin(), triangles.end());
+			}
+			
+			void parse (const char * p, const char * end) {
+				while (p != end) {
+					skipSpace(p, end);
+					
+					const char * keyword = p;
+					while (p != end && !isSpace(*p) && *p != '\n') ++p;
+					
+					if (keyword == p) {
+						// Empty line.
+					} else if (keywordIs(keyword, p, "v")) {
+						Vec3 pos(0, 0, 0);
+						parseFloat(p, end, pos[X]) && parseFloat(p, end, pos[Y]) && parseFloat(p, end, pos[Z]);
+						positions.push_back(pos);
+					} else if (keywordIs(keyword, p, "vt")) {
+						Vec2 tex(0, 0);
+						parseFloat(p, end, tex[X]) && parseFloat(p, end, tex[Y]);
+						// Inverse y coordinates
+						tex[Y] = 1.0 - tex[Y];
+						texcoords.push_back(tex);
+					} else if (keywordIs(keyword, p, "vn")) {
+						Vec3 nor(0, 0, 0);
+						parseFloat(p, end, nor[X]) && parseFloat(p, end, nor[Y]) && parseFloat(p, end, nor[Z]);
+						normals.push_back(nor);
+					} else if (keywordIs(keyword, p, "f")) {
+						parseFace(p, end);
+					} else if (keywordIs(keyword, p, "usemtl")) {
+						parseToken(p, end, currentMaterial);
+						materialChanged = true;
+					}
+					
+					skipLine(p, end);
+				}
+			}
+		};
+	}
+	
+	void parseObjMesh (const char * begin, const char * end, std::vector<ObjMesh> & mesh) {
+		ObjParser parser(mesh);
+		
+		parser.parse(begin, end);
+		
+		if (parser.errorCount) {
+			std::cerr << "Skipped " << parser.errorCount << " invalid faces..." << std::endl;
+		}
+	}
+	
+	bool loadObjMesh (const std::string & filename, std::vector<ObjMesh> & mesh) {
+		MappedFile file;
+		
+		if (!file.open(filename)) {
+			std::cerr << "Couldn't load file: " << filename << std::endl;
+			
+			return false;
+		}
+		
+		file.adviseSequential();
+		parseObjMesh(file.begin(), file.end(), mesh);
+		
+		return true;
+	}
+	
+	bool loadObjMaterials (const std::string & filename, std::vector<MaterialDescription> & materials) {
+		MappedFile file;
+		
+		if (!file.open(filename)) {
+			std::cerr << "Couldn't load file: " << filename << std::endl;
+			
+			return false;
+		}
+		
+		const char * p = file.begin(), * end = file.end();
+		MaterialDescription * material = NULL;
+		
+		while (p != end) {
+			skipSpace(p, end);
+			
+			const char * keyword = p;
+			while (p != end && !isSpace(*p) && *p != '\n') ++p;
+			
+			if (keywordIs(keyword, p, "newmtl")) {
+				materials.resize(materials.size() + 1);
+				material = &materials.back();
+				
+				parseToken(p, end, material->name);
+			} else if (keywordIs(keyword, p, "Ka") && material) {
+				parseFloat(p, end, material->ambient.r) && parseFloat(p, end, material->ambient.g) && parseFloat(p, end, material->ambient.b);
+				material->ambient.a = 1.0;
+			} else if (keywordIs(keyword, p, "map_Kd") && material) {
+				parseToken(p, end, material->diffuseMapPath);
+			}
+			
+			skipLine(p, end);
+		}
+		
+		return true;
+	}
+}
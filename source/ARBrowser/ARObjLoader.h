@@ -0,0 +1,28 @@
+//
+//  ARObjLoader.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_OBJ_LOADER_H
+#define _ARBROWSER_OBJ_LOADER_H
+
+#include "ARMesh.h"
+
+namespace ARBrowser {
+	/// Parse an .obj file into a list of meshes, one for each consecutive run of faces sharing a material.
+	/// The file is memory mapped and tokenized in place. Faces may be given as <tt>v</tt>, <tt>v/vt</tt>, <tt>v//vn</tt> or <tt>v/vt/vn</tt>, with absolute or negative (relative) indices. Polygons with more than three vertices are triangulated as a fan.
+	/// @returns false if the file could not be read.
+	bool loadObjMesh (const std::string & filename, std::vector<ObjMesh> & mesh);
+	
+	/// Parse .obj data which has already been loaded into memory.
+	void parseObjMesh (const char * begin, const char * end, std::vector<ObjMesh> & mesh);
+	
+	/// Parse a .mtl file. Only the material name, ambient colour (<tt>Ka</tt>) and diffuse map (<tt>map_Kd</tt>) are used.
+	/// @returns false if the file could not be read.
+	bool loadObjMaterials (const std::string & filename, std::vector<MaterialDescription> & materials);
+}
+
+#endif
@@ -10,23 +10,56 @@
 
 #import <Foundation/Foundation.h>
 
+#include <memory>
+
 #include "ARModel.h"
 #include "ARRendering.h"
+#include "ARResourceLoader.h"
+#include "ARAssetCache.h"
 
-/// Provides a wrapper for ARBrowser::Model which implements ARRenderable
+/// Provides a wrapper for ARBrowser::Model which implements ARRenderable. The model is loaded on a background thread the first time it is needed, and is shared with other instances which use the same files through the asset cache.
+/// All methods must be called on the rendering thread.
 @interface ARObjectModel : NSObject<ARRenderable> {
 @private
 	NSString * _name;
 	NSString * _directory;
 	
-	ARBrowser::Model * mesh;
+	/// The canonical path of the model, used as the cache key.
+	std::string _key;
+	std::shared_ptr<ARBrowser::ResourceLoader::Request> _request;
+	
+	/// The model, held from the first use in a frame until -didBecomeHidden, so that it can't be evicted while it is drawn.
+	std::shared_ptr<ARBrowser::Model> _mesh;
+	
+	/// The frame in which the model was last looked up in the cache.
+	NSUInteger _frame;
 }
 
+/// Upload models which have finished loading, until the given time budget has been used. Must be called on the rendering thread.
++ (NSUInteger) processPendingLoadsWithinTime: (NSTimeInterval)budget;
+
+/// The cache which holds all loaded models and textures.
++ (ARBrowser::AssetCache &) sharedAssetCache;
+
+/// May be called from any thread; the new budget takes effect on the next call to +processPendingLoadsWithinTime:.
++ (void) setCacheBudget: (std::size_t)bytes;
+
 /// Load a model with the given name from the given directory.
 /// Because .obj models consist of more than one file, we need to know the files <tt>[name].obj</tt> and <tt>[name].mtl</tt> and the associated directory for loading texture data.
 - initWithName: (NSString*)name inDirectory: (NSString*)directory;
 
+/// Returns NO until the model has been loaded, and always if it failed to load, e.g. because its files are missing, so that a marker is drawn instead. A failed model is not loaded again. Calling this method starts loading the model if required. The model is looked up in the cache by the first call to any method in each frame, and held until -didBecomeHidden.
+- (BOOL) isReady;
+
+/// Release the model, so that the cache can evict it.
+- (void) didBecomeHidden;
+
 - (void) draw;
+- (void) drawAtLevelOfDetail: (NSUInteger)level;
+- (void) enqueueAtLevelOfDetail: (NSUInteger)level transform: (const float *)transform depth: (float)depth inQueue: (ARBrowser::RenderQueue &)queue;
+- (NSUInteger) levelOfDetailForPixelsPerUnit: (float)pixelsPerUnit previous: (NSUInteger)previous;
+- (std::shared_ptr<const ARBrowser::TriangleHierarchy>) triangleHierarchy;
+
 - (ARBoundingSphere) boundingSphere;
 
 @end
@@ -8,9 +8,82 @@
 
 #import "ARObjectModel.h"
 
+#include <atomic>
+#include <map>
+#include <set>
+
+/// The default budget for cached models and textures, in bytes.
+static const std::size_t ARObjectModelDefaultCacheBudget = 32 * 1024 * 1024;
+
+/// The budget requested by +setCacheBudget:, applied on the rendering thread since evicting textures deletes them.
+static std::atomic<std::size_t> ARObjectModelCacheBudget(ARObjectModelDefaultCacheBudget);
+
+/// Loading models is dominated by file I/O and parsing, so a couple of workers is enough to keep the renderer fed without competing with the motion model.
+static ARBrowser::ResourceLoader & sharedLoader ()
+{
+	static ARBrowser::ResourceLoader * loader = NULL;
+	static dispatch_once_t once;
+	
+	dispatch_once(&once, ^{
+		loader = new ARBrowser::ResourceLoader(2);
+	});
+	
+	return *loader;
+}
+
+typedef std::map<std::string, std::weak_ptr<ARBrowser::ResourceLoader::Request>> PendingLoadsT;
+
+/// Counts calls to +processPendingLoadsWithinTime:, which is called once per frame, so that each model is only looked up in the cache once per frame. Only accessed on the rendering thread.
+static NSUInteger ARObjectModelFrame = 1;
+
+/// Loads which are in progress, so that instances sharing a model only load it once. Only accessed on the rendering thread.
+static PendingLoadsT & pendingLoads ()
+{
+	static PendingLoadsT loads;
+	
+	return loads;
+}
+
+/// Models which failed to load, which are drawn as markers rather than loaded again by each instance. Only accessed on the rendering thread.
+static std::set<std::string> & failedLoads ()
+{
+	static std::set<std::string> failed;
+	
+	return failed;
+}
 
 @implementation ARObjectModel
 
++ (NSUInteger) processPendingLoadsWithinTime: (NSTimeInterval)budget
+{
+	ARBrowser::AssetCache & cache = [self sharedAssetCache];
+	std::size_t cacheBudget = ARObjectModelCacheBudget.load();
+	
+	if (cache.statistics().budget != cacheBudget)
+		cache.setBudget(cacheBudget);
+	
+	ARObjectModelFrame += 1;
+	
+	return sharedLoader().processUploads(budget);
+}
+
++ (void) setCacheBudget: (std::size_t)bytes
+{
+	ARObjectModelCacheBudget.store(bytes);
+}
+
++ (ARBrowser::AssetCache &) sharedAssetCache
+{
+	static ARBrowser::AssetCache * cache = NULL;
+	static dispatch_once_t once;
+	
+	dispatch_once(&once, ^{
+		cache = new ARBrowser::AssetCache(ARObjectModelDefaultCacheBudget);
+	});
+	
+	return *cache;
+}
+
 - initWithName: (NSString*)name inDirectory: (NSString*)directory
 {
     self = [super init];
@@ -18,37 +91,160 @@
     if (self) {
 		_name = [name copy];
 		_directory = [directory copy];
+		
+		_key = ARBrowser::AssetCache::canonicalPath([_directory UTF8String]) + "/" + [_name UTF8String];
     }
     
     return self;
 }
 
-- (void)dealloc
+- (void) loadMesh
 {
-	if (mesh)
-		delete mesh;
+	// Don't keep retrying a model which failed to load, whichever instance loaded it:
+	std::set<std::string> & failed = failedLoads();
+	
+	if (failed.count(_key))
+		return;
+	
+	// Another instance may already be loading the same model:
+	PendingLoadsT & loads = pendingLoads();
+	_request = loads[_key].lock();
+	
+	if (_request) {
+		if (!_request->finished())
+			return;
+		
+		// Failed loads are never uploaded, so they are removed here rather than by the upload:
+		if (_request->state() == ARBrowser::ResourceLoader::FAILED) {
+			failed.insert(_key);
+			loads.erase(_key);
+			
+			return;
+		}
+	}
+	
+	std::string name = [_name UTF8String], directory = [_directory UTF8String], key = _key;
+	
+	// The model is constructed and its textures decoded on a worker thread, then handed over to the render thread which only uploads the textures:
+	std::shared_ptr<std::shared_ptr<ARBrowser::Model>> loaded = std::make_shared<std::shared_ptr<ARBrowser::Model>>();
+	
+	_request = sharedLoader().load([=]() {
+		*loaded = std::make_shared<ARBrowser::Model>(name, directory);
+		
+		// A model without meshes would be cached and reported as ready, but draw nothing rather than a marker:
+		if ((*loaded)->empty()) {
+			loaded->reset();
+			
+			return false;
+		}
+		
+		(*loaded)->readTextures();
+		
+		return true;
+	}, [=]() {
+		ARBrowser::AssetCache & cache = [ARObjectModel sharedAssetCache];
+		
+		(*loaded)->loadTextures(cache);
+		cache.insert(key, *loaded);
+		
+		pendingLoads().erase(key);
+		
+		return true;
+	});
+	
+	loads[_key] = _request;
 }
 
-- (void) loadMesh
+/// Returns the model held for this frame, or NULL if it isn't ready.
+- (std::shared_ptr<ARBrowser::Model>) mesh
 {
-	if (!mesh) {
-        mesh = new ARBrowser::Model([_name UTF8String], [_directory UTF8String]);
+	// Look up the cached model once per frame, which also keeps it recently used, or start loading it if it isn't cached, e.g. because it was evicted:
+	if (_frame != ARObjectModelFrame) {
+		_frame = ARObjectModelFrame;
+		_mesh = [ARObjectModel sharedAssetCache].lookup<ARBrowser::Model>(_key);
+		
+		if (!_mesh)
+			[self loadMesh];
 	}
+	
+	return _mesh;
+}
+
+- (BOOL) isReady
+{
+	return [self mesh] != nullptr;
+}
+
+- (void) didBecomeHidden
+{
+	_mesh.reset();
+	
+	// The next use looks up the model again:
+	_frame = 0;
 }
 
 - (void) draw
-{	
-	[self loadMesh];
+{
+	[self drawAtLevelOfDetail:0];
+}
+
+- (void) drawAtLevelOfDetail: (NSUInteger)level
+{
+	std::shared_ptr<ARBrowser::Model> mesh = [self mesh];
+	
+	if (!mesh)
+		return;
 	
 	glColor4f(1.0, 1.0, 1.0, 1.0);
 
-	mesh->render();
+	mesh->render(level);
 }
 
-- (ARBoundingSphere) boundingSphere
+- (void) enqueueAtLevelOfDetail: (NSUInteger)level transform: (const float *)transform depth: (float)depth inQueue: (ARBrowser::RenderQueue &)queue
 {
-	[self loadMesh];
+	std::shared_ptr<ARBrowser::Model> mesh = [self mesh];
+	
+	if (!mesh)
+		return;
+	
+	mesh->enqueue(queue, transform, depth, level);
+}
+
+- (NSUInteger) triangleCountAtLevelOfDetail: (NSUInteger)level
+{
+	std::shared_ptr<ARBrowser::Model> mesh = [self mesh];
+	
+	if (!mesh)
+		return 0;
+	
+	return mesh->triangleCount(level);
+}
+
+- (NSUInteger) levelOfDetailForPixelsPerUnit: (float)pixelsPerUnit previous: (NSUInteger)previous
+{
+	std::shared_ptr<ARBrowser::Model> mesh = [self mesh];
+	
+	if (!mesh)
+		return 0;
+	
+	return mesh->detail().select(pixelsPerUnit, previous);
+}
 
+- (std::shared_ptr<const ARBrowser::TriangleHierarchy>) triangleHierarchy
+{
+	std::shared_ptr<ARBrowser::Model> mesh = [self mesh];
+	
+	if (!mesh)
+		return nullptr;
+	
+	// The hierarchy is part of the model, so share ownership of the model to keep it alive:
+	return std::shared_ptr<const ARBrowser::TriangleHierarchy>(mesh, &mesh->triangles());
+}
+
+- (ARBoundingSphere) boundingSphere
+{
+	std::shared_ptr<ARBrowser::Model> mesh = [self mesh];
+	
 	if (mesh) {
 		ARBrowser::BoundingBox box = mesh->boundingBox();
 		
@@ -64,8 +260,8 @@
 
 - (ARBrowser::BoundingBox) boundingBox
 {
-	[self loadMesh];
-
+	std::shared_ptr<ARBrowser::Model> mesh = [self mesh];
+	
 	if (mesh) {
 		return mesh->boundingBox();
 	} else {
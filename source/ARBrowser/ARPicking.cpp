@@ -0,0 +1,652 @@
+//
+//  ARPicking.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARPicking.h"
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace ARBrowser {
+	namespace {
+		/// Leaves are split until they have at most this many primitives, if doing so reduces the expected cost.
+		const std::uint32_t LEAF_SIZE = 4;
+		
+		/// Leaves are always split if they have more than this many primitives.
+		const std::uint32_t MAXIMUM_LEAF_SIZE = 16;
+		
+		/// The number of buckets used to estimate the surface area heuristic.
+		const std::size_t BINS = 12;
+		
+		/// Below this depth, nodes are split in the middle, which adds at most another 32 levels, so that traversal never overflows its stack.
+		const std::size_t MAXIMUM_DEPTH = 32;
+		const std::size_t STACK_SIZE = 72;
+		
+		struct Bounds {
+			float min[3], max[3];
+			
+			void clear () {
+				for (std::size_t i = 0; i < 3; i += 1) {
+					min[i] = std::numeric_limits<float>::infinity();
+					max[i] = -std::numeric_limits<float>::infinity();
+				}
+			}
+			
+			void add (const float * lower, const float * upper) {
+				for (std::size_t i = 0; i < 3; i += 1) {
+					min[i] = std::min(min[i], lower[i]);
+					max[i] = std::max(max[i], upper[i]);
+				}
+			}
+			
+			/// Half the surface area, which is all the heuristic needs.
+			float area () const {
+				float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+				
+				if (x < 0 || y < 0 || z < 0) return 0;
+				
+				return x * y + y * z + z * x;
+			}
+		};
+		
+		/// Builds a hierarchy over primitives using a binned surface area heuristic, reordering the primitives so that each leaf refers to a contiguous range.
+		class Builder {
+			protected:
+				const std::vector<Bounds> & m_bounds;
+				std::vector<float> m_centroids;
+				
+				std::vector<HierarchyNode> & m_nodes;
+				std::vector<std::uint32_t> & m_order;
+				
+				float centroid (std::uint32_t primitive, std::size_t axis) const {
+					return m_centroids[primitive * 3 + axis];
+				}
+				
+				void makeLeaf (std::size_t index, std::uint32_t begin, std::uint32_t end) {
+					m_nodes[index].offset = begin;
+					m_nodes[index].count = end - begin;
+				}
+				
+				std::uint32_t partitionMiddle (std::uint32_t begin, std::uint32_t end, std::size_t axis) {
+					std::uint32_t middle = begin + (end - begin) / 2;
+					
+					std::nth_element(m_order.begin() + begin, m_order.begin() + middle, m_order.begin() + end, [&](std::uint32_t a, std::uint32_t b) {
+						return centroid(a, axis) < centroid(b, axis);
+					});
+					
+					return middle;
+				}
+				
+				void build (std::uint32_t begin, std::uint32_t end, std::size_t depth) {
+					std::size_t index = m_nodes.size();
+					m_nodes.push_back(HierarchyNode());
+					
+					Bounds bounds, centroids;
+					bounds.clear();
+					centroids.clear();
+					
+					for (std::uint32_t i = begin; i < end; i += 1) {
+						std::uint32_t primitive = m_order[i];
+						
+						bounds.add(m_bounds[primitive].min, m_bounds[primitive].max);
+						centroids.add(&m_centroids[primitive * 3], &m_centroids[primitive * 3]);
+					}
+					
+					std::copy(bounds.min, bounds.min + 3, m_nodes[index].min);
+					std::copy(bounds.max, bounds.max + 3, m_nodes[index].max);
+					
+					const std::uint32_t count = end - begin;
+					
+					if (count <= LEAF_SIZE) {
+						makeLeaf(index, begin, end);
+						return;
+					}
+					
+					std::size_t axis = 0;
+					for (std::size_t i = 1; i < 3; i += 1) {
+						if (centroids.max[i] - centroids.min[i] > centroids.max[axis] - centroids.min[axis])
+							axis = i;
+					}
+					
+					const float lower = centroids.min[axis], extent = centroids.max[axis] - lower;
+					std::uint32_t middle = begin;
+					
+					if (extent <= 0) {
+						// All centroids are in the same place, so there is nothing to gain from the heuristic:
+						if (count <= MAXIMUM_LEAF_SIZE) {
+							makeLeaf(index, begin, end);
+							return;
+						}
+						
+						middle = partitionMiddle(begin, end, axis);
+					} else if (depth >= MAXIMUM_DEPTH) {
+						middle = partitionMiddle(begin, end, axis);
+					} else {
+						Bounds binBounds[BINS];
+						std::uint32_t binCounts[BINS] = {0};
+						
+						for (std::size_t i = 0; i < BINS; i += 1)
+							binBounds[i].clear();
+						
+						const float scale = BINS / extent;
+						
+						for (std::uint32_t i = begin; i < end; i += 1) {
+							std::uint32_t primitive = m_order[i];
+							std::size_t bin = std::min<std::size_t>((centroid(primitive, axis) - lower) * scale, BINS - 1);
+							
+							binCounts[bin] += 1;
+							binBounds[bin].add(m_bounds[primitive].min, m_bounds[primitive].max);
+						}
+						
+						// Sweep from the right to find the cost of each right hand side, then from the left to find the best split:
+						float rightCosts[BINS];
+						Bounds right;
+						right.clear();
+						std::uint32_t rightCount = 0;
+						
+						for (std::size_t i = BINS - 1; i > 0; i -= 1) {
+							right.add(binBounds[i].min, binBounds[i].max);
+							rightCount += binCounts[i];
+							rightCosts[i] = right.area() * rightCount;
+						}
+						
+						Bounds left;
+						left.clear();
+						std::uint32_t leftCount = 0;
+						
+						float bestCost = std::numeric_limits<float>::infinity();
+						std::size_t bestSplit = 0;
+						
+						for (std::size_t i = 1; i < BINS; i += 1) {
+							left.add(binBounds[i - 1].min, binBounds[i - 1].max);
+							leftCount += binCounts[i - 1];
+							
+							if (leftCount == 0 || leftCount == count) continue;
+							
+							float cost = left.area() * leftCount + rightCosts[i];
+							
+							if (cost < bestCost) {
+								bestCost = cost;
+								bestSplit = i;
+							}
+						}
+						
+						if (bestSplit == 0) {
+							middle = partitionMiddle(begin, end, axis);
+						} else {
+							if (bestCost >= bounds.area() * count && count <= MAXIMUM_LEAF_SIZE) {
+								makeLeaf(index, begin, end);
+								return;
+							}
+							
+							middle = (std::uint32_t)(std::partition(m_order.begin() + begin, m_order.begin() + end, [&](std::uint32_t primitive) {
+								return std::min<std::size_t>((centroid(primitive, axis) - lower) * scale, BINS - 1) < bestSplit;
+							}) - m_order.begin());
+						}
+					}
+					
+					build(begin, middle, depth + 1);
+					m_nodes[index].offset = (std::uint32_t)m_nodes.size();
+					m_nodes[index].count = 0;
+					build(middle, end, depth + 1);
+				}
+			
+			public:
+				Builder (const std::vector<Bounds> & bounds, std::vector<HierarchyNode> & nodes, std::vector<std::uint32_t> & order) : m_bounds(bounds), m_nodes(nodes), m_order(order) {
+					m_centroids.resize(bounds.size() * 3);
+					
+					for (std::size_t i = 0; i < bounds.size(); i += 1) {
+						for (std::size_t j = 0; j < 3; j += 1) {
+							m_centroids[i * 3 + j] = (bounds[i].min[j] + bounds[i].max[j]) * 0.5f;
+						}
+					}
+				}
+				
+				void build () {
+					m_nodes.clear();
+					m_order.resize(m_bounds.size());
+					
+					for (std::size_t i = 0; i < m_order.size(); i += 1)
+						m_order[i] = (std::uint32_t)i;
+					
+					if (!m_bounds.empty())
+						build(0, (std::uint32_t)m_bounds.size(), 0);
+				}
+		};
+		
+		struct Ray {
+			float origin[3], inverse[3];
+			
+			Ray (const float * _origin, const float * direction) {
+				for (std::size_t i = 0; i < 3; i += 1) {
+					origin[i] = _origin[i];
+					inverse[i] = 1.0f / direction[i];
+				}
+			}
+			
+			/// If the ray is parallel to an axis, the slab test produces NaN, which std::min and std::max ignore because they keep their first argument.
+			bool intersects (const float * min, const float * max, float maximum, float & entry) const {
+				float t0 = 0, t1 = maximum;
+				
+				for (std::size_t i = 0; i < 3; i += 1) {
+					float near = (min[i] - origin[i]) * inverse[i];
+					float far = (max[i] - origin[i]) * inverse[i];
+					
+					if (near > far) std::swap(near, far);
+					
+					t0 = std::max(t0, near);
+					t1 = std::min(t1, far);
+				}
+				
+				entry = t0;
+				
+				return t0 <= t1;
+			}
+		};
+		
+		struct StackEntry {
+			std::uint32_t node;
+			float entry;
+		};
+		
+		/// Traverse the hierarchy nearest child first, calling leaf for each leaf which the ray enters before the current maximum.
+		template <typename LeafT>
+		void traverse (const HierarchyNode * nodes, std::size_t count, const Ray & ray, float & maximum, LeafT leaf) {
+			if (count == 0) return;
+			
+			StackEntry stack[STACK_SIZE];
+			std::size_t top = 0;
+			
+			float entry;
+			if (!ray.intersects(nodes[0].min, nodes[0].max, maximum, entry)) return;
+			
+			stack[top].node = 0; stack[top++].entry = entry;
+			
+			while (top > 0) {
+				StackEntry current = stack[--top];
+				
+				// A closer hit may have been found since this node was pushed:
+				if (current.entry > maximum) continue;
+				
+				const HierarchyNode & node = nodes[current.node];
+				
+				if (node.count) {
+					leaf(node);
+					continue;
+				}
+				
+				std::uint32_t first = current.node + 1, second = node.offset;
+				float firstEntry, secondEntry;
+				
+				bool hitFirst = ray.intersects(nodes[first].min, nodes[first].max, maximum, firstEntry);
+				bool hitSecond = ray.intersects(nodes[second].min, nodes[second].max, maximum, secondEntry);
+				
+				if (hitFirst && hitSecond) {
+					// Push the further child first, so the nearer child is visited first:
+					if (firstEntry < secondEntry) {
+						stack[top].node = second; stack[top++].entry = secondEntry;
+						stack[top].node = first; stack[top++].entry = firstEntry;
+					} else {
+						stack[top].node = first; stack[top++].entry = firstEntry;
+						stack[top].node = second; stack[top++].entry = secondEntry;
+					}
+				} else if (hitFirst) {
+					stack[top].node = first; stack[top++].entry = firstEntry;
+				} else if (hitSecond) {
+					stack[top].node = second; stack[top++].entry = secondEntry;
+				}
+			}
+		}
+		
+		inline void subtract (const float * a, const float * b, float * result) {
+			result[0] = a[0] - b[0];
+			result[1] = a[1] - b[1];
+			result[2] = a[2] - b[2];
+		}
+		
+		inline void cross (const float * a, const float * b, float * result) {
+			result[0] = a[1] * b[2] - a[2] * b[1];
+			result[1] = a[2] * b[0] - a[0] * b[2];
+			result[2] = a[0] * b[1] - a[1] * b[0];
+		}
+		
+		inline float dot (const float * a, const float * b) {
+			return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+		}
+		
+		/// Möller & Trumbore's ray/triangle intersection.
+		inline bool intersectTriangle (const float * triangle, const float * origin, const float * direction, float & t) {
+			float edge1[3], edge2[3], p[3], s[3], q[3];
+			
+			subtract(triangle + 3, triangle, edge1);
+			subtract(triangle + 6, triangle, edge2);
+			cross(direction, edge2, p);
+			
+			float determinant = dot(edge1, p);
+			
+			// The ray is parallel to the triangle:
+			if (determinant == 0) return false;
+			
+			float inverse = 1.0f / determinant;
+			
+			subtract(origin, triangle, s);
+			float u = dot(s, p) * inverse;
+			
+			if (u < 0 || u > 1) return false;
+			
+			cross(s, edge1, q);
+			float v = dot(direction, q) * inverse;
+			
+			if (v < 0 || u + v > 1) return false;
+			
+			t = dot(edge2, q) * inverse;
+			
+			return true;
+		}
+		
+		/// Multiply column-major matrices.
+		void multiply (const float * a, const float * b, float * result) {
+			for (std::size_t column = 0; column < 4; column += 1) {
+				for (std::size_t row = 0; row < 4; row += 1) {
+					float sum = 0;
+					
+					for (std::size_t k = 0; k < 4; k += 1)
+						sum += a[k * 4 + row] * b[column * 4 + k];
+					
+					result[column * 4 + row] = sum;
+				}
+			}
+		}
+		
+		/// Invert a 4x4 matrix using cofactors, in double precision since projection matrices are poorly conditioned.
+		bool invert (const float * m, double * inverse) {
+			double inv[16];
+			
+			inv[0] = m[5]*m[10]*m[15] - m[5]*m[11]*m[14] - m[9]*m[6]*m[15] + m[9]*m[7]*m[14] + m[13]*m[6]*m[11] - m[13]*m[7]*m[10];
+			inv[4] = -m[4]*m[10]*m[15] + m[4]*m[11]*m[14] + m[8]*m[6]*m[15] - m[8]*m[7]*m[14] - m[12]*m[6]*m[11] + m[12]*m[7]*m[10];
+			inv[8] = m[4]*m[9]*m[15] - m[4]*m[11]*m[13] - m[8]*m[5]*m[15] + m[8]*m[7]*m[13] + m[12]*m[5]*m[11] - m[12]*m[7]*m[9];
+			inv[12] = -m[4]*m[9]*m[14] + m[4]*m[10]*m[13] + m[8]*m[5]*m[14] - m[8]*m[6]*m[13] - m[12]*m[5]*m[10] + m[12]*m[6]*m[9];
+			inv[1] = -m[1]*m[10]*m[15] + m[1]*m[11]*m[14] + m[9]*m[2]*m[15] - m[9]*m[3]*m[14] - m[13]*m[2]*m[11] + m[13]*m[3]*m[10];
+			inv[5] = m[0]*m[10]*m[15] - m[0]*m[11]*m[14] - m[8]*m[2]*m[15] + m[8]*m[3]*m[14] + m[12]*m[2]*m[11] - m[12]*m[3]*m[10];
+			inv[9] = -m[0]*m[9]*m[15] + m[0]*m[11]*m[13] + m[8]*m[1]*m[15] - m[8]*m[3]*m[13] - m[12]*m[1]*m[11] + m[12]*m[3]*m[9];
+			inv[13] = m[0]*m[9]*m[14] - m[0]*m[10]*m[13] - m[8]*m[1]*m[14] + m[8]*m[2]*m[13] + m[12]*m[1]*m[10] - m[12]*m[2]*m[9];
+			inv[2] = m[1]*m[6]*m[15] - m[1]*m[7]*m[14] - m[5]*m[2]*m[15] + m[5]*m[3]*m[14] + m[13]*m[2]*m[7] - m[13]*m[3]*m[6];
+			inv[6] = -m[0]*m[6]*m[15] + m[0]*m[7]*m[14] + m[4]*m[2]*m[15] - m[4]*m[3]*m[14] - m[12]*m[2]*m[7] + m[12]*m[3]*m[6];
+			inv[10] = m[0]*m[5]*m[15] - m[0]*m[7]*m[13] - m[4]*m[1]*m[15] + m[4]*m[3]*m[13] + m[12]*m[1]*m[7] - m[12]*m[3]*m[5];
+			inv[14] = -m[0]*m[5]*m[14] + m[0]*m[6]*m[13] + m[4]*m[1]*m[14] - m[4]*m[2]*m[13] - m[12]*m[1]*m[6] + m[12]*m[2]*m[5];
+			inv[3] = -m[1]*m[6]*m[11] + m[1]*m[7]*m[10] + m[5]*m[2]*m[11] - m[5]*m[3]*m[10] - m[9]*m[2]*m[7] + m[9]*m[3]*m[6];
+			inv[7] = m[0]*m[6]*m[11] - m[0]*m[7]*m[10] - m[4]*m[2]*m[11] + m[4]*m[3]*m[10] + m[8]*m[2]*m[7] - m[8]*m[3]*m[6];
+			inv[11] = -m[0]*m[5]*m[11] + m[0]*m[7]*m[9] + m[4]*m[1]*m[11] - m[4]*m[3]*m[9] - m[8]*m[1]*m[7] + m[8]*m[3]*m[5];
+			inv[15] = m[0]*m[5]*m[10] - m[0]*m[6]*m[9] - m[4]*m[1]*m[10] + m[4]*m[2]*m[9] + m[8]*m[1]*m[6] - m[8]*m[2]*m[5];
+			
+			double determinant = m[0] * inv[0] + m[1] * inv[4] + m[2] * inv[8] + m[3] * inv[12];
+			
+			if (determinant == 0) return false;
+			
+			for (std::size_t i = 0; i < 16; i += 1)
+				inverse[i] = inv[i] / determinant;
+			
+			return true;
+		}
+		
+		bool unproject (const double * inverse, float x, float y, float z, double * result) {
+			double w = inverse[3] * x + inverse[7] * y + inverse[11] * z + inverse[15];
+			
+			if (w == 0) return false;
+			
+			for (std::size_t i = 0; i < 3; i += 1)
+				result[i] = (inverse[i] * x + inverse[4 + i] * y + inverse[8 + i] * z + inverse[12 + i]) / w;
+			
+			return true;
+		}
+	}
+	
+	bool screenRay (const float * projection, const float * view, float x, float y, float * origin, float * direction) {
+		float combined[16];
+		double inverse[16], near[3], far[3];
+		
+		multiply(projection, view, combined);
+		
+		if (!invert(combined, inverse) || !unproject(inverse, x, y, -1, near) || !unproject(inverse, x, y, 1, far))
+			return false;
+		
+		double delta[3] = {far[0] - near[0], far[1] - near[1], far[2] - near[2]};
+		double length = std::sqrt(delta[0] * delta[0] + delta[1] * delta[1] + delta[2] * delta[2]);
+		
+		if (length == 0) return false;
+		
+		for (std::size_t i = 0; i < 3; i += 1) {
+			origin[i] = near[i];
+			direction[i] = delta[i] / length;
+		}
+		
+		return true;
+	}
+	
+	TriangleHierarchy::TriangleHierarchy () : m_nodes(NULL), m_nodeCount(0), m_triangles(NULL), m_triangleCount(0) {
+	}
+	
+	void TriangleHierarchy::build (const std::vector<MeshBuffer> & meshes) {
+		std::vector<float> triangles;
+		std::vector<Bounds> bounds;
+		
+		for (std::size_t i = 0; i < meshes.size(); i += 1) {
+			const MeshBuffer & mesh = meshes[i];
+			
+			for (std::size_t j = 0; j + 2 < mesh.indexCount; j += 3) {
+				Bounds triangle;
+				triangle.clear();
+				
+				for (std::size_t k = 0; k < 3; k += 1) {
+					std::uint32_t index = mesh.shortIndices ? ((const std::uint16_t *)mesh.indices)[j + k] : ((const std::uint32_t *)mesh.indices)[j + k];
+					Vec3 vertex = mesh.position(index);
+					const float * position = vertex.data();
+					
+					triangles.insert(triangles.end(), position, position + 3);
+					triangle.add(position, position);
+				}
+				
+				bounds.push_back(triangle);
+			}
+		}
+		
+		clear();
+		
+		std::vector<std::uint32_t> order;
+		Builder(bounds, m_nodeStorage, order).build();
+		
+		// Store the triangles in leaf order, so each leaf reads a contiguous range:
+		m_triangleStorage.resize(triangles.size());
+		
+		for (std::size_t i = 0; i < order.size(); i += 1) {
+			std::copy(&triangles[order[i] * 9], &triangles[order[i] * 9] + 9, &m_triangleStorage[i * 9]);
+		}
+		
+		m_nodes = m_nodeStorage.data();
+		m_nodeCount = m_nodeStorage.size();
+		m_triangles = m_triangleStorage.data();
+		m_triangleCount = m_triangleStorage.size() / 9;
+	}
+	
+	bool TriangleHierarchy::assign (const HierarchyNode * nodes, std::size_t nodeCount, const float * triangles, std::size_t triangleCount) {
+		clear();
+		
+		// Children always follow their parent, so the depth of every node is known before its children are reached:
+		std::vector<std::uint8_t> depths(nodeCount, 0);
+		
+		for (std::size_t i = 0; i < nodeCount; i += 1) {
+			const HierarchyNode & node = nodes[i];
+			
+			if (node.count) {
+				if ((std::uint64_t)node.offset + node.count > triangleCount)
+					return false;
+			} else {
+				// Traversal has a fixed size stack, which is enough for the depth produced by the builder:
+				if (i + 1 >= nodeCount || node.offset <= i + 1 || node.offset >= nodeCount || depths[i] >= MAXIMUM_DEPTH * 2)
+					return false;
+				
+				depths[i + 1] = std::max<std::uint8_t>(depths[i + 1], depths[i] + 1);
+				depths[node.offset] = std::max<std::uint8_t>(depths[node.offset], depths[i] + 1);
+			}
+		}
+		
+		m_nodes = nodes;
+		m_nodeCount = nodeCount;
+		m_triangles = triangles;
+		m_triangleCount = triangleCount;
+		
+		return true;
+	}
+	
+	void TriangleHierarchy::clear () {
+		m_nodes = NULL;
+		m_nodeCount = 0;
+		m_triangles = NULL;
+		m_triangleCount = 0;
+		
+		m_nodeStorage.clear();
+		m_triangleStorage.clear();
+	}
+	
+	bool TriangleHierarchy::intersect (const float * origin, const float * direction, float & maximum) const {
+		Ray ray(origin, direction);
+		bool hit = false;
+		
+		traverse(m_nodes, m_nodeCount, ray, maximum, [&](const HierarchyNode & node) {
+			for (std::uint32_t i = node.offset; i < node.offset + node.count; i += 1) {
+				float t;
+				
+				if (intersectTriangle(&m_triangles[i * 9], origin, direction, t) && t >= 0 && t <= maximum) {
+					maximum = t;
+					hit = true;
+				}
+			}
+		});
+		
+		return hit;
+	}
+	
+	std::size_t TriangleHierarchy::residentSize () const {
+		return m_nodeStorage.size() * sizeof(HierarchyNode) + m_triangleStorage.size() * sizeof(float);
+	}
+	
+	void InstanceHierarchy::updateInverses () {
+		m_inverses.resize(m_instances.size() * 12);
+		m_invertible.resize(m_instances.size());
+		
+		for (std::size_t i = 0; i < m_instances.size(); i += 1) {
+			const float * m = m_instances[i].transform;
+			float * inverse = &m_inverses[i * 12];
+			
+			// The upper 3x3 is a[row][column] = m[column * 4 + row]:
+			double c00 = m[5] * m[10] - m[9] * m[6], c01 = m[9] * m[2] - m[1] * m[10], c02 = m[1] * m[6] - m[5] * m[2];
+			double c10 = m[8] * m[6] - m[4] * m[10], c11 = m[0] * m[10] - m[8] * m[2], c12 = m[4] * m[2] - m[0] * m[6];
+			double c20 = m[4] * m[9] - m[8] * m[5], c21 = m[8] * m[1] - m[0] * m[9], c22 = m[0] * m[5] - m[4] * m[1];
+			
+			double determinant = m[0] * c00 + m[4] * c01 + m[8] * c02;
+			
+			m_invertible[i] = (determinant != 0);
+			
+			if (!m_invertible[i]) continue;
+			
+			const double rows[3][3] = {{c00, c10, c20}, {c01, c11, c21}, {c02, c12, c22}};
+			
+			for (std::size_t row = 0; row < 3; row += 1) {
+				double translation = 0;
+				
+				for (std::size_t column = 0; column < 3; column += 1) {
+					inverse[row * 4 + column] = rows[row][column] / determinant;
+					translation -= inverse[row * 4 + column] * m[12 + column];
+				}
+				
+				inverse[row * 4 + 3] = translation;
+			}
+		}
+	}
+	
+	void InstanceHierarchy::build () {
+		std::vector<Bounds> bounds(m_instances.size());
+		
+		for (std::size_t i = 0; i < m_instances.size(); i += 1) {
+			std::copy(m_instances[i].min, m_instances[i].min + 3, bounds[i].min);
+			std::copy(m_instances[i].max, m_instances[i].max + 3, bounds[i].max);
+		}
+		
+		Builder(bounds, m_nodes, m_order).build();
+		
+		updateInverses();
+	}
+	
+	void InstanceHierarchy::refit () {
+		updateInverses();
+		
+		// Children always follow their parents, so walking backwards updates children first:
+		for (std::size_t i = m_nodes.size(); i-- > 0; ) {
+			HierarchyNode & node = m_nodes[i];
+			Bounds bounds;
+			bounds.clear();
+			
+			if (node.count) {
+				for (std::uint32_t j = node.offset; j < node.offset + node.count; j += 1) {
+					const Instance & instance = m_instances[m_order[j]];
+					bounds.add(instance.min, instance.max);
+				}
+			} else {
+				bounds.add(m_nodes[i + 1].min, m_nodes[i + 1].max);
+				bounds.add(m_nodes[node.offset].min, m_nodes[node.offset].max);
+			}
+			
+			std::copy(bounds.min, bounds.min + 3, node.min);
+			std::copy(bounds.max, bounds.max + 3, node.max);
+		}
+	}
+	
+	void InstanceHierarchy::clear () {
+		m_instances.clear();
+		m_nodes.clear();
+		m_order.clear();
+		m_inverses.clear();
+		m_invertible.clear();
+	}
+	
+	bool InstanceHierarchy::pick (const float * origin, const float * direction, float maximum, Hit & hit) const {
+		Ray ray(origin, direction);
+		bool found = false;
+		
+		traverse(m_nodes.data(), m_nodes.size(), ray, maximum, [&](const HierarchyNode & node) {
+			for (std::uint32_t i = node.offset; i < node.offset + node.count; i += 1) {
+				std::uint32_t index = m_order[i];
+				const Instance & instance = m_instances[index];
+				
+				float entry;
+				if (!ray.intersects(instance.min, instance.max, maximum, entry)) continue;
+				
+				if (instance.triangles && m_invertible[index]) {
+					// Transform the ray into object space. The transform is affine, so t is the same in both spaces:
+					const float * inverse = &m_inverses[index * 12];
+					float localOrigin[3], localDirection[3];
+					
+					for (std::size_t row = 0; row < 3; row += 1) {
+						localOrigin[row] = dot(inverse + row * 4, origin) + inverse[row * 4 + 3];
+						localDirection[row] = dot(inverse + row * 4, direction);
+					}
+					
+					if (!instance.triangles->intersect(localOrigin, localDirection, maximum)) continue;
+				} else {
+					maximum = entry;
+				}
+				
+				hit.handle = instance.handle;
+				hit.distance = maximum;
+				found = true;
+			}
+		});
+		
+		return found;
+	}
+}
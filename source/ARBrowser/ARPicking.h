@@ -0,0 +1,127 @@
+//
+//  ARPicking.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_PICKING_H
+#define _ARBROWSER_PICKING_H
+
+#include "ARMesh.h"
+
+namespace ARBrowser {
+	/// Calculate the ray through a point on the screen, given in normalized device coordinates (-1 to 1), using column-major projection and view matrices. The origin is on the near plane and the direction is normalized.
+	/// @returns false if the matrices can't be inverted.
+	bool screenRay (const float * projection, const float * view, float x, float y, float * origin, float * direction);
+	
+	/// A node of a bounding volume hierarchy. Nodes are stored depth first, so the first child of an internal node immediately follows it.
+	struct HierarchyNode {
+		float min[3], max[3];
+		
+		/// For a leaf, the first primitive, otherwise the index of the second child.
+		std::uint32_t offset;
+		
+		/// For a leaf, the number of primitives, otherwise 0.
+		std::uint32_t count;
+	};
+	
+	/// A bounding volume hierarchy over the triangles of a model, used to find exact hits. It is either built when the model is loaded, or baked into the model's .armesh file.
+	class TriangleHierarchy {
+		protected:
+			const HierarchyNode * m_nodes;
+			std::size_t m_nodeCount;
+			
+			/// The positions of the three vertices of each triangle, in the order the leaves refer to them.
+			const float * m_triangles;
+			std::size_t m_triangleCount;
+			
+			/// The nodes and triangles of a hierarchy which was built rather than assigned.
+			std::vector<HierarchyNode> m_nodeStorage;
+			std::vector<float> m_triangleStorage;
+		
+		public:
+			TriangleHierarchy ();
+			
+			void build (const std::vector<MeshBuffer> & meshes);
+			
+			/// Refer to a hierarchy which was built elsewhere, e.g. mapped from an .armesh file, which must outlive this one. There are 9 floats for each triangle.
+			/// @returns false if the nodes don't form a valid hierarchy over the triangles, in which case the hierarchy is empty.
+			bool assign (const HierarchyNode * nodes, std::size_t nodeCount, const float * triangles, std::size_t triangleCount);
+			
+			void clear ();
+			
+			bool empty () const { return m_nodeCount == 0; }
+			std::size_t triangleCount () const { return m_triangleCount; }
+			
+			const HierarchyNode * nodes () const { return m_nodes; }
+			std::size_t nodeCount () const { return m_nodeCount; }
+			const float * triangles () const { return m_triangles; }
+			
+			/// Find the nearest triangle hit by <tt>origin + direction * t</tt> where <tt>0 <= t <= maximum</tt>. Both sides of each triangle are considered.
+			/// @returns true if a triangle was hit, in which case maximum is updated to its t.
+			bool intersect (const float * origin, const float * direction, float & maximum) const;
+			
+			/// The size of a hierarchy which was built. An assigned hierarchy is owned by whoever assigned it.
+			std::size_t residentSize () const;
+		
+		private:
+			/// The nodes and triangles may refer to the storage, so the hierarchy can't be copied.
+			TriangleHierarchy (const TriangleHierarchy &);
+			TriangleHierarchy & operator= (const TriangleHierarchy &);
+	};
+	
+	/// A bounding volume hierarchy over the objects in the scene, which is updated every frame and used to find the object hit by a ray. Objects which have a TriangleHierarchy are hit exactly, otherwise their bounding box is used.
+	class InstanceHierarchy {
+		public:
+			struct Instance {
+				/// The bounding box in world space.
+				float min[3], max[3];
+				
+				/// The column-major transform from object space to world space.
+				float transform[16];
+				
+				/// The triangles of the object in object space, may be NULL.
+				const TriangleHierarchy * triangles;
+				
+				void * handle;
+			};
+			
+			struct Hit {
+				void * handle;
+				
+				/// The distance along the ray, in units of the ray direction.
+				float distance;
+			};
+		
+		protected:
+			std::vector<Instance> m_instances;
+			std::vector<HierarchyNode> m_nodes;
+			std::vector<std::uint32_t> m_order;
+			
+			/// The inverse of each transform as a 3x4 row-major matrix, used to transform rays into object space. Instances whose transform isn't invertible are hit using their bounding box.
+			std::vector<float> m_inverses;
+			std::vector<std::uint8_t> m_invertible;
+			
+			void updateInverses ();
+		
+		public:
+			/// Add or modify instances, then call build() or refit().
+			std::vector<Instance> & instances () { return m_instances; }
+			const std::vector<Instance> & instances () const { return m_instances; }
+			
+			/// Build the hierarchy from scratch, which is required after instances are added or removed.
+			void build ();
+			
+			/// Update the bounds of the existing hierarchy after instances have moved. This is faster than building, but the hierarchy becomes less efficient as instances move further from where they were when it was built.
+			void refit ();
+			
+			void clear ();
+			
+			/// Find the nearest instance hit by <tt>origin + direction * t</tt> where <tt>0 <= t <= maximum</tt>.
+			bool pick (const float * origin, const float * direction, float maximum, Hit & hit) const;
+	};
+}
+
+#endif
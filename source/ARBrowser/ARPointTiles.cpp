@@ -0,0 +1,516 @@
+//
+//  ARPointTiles.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARPointTiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+namespace ARBrowser {
+	static_assert(sizeof(PointTilesHeader) == 64, "PointTilesHeader must match the file format");
+	static_assert(sizeof(PointTileRecord) == 16, "PointTileRecord must match the file format");
+	static_assert(sizeof(PointRecord) == 24, "PointRecord must match the file format");
+	
+	static const char POINT_TILES_MAGIC[8] = {'A', 'R', 'P', 'O', 'I', 0, 0, 0};
+	
+	static const double D2R = M_PI / 180.0;
+	
+	/// The radius used for distance calculations, in meters, the same as SpatialIndex::RADIUS.
+	static const double RADIUS = 6378137.0;
+	
+	/// The latitude at which the web mercator projection is square.
+	static const double MAXIMUM_LATITUDE = 85.0511287798;
+	
+	/// Coordinates are stored in units of 1e-7 degrees.
+	static const double COORDINATE_SCALE = 1e7;
+	
+	/// The velocity is smoothed over about this many seconds, and forgotten if there is no update for longer than the maximum interval.
+	static const double MOTION_TIME_CONSTANT = 2.0;
+	static const double MOTION_MAXIMUM_INTERVAL = 10.0;
+	
+	/// The prefetched tiles are forgotten after this many, e.g. if the viewer turns back, so that they are advised again.
+	static const std::size_t MAXIMUM_PREFETCHED = 4096;
+	
+	void pointTile (double latitude, double longitude, std::uint32_t zoom, std::uint32_t & x, std::uint32_t & y) {
+		const std::uint32_t n = 1u << zoom;
+		
+		latitude = std::max(-MAXIMUM_LATITUDE, std::min(MAXIMUM_LATITUDE, latitude));
+		
+		double column = std::floor((longitude + 180.0) / 360.0 * n);
+		double sine = std::sin(latitude * D2R);
+		double row = std::floor((0.5 - std::log((1.0 + sine) / (1.0 - sine)) / (4.0 * M_PI)) * n);
+		
+		// Longitudes wrap around, e.g. 180 is the same as -180:
+		std::int64_t wrapped = (std::int64_t)column % (std::int64_t)n;
+		if (wrapped < 0) wrapped += n;
+		
+		x = (std::uint32_t)wrapped;
+		y = (std::uint32_t)std::max(0.0, std::min(row, n - 1.0));
+	}
+	
+	std::uint64_t pointTileQuadkey (std::uint32_t x, std::uint32_t y) {
+		std::uint64_t quadkey = 0;
+		
+		for (std::size_t i = 0; i < 32; i += 1) {
+			quadkey |= (std::uint64_t)((x >> i) & 1) << (2 * i);
+			quadkey |= (std::uint64_t)((y >> i) & 1) << (2 * i + 1);
+		}
+		
+		return quadkey;
+	}
+	
+	void pointTileCoordinates (std::uint64_t quadkey, std::uint32_t & x, std::uint32_t & y) {
+		x = y = 0;
+		
+		for (std::size_t i = 0; i < 32; i += 1) {
+			x |= (std::uint32_t)((quadkey >> (2 * i)) & 1) << i;
+			y |= (std::uint32_t)((quadkey >> (2 * i + 1)) & 1) << i;
+		}
+	}
+	
+	namespace {
+		/// Accumulates null terminated strings, storing each distinct string once.
+		struct StringTable {
+			std::string data;
+			std::unordered_map<std::string, std::uint32_t> offsets;
+			
+			std::uint32_t insert (const std::string & value) {
+				auto existing = offsets.find(value);
+				
+				if (existing != offsets.end())
+					return existing->second;
+				
+				std::uint32_t offset = (std::uint32_t)data.size();
+				
+				data.append(value.c_str(), std::strlen(value.c_str()) + 1);
+				offsets[value] = offset;
+				
+				return offset;
+			}
+		};
+	}
+	
+	bool writePointTiles (const std::string & path, const std::vector<PointDescription> & points, std::uint32_t zoom) {
+		if (zoom < 1 || zoom > 24) {
+			std::cerr << "Point tiles zoom level " << zoom << " is not between 1 and 24!" << std::endl;
+			
+			return false;
+		}
+		
+		// The tiles are chosen from the stored coordinates, so that rounding can't move a point out of its tile:
+		std::vector<PointRecord> records(points.size());
+		std::vector<std::pair<std::uint64_t, std::uint32_t>> order(points.size());
+		
+		for (std::size_t i = 0; i < points.size(); i += 1) {
+			PointRecord & record = records[i];
+			
+			// Wrapped into -180 to 180, since the tiles wrap around:
+			double longitude = std::fmod(points[i].longitude + 180.0, 360.0);
+			if (longitude < 0) longitude += 360.0;
+			
+			record.latitude = (std::int32_t)std::lround(std::max(-90.0, std::min(90.0, points[i].latitude)) * COORDINATE_SCALE);
+			record.longitude = (std::int32_t)std::lround((longitude - 180.0) * COORDINATE_SCALE);
+			record.altitude = points[i].altitude;
+			
+			std::uint32_t x, y;
+			pointTile(record.latitude / COORDINATE_SCALE, record.longitude / COORDINATE_SCALE, zoom, x, y);
+			
+			order[i] = std::make_pair(pointTileQuadkey(x, y), (std::uint32_t)i);
+		}
+		
+		// Sort the points by tile, keeping the points of each tile in their original order:
+		std::sort(order.begin(), order.end());
+		
+		std::vector<PointTileRecord> tiles;
+		std::vector<PointRecord> sorted(points.size());
+		StringTable strings;
+		
+		for (std::size_t i = 0; i < order.size(); i += 1) {
+			if (tiles.empty() || tiles.back().quadkey != order[i].first) {
+				PointTileRecord tile = {order[i].first, (std::uint32_t)i, 0};
+				tiles.push_back(tile);
+			}
+			
+			tiles.back().recordCount += 1;
+			
+			const PointDescription & point = points[order[i].second];
+			PointRecord & record = sorted[i];
+			
+			record = records[order[i].second];
+			record.title = strings.insert(point.title);
+			record.subtitle = strings.insert(point.subtitle);
+			record.category = strings.insert(point.category);
+		}
+		
+		if (strings.data.size() > 0xFFFFFFFFu) {
+			std::cerr << "Point tiles string table is too large!" << std::endl;
+			
+			return false;
+		}
+		
+		PointTilesHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, POINT_TILES_MAGIC, sizeof(header.magic));
+		
+		header.version = POINT_TILES_VERSION;
+		header.zoom = zoom;
+		header.tileCount = (std::uint32_t)tiles.size();
+		header.recordCount = (std::uint32_t)records.size();
+		header.stringTableSize = (std::uint32_t)strings.data.size();
+		
+		// Every section is a multiple of 8 bytes, except the string table at the end, so no padding is needed:
+		header.tileTableOffset = sizeof(PointTilesHeader);
+		header.recordOffset = header.tileTableOffset + sizeof(PointTileRecord) * tiles.size();
+		header.stringTableOffset = header.recordOffset + sizeof(PointRecord) * records.size();
+		header.fileSize = header.stringTableOffset + strings.data.size();
+		
+		std::FILE * file = std::fopen(path.c_str(), "wb");
+		
+		if (!file) {
+			std::cerr << "Couldn't open " << path << " for writing!" << std::endl;
+			
+			return false;
+		}
+		
+		bool success = std::fwrite(&header, sizeof(header), 1, file) == 1;
+		
+		if (!tiles.empty())
+			success = success && std::fwrite(tiles.data(), sizeof(PointTileRecord) * tiles.size(), 1, file) == 1;
+		
+		if (!sorted.empty())
+			success = success && std::fwrite(sorted.data(), sizeof(PointRecord) * sorted.size(), 1, file) == 1;
+		
+		if (!strings.data.empty())
+			success = success && std::fwrite(strings.data.data(), strings.data.size(), 1, file) == 1;
+		
+		success = (std::fclose(file) == 0) && success;
+		
+		if (!success) {
+			std::cerr << "Couldn't write " << path << "!" << std::endl;
+			std::remove(path.c_str());
+		}
+		
+		return success;
+	}
+	
+	MotionEstimate::MotionEstimate () : m_time(0), m_latitude(0), m_longitude(0), m_east(0), m_north(0), m_valid(false) {
+	}
+	
+	void MotionEstimate::update (double time, double latitude, double longitude) {
+		if (m_valid) {
+			double interval = time - m_time;
+			
+			// Locations at the same time don't say anything about the velocity:
+			if (interval <= 0)
+				return;
+			
+			if (interval <= MOTION_MAXIMUM_INTERVAL) {
+				double deltaLongitude = longitude - m_longitude;
+				
+				if (deltaLongitude > 180.0) deltaLongitude -= 360.0;
+				else if (deltaLongitude < -180.0) deltaLongitude += 360.0;
+				
+				double north = (latitude - m_latitude) * D2R * RADIUS / interval;
+				double east = deltaLongitude * D2R * RADIUS * std::cos(latitude * D2R) / interval;
+				
+				double weight = 1.0 - std::exp(-interval / MOTION_TIME_CONSTANT);
+				
+				m_east += (east - m_east) * weight;
+				m_north += (north - m_north) * weight;
+			} else {
+				m_east = m_north = 0;
+			}
+		}
+		
+		m_time = time;
+		m_latitude = latitude;
+		m_longitude = longitude;
+		m_valid = true;
+	}
+	
+	PointTiles::PointTiles () : m_header(NULL), m_tiles(NULL), m_records(NULL) {
+		resetStatistics();
+	}
+	
+	bool PointTiles::open (const std::string & path) {
+		close();
+		
+		if (!m_file.open(path))
+			return false;
+		
+		// Only the tiles near the viewer are read, so reading ahead, even while validating the tile table, would mostly read tiles which aren't needed:
+		m_file.adviseRandom();
+		
+		if (!validate(path)) {
+			close();
+			
+			return false;
+		}
+		
+		return true;
+	}
+	
+	void PointTiles::close () {
+		m_file.close();
+		
+		m_header = NULL;
+		m_tiles = NULL;
+		m_records = NULL;
+		
+		m_visited.clear();
+		m_previouslyVisited.clear();
+		m_prefetched.clear();
+	}
+	
+	bool PointTiles::validate (const std::string & path) {
+		const std::uint64_t size = m_file.size();
+		
+		if (size < sizeof(PointTilesHeader)) {
+			std::cerr << "Point tiles " << path << " is truncated!" << std::endl;
+			return false;
+		}
+		
+		const PointTilesHeader * header = (const PointTilesHeader *)m_file.begin();
+		
+		if (std::memcmp(header->magic, POINT_TILES_MAGIC, sizeof(header->magic)) != 0) {
+			std::cerr << "Point tiles " << path << " is not a .arpoi file!" << std::endl;
+			return false;
+		}
+		
+		if (header->version != POINT_TILES_VERSION) {
+			std::cerr << "Point tiles " << path << " has unsupported version " << header->version << "!" << std::endl;
+			return false;
+		}
+		
+		std::uint64_t tilesEnd = header->tileTableOffset + (std::uint64_t)sizeof(PointTileRecord) * header->tileCount;
+		std::uint64_t recordsEnd = header->recordOffset + (std::uint64_t)sizeof(PointRecord) * header->recordCount;
+		std::uint64_t stringsEnd = header->stringTableOffset + header->stringTableSize;
+		
+		bool valid = header->zoom >= 1 && header->zoom <= 24
+			&& header->fileSize == size
+			&& (header->tileTableOffset % alignof(PointTileRecord)) == 0
+			&& (header->recordOffset % alignof(PointRecord)) == 0
+			&& tilesEnd <= size && recordsEnd <= size && stringsEnd <= size
+			&& (header->stringTableSize == 0 || m_file.begin()[stringsEnd - 1] == '\0');
+		
+		if (!valid) {
+			std::cerr << "Point tiles " << path << " is corrupt!" << std::endl;
+			return false;
+		}
+		
+		// The tile table is small, and is read by every query, so it is checked completely. The records are checked as they are read, so that opening the file doesn't read all of them:
+		const PointTileRecord * tiles = (const PointTileRecord *)(m_file.begin() + header->tileTableOffset);
+		std::uint64_t next = 0;
+		
+		for (std::size_t i = 0; i < header->tileCount; i += 1) {
+			valid = tiles[i].firstRecord == next
+				&& (i == 0 || tiles[i].quadkey > tiles[i - 1].quadkey)
+				&& (tiles[i].quadkey >> (2 * header->zoom)) == 0;
+			
+			if (!valid) {
+				std::cerr << "Point tiles " << path << " has corrupt tile " << i << "!" << std::endl;
+				return false;
+			}
+			
+			next += tiles[i].recordCount;
+		}
+		
+		if (next != header->recordCount) {
+			std::cerr << "Point tiles " << path << " has " << next << " records in its tiles, but " << header->recordCount << " records!" << std::endl;
+			return false;
+		}
+		
+		m_header = header;
+		m_tiles = tiles;
+		m_records = (const PointRecord *)(m_file.begin() + header->recordOffset);
+		
+		return true;
+	}
+	
+	const char * PointTiles::string (std::uint32_t offset) const {
+		if (offset >= m_header->stringTableSize)
+			return "";
+		
+		return m_file.begin() + m_header->stringTableOffset + offset;
+	}
+	
+	std::int64_t PointTiles::findTile (std::uint64_t quadkey) const {
+		const PointTileRecord * end = m_tiles + m_header->tileCount;
+		
+		const PointTileRecord * tile = std::lower_bound(m_tiles, end, quadkey, [](const PointTileRecord & tile, std::uint64_t quadkey) {
+			return tile.quadkey < quadkey;
+		});
+		
+		if (tile == end || tile->quadkey != quadkey)
+			return -1;
+		
+		return tile - m_tiles;
+	}
+	
+	void PointTiles::tilesWithinDistance (double latitude, double longitude, double distance, std::vector<std::uint32_t> & tiles) const {
+		const std::uint32_t tileCount = m_header->tileCount;
+		const std::int64_t n = (std::int64_t)1 << m_header->zoom;
+		
+		if (tileCount == 0)
+			return;
+		
+		// The angle subtended by the distance at the center of the earth:
+		double angle = distance / RADIUS;
+		
+		double minimumLatitude = latitude - angle / D2R, maximumLatitude = latitude + angle / D2R;
+		bool everyLongitude = angle >= M_PI || minimumLatitude <= -90.0 || maximumLatitude >= 90.0;
+		double longitudeRange = 0;
+		
+		if (!everyLongitude) {
+			// The widest part of the search area is at the latitude closest to the pole:
+			double widest = std::max(std::fabs(minimumLatitude), std::fabs(maximumLatitude)) * D2R;
+			double ratio = std::sin(angle) / std::cos(widest);
+			
+			if (ratio >= 1.0)
+				everyLongitude = true;
+			else
+				longitudeRange = std::asin(ratio) / D2R;
+		}
+		
+		std::uint32_t x, firstRow, lastRow;
+		pointTile(std::min(maximumLatitude, 90.0), longitude, m_header->zoom, x, firstRow);
+		pointTile(std::max(minimumLatitude, -90.0), longitude, m_header->zoom, x, lastRow);
+		
+		std::int64_t firstColumn = 0, columnCount = n;
+		
+		if (!everyLongitude) {
+			firstColumn = (std::int64_t)std::floor((longitude - longitudeRange + 180.0) / 360.0 * n);
+			std::int64_t lastColumn = (std::int64_t)std::floor((longitude + longitudeRange + 180.0) / 360.0 * n);
+			
+			columnCount = std::min(lastColumn - firstColumn + 1, n);
+			firstColumn = ((firstColumn % n) + n) % n;
+		}
+		
+		std::uint64_t rowCount = lastRow - firstRow + 1;
+		
+		if (rowCount * columnCount <= tileCount) {
+			for (std::uint32_t row = firstRow; row <= lastRow; row += 1) {
+				for (std::int64_t i = 0; i < columnCount; i += 1) {
+					std::int64_t tile = findTile(pointTileQuadkey((std::uint32_t)((firstColumn + i) % n), row));
+					
+					if (tile >= 0)
+						tiles.push_back((std::uint32_t)tile);
+				}
+			}
+		} else {
+			// The search area covers more tiles than have points, so it is faster to check every tile:
+			for (std::uint32_t i = 0; i < tileCount; i += 1) {
+				std::uint32_t column, row;
+				pointTileCoordinates(m_tiles[i].quadkey, column, row);
+				
+				if (row >= firstRow && row <= lastRow && (((std::int64_t)column - firstColumn + n) % n) < columnCount)
+					tiles.push_back(i);
+			}
+		}
+	}
+	
+	void PointTiles::query (double latitude, double longitude, double distance, std::vector<std::uint32_t> & results) {
+		m_statistics.queries += 1;
+		
+		m_visited.clear();
+		tilesWithinDistance(latitude, longitude, distance, m_visited);
+		
+		double lat = latitude * D2R, lon = longitude * D2R;
+		double x = std::cos(lat) * std::cos(lon), y = std::cos(lat) * std::sin(lon), z = std::sin(lat);
+		
+		// Points within the distance have a dot product with the origin of at least this, as in SpatialIndex::query:
+		double angle = distance / RADIUS;
+		double threshold = angle >= M_PI ? -2.0 : std::cos(angle);
+		
+		const double scale = D2R / COORDINATE_SCALE;
+		
+		// Most points are clearly inside or outside, which is decided by their distance on a flat map around the viewer. The map is stretched by up to the tangent of the latitude times the angle across the search area, so only points near the edge need to be tested exactly:
+		double widest = std::fabs(latitude) + angle / D2R;
+		double tolerance = widest < 89.0 ? 1.0 + distance * (0.001 + angle * (2.0 + 2.0 * std::tan(widest * D2R))) : distance;
+		double inside = std::max(0.0, distance - tolerance), outside = distance + tolerance;
+		
+		const std::int64_t originLatitude = std::llround(latitude * COORDINATE_SCALE), originLongitude = std::llround(longitude * COORDINATE_SCALE);
+		const double northScale = RADIUS * scale, eastScale = northScale * std::cos(lat);
+		const std::int64_t FULL_CIRCLE = (std::int64_t)(360 * COORDINATE_SCALE);
+		
+		for (std::uint32_t tileIndex : m_visited) {
+			const PointTileRecord & tile = m_tiles[tileIndex];
+			const PointRecord * record = m_records + tile.firstRecord;
+			
+			for (std::uint32_t i = 0; i < tile.recordCount; i += 1, record += 1) {
+				std::int64_t deltaLongitude = record->longitude - originLongitude;
+				
+				if (deltaLongitude > FULL_CIRCLE / 2) deltaLongitude -= FULL_CIRCLE;
+				else if (deltaLongitude < -FULL_CIRCLE / 2) deltaLongitude += FULL_CIRCLE;
+				
+				double north = (record->latitude - originLatitude) * northScale, east = deltaLongitude * eastScale;
+				double squared = north * north + east * east;
+				
+				if (squared > outside * outside)
+					continue;
+				
+				if (squared > inside * inside) {
+					double pointLatitude = record->latitude * scale, pointLongitude = record->longitude * scale;
+					double c = std::cos(pointLatitude);
+					
+					if (c * std::cos(pointLongitude) * x + c * std::sin(pointLongitude) * y + std::sin(pointLatitude) * z < threshold)
+						continue;
+				}
+				
+				results.push_back(tile.firstRecord + i);
+			}
+			
+			m_statistics.recordsTested += tile.recordCount;
+			
+			// Tiles which the previous query didn't visit had to be read, unless they were prefetched:
+			if (!std::binary_search(m_previouslyVisited.begin(), m_previouslyVisited.end(), tileIndex)) {
+				if (m_prefetched.erase(tileIndex))
+					m_statistics.prefetchHits += 1;
+				else
+					m_statistics.prefetchMisses += 1;
+			}
+		}
+		
+		m_statistics.tilesVisited += m_visited.size();
+		
+		std::sort(m_visited.begin(), m_visited.end());
+		m_previouslyVisited.swap(m_visited);
+	}
+	
+	void PointTiles::prefetch (double latitude, double longitude, double distance, double east, double north, double time) {
+		double predictedLatitude = latitude + (north * time / RADIUS) / D2R;
+		double predictedLongitude = longitude + (east * time / (RADIUS * std::max(std::cos(latitude * D2R), 1e-6))) / D2R;
+		
+		if (m_prefetched.size() > MAXIMUM_PREFETCHED)
+			m_prefetched.clear();
+		
+		m_visited.clear();
+		tilesWithinDistance(std::max(-90.0, std::min(90.0, predictedLatitude)), predictedLongitude, distance, m_visited);
+		
+		for (std::uint32_t tileIndex : m_visited) {
+			// Tiles which the last query visited are already in memory:
+			if (std::binary_search(m_previouslyVisited.begin(), m_previouslyVisited.end(), tileIndex))
+				continue;
+			
+			if (!m_prefetched.insert(tileIndex).second)
+				continue;
+			
+			const PointTileRecord & tile = m_tiles[tileIndex];
+			m_file.adviseWillNeed(m_header->recordOffset + (std::uint64_t)sizeof(PointRecord) * tile.firstRecord, sizeof(PointRecord) * tile.recordCount);
+			
+			m_statistics.tilesPrefetched += 1;
+		}
+	}
+	
+	void PointTiles::resetStatistics () {
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+	}
+}
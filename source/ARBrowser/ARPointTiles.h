@@ -0,0 +1,178 @@
+//
+//  ARPointTiles.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_POINT_TILES_H
+#define _ARBROWSER_POINT_TILES_H
+
+#include "ARMappedFile.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace ARBrowser {
+	/**
+	 * The .arpoi format stores points of interest in web mercator tiles, so that a memory mapped file only needs to read the tiles near the viewer.
+	 *
+	 * All values are little endian. The file begins with a PointTilesHeader, followed by tileCount PointTileRecords sorted by quadkey, recordCount PointRecords and the string table. The records of each tile are contiguous, in the same order as the tiles, so tiles which are near each other on the ground are usually near each other in the file. Strings are null terminated, stored once however many records refer to them, and referenced by offset from the start of the table. They are stored in the order they are first used, so the strings of a tile are mostly together.
+	 */
+	
+	const std::uint32_t POINT_TILES_VERSION = 1;
+	
+	struct PointTilesHeader {
+		/// "ARPOI" followed by three null bytes.
+		char magic[8];
+		std::uint32_t version;
+		
+		/// The zoom level of the tiles, i.e. there are 2^zoom tiles in each direction.
+		std::uint32_t zoom;
+		
+		std::uint32_t tileCount;
+		std::uint32_t recordCount;
+		
+		std::uint32_t stringTableSize;
+		std::uint32_t reserved;
+		
+		std::uint64_t tileTableOffset;
+		std::uint64_t recordOffset;
+		std::uint64_t stringTableOffset;
+		
+		std::uint64_t fileSize;
+	};
+	
+	struct PointTileRecord {
+		/// The tile coordinates, with the bits of x and y interleaved.
+		std::uint64_t quadkey;
+		
+		std::uint32_t firstRecord;
+		std::uint32_t recordCount;
+	};
+	
+	struct PointRecord {
+		/// In units of 1e-7 degrees, i.e. about 1cm.
+		std::int32_t latitude, longitude;
+		float altitude;
+		
+		/// Offsets into the string table.
+		std::uint32_t title, subtitle, category;
+	};
+	
+	/// A point to be written to a .arpoi file.
+	struct PointDescription {
+		/// In degrees.
+		double latitude, longitude;
+		float altitude;
+		
+		std::string title, subtitle;
+		
+		/// What kind of point it is, e.g. to choose a model.
+		std::string category;
+	};
+	
+	/// The web mercator tile containing the given location, in degrees. Locations beyond about 85 degrees north or south are in the top or bottom row of tiles.
+	void pointTile (double latitude, double longitude, std::uint32_t zoom, std::uint32_t & x, std::uint32_t & y);
+	
+	std::uint64_t pointTileQuadkey (std::uint32_t x, std::uint32_t y);
+	void pointTileCoordinates (std::uint64_t quadkey, std::uint32_t & x, std::uint32_t & y);
+	
+	/// Write the points to a .arpoi file, in tiles at the given zoom level, which must be between 1 and 24. Level 15 tiles are about 1.2km across at the equator, and less further north or south.
+	/// @returns false if the file could not be written.
+	bool writePointTiles (const std::string & path, const std::vector<PointDescription> & points, std::uint32_t zoom = 15);
+	
+	/// Estimates the velocity of the viewer from successive locations, smoothed over a few seconds.
+	class MotionEstimate {
+		protected:
+			double m_time, m_latitude, m_longitude;
+			
+			/// In meters per second.
+			double m_east, m_north;
+			
+			bool m_valid;
+		
+		public:
+			MotionEstimate ();
+			
+			/// Add a location at the given time, in seconds.
+			void update (double time, double latitude, double longitude);
+			
+			void reset () { m_valid = false; m_east = m_north = 0; }
+			
+			double east () const { return m_east; }
+			double north () const { return m_north; }
+	};
+	
+	/// A memory mapped .arpoi file. Records and strings refer directly to the mapped data, so they are only valid while the file remains open.
+	class PointTiles {
+		public:
+			struct Statistics {
+				std::size_t queries, tilesVisited, recordsTested;
+				
+				/// Tiles which were advised, and tiles which a query visited for the first time, i.e. which weren't visited by the previous query, which had or hadn't been prefetched.
+				std::size_t tilesPrefetched, prefetchHits, prefetchMisses;
+			};
+		
+		protected:
+			MappedFile m_file;
+			
+			const PointTilesHeader * m_header;
+			const PointTileRecord * m_tiles;
+			const PointRecord * m_records;
+			
+			/// The tiles being visited, and the tiles which the last query visited, sorted.
+			std::vector<std::uint32_t> m_visited, m_previouslyVisited;
+			
+			/// Tiles which have been prefetched and not visited since.
+			std::unordered_set<std::uint32_t> m_prefetched;
+			
+			Statistics m_statistics;
+			
+			bool validate (const std::string & path);
+			
+			/// The index of the tile with the given quadkey, or -1 if there are no points in it.
+			std::int64_t findTile (std::uint64_t quadkey) const;
+			
+			/// Append the indices of the tiles which could contain points within the distance of the location.
+			void tilesWithinDistance (double latitude, double longitude, double distance, std::vector<std::uint32_t> & tiles) const;
+		
+		public:
+			PointTiles ();
+			
+			/// Map and validate the given file.
+			/// @returns false if the file does not exist, or is not a valid .arpoi file of a supported version.
+			bool open (const std::string & path);
+			void close ();
+			
+			bool isOpen () const { return m_header != NULL; }
+			
+			std::size_t size () const { return m_header->recordCount; }
+			std::size_t tileCount () const { return m_header->tileCount; }
+			std::uint32_t zoom () const { return m_header->zoom; }
+			
+			const PointRecord & record (std::uint32_t index) const { return m_records[index]; }
+			const char * string (std::uint32_t offset) const;
+			
+			const PointTileRecord & tile (std::uint32_t index) const { return m_tiles[index]; }
+			
+			/// Append the indices of all records within the given great circle distance, in meters, of the given location, in degrees. Results are in no particular order.
+			void query (double latitude, double longitude, double distance, std::vector<std::uint32_t> & results);
+			
+			/// Start reading the tiles within the given distance of where the viewer will be after the given time, moving at the given velocity, in meters per second. Tiles which are already prefetched are skipped.
+			void prefetch (double latitude, double longitude, double distance, double east, double north, double time);
+			
+			/// The number of bytes of the file which are in memory.
+			std::size_t residentSize () const { return m_file.residentSize(); }
+			std::size_t fileSize () const { return m_file.size(); }
+			
+			const Statistics & statistics () const { return m_statistics; }
+			void resetStatistics ();
+	};
+}
+
+#endif
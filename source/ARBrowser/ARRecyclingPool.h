@@ -0,0 +1,94 @@
+//
+//  ARRecyclingPool.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_RECYCLING_POOL_H
+#define _ARBROWSER_RECYCLING_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace ARBrowser {
+	/// Describes how RecyclingPool tells whether anything other than the pool refers to a value. Specialize this for other reference counted pointer types.
+	template <typename PointerT>
+	struct RecyclingTraits;
+	
+	template <typename ValueT>
+	struct RecyclingTraits<std::shared_ptr<ValueT>> {
+		static bool unique (const std::shared_ptr<ValueT> & pointer) { return pointer.use_count() == 1; }
+	};
+	
+	/// Keeps a small number of reference counted values, e.g. image buffers, and hands out one which nobody else refers to instead of allocating a new one. Values are returned to the pool simply by releasing every other reference to them, on any thread.
+	/// The pool itself must only be used from one thread.
+	template <typename PointerT>
+	class RecyclingPool {
+		public:
+			struct Statistics {
+				/// The number of values created and kept for reuse.
+				std::size_t allocations;
+				
+				/// The number of values which were reused.
+				std::size_t reuses;
+				
+				/// The number of values created which weren't kept, because the pool was full.
+				std::size_t overflows;
+			};
+		
+		protected:
+			std::vector<PointerT> m_values;
+			std::size_t m_capacity;
+			
+			Statistics m_statistics;
+		
+		public:
+			/// The capacity is the number of values kept for reuse, which should be the number expected to be in use at once.
+			RecyclingPool (std::size_t capacity = 4) : m_capacity(capacity), m_statistics()
+			{
+				m_values.reserve(capacity);
+			}
+			
+			/// Return a value which nobody else refers to, or create one by calling factory(), which must return a PointerT.
+			template <typename FactoryT>
+			PointerT acquire (FactoryT factory)
+			{
+				for (std::size_t i = 0; i < m_values.size(); i += 1) {
+					if (RecyclingTraits<PointerT>::unique(m_values[i])) {
+						// Whichever thread released the value last has finished with it, and its writes must be visible before we reuse it:
+						std::atomic_thread_fence(std::memory_order_acquire);
+						
+						m_statistics.reuses += 1;
+						return m_values[i];
+					}
+				}
+				
+				PointerT value = factory();
+				
+				if (m_values.size() < m_capacity) {
+					m_statistics.allocations += 1;
+					m_values.push_back(value);
+				} else {
+					m_statistics.overflows += 1;
+				}
+				
+				return value;
+			}
+			
+			/// Release the pool's references to its values, e.g. when the size of the values changes. Values in use are freed once they are released.
+			void clear () { m_values.clear(); }
+			
+			/// The number of values kept for reuse.
+			std::size_t size () const { return m_values.size(); }
+			std::size_t capacity () const { return m_capacity; }
+			
+			const Statistics & statistics () const { return m_statistics; }
+			void resetStatistics () { m_statistics = Statistics(); }
+	};
+}
+
+#endif
@@ -0,0 +1,185 @@
+//
+//  ARRenderBudget.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARRenderBudget.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ARBrowser {
+	RenderBudget::RenderBudget (std::size_t maximumDraws, std::size_t maximumTriangles) : m_maximumDraws(maximumDraws), m_maximumTriangles(maximumTriangles) {
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+	}
+	
+	void RenderBudget::clear () {
+		m_items.clear();
+		m_accepted.clear();
+		m_deferred.clear();
+	}
+	
+	std::uint32_t RenderBudget::add (const Item & item) {
+		m_items.push_back(item);
+		
+		return (std::uint32_t)(m_items.size() - 1);
+	}
+	
+	void RenderBudget::select () {
+		const std::size_t count = m_items.size();
+		
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+		m_statistics.candidates = count;
+		
+		m_accepted.assign(count, 1);
+		m_deferred.clear();
+		
+		std::size_t triangles = 0, largest = 0;
+		
+		for (std::size_t i = 0; i < count; i += 1) {
+			triangles += m_items[i].triangles;
+			largest = std::max<std::size_t>(largest, m_items[i].triangles);
+		}
+		
+		const std::size_t maximumDraws = m_maximumDraws ? m_maximumDraws : count;
+		const std::size_t maximumTriangles = m_maximumTriangles ? m_maximumTriangles : triangles;
+		
+		// In the common case everything fits, and nothing needs to be sorted:
+		if (count <= maximumDraws && triangles <= maximumTriangles) {
+			m_statistics.drawn = count;
+			m_statistics.triangles = triangles;
+			
+			return;
+		}
+		
+		// Required items are always drawn, and the rest are candidates:
+		m_order.resize(count);
+		std::size_t candidates = 0;
+		
+		for (std::size_t i = 0; i < count; i += 1) {
+			const Item & item = m_items[i];
+			
+			Candidate candidate = {item.priority, item.triangles, (std::uint32_t)i};
+			m_order[candidates] = candidate;
+			
+			// Written either way, but only kept if the item isn't required:
+			candidates += !item.required;
+			
+			if (item.required) {
+				m_statistics.drawn += 1;
+				m_statistics.triangles += item.triangles;
+			}
+		}
+		
+		m_order.resize(candidates);
+		
+		// Usually only a few hundred of many candidates are drawn, so rather than ordering all of them, only the chunk with the highest priority is selected and sorted. If some of it didn't fit, the next chunk, twice as large, is selected from what remains. A partial sort scans the rest against a heap of the chunk, which is close to linear when the chunk is small, and was several times faster than nth_element here, as most candidates are small on screen with similar priorities:
+		auto higherPriority = [](const Candidate & a, const Candidate & b) {
+			return a.priority > b.priority;
+		};
+		
+		std::size_t begin = 0, end = m_order.size(), chunk = m_statistics.drawn < maximumDraws ? maximumDraws - m_statistics.drawn : 1;
+		
+		while (begin < end && m_statistics.drawn < maximumDraws) {
+			const std::size_t remaining = m_statistics.triangles < maximumTriangles ? maximumTriangles - m_statistics.triangles : 0;
+			
+			// The triangles remaining only decrease, so candidates which don't fit now never will, and are moved past the end to be deferred:
+			if (remaining < largest) {
+				end = std::partition(m_order.begin() + begin, m_order.begin() + end, [&](const Candidate & candidate) {
+					return candidate.triangles <= remaining;
+				}) - m_order.begin();
+				
+				largest = remaining;
+			}
+			
+			const std::size_t last = begin + std::min(chunk, end - begin);
+			
+			std::partial_sort(m_order.begin() + begin, m_order.begin() + last, m_order.begin() + end, higherPriority);
+			
+			for (; begin < last; begin += 1) {
+				const Candidate & candidate = m_order[begin];
+				
+				if (m_statistics.drawn < maximumDraws && m_statistics.triangles + candidate.triangles <= maximumTriangles) {
+					m_statistics.drawn += 1;
+					m_statistics.triangles += candidate.triangles;
+				} else {
+					defer(candidate.index);
+				}
+			}
+			
+			chunk *= 2;
+		}
+		
+		// Nothing more can be drawn once either limit is reached, and the rest are deferred:
+		for (; begin < m_order.size(); begin += 1)
+			defer(m_order[begin].index);
+		
+		m_statistics.deferred = m_deferred.size();
+		m_statistics.deferredTriangles = triangles - m_statistics.triangles;
+	}
+	
+	void RenderBudget::defer (std::uint32_t index) {
+		m_accepted[index] = 0;
+		m_deferred.push_back(index);
+	}
+	
+	DrawOrder::DrawOrder () {
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+	}
+	
+	void DrawOrder::clear () {
+		m_added.clear();
+		m_positions.clear();
+	}
+	
+	void DrawOrder::add (const Item & item) {
+		m_positions[item.handle] = (std::uint32_t)m_added.size();
+		m_added.push_back(item);
+	}
+	
+	void DrawOrder::sort () {
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+		
+		m_placed.assign(m_added.size(), 0);
+		
+		// Objects which are still drawn keep their order from the last frame, with this frame's distance and index:
+		std::size_t kept = 0;
+		
+		for (std::size_t i = 0; i < m_items.size(); i += 1) {
+			auto position = m_positions.find(m_items[i].handle);
+			
+			if (position == m_positions.end())
+				continue;
+			
+			m_items[kept] = m_added[position->second];
+			m_placed[position->second] = 1;
+			kept += 1;
+		}
+		
+		m_items.resize(kept);
+		m_statistics.kept = kept;
+		
+		// New objects are added after them, in the order they were added:
+		for (std::size_t i = 0; i < m_added.size(); i += 1) {
+			if (!m_placed[i])
+				m_items.push_back(m_added[i]);
+		}
+		
+		m_statistics.added = m_items.size() - kept;
+		
+		// Far to near:
+		for (std::size_t i = 1; i < m_items.size(); i += 1) {
+			const Item item = m_items[i];
+			std::size_t j = i;
+			
+			for (; j > 0 && m_items[j - 1].distance < item.distance; j -= 1)
+				m_items[j] = m_items[j - 1];
+			
+			m_items[j] = item;
+			m_statistics.moves += i - j;
+		}
+	}
+}
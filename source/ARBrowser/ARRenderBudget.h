@@ -0,0 +1,134 @@
+//
+//  ARRenderBudget.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_RENDER_BUDGET_H
+#define _ARBROWSER_RENDER_BUDGET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ARBrowser {
+	/// Limits the number of objects and triangles drawn in a frame. Objects are chosen by priority, e.g. their size on screen, and the rest are deferred until they are more important or the frame is less busy.
+	class RenderBudget {
+		public:
+			struct Item {
+				/// Higher priority items are drawn first.
+				float priority;
+				
+				std::uint32_t triangles;
+				
+				/// Required items, e.g. the selected object, are always drawn, and count against the budget.
+				bool required;
+			};
+			
+			/// A copy of a non-required item and its index, so that selecting candidates only touches what it needs.
+			struct Candidate {
+				float priority;
+				std::uint32_t triangles, index;
+			};
+			
+			struct Statistics {
+				std::size_t candidates, drawn, deferred;
+				std::size_t triangles, deferredTriangles;
+			};
+		
+		protected:
+			std::size_t m_maximumDraws, m_maximumTriangles;
+			
+			std::vector<Item> m_items;
+			std::vector<std::uint8_t> m_accepted;
+			std::vector<Candidate> m_order;
+			std::vector<std::uint32_t> m_deferred;
+			
+			Statistics m_statistics;
+			
+			void defer (std::uint32_t index);
+		
+		public:
+			/// A maximum of zero means there is no limit.
+			RenderBudget (std::size_t maximumDraws = 0, std::size_t maximumTriangles = 0);
+			
+			void setMaximumDraws (std::size_t maximumDraws) { m_maximumDraws = maximumDraws; }
+			void setMaximumTriangles (std::size_t maximumTriangles) { m_maximumTriangles = maximumTriangles; }
+			
+			std::size_t maximumDraws () const { return m_maximumDraws; }
+			std::size_t maximumTriangles () const { return m_maximumTriangles; }
+			
+			/// Remove all items, to start a new frame.
+			void clear ();
+			
+			/// @returns the index of the item.
+			std::uint32_t add (const Item & item);
+			
+			/// Choose which items to draw, highest priority first. An item which doesn't fit is deferred, but lower priority items which do fit are still drawn. Only the items which are considered for drawing are sorted, so the cost is close to linear in the number of items.
+			void select ();
+			
+			bool accepted (std::uint32_t index) const { return m_accepted[index] != 0; }
+			
+			/// The indices of the deferred items, in no particular order.
+			const std::vector<std::uint32_t> & deferred () const { return m_deferred; }
+			
+			const Statistics & statistics () const { return m_statistics; }
+	};
+	
+	/// Keeps the drawn objects ordered far to near from one frame to the next. The drawn set is limited by the render budget and changes little between frames, so objects which are still drawn keep their last order, new objects are added after them, and the order is fixed with an insertion sort. This is close to linear when little has changed, and at worst quadratic in the number of drawn objects, never in the number of visible objects.
+	class DrawOrder {
+		public:
+			struct Item {
+				/// Identifies the object from one frame to the next, e.g. an ARWorldPoint.
+				const void * handle;
+				float distance;
+				
+				/// The index of the object in the caller's list for this frame.
+				std::uint32_t index;
+			};
+			
+			struct Statistics {
+				/// Objects which were also drawn in the last frame, and objects which were not.
+				std::size_t kept, added;
+				/// Places items were moved by the insertion sort.
+				std::size_t moves;
+			};
+		
+		protected:
+			/// The objects drawn in this frame, in the order they were added.
+			std::vector<Item> m_added;
+			
+			/// The position of each object in m_added.
+			std::unordered_map<const void *, std::uint32_t> m_positions;
+			
+			/// Whether each object in m_added has been placed in m_items.
+			std::vector<std::uint8_t> m_placed;
+			
+			/// The drawn objects, far to near, kept between frames.
+			std::vector<Item> m_items;
+			
+			Statistics m_statistics;
+		
+		public:
+			DrawOrder ();
+			
+			/// Remove the objects added in the last frame, keeping their order.
+			void clear ();
+			
+			/// Add an object which is drawn in this frame.
+			void add (const Item & item);
+			
+			/// Order the objects added since clear far to near, starting from the order of the last frame.
+			void sort ();
+			
+			/// The drawn objects, far to near.
+			const std::vector<Item> & items () const { return m_items; }
+			
+			const Statistics & statistics () const { return m_statistics; }
+	};
+}
+
+#endif
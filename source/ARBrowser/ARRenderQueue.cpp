@@ -0,0 +1,225 @@
+//
+//  ARRenderQueue.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARRenderQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace ARBrowser {
+	/// The number of distinct textures and vertex arrays which are given their own group in the sort key. Items beyond these limits share the last group, which only costs extra state changes.
+	static const std::uint32_t TEXTURE_SLOTS = 1 << 15;
+	static const std::uint32_t VERTEX_SLOTS = 1 << 16;
+	
+	/// Used as the current transform when it is unknown.
+	static const std::uint32_t UNKNOWN_TRANSFORM = ~std::uint32_t(0);
+	
+	static void multiply (const float * a, const float * b, float * result) {
+		for (std::size_t i = 0; i < 4; i += 1) {
+			for (std::size_t j = 0; j < 4; j += 1) {
+				float sum = 0;
+				
+				for (std::size_t k = 0; k < 4; k += 1)
+					sum += a[k*4 + i] * b[j*4 + k];
+				
+				result[j*4 + i] = sum;
+			}
+		}
+	}
+	
+	/// The bits of a non-negative float, which have the same order as the float itself.
+	static std::uint32_t depthBits (float depth) {
+		std::uint32_t bits = 0;
+		
+		// Negative depths and NaN are treated as 0:
+		if (depth > 0)
+			std::memcpy(&bits, &depth, sizeof(bits));
+		
+		return bits;
+	}
+	
+	/// A small number identifying the key, in order of first use.
+	template <typename KeyT>
+	static std::uint32_t slot (std::unordered_map<KeyT, std::uint32_t> & slots, KeyT key, std::uint32_t limit) {
+		std::uint32_t next = (std::uint32_t)std::min<std::size_t>(slots.size(), limit - 1);
+		
+		return slots.insert(std::make_pair(key, next)).first->second;
+	}
+	
+	static bool equalColors (const Color4f & a, const Color4f & b) {
+		return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+	}
+	
+	/// Whether the items can be drawn with one instanced draw call.
+	static bool sameState (const DrawItem & a, const DrawItem & b) {
+		return a.mesh == b.mesh && a.texture == b.texture && a.blended == b.blended && equalColors(a.color, b.color);
+	}
+	
+	RenderBackend::~RenderBackend () {
+	}
+	
+	void RenderBackend::begin () {
+	}
+	
+	void RenderBackend::end () {
+	}
+	
+	bool RenderBackend::supportsInstancing () const {
+		return false;
+	}
+	
+	void RenderBackend::drawInstanced (const MeshBuffer & mesh, const float * transforms, std::size_t count) {
+		for (std::size_t i = 0; i < count; i += 1) {
+			setTransform(transforms + i * 16);
+			drawElements(mesh);
+		}
+	}
+	
+	RenderQueue::RenderQueue () : m_sorted(true) {
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+	}
+	
+	void RenderQueue::clear () {
+		m_items.clear();
+		m_transforms.clear();
+		m_order.clear();
+		m_sorted = true;
+	}
+	
+	std::uint32_t RenderQueue::addTransform (const float * matrix) {
+		std::uint32_t index = (std::uint32_t)(m_transforms.size() / 16);
+		
+		m_transforms.insert(m_transforms.end(), matrix, matrix + 16);
+		
+		return index;
+	}
+	
+	void RenderQueue::sort () {
+		m_textureSlots.clear();
+		m_vertexSlots.clear();
+		
+		m_order.resize(m_items.size());
+		
+		for (std::size_t i = 0; i < m_items.size(); i += 1) {
+			const DrawItem & item = m_items[i];
+			
+			std::uint64_t texture = slot(m_textureSlots, item.texture, TEXTURE_SLOTS);
+			std::uint64_t vertices = slot<const void *>(m_vertexSlots, item.mesh->vertexData(), VERTEX_SLOTS);
+			std::uint64_t depth = depthBits(item.depth);
+			
+			std::uint64_t key;
+			
+			if (!item.blended) {
+				// Grouped by state, then front to back:
+				key = (texture << 48) | (vertices << 32) | depth;
+			} else {
+				// After all opaque items, back to front, then grouped by state. The sign bit of the depth is always clear, so it fits in 31 bits:
+				key = (std::uint64_t(1) << 63) | ((0x7FFFFFFF - depth) << 32) | (texture << 16) | vertices;
+			}
+			
+			m_order[i] = std::make_pair(key, (std::uint32_t)i);
+		}
+		
+		std::sort(m_order.begin(), m_order.end());
+		
+		m_sorted = true;
+	}
+	
+	void RenderQueue::submit (RenderBackend & backend, const float * view) {
+		std::memset(&m_statistics, 0, sizeof(m_statistics));
+		m_statistics.items = m_items.size();
+		
+		if (m_items.empty())
+			return;
+		
+		if (!m_sorted)
+			sort();
+		
+		m_modelViews.resize(m_transforms.size());
+		
+		for (std::size_t i = 0; i < m_transforms.size(); i += 16)
+			multiply(view, &m_transforms[i], &m_modelViews[i]);
+		
+		const bool instancing = backend.supportsInstancing();
+		
+		backend.begin();
+		
+		// The current state, which is unknown until the first item has been drawn:
+		bool known = false;
+		bool blending = false;
+		std::uint32_t texture = 0;
+		Color4f color = {1, 1, 1, 1};
+		const void * vertices = NULL;
+		std::uint32_t transform = UNKNOWN_TRANSFORM;
+		
+		for (std::size_t i = 0; i < m_order.size(); ) {
+			const DrawItem & item = m_items[m_order[i].second];
+			
+			if (!known || item.blended != blending) {
+				backend.setBlending(item.blended);
+				blending = item.blended;
+				m_statistics.blendingChanges += 1;
+			}
+			
+			if (!known || item.texture != texture) {
+				backend.setTexture(item.texture);
+				texture = item.texture;
+				m_statistics.textureChanges += 1;
+			}
+			
+			if (!known || !equalColors(item.color, color)) {
+				backend.setColor(item.color);
+				color = item.color;
+				m_statistics.colorChanges += 1;
+			}
+			
+			if (!known || item.mesh->vertexData() != vertices) {
+				backend.setVertices(*item.mesh);
+				vertices = item.mesh->vertexData();
+				m_statistics.vertexChanges += 1;
+			}
+			
+			known = true;
+			
+			// Consecutive items which differ only by transform, i.e. instances of the same model, can be drawn together:
+			std::size_t count = 1;
+			
+			if (instancing) {
+				while (i + count < m_order.size() && sameState(item, m_items[m_order[i + count].second]))
+					count += 1;
+			}
+			
+			if (count > 1) {
+				m_instances.clear();
+				
+				for (std::size_t j = i; j < i + count; j += 1) {
+					const float * modelView = &m_modelViews[m_items[m_order[j].second].transform * 16];
+					m_instances.insert(m_instances.end(), modelView, modelView + 16);
+				}
+				
+				backend.drawInstanced(*item.mesh, m_instances.data(), count);
+				
+				transform = UNKNOWN_TRANSFORM;
+				m_statistics.transformChanges += count;
+			} else {
+				if (item.transform != transform) {
+					backend.setTransform(&m_modelViews[item.transform * 16]);
+					transform = item.transform;
+					m_statistics.transformChanges += 1;
+				}
+				
+				backend.drawElements(*item.mesh);
+			}
+			
+			m_statistics.draws += 1;
+			i += count;
+		}
+		
+		backend.end();
+	}
+}
@@ -0,0 +1,134 @@
+//
+//  ARRenderQueue.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_RENDER_QUEUE_H
+#define _ARBROWSER_RENDER_QUEUE_H
+
+#include "ARMesh.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ARBrowser {
+	/// One mesh of a model to be drawn, with the state it needs.
+	struct DrawItem {
+		const MeshBuffer * mesh;
+		
+		/// The name of the diffuse texture, or 0 if the mesh is untextured.
+		std::uint32_t texture;
+		Color4f color;
+		
+		/// Blended items are drawn after all opaque items, back to front.
+		bool blended;
+		
+		/// The distance from the viewer, which must not be negative.
+		float depth;
+		
+		/// The index returned by RenderQueue::addTransform.
+		std::uint32_t transform;
+	};
+	
+	/// The state changes and draw calls made by RenderQueue::submit. The queue tracks the current state, so a setter is only called when the state actually changes.
+	class RenderBackend {
+		public:
+			virtual ~RenderBackend ();
+			
+			/// Called before the first item is drawn. Until each setter has been called once, the state is unknown.
+			virtual void begin ();
+			
+			/// Called after the last item is drawn, to restore the state expected by other drawing code.
+			virtual void end ();
+			
+			virtual void setBlending (bool enabled) = 0;
+			
+			/// Bind the texture, or disable texturing if it is 0.
+			virtual void setTexture (std::uint32_t texture) = 0;
+			
+			virtual void setColor (const Color4f & color) = 0;
+			
+			/// Set the position, normal and texture coordinate arrays to the vertices of the mesh, which may be quantized.
+			virtual void setVertices (const MeshBuffer & mesh) = 0;
+			
+			/// Set the model-view matrix, in column major order.
+			virtual void setTransform (const float * matrix) = 0;
+			
+			virtual void drawElements (const MeshBuffer & mesh) = 0;
+			
+			/// If true, consecutive items which differ only by transform are drawn with drawInstanced.
+			virtual bool supportsInstancing () const;
+			
+			/// Draw the mesh once for each of count model-view matrices, which are stored consecutively.
+			virtual void drawInstanced (const MeshBuffer & mesh, const float * transforms, std::size_t count);
+	};
+	
+	/// Gathers the meshes to draw in a frame, and draws them in an order which minimises state changes: opaque items are grouped by texture and vertex array and drawn front to back within each group, so that hidden fragments fail the depth test early, then blended items are drawn back to front so that they composite correctly.
+	/// The queue doesn't depend on OpenGL, which is only used by the RenderBackend.
+	class RenderQueue {
+		public:
+			struct Statistics {
+				std::size_t items, draws;
+				
+				std::size_t blendingChanges, textureChanges, colorChanges, vertexChanges, transformChanges;
+				
+				std::size_t stateChanges () const { return blendingChanges + textureChanges + colorChanges + vertexChanges + transformChanges; }
+			};
+		
+		protected:
+			std::vector<DrawItem> m_items;
+			
+			/// 16 floats per transform.
+			std::vector<float> m_transforms;
+			
+			/// The sort key and index of each item, in drawing order after sort().
+			std::vector<std::pair<std::uint64_t, std::uint32_t>> m_order;
+			bool m_sorted;
+			
+			/// Scratch space reused between frames.
+			std::unordered_map<std::uint32_t, std::uint32_t> m_textureSlots;
+			std::unordered_map<const void *, std::uint32_t> m_vertexSlots;
+			std::vector<float> m_modelViews, m_instances;
+			
+			Statistics m_statistics;
+		
+		public:
+			RenderQueue ();
+			
+			/// Remove all items and transforms, keeping the allocated memory for the next frame.
+			void clear ();
+			
+			/// Add a world transform, in column major order, which is shared by the items of one model.
+			/// @returns the index to store in DrawItem::transform.
+			std::uint32_t addTransform (const float * matrix);
+			
+			void add (const DrawItem & item) { m_items.push_back(item); m_sorted = false; }
+			
+			std::size_t size () const { return m_items.size(); }
+			bool empty () const { return m_items.empty(); }
+			
+			/// Order the items for drawing. Called by submit() if needed.
+			void sort ();
+			
+			/// The items in drawing order, after sort().
+			const DrawItem & item (std::size_t index) const { return m_items[m_order[index].second]; }
+			
+			/// Draw all items, skipping redundant state changes. The view matrix is applied to the world transform of each item.
+			void submit (RenderBackend & backend, const float * view);
+			
+			/// The work done by the last call to submit().
+			const Statistics & statistics () const { return m_statistics; }
+		
+		private:
+			RenderQueue (const RenderQueue &);
+			RenderQueue & operator= (const RenderQueue &);
+	};
+}
+
+#endif
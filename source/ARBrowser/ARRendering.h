@@ -10,12 +10,23 @@
 #define _ARBROWSER_RENDERING_H
 
 #include "ARWorldPoint.h"
+#include "ARMesh.h"
+#include "ARBakedMesh.h"
+#include "ARBakedTexture.h"
+#include "ARAssetCache.h"
+#include "ARLevelOfDetail.h"
+#include "ARPicking.h"
+#include "ARFrameProfiler.h"
+#include "ARRenderQueue.h"
+#include "ARHudGeometry.h"
+#include "ARClustering.h"
 
 #include <string>
 #include <vector>
 #include <sstream>
 #include <fstream>
 #include <map>
+#include <memory>
 
 #include <GLKit/GLKit.h>
 
@@ -39,12 +50,15 @@ namespace ARBrowser {
 	/// The size of the compass is fixed from -20 <-> 20.
 	const float RadarDiameter = 40.0;
 	
-	/// Render a ring with radius r around the Z axis.
+	/// Render a ring with radius r around the Z axis, by scaling a shared unit ring.
 	void renderRing (float r);
 	
+	/// Render the grid generated by generateGrid, from shared geometry.
+	void renderGrid ();
+	
 	/// Render a radar using OpenGL at the origin.
-	/// Points are points within the compass, edgePoints are points on the edge of the compass.
-	void renderRadar (VerticesT & points, VerticesT & edgePoints, float pointScale = 1.0);
+	/// Each non-empty bin of the clusters is drawn as one point, larger for bins holding more points. Bins within the maximum distance are drawn in white, and those on the edge of the compass in blue.
+	void renderRadar (const RadarClusters & clusters, float pointScale = 1.0);
     
 	void renderRadarFieldOfView();
 	
@@ -54,27 +68,46 @@ namespace ARBrowser {
 	/// Renders an x,y,z axis at the origin.
 	void renderAxis ();
 	
-	/// Simple representation of 4-component colour.
-	struct Color4f {
-		float r, g, b, a;
-	};
+	/// Renders a bar for each frame, oldest on the left, with the time taken by each stage stacked from the bottom. The bars fill the given size from the origin, in the units of the current projection, and a line is drawn at 60 frames per second.
+	void renderFrameProfile (const FrameSample * samples, std::size_t count, float width, float height);
 	
-	/// The position, texture coordinate and normal of a vertex.
-	struct ObjMeshVertex {
-		Vec3 pos;
-		Vec2 texcoord;
-		Vec3 normal;
-	};
-
-	/// A triangle that can be rendered as part of an object model.
-	struct ObjMeshFace{
-		ObjMeshVertex vertices[3];
+	/// A texture loaded from an image file, which is shared between models using the asset cache.
+	class Texture : public AssetCache::Asset {
+		protected:
+			GLuint m_name;
+			GLuint m_width, m_height;
+			
+			std::size_t m_size;
+			
+		public:
+			/// The size is the number of bytes of texture memory used by every level.
+			Texture (GLuint name, GLuint width, GLuint height, std::size_t size);
+			
+			/// Deletes the texture, so the last reference must be released on the thread which owns the OpenGL context.
+			virtual ~Texture ();
+			
+			GLuint name () const { return m_name; }
+			
+			virtual std::size_t residentSize () const;
 	};
-
-	/// A mesh consists of a list of triangle faces and an associated material
-	struct ObjMesh{
-		std::string material;
-		std::vector<ObjMeshFace> faces;
+	
+	/// The contents of a texture file, read and decoded on a worker thread, so that the thread which owns the OpenGL context only has to upload them.
+	class TextureSource {
+		protected:
+			/// A .artex file made by artex-bake, whose levels are uploaded directly from the mapped file.
+			BakedTexture m_baked;
+			
+			/// Otherwise, the image decoded to RGBA8, without premultiplying the colour by alpha.
+			TextureImage m_image;
+			
+		public:
+			/// Maps the baked texture next to the image if there is one, otherwise decodes the image. May be called on any thread.
+			/// @returns false if neither could be read.
+			bool load (const std::string & path);
+			
+			/// Upload every level of the baked texture, using PVRTC if the device supports it, otherwise the uncompressed levels, or the decoded image. Must be called on the thread which owns the OpenGL context.
+			/// @returns NULL if nothing was loaded or the baked texture has no format supported by the device.
+			std::shared_ptr<Texture> upload () const;
 	};
 	
 	/// A material references any required textures for rendering.
@@ -95,7 +128,37 @@ namespace ARBrowser {
 		std::string diffuseMapPath;
 		
 		/// The actual reference to the loaded texture.
-		GLKTextureInfo * diffuseMapTexture;
+		std::shared_ptr<Texture> diffuseMapTexture;
+		
+		/// The diffuse map read by Model::readTextures, until it is uploaded.
+		std::shared_ptr<TextureSource> diffuseMapSource;
+	};
+	
+	/// Draws a RenderQueue using OpenGL ES 1, which doesn't support instancing. The model-view matrix is saved by begin() and restored by end().
+	class GLRenderBackend : public RenderBackend {
+		protected:
+			std::uint32_t m_texture;
+			
+			/// The decoding of the current vertices, if they are quantized, which is applied after the current transform.
+			const VertexDecode * m_decode;
+			
+			float m_transform[16];
+			bool m_hasTransform;
+			
+			void loadTransform ();
+		
+		public:
+			GLRenderBackend ();
+			
+			virtual void begin ();
+			virtual void end ();
+			
+			virtual void setBlending (bool enabled);
+			virtual void setTexture (std::uint32_t texture);
+			virtual void setColor (const Color4f & color);
+			virtual void setVertices (const MeshBuffer & mesh);
+			virtual void setTransform (const float * matrix);
+			virtual void drawElements (const MeshBuffer & mesh);
 	};
 	
 	/// An aligned bounding box class which provides basic intersection tests.
@@ -146,24 +209,66 @@ namespace ARBrowser {
 		bool intersectsWith(Vec3 origin, Vec3 direction, float & t1, float & t2) const;
 	};
 	
-	/// Main .obj format model loader.
-	class Model {
+	/// Main model loader, which loads <tt>[name].armesh</tt> if it exists, otherwise <tt>[name].obj</tt> and <tt>[name].mtl</tt>.
+	class Model : public AssetCache::Asset {
 		public:
 			typedef std::map<std::string, ObjMaterial> MaterialMapT;
 			
 		protected:
-			std::vector<ObjMesh> m_mesh;
+			/// The meshes to draw, which refer to either m_storage or m_baked.
+			std::vector<MeshBuffer> m_mesh;
+			
+			/// Meshes loaded from an .obj file.
+			std::vector<IndexedMesh> m_storage;
+			
+			/// Meshes mapped from an .armesh file.
+			BakedMesh m_baked;
+			
+			/// Simplified versions of m_mesh, for drawing the model when it is small on screen.
+			LevelOfDetail m_detail;
+			
+			/// The triangles of m_mesh, for picking.
+			TriangleHierarchy m_triangles;
+			
 			MaterialMapT m_materials;
 			BoundingBox m_boundingBox;
 			
+			std::string m_directory;
+			
+			bool loadBakedMesh(std::string path, std::vector<MaterialDescription> & materials);
+			void loadObjMesh(std::string path, std::vector<MaterialDescription> & materials);
+			
 			void updateBoundingBox();
 			
 		public:
+			/// Loads the geometry and materials, which may be done on a background thread.
 			Model (std::string name, std::string directory);
 			
-			void render ();
+			/// Reads and decodes the textures for the materials, which may be done on a background thread after constructing the model.
+			void readTextures ();
+			
+			/// Uploads the textures for the materials, sharing any which are already in the cache. Textures which were not read by readTextures are read now. This must be called on the thread which owns the OpenGL context, before the model is rendered.
+			void loadTextures (AssetCache & cache);
+			
+			/// The size of the vertex and index data. Textures are cached separately.
+			virtual std::size_t residentSize () const;
+			
+			/// Render the model using the given level of detail, where 0 is the original mesh.
+			void render (std::size_t level = 0);
+			
+			/// Add the meshes of the given level of detail to the queue, to be drawn with the given world transform. The model must not be destroyed until the queue has been submitted.
+			void enqueue (RenderQueue & queue, const float * transform, float depth, std::size_t level = 0) const;
+			
+			/// The number of triangles drawn by render(level).
+			std::size_t triangleCount (std::size_t level = 0) const;
+			
+			const LevelOfDetail & detail () const { return m_detail; }
+			const TriangleHierarchy & triangles () const { return m_triangles; }
 			
 			const BoundingBox & boundingBox () const { return m_boundingBox; }
+			
+			/// Whether no meshes were loaded, e.g. because the model's files are missing.
+			bool empty () const { return m_mesh.empty(); }
 	};
 }
 
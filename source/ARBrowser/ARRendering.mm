@@ -7,7 +7,12 @@
 //
 
 #include "ARRendering.h"
+#include "ARObjLoader.h"
+#include "ARFrustum.h"
+
 #include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <iostream>
 
 /**
@@ -36,43 +41,54 @@
 
 namespace ARBrowser {
 	
-	void renderRing (float r) {
-		const unsigned STEPS = 32;
+	/// Draw a range of the shared heads up display geometry, with the current colour or the colour of each vertex.
+	static void renderHud (HudPrimitive primitive, GLenum mode, bool vertexColors = false) {
+		const HudGeometry & geometry = HudGeometry::shared();
+		const HudRange & range = geometry.range(primitive);
 		
-		Vec3 k(r, 0, 0);
-		Mat44 rotation = rotate<Z>(R360 / STEPS);
-
-		VerticesT vertices;
-		for (unsigned i = 0; i < STEPS; i++) {
-			vertices.push_back(k);
-
-			k = rotation * k;
+		glVertexPointer(3, GL_FLOAT, sizeof(HudVertex), geometry.vertices()->position);
+		glEnableClientState(GL_VERTEX_ARRAY);
+		
+		if (vertexColors) {
+			glColorPointer(4, GL_FLOAT, sizeof(HudVertex), geometry.vertices()->color);
+			glEnableClientState(GL_COLOR_ARRAY);
 		}
 		
-		renderVertices(vertices, GL_LINE_LOOP);
+		glDrawArrays(mode, range.first, range.count);
+		
+		if (vertexColors)
+			glDisableClientState(GL_COLOR_ARRAY);
+		
+		glDisableClientState(GL_VERTEX_ARRAY);
+	}
+	
+	void renderRing (float r) {
+		glPushMatrix();
+		glScalef(r, r, 1);
+		
+		renderHud(HUD_RING, GL_LINE_LOOP);
+		
+		glPopMatrix();
+	}
+	
+	void renderGrid () {
+		renderHud(HUD_GRID, GL_LINES);
 	}
     
 	void renderRadarFieldOfView()
 	{
-		VerticesT vertices;
-		vertices.push_back(Vec3(0, 0, 0));
-		vertices.push_back(Vec3(-8, 20, 0));
-		vertices.push_back(Vec3(8, 20, 0));
-		
 		glEnable(GL_BLEND);
 		glBlendFunc(GL_SRC_ALPHA, GL_DST_ALPHA);
 		
 		glColor4f(0.8, 0.8, 0.8, 0.5);
-		renderVertices(vertices, GL_TRIANGLES);
+		renderHud(HUD_RADAR_FIELD_OF_VIEW, GL_TRIANGLES);
 		
 		glDisable(GL_BLEND);
 	}
 	
-	void renderRadar (VerticesT & points, VerticesT & edgePoints, float pointScale) {
+	void renderRadar (const RadarClusters & clusters, float pointScale) {
 		glDisable(GL_DEPTH_TEST);
 		
-		VerticesT ring;
-		
 		glLineWidth(2);
 		glColor4f(0.5, 0.5, 1.0, 1.0);
 		renderRing(5);
@@ -80,40 +96,38 @@ namespace ARBrowser {
 		renderRing(15);
 		renderRing(20);
 		
-		VerticesT vertices;
-		vertices.push_back(Vec3(-20, 0, 0));
-		vertices.push_back(Vec3( 20, 0, 0));
-		vertices.push_back(Vec3(0, -20, 0));
-		vertices.push_back(Vec3(0,  0, 0));
 		glColor4f(1.0, 1.0, 1.0, 0.8);
-		renderVertices(vertices, GL_LINES);
-		
-		vertices.clear();
+		renderHud(HUD_RADAR_CROSSHAIR, GL_LINES);
 		
-		vertices.push_back(Vec3(0,  0, 0));		
-		vertices.push_back(Vec3(0, 20, 0));
 		glColor4f(0.8, 0.8, 1.0, 0.8);
-		renderVertices(vertices, GL_LINES);
+		renderHud(HUD_RADAR_FORWARD, GL_LINES);
 		
 		glLineWidth(3);
 		
-		// Points within compass
-		glPointSize(8.0 * pointScale);
-		glColor4f(0.0, 0.0, 0.0, 1.0);
-		renderVertices(points, GL_POINTS);
-		
-		glPointSize(6.0 * pointScale);
-		glColor4f(1.0, 1.0, 1.0, 1.0);
-		renderVertices(points, GL_POINTS);
-		
-		// Edge points
-		glPointSize(8.0 * pointScale);
-		glColor4f(0.0, 0.0, 0.0, 1.0);
-		renderVertices(edgePoints, GL_POINTS);
-		
-		glPointSize(6.0 * pointScale);
-		glColor4f(0.2, 0.2, 1.0, 1.0);
-		renderVertices(edgePoints, GL_POINTS);
+		// Points within compass, then edge points, with an outline. Bins holding more points are drawn 2 units larger for each size class:
+		for (std::size_t edge = 0; edge < 2; edge += 1) {
+			for (std::size_t sizeClass = 0; sizeClass < RadarClusters::SIZE_CLASSES; sizeClass += 1) {
+				const VerticesT & points = clusters.points(edge, sizeClass);
+				
+				if (points.empty())
+					continue;
+				
+				float size = 6.0 + sizeClass * 2.0;
+				
+				glPointSize((size + 2.0) * pointScale);
+				glColor4f(0.0, 0.0, 0.0, 1.0);
+				renderVertices(points, GL_POINTS);
+				
+				glPointSize(size * pointScale);
+				
+				if (edge)
+					glColor4f(0.2, 0.2, 1.0, 1.0);
+				else
+					glColor4f(1.0, 1.0, 1.0, 1.0);
+				
+				renderVertices(points, GL_POINTS);
+			}
+		}
 		
 		glEnable(GL_DEPTH_TEST);
 		glPointSize(1.0);
@@ -204,43 +218,77 @@ namespace ARBrowser {
 	
 	void renderAxis ()
 	{
-		std::vector<Vec3> vertices;
-		std::vector<Vec4> colors;
-		
-		vertices.push_back(Vec3(0, 0, 0));
-		colors.push_back(Vec4(1.0, 0.0, 0.0, 1.0));
-		
-		vertices.push_back(Vec3(10.0, 0.0, 0.0));
-		colors.push_back(Vec4(1.0, 0.0, 0.0, 1.0));
+		glLineWidth(5.0);
 		
-		vertices.push_back(Vec3(0, 0, 0));
-		colors.push_back(Vec4(0.0, 1.0, 0.0, 1.0));
+		renderHud(HUD_AXIS, GL_LINES, true);
 		
-		vertices.push_back(Vec3(0.0, 10.0, 0.0));
-		colors.push_back(Vec4(0.0, 1.0, 0.0, 1.0));
+		glLineWidth(1.0);
+	}
+
+	void renderFrameProfile (const FrameSample * samples, std::size_t count, float width, float height) {
+		// The colors of the stages after STAGE_FRAME, and then of the time not spent in any of them:
+		static const Vec4 STAGE_COLORS[FRAME_STAGES] = {
+			Vec4(1.0, 1.0, 0.0, 0.8), Vec4(1.0, 0.5, 0.0, 0.8), Vec4(0.0, 1.0, 0.0, 0.8), Vec4(0.0, 1.0, 1.0, 0.8),
+			Vec4(0.0, 0.5, 1.0, 0.8), Vec4(1.0, 0.0, 1.0, 0.8), Vec4(1.0, 0.0, 0.0, 0.8), Vec4(0.5, 0.5, 1.0, 0.8),
+			Vec4(0.5, 0.5, 0.5, 0.8)
+		};
 		
-		vertices.push_back(Vec3(0, 0, 0));
-		colors.push_back(Vec4(0.0, 0.0, 1.0, 1.0));
+		// The full height is two frames at 60 frames per second:
+		const float FRAME_TIME = 1.0 / 60.0;
+		const float scale = height / (FRAME_TIME * 2.0 * 1e9);
+		const float barWidth = width / FrameProfiler::CAPACITY;
 		
-		vertices.push_back(Vec3(0.0, 0.0, 10.0));
-		colors.push_back(Vec4(0.0, 0.0, 1.0, 1.0));
+		VerticesT vertices;
+		std::vector<Vec4> colors;
 		
-		glLineWidth(5.0);
+		for (std::size_t i = 0; i < count; i += 1) {
+			const FrameSample & sample = samples[i];
+			float left = i * barWidth, right = left + barWidth, bottom = 0;
+			std::uint32_t other = sample.stages[STAGE_FRAME];
+			
+			for (std::size_t stage = STAGE_FRAME + 1; stage <= FRAME_STAGES; stage += 1) {
+				std::uint32_t time = other;
+				
+				if (stage < FRAME_STAGES) {
+					time = std::min(sample.stages[stage], other);
+					other -= time;
+				}
+				
+				float top = std::min(bottom + time * scale, height);
+				const Vec4 & color = STAGE_COLORS[stage - 1];
+				
+				const Vec3 corners[6] = {Vec3(left, bottom, 0), Vec3(right, bottom, 0), Vec3(right, top, 0), Vec3(left, bottom, 0), Vec3(right, top, 0), Vec3(left, top, 0)};
+				
+				vertices.insert(vertices.end(), corners, corners + 6);
+				colors.insert(colors.end(), 6, color);
+				
+				bottom = top;
+			}
+		}
 		
-		glColorPointer(4, GL_FLOAT, 0, &colors[0]);
-		glEnableClientState(GL_COLOR_ARRAY);
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 		
-		glVertexPointer(3, GL_FLOAT, 0, &vertices[0]);
-		glEnableClientState(GL_VERTEX_ARRAY);
+		if (!vertices.empty()) {
+			glColorPointer(4, GL_FLOAT, 0, &colors[0]);
+			glEnableClientState(GL_COLOR_ARRAY);
+			
+			renderVertices(vertices, GL_TRIANGLES);
+			
+			glDisableClientState(GL_COLOR_ARRAY);
+		}
 		
-		glDrawArrays(GL_LINES, 0, vertices.size());
+		VerticesT line;
+		line.push_back(Vec3(0, FRAME_TIME * 1e9 * scale, 0));
+		line.push_back(Vec3(width, FRAME_TIME * 1e9 * scale, 0));
 		
-		glDisableClientState(GL_VERTEX_ARRAY);
-		glDisableClientState(GL_COLOR_ARRAY);
+		glColor4f(1.0, 1.0, 1.0, 1.0);
+		renderVertices(line, GL_LINES);
 		
-		glLineWidth(1.0);
+		glDisable(GL_BLEND);
 	}
-
+	
 	void renderBoundingBox(const BoundingBox & box)
 	{
 		// Bounding Box Debug
@@ -270,170 +318,138 @@ namespace ARBrowser {
 		renderVertices(vertices, GL_LINES);
 	}
 	
-	const char * TOKEN_VERTEX_POS = "v";
-	const char * TOKEN_VERTEX_NOR = "vn";
-	const char * TOKEN_VERTEX_TEX = "vt";
-	const char * TOKEN_FACE = "f";
-	const char * TOKEN_USE_MATERIAL = "usemtl";
-	
-	struct _ObjMeshFaceIndex {
-		_ObjMeshFaceIndex() {
-			pos_index[0] = pos_index[1] = pos_index[2] = 0;
-			tex_index[0] = tex_index[1] = tex_index[2] = -1;
-			nor_index[0] = nor_index[1] = nor_index[2] = -1;
-		}
-		
-		std::string material;
-		int pos_index[3];
-		int tex_index[3];
-		int nor_index[3];
-	};
-	
-	/// Call this function to load a model, only loads triangulated meshes.
-	static void loadMesh(std::string filename, std::vector<ObjMesh> & mesh) {
-		std::vector<Vec3> positions;
-		std::vector<Vec2> texcoords;
-		std::vector<Vec3> normals;
-		std::vector<_ObjMeshFaceIndex> faces;
-		std::string currentMaterial = "";
-		
-		unsigned materialCount = 1;
-		
-		/**
-		 * Load file, parse it
-		 * Lines beginning with:
-		 * '#'  are comments can be ignored
-		 * 'v'  are vertices positions (3 floats that can be positive or negative)
-		 * 'vt' are vertices texcoords (2 floats that can be positive or negative)
-		 * 'vn' are vertices normals   (3 floats that can be positive or negative)
-		 * 'f'  are faces, 3 values that contain 3 values which are separated by / and <space>
-		 */
-		
-		std::ifstream filestream;
-		filestream.open(filename.c_str());
-		
-		if (!filestream) {
-			std::cerr << "Couldn't load file: " << filename << std::endl;
-		}
-		
-		// No longer depending on char arrays thanks to: Dale Weiler
-		std::string line_stream;
-		while(std::getline(filestream, line_stream)) {
-			std::stringstream str_stream(line_stream);
-			std::string type_str;
-			str_stream >> type_str;
-			if (type_str == TOKEN_VERTEX_POS) {
-				Vec3 pos;
-				str_stream >> pos[X] >> pos[Y] >> pos[Z];
-				positions.push_back(pos);
-			} else if (type_str == TOKEN_VERTEX_TEX) {
-				Vec2 tex;
-				str_stream >> tex[X] >> tex[Y];
-				// Inverse y coordinates
-				tex[Y] = 1.0 - tex[Y];
-				texcoords.push_back(tex);
-			} else if (type_str == TOKEN_VERTEX_NOR) {
-				Vec3 nor;
-				str_stream >> nor[X] >> nor[Y] >> nor[Z];
-				normals.push_back(nor);
-			} else if (type_str == TOKEN_FACE) {
-				_ObjMeshFaceIndex face_index;
-				face_index.material = currentMaterial;
+	/// Decode the image at the given path to RGBA8 using CoreGraphics, which unlike GLKTextureLoader is safe to use without an OpenGL context.
+	static bool decodeImage (const std::string & path, TextureImage & image) {
+		@autoreleasepool {
+			UIImage * source = [UIImage imageWithContentsOfFile:[NSString stringWithUTF8String:path.c_str()]];
+			CGImageRef sourceImage = source.CGImage;
+			
+			if (!sourceImage) {
+				std::cerr << "Could not load texture " << path << "!" << std::endl;
 				
-				char interrupt;
-				for(int i = 0; i < 3; ++i) {
-					std::string vertex;
-					str_stream >> vertex;
-					
-					std::stringstream vertex_stream;
-					vertex_stream.str(vertex);
-					
-					vertex_stream >> face_index.pos_index[i] >> interrupt >> face_index.tex_index[i] >> interrupt >> face_index.nor_index[i];
-				}
-				faces.push_back(face_index);
-			} else if (type_str == TOKEN_USE_MATERIAL) {
-				str_stream >> currentMaterial;
-				materialCount++;
+				return false;
 			}
-		}
-		// Explicit closing of the file
-		filestream.close();
-		
-		currentMaterial = "";
-		mesh.reserve(materialCount);
-		ObjMesh * currentMesh = NULL;
-		
-		for (size_t i = 0; i < faces.size(); ++i) {
-			ObjMeshFace face;
 			
-			if (currentMesh != NULL && currentMaterial != faces[i].material) {
-				currentMesh = NULL;
-			}
+			image = TextureImage((std::uint32_t)CGImageGetWidth(sourceImage), (std::uint32_t)CGImageGetHeight(sourceImage));
 			
-			if (currentMesh == NULL) {
-				mesh.resize(mesh.size() + 1);
-				currentMesh = &mesh.back();
-				currentMesh->material = faces[i].material;
-				
-				currentMaterial = faces[i].material;				
-			}
+			CGColorSpaceRef colourSpace = CGColorSpaceCreateDeviceRGB();
+			CGContextRef context = CGBitmapContextCreate(image.pixels.data(), image.width, image.height, 8, image.width * 4, colourSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+			CGColorSpaceRelease(colourSpace);
 			
-			for(size_t j = 0; j < 3; ++j) {
-				face.vertices[j].pos = positions[faces[i].pos_index[j] - 1];
-				
-				if (faces[i].tex_index[j] != -1)
-					face.vertices[j].texcoord = texcoords[faces[i].tex_index[j] - 1];
+			if (!context) {
+				std::cerr << "Could not decode texture " << path << "!" << std::endl;
 				
-				if (faces[i].nor_index[j] != -1)
-					face.vertices[j].normal = normals[faces[i].nor_index[j] - 1];
+				return false;
 			}
 			
-			currentMesh->faces.push_back(face);
+			// The first row of the bitmap is the top of the image, as with GLKTextureLoader:
+			CGContextSetBlendMode(context, kCGBlendModeCopy);
+			CGContextDrawImage(context, CGRectMake(0, 0, image.width, image.height), sourceImage);
+			CGContextRelease(context);
 		}
-
-		std::cerr << "Loaded " << faces.size() << " faces..." << std::endl;
-	}
-	
-	static void loadMaterials(std::string filename, Model::MaterialMapT & materials) {
-		std::ifstream filestream;
-		filestream.open(filename.c_str());
-		
-		ObjMaterial * material = NULL;
 		
-		std::string line_stream;
-		while (std::getline(filestream, line_stream)) {
-			std::stringstream str_stream(line_stream);
-			std::string type_str;
-			str_stream >> type_str;
+		// CoreGraphics only draws premultiplied alpha, but GLKTextureLoader left the colour as it was in the file, and models are blended with GL_SRC_ALPHA:
+		for (std::size_t i = 0; i < image.pixels.size(); i += 4) {
+			std::uint8_t * pixel = &image.pixels[i];
 			
-			if (type_str == "newmtl") {
-				std::string name;
-				str_stream >> name;
-				
-				material = &materials[name];
-			} else if (type_str == "Ka" && material) {
-				str_stream >> material->ambient.r >> material->ambient.g >> material->ambient.b;
-				material->ambient.a = 1.0;
-			} else if (type_str == "map_Kd") {
-				std::string map_path;
-				str_stream >> material->diffuseMapPath;
+			if (pixel[3] != 0 && pixel[3] != 255) {
+				for (std::size_t c = 0; c < 3; c += 1)
+					pixel[c] = (std::uint8_t)std::min(255, (pixel[c] * 255 + pixel[3] / 2) / pixel[3]);
 			}
 		}
+		
+		return true;
 	}
 	
-	/// Loads textures from a directory for the given materials.
-	static void loadTextures(std::string directory, Model::MaterialMapT & materials) {
-		for (Model::MaterialMapT::iterator i = materials.begin(); i != materials.end(); i++) {
-			ObjMaterial & material = (*i).second;
+	bool TextureSource::load (const std::string & path) {
+		// A baked texture next to the image is used instead of decoding it:
+		if (m_baked.open(bakedTexturePath(path)))
+			return true;
+		
+		return decodeImage(path, m_image);
+	}
+	
+	/// Every iOS device supports PVRTC, but it is checked in case the context doesn't, e.g. in some versions of the simulator.
+	static bool supportsPVRTC () {
+		const char * extensions = (const char *)glGetString(GL_EXTENSIONS);
+		
+		return extensions && std::strstr(extensions, "GL_IMG_texture_compression_pvrtc") != NULL;
+	}
+	
+	std::shared_ptr<Texture> TextureSource::upload () const {
+		GLuint name = 0;
+		
+		if (!m_baked.isOpen()) {
+			if (m_image.pixels.empty())
+				return nullptr;
 			
-			std::string fullPath = directory + "/" + material.diffuseMapPath;
-			NSString * imagePath = [NSString stringWithCString:fullPath.c_str() encoding:NSUTF8StringEncoding];
-
-			material.diffuseMapTexture = [GLKTextureLoader textureWithContentsOfFile:imagePath options:nil error:nil];
+			glGenTextures(1, &name);
+			glBindTexture(GL_TEXTURE_2D, name);
+			
+			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_image.width, m_image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_image.pixels.data());
+			
+			// The same parameters as GLKTextureLoader without mipmaps:
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+			
+			glBindTexture(GL_TEXTURE_2D, 0);
+			
+			return std::make_shared<Texture>(name, m_image.width, m_image.height, m_image.pixels.size());
+		}
+		
+		const BakedTextureLevel * levels = supportsPVRTC() ? m_baked.levels(BAKED_TEXTURE_PVRTC_4BPP) : NULL;
+		
+		if (!levels)
+			levels = m_baked.levels(BAKED_TEXTURE_RGBA8);
+		
+		if (!levels) {
+			std::cerr << "Baked texture has no format supported by this device!" << std::endl;
+			
+			return nullptr;
+		}
+		
+		std::size_t size = 0;
+		
+		glGenTextures(1, &name);
+		glBindTexture(GL_TEXTURE_2D, name);
+		
+		// The levels are uploaded directly from the mapped file, without decoding an image:
+		for (std::size_t i = 0; i < m_baked.levelCount(); i += 1) {
+			const BakedTextureLevel & level = levels[i];
+			
+			if (level.format == BAKED_TEXTURE_PVRTC_4BPP)
+				glCompressedTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG, level.width, level.height, 0, (GLsizei)level.size, m_baked.data(level));
+			else
+				glTexImage2D(GL_TEXTURE_2D, (GLint)i, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_baked.data(level));
+			
+			size += level.size;
 		}
+		
+		// The same wrapping as GLKTextureLoader, so that baking a texture doesn't change how models look:
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		
+		glBindTexture(GL_TEXTURE_2D, 0);
+		
+		return std::make_shared<Texture>(name, m_baked.width(), m_baked.height(), size);
+	}
+	
+	Texture::Texture (GLuint name, GLuint width, GLuint height, std::size_t size) : m_name(name), m_width(width), m_height(height), m_size(size) {
+	}
+	
+	Texture::~Texture () {
+		glDeleteTextures(1, &m_name);
+	}
+	
+	std::size_t Texture::residentSize () const {
+		return m_size;
 	}
 	
-	ObjMaterial::ObjMaterial () : diffuseMapTexture(NULL)
+	ObjMaterial::ObjMaterial ()
 	{
 		ambient.r = ambient.g = ambient.b = ambient.a = 1.0;
 	}
@@ -447,6 +463,8 @@ namespace ARBrowser {
 	
 	ObjMaterial & ObjMaterial::operator= (const ObjMaterial & other) {
 		this->diffuseMapTexture = other.diffuseMapTexture;
+		this->diffuseMapSource = other.diffuseMapSource;
+		this->diffuseMapPath = other.diffuseMapPath;
 		this->ambient = other.ambient;
 		
 		return *this;
@@ -454,7 +472,7 @@ namespace ARBrowser {
 	
 	void ObjMaterial::enable () {
 		if (diffuseMapTexture) {
-			glBindTexture(GL_TEXTURE_2D, [diffuseMapTexture name]);
+			glBindTexture(GL_TEXTURE_2D, diffuseMapTexture->name());
 			glColor4f(ambient.r, ambient.g, ambient.b, ambient.a);
 		}
 	}
@@ -464,38 +482,330 @@ namespace ARBrowser {
 		glColor4f(1.0, 1.0, 1.0, 1.0);
 	}
 	
-	Model::Model (std::string name, std::string directory) {
+	/// Set the position, normal and texture coordinate arrays. Quantized positions and texture coordinates must also be decoded using the model-view and texture matrices.
+	static void setVertexPointers (const MeshBuffer & mesh) {
+		if (mesh.quantizedVertices) {
+			const QuantizedVertex * vertices = mesh.quantizedVertices;
+			
+			// Byte normals are converted to the range -1 to 1 by OpenGL, but are scaled by the inverse of the decoding, so lighting would need GL_RESCALE_NORMAL:
+			glVertexPointer(3, GL_SHORT, sizeof(QuantizedVertex), vertices[0].pos);
+			glNormalPointer(GL_BYTE, sizeof(QuantizedVertex), vertices[0].normal);
+			glTexCoordPointer(2, GL_SHORT, sizeof(QuantizedVertex), vertices[0].texcoord);
+		} else {
+			const ObjMeshVertex * vertices = mesh.vertices;
+			
+			glVertexPointer(3, GL_FLOAT, sizeof(ObjMeshVertex), (void*)&(vertices[0].pos));
+			glNormalPointer(GL_FLOAT, sizeof(ObjMeshVertex), (void*)&(vertices[0].normal));
+			glTexCoordPointer(2, GL_FLOAT, sizeof(ObjMeshVertex), (void*)&(vertices[0].texcoord));
+		}
+	}
+	
+	/// Load the texture matrix which decodes quantized texture coordinates, or the identity if decode is NULL.
+	static void loadTexcoordDecode (const VertexDecode * decode) {
+		glMatrixMode(GL_TEXTURE);
+		
+		if (decode) {
+			float matrix[16];
+			decode->texcoordMatrix(matrix);
+			glLoadMatrixf(matrix);
+		} else {
+			glLoadIdentity();
+		}
+		
+		glMatrixMode(GL_MODELVIEW);
+	}
+	
+	GLRenderBackend::GLRenderBackend () : m_texture(0), m_decode(NULL), m_hasTransform(false) {
+	}
+	
+	void GLRenderBackend::begin () {
+		glPushMatrix();
+		
+		glEnableClientState(GL_VERTEX_ARRAY);
+		glEnableClientState(GL_NORMAL_ARRAY);
+		
+		// Other drawing code leaves texturing disabled:
+		m_texture = 0;
+		
+		m_decode = NULL;
+		m_hasTransform = false;
+	}
+	
+	void GLRenderBackend::end () {
+		setTexture(0);
+		setBlending(false);
+		
+		glColor4f(1.0, 1.0, 1.0, 1.0);
+		
+		glDisableClientState(GL_VERTEX_ARRAY);
+		glDisableClientState(GL_NORMAL_ARRAY);
+		
+		if (m_decode) {
+			loadTexcoordDecode(NULL);
+			m_decode = NULL;
+		}
+		
+		glPopMatrix();
+	}
+	
+	void GLRenderBackend::setBlending (bool enabled) {
+		if (enabled) {
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		} else {
+			glDisable(GL_BLEND);
+		}
+	}
+	
+	void GLRenderBackend::setTexture (std::uint32_t texture) {
+		if (texture) {
+			if (!m_texture) {
+				glEnable(GL_TEXTURE_2D);
+				glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+			}
+			
+			glBindTexture(GL_TEXTURE_2D, texture);
+		} else if (m_texture) {
+			glBindTexture(GL_TEXTURE_2D, 0);
+			
+			glDisable(GL_TEXTURE_2D);
+			glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+		}
+		
+		m_texture = texture;
+	}
+	
+	void GLRenderBackend::setColor (const Color4f & color) {
+		glColor4f(color.r, color.g, color.b, color.a);
+	}
+	
+	void GLRenderBackend::setVertices (const MeshBuffer & mesh) {
+		// The texture coordinate array is only used while it is enabled:
+		setVertexPointers(mesh);
+		
+		const VertexDecode * decode = mesh.quantizedVertices ? mesh.decode : NULL;
+		
+		if (decode != m_decode) {
+			loadTexcoordDecode(decode);
+			m_decode = decode;
+			
+			// The position decoding is part of the model-view matrix:
+			if (m_hasTransform)
+				loadTransform();
+		}
+	}
+	
+	void GLRenderBackend::loadTransform () {
+		glLoadMatrixf(m_transform);
+		
+		if (m_decode) {
+			float matrix[16];
+			m_decode->positionMatrix(matrix);
+			glMultMatrixf(matrix);
+		}
+	}
+	
+	void GLRenderBackend::setTransform (const float * matrix) {
+		std::copy(matrix, matrix + 16, m_transform);
+		m_hasTransform = true;
+		
+		loadTransform();
+	}
+	
+	void GLRenderBackend::drawElements (const MeshBuffer & mesh) {
+		// 32-bit indices require OES_element_index_uint, which is available on all iOS devices.
+		glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, mesh.indices);
+	}
+	
+	Model::Model (std::string name, std::string directory) : m_directory(directory) {
 		assert(sizeof(Vec2) == (sizeof(float) * 2));
 		assert(sizeof(Vec3) == (sizeof(float) * 3));
 		
-		loadMesh(directory + "/" + name + ".obj", m_mesh);
+		std::string path = directory + "/" + name;
+		std::vector<MaterialDescription> materials;
+		
+		// Prefer the baked mesh, which can be drawn directly from the mapped file:
+		if (!loadBakedMesh(path + ".armesh", materials)) {
+			loadObjMesh(path, materials);
+		}
 		
 		if (m_mesh.size() == 0) {
 			std::cerr << "Mesh " << name << " in directory " << directory << " had 0 faces!" << std::endl;
 		}
 		
-		loadMaterials(directory + "/" + name + ".mtl", m_materials);
-		loadTextures(directory, m_materials);
+		// Baked models normally include both, as building them takes much longer than loading the meshes:
+		if (!m_baked.isOpen() || !m_baked.loadDetail(m_detail)) {
+			// Simplified levels are only useful until their error is a significant fraction of the model's size:
+			m_detail.build(m_mesh, m_boundingBox.radius() * MAXIMUM_DETAIL_ERROR);
+		}
+		
+		if (!m_baked.isOpen() || !m_baked.loadHierarchy(m_triangles)) {
+			m_triangles.build(m_mesh);
+		}
+		
+		for (std::size_t i = 0; i < materials.size(); i++) {
+			ObjMaterial & material = m_materials[materials[i].name];
+			
+			material.ambient = materials[i].ambient;
+			material.diffuseMapPath = materials[i].diffuseMapPath;
+		}
+	}
+	
+	void Model::readTextures () {
+		for (MaterialMapT::iterator i = m_materials.begin(); i != m_materials.end(); i++) {
+			ObjMaterial & material = (*i).second;
+			
+			if (material.diffuseMapPath.empty() || material.diffuseMapSource)
+				continue;
+			
+			// The texture may already be in the cache, but it is read anyway, as it could be evicted before the model is uploaded:
+			std::shared_ptr<TextureSource> source = std::make_shared<TextureSource>();
+			
+			if (source->load(AssetCache::canonicalPath(m_directory + "/" + material.diffuseMapPath)))
+				material.diffuseMapSource = source;
+		}
+	}
+	
+	void Model::loadTextures (AssetCache & cache) {
+		for (MaterialMapT::iterator i = m_materials.begin(); i != m_materials.end(); i++) {
+			ObjMaterial & material = (*i).second;
+			
+			if (material.diffuseMapPath.empty() || material.diffuseMapTexture)
+				continue;
+			
+			std::string path = AssetCache::canonicalPath(m_directory + "/" + material.diffuseMapPath);
+			
+			material.diffuseMapTexture = cache.lookup<Texture>(path);
+			
+			if (!material.diffuseMapTexture) {
+				std::shared_ptr<TextureSource> source = material.diffuseMapSource;
+				
+				if (!source) {
+					source = std::make_shared<TextureSource>();
+					source->load(path);
+				}
+				
+				std::shared_ptr<Texture> texture = source->upload();
+				
+				if (texture)
+					material.diffuseMapTexture = cache.insert(path, texture);
+			}
+			
+			// The decoded image is no longer needed:
+			material.diffuseMapSource.reset();
+		}
+	}
+	
+	std::size_t Model::residentSize () const {
+		std::size_t size = m_detail.residentSize() + m_triangles.residentSize();
+		
+		if (m_baked.isOpen())
+			return size + m_baked.fileSize();
+		
+		for (std::size_t i = 0; i < m_storage.size(); i++) {
+			const IndexedMesh & mesh = m_storage[i];
+			
+			size += mesh.vertices.size() * sizeof(ObjMeshVertex);
+			size += mesh.shortIndices.size() * sizeof(uint16_t) + mesh.longIndices.size() * sizeof(uint32_t);
+		}
+		
+		return size;
+	}
+	
+	bool Model::loadBakedMesh(std::string path, std::vector<MaterialDescription> & materials) {
+		if (!m_baked.open(path))
+			return false;
+		
+		for (std::size_t i = 0; i < m_baked.meshCount(); i++) {
+			m_mesh.push_back(m_baked.mesh(i));
+		}
+		
+		for (std::size_t i = 0; i < m_baked.materialCount(); i++) {
+			materials.push_back(m_baked.material(i));
+		}
+		
+		const float * min = m_baked.boundsMin(), * max = m_baked.boundsMax();
+		m_boundingBox = BoundingBox(Vec3(min[X], min[Y], min[Z]), Vec3(max[X], max[Y], max[Z]));
+		
+		return true;
+	}
+	
+	void Model::loadObjMesh(std::string path, std::vector<MaterialDescription> & materials) {
+		std::vector<ObjMesh> faces;
+		ARBrowser::loadObjMesh(path + ".obj", faces);
+		
+		// Share identical vertices between faces so they can be drawn using an index buffer:
+		m_storage.resize(faces.size());
+		for (std::size_t i = 0; i < faces.size(); i++) {
+			weldMesh(faces[i], m_storage[i]);
+			m_mesh.push_back(m_storage[i].buffer());
+		}
+		
+		loadObjMaterials(path + ".mtl", materials);
+		
 		updateBoundingBox();
 	}
 	
 	void Model::updateBoundingBox() {
 		for (std::size_t i = 0; i < m_mesh.size(); i++) {
-			ObjMesh & mesh = m_mesh[i];
+			const MeshBuffer & mesh = m_mesh[i];
 			
-			for (std::size_t j = 0; j < mesh.faces.size(); j++) {
-				m_boundingBox.add(mesh.faces[j].vertices[0].pos);
-				m_boundingBox.add(mesh.faces[j].vertices[1].pos);
-				m_boundingBox.add(mesh.faces[j].vertices[2].pos);
+			for (std::size_t j = 0; j < mesh.vertexCount; j++) {
+				m_boundingBox.add(mesh.position(j));
 			}
 		}
 	}
 	
-	void Model::render () {		
-		if (m_mesh.size() > 0) {			
-			for (std::size_t i = 0; i < m_mesh.size(); i++) {
-				MaterialMapT::iterator m = m_materials.find(m_mesh[i].material);
-				std::vector<ObjMeshFace> & faces = m_mesh[i].faces;
+	std::size_t Model::triangleCount (std::size_t level) const {
+		if (level < m_detail.levelCount())
+			return m_detail.level(level).triangleCount;
+		
+		std::size_t count = 0;
+		
+		for (std::size_t i = 0; i < m_mesh.size(); i += 1)
+			count += m_mesh[i].indexCount / 3;
+		
+		return count;
+	}
+	
+	void Model::enqueue (RenderQueue & queue, const float * transform, float depth, std::size_t level) const {
+		const std::vector<MeshBuffer> & meshes = (level < m_detail.levelCount()) ? m_detail.level(level).meshes : m_mesh;
+		
+		if (meshes.empty())
+			return;
+		
+		std::uint32_t index = queue.addTransform(transform);
+		
+		for (std::size_t i = 0; i < meshes.size(); i++) {
+			const MeshBuffer & mesh = meshes[i];
+			
+			if (mesh.indexCount == 0)
+				continue;
+			
+			DrawItem item = {&mesh, 0, {1.0, 1.0, 1.0, 1.0}, false, depth, index};
+			MaterialMapT::const_iterator m = m_materials.find(*mesh.material);
+			
+			// As with ObjMaterial::enable, the ambient colour is only used with the diffuse texture:
+			if (m != m_materials.end() && m->second.diffuseMapTexture) {
+				item.texture = m->second.diffuseMapTexture->name();
+				item.color = m->second.ambient;
+				item.blended = item.color.a < 1.0;
+			}
+			
+			queue.add(item);
+		}
+	}
+	
+	void Model::render (std::size_t level) {
+		const std::vector<MeshBuffer> & meshes = (level < m_detail.levelCount()) ? m_detail.level(level).meshes : m_mesh;
+		
+		if (meshes.size() > 0) {
+			for (std::size_t i = 0; i < meshes.size(); i++) {
+				const MeshBuffer & mesh = meshes[i];
+				MaterialMapT::iterator m = m_materials.find(*mesh.material);
+				
+				if (mesh.indexCount == 0)
+					continue;
 				
 				// Keep track of whether textures have been enabled:
 				bool texturingEnabled = false;
@@ -507,19 +817,34 @@ namespace ARBrowser {
 						glEnable(GL_TEXTURE_2D);
 						
 						glEnableClientState(GL_TEXTURE_COORD_ARRAY);
-						glTexCoordPointer(2, GL_FLOAT, sizeof(ObjMeshVertex), (void*)&(faces[0].vertices[0].texcoord));
 						
 						texturingEnabled = true;
 					}
 				}
 				
 				glEnableClientState(GL_VERTEX_ARRAY);
-				glVertexPointer(3, GL_FLOAT, sizeof(ObjMeshVertex), (void*)&(faces[0].vertices[0].pos));
-				
 				glEnableClientState(GL_NORMAL_ARRAY);
-				glNormalPointer(GL_FLOAT, sizeof(ObjMeshVertex), (void*)&(faces[0].vertices[0].normal));
 				
-				glDrawArrays(GL_TRIANGLES, 0, faces.size() * 3);
+				setVertexPointers(mesh);
+				
+				if (mesh.quantizedVertices) {
+					float matrix[16];
+					mesh.decode->positionMatrix(matrix);
+					
+					glPushMatrix();
+					glMultMatrixf(matrix);
+					
+					loadTexcoordDecode(mesh.decode);
+				}
+				
+				// 32-bit indices require OES_element_index_uint, which is available on all iOS devices.
+				glDrawElements(GL_TRIANGLES, mesh.indexCount, mesh.shortIndices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT, mesh.indices);
+				
+				if (mesh.quantizedVertices) {
+					loadTexcoordDecode(NULL);
+					
+					glPopMatrix();
+				}
 				
 				if (m != m_materials.end()) {
 					m->second.disable();
@@ -610,7 +935,12 @@ namespace ARBrowser {
 	}
 
 	BoundingBox BoundingBox::transform(const Mat44 & transform) const {
-		return BoundingBox(transform * min, transform * max);
+		// Transforming only min and max gives the wrong box under any rotation, so compute the box enclosing all eight transformed corners:
+		Vec3 transformedMin, transformedMax;
+		
+		transformBox(transform.data(), min.data(), max.data(), transformedMin.data(), transformedMax.data());
+		
+		return BoundingBox(transformedMin, transformedMax);
 	}
 
 	BoundingSphere::BoundingSphere(Vec3 _center, float _radius) : center(_center), radius(_radius) {
@@ -644,12 +974,16 @@ namespace ARBrowser {
 	}
 	
 	BoundingSphere BoundingSphere::transform(const Mat44 & transform) {
-		Vec3 edge = center + (Vec3(1, 0, 0) * radius);
-
-		Vec3 newCenter = transform * center;
-		Vec3 newEdge = transform * edge;
+		// The radius must scale by the largest axis scale, otherwise non-uniform scaling shrinks the sphere:
+		const float * m = transform.data();
+		float scale = 0;
+		
+		for (std::size_t i = 0; i < 3; i += 1) {
+			const float * axis = m + (i * 4);
+			scale = std::max(scale, std::sqrt(axis[0]*axis[0] + axis[1]*axis[1] + axis[2]*axis[2]));
+		}
 
-		return BoundingSphere(newCenter, (newEdge - newCenter).length());
+		return BoundingSphere(transform * center, radius * scale);
 	}
 	
 	void BoundingBox::add(Vec3 pt) {
@@ -0,0 +1,160 @@
+//
+//  ARResourceLoader.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARResourceLoader.h"
+
+#include <chrono>
+#include <exception>
+#include <iostream>
+
+namespace ARBrowser {
+	ResourceLoader::ResourceLoader (std::size_t workerCount) : m_stopping(false), m_loading(0) {
+		if (workerCount == 0) workerCount = 1;
+		
+		for (std::size_t i = 0; i < workerCount; i += 1) {
+			m_workers.push_back(std::thread(&ResourceLoader::run, this));
+		}
+	}
+	
+	ResourceLoader::~ResourceLoader () {
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_stopping = true;
+		}
+		
+		m_condition.notify_all();
+		
+		for (std::size_t i = 0; i < m_workers.size(); i += 1) {
+			m_workers[i].join();
+		}
+	}
+	
+	std::shared_ptr<ResourceLoader::Request> ResourceLoader::load (LoadFunctionT load, UploadFunctionT upload) {
+		std::shared_ptr<Request> request = std::make_shared<Request>();
+		
+		Job job = {request, load, upload};
+		
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_pending.push_back(job);
+		}
+		
+		m_condition.notify_one();
+		
+		return request;
+	}
+	
+	void ResourceLoader::finish (Job & job, bool success) {
+		std::shared_ptr<Request> request = job.request.lock();
+		
+		if (request) {
+			request->m_state.store(success ? READY : FAILED, std::memory_order_release);
+		}
+	}
+	
+	void ResourceLoader::run () {
+		while (true) {
+			Job job;
+			
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				
+				while (!m_stopping && m_pending.empty()) {
+					m_condition.wait(lock);
+				}
+				
+				if (m_stopping) return;
+				
+				job = m_pending.front();
+				m_pending.pop_front();
+				
+				m_loading += 1;
+			}
+			
+			std::shared_ptr<Request> request = job.request.lock();
+			
+			// Nobody is waiting for this resource any more:
+			if (!request) {
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_loading -= 1;
+				
+				continue;
+			}
+			
+			request->m_state.store(LOADING, std::memory_order_release);
+			request.reset();
+			
+			bool success = false;
+			
+			try {
+				success = job.load();
+			} catch (std::exception & error) {
+				std::cerr << "Resource failed to load: " << error.what() << std::endl;
+			}
+			
+			if (success && (request = job.request.lock())) {
+				request->m_state.store(UPLOADING, std::memory_order_release);
+			} else {
+				finish(job, false);
+				success = false;
+			}
+			
+			// The job stops counting as loading only once its state has been updated, so that outstandingCount doesn't miss it:
+			std::lock_guard<std::mutex> lock(m_mutex);
+			
+			if (success)
+				m_uploads.push_back(job);
+			
+			m_loading -= 1;
+		}
+	}
+	
+	std::size_t ResourceLoader::processUploads (double budget) {
+		typedef std::chrono::steady_clock ClockT;
+		
+		ClockT::time_point start = ClockT::now();
+		std::size_t count = 0;
+		
+		while (true) {
+			Job job;
+			
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				
+				if (m_uploads.empty()) break;
+				
+				job = m_uploads.front();
+				m_uploads.pop_front();
+			}
+			
+			if (job.request.expired()) continue;
+			
+			bool success = false;
+			
+			try {
+				success = job.upload ? job.upload() : true;
+			} catch (std::exception & error) {
+				std::cerr << "Resource failed to upload: " << error.what() << std::endl;
+			}
+			
+			finish(job, success);
+			count += 1;
+			
+			if (std::chrono::duration<double>(ClockT::now() - start).count() >= budget)
+				break;
+		}
+		
+		return count;
+	}
+	
+	std::size_t ResourceLoader::outstandingCount () const {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		
+		return m_pending.size() + m_loading + m_uploads.size();
+	}
+}
@@ -0,0 +1,105 @@
+//
+//  ARResourceLoader.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_RESOURCE_LOADER_H
+#define _ARBROWSER_RESOURCE_LOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ARBrowser {
+	/// Loads resources in two stages: file I/O and parsing run on a pool of worker threads, then the finished resources are uploaded on the render thread, a few at a time, so that no single frame stalls.
+	class ResourceLoader {
+		public:
+			enum State {
+				/// Waiting for a worker thread.
+				PENDING,
+				/// Running on a worker thread.
+				LOADING,
+				/// Loaded, waiting to be uploaded by processUploads.
+				UPLOADING,
+				/// Loaded and uploaded, ready to use.
+				READY,
+				/// The load or upload function returned false or threw an exception.
+				FAILED
+			};
+			
+			/// The progress of a single resource. If the caller releases the request before it has been loaded, the load is skipped.
+			class Request {
+				protected:
+					friend class ResourceLoader;
+					std::atomic<int> m_state;
+					
+				public:
+					Request () : m_state(PENDING) {}
+					
+					State state () const { return (State)m_state.load(std::memory_order_acquire); }
+					
+					bool ready () const { return state() == READY; }
+					bool finished () const { State current = state(); return current == READY || current == FAILED; }
+			};
+			
+			/// Called on a worker thread. Return false if the resource could not be loaded.
+			typedef std::function<bool()> LoadFunctionT;
+			
+			/// Called on the thread which calls processUploads, e.g. the render thread which owns the OpenGL context.
+			typedef std::function<bool()> UploadFunctionT;
+			
+		protected:
+			struct Job {
+				std::weak_ptr<Request> request;
+				
+				LoadFunctionT load;
+				UploadFunctionT upload;
+			};
+			
+			std::vector<std::thread> m_workers;
+			
+			mutable std::mutex m_mutex;
+			std::condition_variable m_condition;
+			bool m_stopping;
+			
+			std::deque<Job> m_pending;
+			std::deque<Job> m_uploads;
+			
+			/// Jobs which a worker has taken from m_pending, and which have not yet been queued for upload, finished or dropped.
+			std::size_t m_loading;
+			
+			void run ();
+			
+			static void finish (Job & job, bool success);
+			
+		public:
+			ResourceLoader (std::size_t workerCount = 2);
+			
+			/// Stops the worker threads, waiting for any loads in progress. Pending requests are never finished.
+			~ResourceLoader ();
+			
+			/// Queue a resource to be loaded.
+			std::shared_ptr<Request> load (LoadFunctionT load, UploadFunctionT upload);
+			
+			/// Upload loaded resources until the time budget has been used. At least one upload is processed if one is available, so that progress is always made.
+			/// @returns the number of resources which were uploaded.
+			std::size_t processUploads (double budget);
+			
+			/// The number of requests which have not been uploaded yet, including those which are being loaded.
+			std::size_t outstandingCount () const;
+			
+		private:
+			ResourceLoader (const ResourceLoader &);
+			ResourceLoader & operator= (const ResourceLoader &);
+	};
+}
+
+#endif
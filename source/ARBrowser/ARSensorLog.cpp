@@ -0,0 +1,224 @@
+//
+//  ARSensorLog.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARSensorLog.h"
+
+#include <cstring>
+#include <iostream>
+
+namespace ARBrowser {
+	static_assert(sizeof(SensorLogHeader) == 16, "SensorLogHeader must match the file format");
+	static_assert(sizeof(SensorRecordHeader) == 16, "SensorRecordHeader must match the file format");
+	static_assert(sizeof(SensorMotion) == 72, "SensorMotion must match the file format");
+	static_assert(sizeof(SensorLocation) == 32, "SensorLocation must match the file format");
+	static_assert(sizeof(SensorHeading) == 16, "SensorHeading must match the file format");
+	static_assert(sizeof(SensorImage) == 24, "SensorImage must match the file format");
+	
+	static const char SENSOR_LOG_MAGIC[8] = {'A', 'R', 'S', 'E', 'N', 'S', 'O', 'R'};
+	static const std::size_t SENSOR_LOG_ALIGNMENT = 8;
+	
+	/// Images are large, so the log is written in big chunks.
+	static const std::size_t SENSOR_LOG_BUFFER_SIZE = 1024 * 1024;
+	
+	static std::size_t alignSize (std::size_t size) {
+		return (size + SENSOR_LOG_ALIGNMENT - 1) & ~(SENSOR_LOG_ALIGNMENT - 1);
+	}
+	
+	const char * sensorKindName (std::uint32_t kind) {
+		switch (kind) {
+			case SENSOR_MOTION: return "motion";
+			case SENSOR_LOCATION: return "location";
+			case SENSOR_HEADING: return "heading";
+			case SENSOR_IMAGE: return "image";
+			default: return "unknown";
+		}
+	}
+	
+	SensorLogWriter::SensorLogWriter () : m_file(NULL), m_records(0), m_failed(false) {
+	}
+	
+	SensorLogWriter::~SensorLogWriter () {
+		close();
+	}
+	
+	bool SensorLogWriter::open (const std::string & path) {
+		close();
+		
+		m_file = std::fopen(path.c_str(), "wb");
+		
+		if (!m_file) {
+			std::cerr << "Couldn't open " << path << " for writing!" << std::endl;
+			
+			return false;
+		}
+		
+		std::setvbuf(m_file, NULL, _IOFBF, SENSOR_LOG_BUFFER_SIZE);
+		
+		m_path = path;
+		m_records = 0;
+		m_failed = false;
+		
+		SensorLogHeader header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic, SENSOR_LOG_MAGIC, sizeof(header.magic));
+		header.version = SENSOR_LOG_VERSION;
+		
+		if (std::fwrite(&header, sizeof(header), 1, m_file) != 1)
+			m_failed = true;
+		
+		return true;
+	}
+	
+	bool SensorLogWriter::close () {
+		if (!m_file)
+			return !m_failed;
+		
+		if (std::fclose(m_file) != 0)
+			m_failed = true;
+		
+		m_file = NULL;
+		
+		if (m_failed)
+			std::cerr << "Couldn't write " << m_path << "!" << std::endl;
+		
+		return !m_failed;
+	}
+	
+	void SensorLogWriter::write (std::uint32_t kind, double time, const void * payload, std::size_t size, const void * extra, std::size_t extraSize) {
+		static const char zeros[SENSOR_LOG_ALIGNMENT] = {0};
+		
+		// Once a write has failed, the log is only valid up to the last complete record, so nothing more is written:
+		if (!m_file || m_failed)
+			return;
+		
+		SensorRecordHeader header = {kind, (std::uint32_t)(size + extraSize), time};
+		std::size_t padding = alignSize(size + extraSize) - (size + extraSize);
+		
+		bool success = std::fwrite(&header, sizeof(header), 1, m_file) == 1
+			&& std::fwrite(payload, size, 1, m_file) == 1
+			&& (extraSize == 0 || std::fwrite(extra, extraSize, 1, m_file) == 1)
+			&& (padding == 0 || std::fwrite(zeros, padding, 1, m_file) == 1);
+		
+		if (success)
+			m_records += 1;
+		else
+			m_failed = true;
+	}
+	
+	void SensorLogWriter::writeMotion (double time, const SensorMotion & motion) {
+		write(SENSOR_MOTION, time, &motion, sizeof(motion));
+	}
+	
+	void SensorLogWriter::writeLocation (double time, const SensorLocation & location) {
+		write(SENSOR_LOCATION, time, &location, sizeof(location));
+	}
+	
+	void SensorLogWriter::writeHeading (double time, const SensorHeading & heading) {
+		write(SENSOR_HEADING, time, &heading, sizeof(heading));
+	}
+	
+	void SensorLogWriter::writeImage (double time, const SensorImage & image, const std::uint8_t * pixels) {
+		write(SENSOR_IMAGE, time, &image, sizeof(image), pixels, (std::size_t)image.width * image.height * image.channels);
+	}
+	
+	void SensorLogWriter::flush () {
+		if (m_file && std::fflush(m_file) != 0)
+			m_failed = true;
+	}
+	
+	SensorLogReader::SensorLogReader () : m_cursor(NULL), m_truncated(false) {
+	}
+	
+	bool SensorLogReader::open (const std::string & path) {
+		close();
+		
+		if (!m_file.open(path))
+			return false;
+		
+		const SensorLogHeader * header = (const SensorLogHeader *)m_file.begin();
+		
+		if (m_file.size() < sizeof(SensorLogHeader) || std::memcmp(header->magic, SENSOR_LOG_MAGIC, sizeof(header->magic)) != 0) {
+			std::cerr << "Sensor log " << path << " is not a .arsensors file!" << std::endl;
+			close();
+			
+			return false;
+		}
+		
+		if (header->version != SENSOR_LOG_VERSION) {
+			std::cerr << "Sensor log " << path << " has unsupported version " << header->version << "!" << std::endl;
+			close();
+			
+			return false;
+		}
+		
+		m_path = path;
+		m_file.adviseSequential();
+		rewind();
+		
+		return true;
+	}
+	
+	void SensorLogReader::close () {
+		m_file.close();
+		
+		m_cursor = NULL;
+		m_truncated = false;
+	}
+	
+	void SensorLogReader::rewind () {
+		m_cursor = m_file.begin() + sizeof(SensorLogHeader);
+		m_truncated = false;
+	}
+	
+	bool SensorLogReader::next (Record & record) {
+		std::size_t remaining = m_file.end() - m_cursor;
+		
+		if (remaining == 0)
+			return false;
+		
+		const SensorRecordHeader * header = (const SensorRecordHeader *)m_cursor;
+		
+		if (remaining < sizeof(SensorRecordHeader) || remaining - sizeof(SensorRecordHeader) < alignSize(header->size)) {
+			m_truncated = true;
+			
+			return false;
+		}
+		
+		record.kind = header->kind;
+		record.time = header->time;
+		record.payload = header + 1;
+		record.size = header->size;
+		
+		// Check that fixed size payloads are complete, so the accessors are safe to use:
+		std::size_t expected = 0;
+		
+		switch (record.kind) {
+			case SENSOR_MOTION: expected = sizeof(SensorMotion); break;
+			case SENSOR_LOCATION: expected = sizeof(SensorLocation); break;
+			case SENSOR_HEADING: expected = sizeof(SensorHeading); break;
+			case SENSOR_IMAGE:
+				expected = sizeof(SensorImage);
+				
+				if (record.size >= expected)
+					expected += (std::size_t)record.image().width * record.image().height * record.image().channels;
+				
+				break;
+		}
+		
+		if (record.size < expected) {
+			std::cerr << "Sensor log " << m_path << " has a corrupt " << sensorKindName(record.kind) << " record!" << std::endl;
+			m_truncated = true;
+			
+			return false;
+		}
+		
+		m_cursor += sizeof(SensorRecordHeader) + alignSize(header->size);
+		
+		return true;
+	}
+}
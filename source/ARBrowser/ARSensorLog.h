@@ -0,0 +1,168 @@
+//
+//  ARSensorLog.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_SENSOR_LOG_H
+#define _ARBROWSER_SENSOR_LOG_H
+
+#include "ARMappedFile.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+namespace ARBrowser {
+	/**
+	 * The .arsensors format is an append-only log of the updates passed to a motion model, so that a walk can be recorded on a device and replayed on the development machine.
+	 *
+	 * All values are little endian. The file begins with a SensorLogHeader, followed by records in the order the updates were processed. Each record is a SensorRecordHeader followed by its payload, padded to a multiple of 8 bytes. Image payloads are a SensorImage followed by the tightly packed pixels. If recording was interrupted, the last record may be incomplete, and is ignored.
+	 */
+	
+	const std::uint32_t SENSOR_LOG_VERSION = 1;
+	
+	struct SensorLogHeader {
+		/// "ARSENSOR".
+		char magic[8];
+		std::uint32_t version;
+		std::uint32_t reserved;
+	};
+	
+	enum SensorKind {
+		SENSOR_MOTION = 1,
+		SENSOR_LOCATION = 2,
+		SENSOR_HEADING = 3,
+		SENSOR_IMAGE = 4,
+		
+		SENSOR_KINDS = 5
+	};
+	
+	struct SensorRecordHeader {
+		std::uint32_t kind;
+		
+		/// The size of the payload, excluding padding.
+		std::uint32_t size;
+		
+		/// The time offset of the update in seconds.
+		double time;
+	};
+	
+	struct SensorMotion {
+		double gravity[3], rotationRate[3], acceleration[3];
+	};
+	
+	struct SensorLocation {
+		double latitude, longitude;
+		double horizontalAccuracy, verticalAccuracy;
+	};
+	
+	struct SensorHeading {
+		double trueBearing, magneticBearing;
+	};
+	
+	struct SensorImage {
+		std::uint32_t width, height;
+		
+		/// 1 for luminance, or 4 for BGRA.
+		std::uint32_t channels;
+		std::uint32_t reserved;
+		
+		/// The horizontal field of view in degrees.
+		double fieldOfView;
+	};
+	
+	/// The name of a kind of record, e.g. "motion".
+	const char * sensorKindName (std::uint32_t kind);
+	
+	/// Appends records to a .arsensors file. Writes are buffered, so a record may not be on disk until the writer is flushed or closed.
+	class SensorLogWriter {
+		protected:
+			std::FILE * m_file;
+			std::string m_path;
+			
+			std::uint64_t m_records;
+			bool m_failed;
+			
+			void write (std::uint32_t kind, double time, const void * payload, std::size_t size, const void * extra = NULL, std::size_t extraSize = 0);
+		
+		public:
+			SensorLogWriter ();
+			~SensorLogWriter ();
+			
+			/// Create the given file, replacing it if it exists.
+			/// @returns false if the file could not be created.
+			bool open (const std::string & path);
+			
+			/// @returns false if any record could not be written.
+			bool close ();
+			
+			bool isOpen () const { return m_file != NULL; }
+			
+			void writeMotion (double time, const SensorMotion & motion);
+			void writeLocation (double time, const SensorLocation & location);
+			void writeHeading (double time, const SensorHeading & heading);
+			
+			/// The pixels are tightly packed, i.e. width * channels bytes per row.
+			void writeImage (double time, const SensorImage & image, const std::uint8_t * pixels);
+			
+			void flush ();
+			
+			std::uint64_t recordCount () const { return m_records; }
+		
+		private:
+			SensorLogWriter (const SensorLogWriter &);
+			SensorLogWriter & operator= (const SensorLogWriter &);
+	};
+	
+	/// Reads the records of a memory mapped .arsensors file in order. Payloads refer directly to the mapped data, so they are only valid while the file remains open.
+	class SensorLogReader {
+		public:
+			struct Record {
+				std::uint32_t kind;
+				double time;
+				
+				const void * payload;
+				std::size_t size;
+				
+				const SensorMotion & motion () const { return *(const SensorMotion *)payload; }
+				const SensorLocation & location () const { return *(const SensorLocation *)payload; }
+				const SensorHeading & heading () const { return *(const SensorHeading *)payload; }
+				const SensorImage & image () const { return *(const SensorImage *)payload; }
+				const std::uint8_t * pixels () const { return (const std::uint8_t *)payload + sizeof(SensorImage); }
+			};
+		
+		protected:
+			MappedFile m_file;
+			std::string m_path;
+			
+			const char * m_cursor;
+			bool m_truncated;
+		
+		public:
+			SensorLogReader ();
+			
+			/// Map and validate the header of the given file.
+			/// @returns false if the file does not exist, or is not a .arsensors file of a supported version.
+			bool open (const std::string & path);
+			void close ();
+			
+			bool isOpen () const { return m_cursor != NULL; }
+			
+			/// Read the next record. Records of unknown kinds are returned too, and should be skipped.
+			/// @returns false at the end of the log, or if the next record is incomplete or corrupt.
+			bool next (Record & record);
+			
+			/// Start reading from the first record again.
+			void rewind ();
+			
+			/// Whether reading stopped because the last record was incomplete or corrupt, rather than at the end of the file.
+			bool truncated () const { return m_truncated; }
+			
+			std::size_t fileSize () const { return m_file.size(); }
+	};
+}
+
+#endif
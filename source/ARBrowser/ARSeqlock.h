@@ -0,0 +1,81 @@
+//
+//  ARSeqlock.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_SEQLOCK_H
+#define _ARBROWSER_SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace ARBrowser {
+	/// Holds a small value which one thread writes and any number of threads read, without locking. A reader never sees a partially written value: it copies the value and retries if a write happened at the same time. Writers never wait.
+	/// The value is stored as atomic words, so that copying it while it is being written is well defined.
+	template <typename ValueT>
+	class Seqlock {
+		static_assert(std::is_trivially_copyable<ValueT>::value, "Seqlock values are copied word by word.");
+		
+		protected:
+			enum { WORDS = (sizeof(ValueT) + sizeof(std::uint32_t) - 1) / sizeof(std::uint32_t) };
+			
+			/// Odd while a write is in progress.
+			std::atomic<std::uint32_t> m_sequence;
+			std::atomic<std::uint32_t> m_words[WORDS];
+		
+		public:
+			Seqlock () : m_sequence(0) {
+				store(ValueT());
+			}
+			
+			/// Replace the value, from the writer thread only.
+			void store (const ValueT & value) {
+				std::uint32_t words[WORDS] = {0};
+				std::memcpy(words, &value, sizeof(ValueT));
+				
+				std::uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+				
+				m_sequence.store(sequence + 1, std::memory_order_relaxed);
+				std::atomic_thread_fence(std::memory_order_release);
+				
+				for (std::size_t i = 0; i < WORDS; i += 1)
+					m_words[i].store(words[i], std::memory_order_relaxed);
+				
+				m_sequence.store(sequence + 2, std::memory_order_release);
+			}
+			
+			/// A copy of the most recently stored value, from any thread.
+			ValueT load () const {
+				std::uint32_t words[WORDS];
+				
+				while (true) {
+					std::uint32_t before = m_sequence.load(std::memory_order_acquire);
+					
+					for (std::size_t i = 0; i < WORDS; i += 1)
+						words[i] = m_words[i].load(std::memory_order_relaxed);
+					
+					std::atomic_thread_fence(std::memory_order_acquire);
+					
+					// If the sequence is odd or has changed, a write overlapped the copy:
+					if (!(before & 1) && m_sequence.load(std::memory_order_relaxed) == before)
+						break;
+				}
+				
+				ValueT value;
+				std::memcpy(&value, words, sizeof(ValueT));
+				
+				return value;
+			}
+		
+		private:
+			Seqlock (const Seqlock &);
+			Seqlock & operator= (const Seqlock &);
+	};
+}
+
+#endif
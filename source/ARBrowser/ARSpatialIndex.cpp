@@ -0,0 +1,162 @@
+//
+//  ARSpatialIndex.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARSpatialIndex.h"
+
+#include <cmath>
+#include <algorithm>
+
+namespace ARBrowser {
+	// WGS 84 semi-major axis constant in meters:
+	const double SpatialIndex::RADIUS = 6378137.0;
+	
+	static const double D2R = M_PI / 180.0;
+	
+	SpatialIndex::SpatialIndex (double cellSize) {
+		// Round so that the cells wrap around exactly at the antimeridian:
+		m_longitudeCells = std::max<std::int32_t>(1, (std::int32_t)std::ceil(360.0 / cellSize));
+		m_cellSize = 360.0 / m_longitudeCells;
+	}
+	
+	std::int32_t SpatialIndex::latitudeCell (double latitude) const {
+		return (std::int32_t)std::floor((latitude + 90.0) / m_cellSize);
+	}
+	
+	std::int32_t SpatialIndex::longitudeCell (double longitude) const {
+		std::int32_t cell = (std::int32_t)std::floor((longitude + 180.0) / m_cellSize) % m_longitudeCells;
+		
+		if (cell < 0) cell += m_longitudeCells;
+		
+		return cell;
+	}
+	
+	SpatialIndex::CellT SpatialIndex::cellKey (std::int32_t latitudeCell, std::int32_t longitudeCell) {
+		return ((CellT)(std::uint32_t)latitudeCell << 32) | (std::uint32_t)longitudeCell;
+	}
+	
+	void SpatialIndex::removeFromCell (HandleT handle, CellT cell) {
+		auto i = m_cells.find(cell);
+		
+		if (i == m_cells.end()) return;
+		
+		EntriesT & entries = i->second;
+		
+		for (std::size_t j = 0; j < entries.size(); j += 1) {
+			if (entries[j].handle == handle) {
+				entries[j] = entries.back();
+				entries.pop_back();
+				
+				break;
+			}
+		}
+		
+		if (entries.empty())
+			m_cells.erase(i);
+	}
+	
+	void SpatialIndex::insert (HandleT handle, double latitude, double longitude) {
+		CellT cell = cellKey(latitudeCell(latitude), longitudeCell(longitude));
+		
+		auto existing = m_handles.find(handle);
+		
+		if (existing != m_handles.end()) {
+			removeFromCell(handle, existing->second);
+			existing->second = cell;
+		} else {
+			m_handles[handle] = cell;
+		}
+		
+		double lat = latitude * D2R, lon = longitude * D2R;
+		
+		Entry entry = {handle, std::cos(lat) * std::cos(lon), std::cos(lat) * std::sin(lon), std::sin(lat)};
+		m_cells[cell].push_back(entry);
+	}
+	
+	void SpatialIndex::remove (HandleT handle) {
+		auto existing = m_handles.find(handle);
+		
+		if (existing == m_handles.end()) return;
+		
+		removeFromCell(handle, existing->second);
+		m_handles.erase(existing);
+	}
+	
+	void SpatialIndex::clear () {
+		m_cells.clear();
+		m_handles.clear();
+	}
+	
+	void SpatialIndex::query (double latitude, double longitude, double distance, std::vector<HandleT> & results) const {
+		if (m_handles.empty()) return;
+		
+		// The angle subtended by the distance at the center of the earth:
+		double angle = distance / RADIUS;
+		
+		if (angle >= M_PI) {
+			for (auto & cell : m_cells)
+				for (auto & entry : cell.second)
+					results.push_back(entry.handle);
+			
+			return;
+		}
+		
+		double lat = latitude * D2R, lon = longitude * D2R;
+		double x = std::cos(lat) * std::cos(lon), y = std::cos(lat) * std::sin(lon), z = std::sin(lat);
+		
+		// Points within the distance have a dot product with the origin of at least this:
+		double threshold = std::cos(angle);
+		
+		double minimumLatitude = latitude - angle / D2R, maximumLatitude = latitude + angle / D2R;
+		std::int32_t longitudeSpan;
+		
+		if (minimumLatitude <= -90.0 || maximumLatitude >= 90.0) {
+			// The search area includes a pole, so it covers every longitude:
+			longitudeSpan = m_longitudeCells;
+		} else {
+			// The widest part of the search area is at the latitude closest to the pole:
+			double widest = std::max(std::fabs(minimumLatitude), std::fabs(maximumLatitude)) * D2R;
+			double ratio = std::sin(angle) / std::cos(widest);
+			
+			if (ratio >= 1.0) {
+				longitudeSpan = m_longitudeCells;
+			} else {
+				double longitudeRange = std::asin(ratio) / D2R;
+				longitudeSpan = (std::int32_t)std::ceil(longitudeRange / m_cellSize) + 1;
+			}
+		}
+		
+		std::int32_t firstLatitude = latitudeCell(std::max(minimumLatitude, -90.0));
+		std::int32_t lastLatitude = latitudeCell(std::min(maximumLatitude, 90.0));
+		
+		std::int32_t firstLongitude, longitudeCount;
+		
+		if (longitudeSpan * 2 + 1 >= m_longitudeCells) {
+			firstLongitude = 0;
+			longitudeCount = m_longitudeCells;
+		} else {
+			firstLongitude = longitudeCell(longitude) - longitudeSpan;
+			longitudeCount = longitudeSpan * 2 + 1;
+		}
+		
+		for (std::int32_t i = firstLatitude; i <= lastLatitude; i += 1) {
+			for (std::int32_t j = 0; j < longitudeCount; j += 1) {
+				std::int32_t cell = (firstLongitude + j) % m_longitudeCells;
+				if (cell < 0) cell += m_longitudeCells;
+				
+				auto entries = m_cells.find(cellKey(i, cell));
+				
+				if (entries == m_cells.end()) continue;
+				
+				for (auto & entry : entries->second) {
+					if (entry.x * x + entry.y * y + entry.z * z >= threshold)
+						results.push_back(entry.handle);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,74 @@
+//
+//  ARSpatialIndex.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_SPATIAL_INDEX_H
+#define _ARBROWSER_SPATIAL_INDEX_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ARBrowser {
+	/// Indexes points on the surface of the earth by latitude/longitude cell, so that the points within a given distance of a location can be found without visiting every point.
+	/// Points are identified by an opaque handle, e.g. a pointer to the object being indexed.
+	class SpatialIndex {
+		public:
+			typedef const void * HandleT;
+			
+			/// The radius used for distance calculations, in meters. Matches calculateDistanceBetween.
+			static const double RADIUS;
+			
+		protected:
+			struct Entry {
+				HandleT handle;
+				
+				/// Unit vector from the center of the earth, so that distance tests don't need any trigonometry.
+				double x, y, z;
+			};
+			
+			typedef std::uint64_t CellT;
+			typedef std::vector<Entry> EntriesT;
+			
+			double m_cellSize;
+			std::int32_t m_longitudeCells;
+			
+			std::unordered_map<CellT, EntriesT> m_cells;
+			std::unordered_map<HandleT, CellT> m_handles;
+			
+			std::int32_t latitudeCell (double latitude) const;
+			std::int32_t longitudeCell (double longitude) const;
+			
+			static CellT cellKey (std::int32_t latitudeCell, std::int32_t longitudeCell);
+			
+			void removeFromCell (HandleT handle, CellT cell);
+			
+		public:
+			/// @param cellSize the size of each cell in degrees. Cells should be a similar size to the typical query distance.
+			SpatialIndex (double cellSize = 0.01);
+			
+			/// Add a point, given its latitude and longitude in degrees. If the handle is already indexed, it is moved.
+			void insert (HandleT handle, double latitude, double longitude);
+			
+			/// Remove a point. Does nothing if the handle is not indexed.
+			void remove (HandleT handle);
+			
+			/// Update the location of a point which is already indexed.
+			void move (HandleT handle, double latitude, double longitude) { insert(handle, latitude, longitude); }
+			
+			bool contains (HandleT handle) const { return m_handles.count(handle) != 0; }
+			
+			void clear ();
+			
+			std::size_t size () const { return m_handles.size(); }
+			
+			/// Append the handles of all points within the given great circle distance, in meters, of the given location, in degrees. Results are in no particular order.
+			void query (double latitude, double longitude, double distance, std::vector<HandleT> & results) const;
+	};
+}
+
+#endif
@@ -0,0 +1,554 @@
+//
+//  ARTextureCompression.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARTextureCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace ARBrowser {
+	static bool isPowerOfTwo (std::uint32_t value) {
+		return value != 0 && (value & (value - 1)) == 0;
+	}
+	
+	void resizeImage (const TextureImage & source, std::uint32_t width, std::uint32_t height, TextureImage & result) {
+		result = TextureImage(width, height);
+		
+		for (std::uint32_t y = 0; y < height; y += 1) {
+			// The centre of the pixel, in source pixels:
+			float sy = std::max(0.0f, (y + 0.5f) * source.height / height - 0.5f);
+			std::uint32_t y0 = std::min((std::uint32_t)sy, source.height - 1), y1 = std::min(y0 + 1, source.height - 1);
+			float fy = sy - y0;
+			
+			for (std::uint32_t x = 0; x < width; x += 1) {
+				float sx = std::max(0.0f, (x + 0.5f) * source.width / width - 0.5f);
+				std::uint32_t x0 = std::min((std::uint32_t)sx, source.width - 1), x1 = std::min(x0 + 1, source.width - 1);
+				float fx = sx - x0;
+				
+				const std::uint8_t * p = source.pixel(x0, y0), * q = source.pixel(x1, y0), * r = source.pixel(x0, y1), * s = source.pixel(x1, y1);
+				std::uint8_t * pixel = result.pixel(x, y);
+				
+				for (std::size_t c = 0; c < 4; c += 1) {
+					float value = (p[c] * (1 - fx) + q[c] * fx) * (1 - fy) + (r[c] * (1 - fx) + s[c] * fx) * fy;
+					pixel[c] = (std::uint8_t)std::min(255.0f, value + 0.5f);
+				}
+			}
+		}
+	}
+	
+	void buildMipChain (const TextureImage & image, std::vector<TextureImage> & levels) {
+		levels.assign(1, image);
+		
+		while (levels.back().width > 1 || levels.back().height > 1) {
+			const TextureImage & previous = levels.back();
+			TextureImage level(std::max(previous.width / 2, 1u), std::max(previous.height / 2, 1u));
+			
+			// Sides of 1 pixel aren't halved, so only average along the other side:
+			std::uint32_t stepX = previous.width > 1 ? 2 : 1, stepY = previous.height > 1 ? 2 : 1, count = stepX * stepY;
+			
+			for (std::uint32_t y = 0; y < level.height; y += 1) {
+				for (std::uint32_t x = 0; x < level.width; x += 1) {
+					std::uint8_t * pixel = level.pixel(x, y);
+					
+					for (std::size_t c = 0; c < 4; c += 1) {
+						std::uint32_t sum = count / 2;
+						
+						for (std::uint32_t j = 0; j < stepY; j += 1)
+							for (std::uint32_t i = 0; i < stepX; i += 1)
+								sum += previous.pixel(x * stepX + i, y * stepY + j)[c];
+						
+						pixel[c] = (std::uint8_t)(sum / count);
+					}
+				}
+			}
+			
+			levels.push_back(level);
+		}
+	}
+	
+	/**
+	 * PVRTC with 4 bits per pixel divides the image into 4x4 blocks, each stored as a 32-bit modulation word followed by a 32-bit colour word. The colour word holds two colours, A and B, which are each upscaled to the full image by interpolating between the centres of the blocks, wrapping around the edges. Each pixel then has a 2-bit modulation value which chooses a blend of A and B.
+	 *
+	 * Bit 0 of the colour word selects the modulation mode of the block, bits 1 to 15 hold A and bits 16 to 31 hold B. The top bit of each colour selects between opaque RGB 554 or 555, and translucent ARGB 3443 or 3444. Blocks are stored in twiddled order.
+	 */
+	
+	namespace {
+		/// The colours of a block as unpacked from its colour word, with 5-bit red, green and blue and 4-bit alpha.
+		struct BlockColors {
+			int a[4], b[4];
+		};
+		
+		struct PVRTCBlock {
+			std::uint32_t modulation, color;
+		};
+		
+		/// The weight of B, out of 8, for each modulation value, in the standard and punch-through modes. Punch-through also makes the pixel transparent for value 2.
+		const int MODULATION_WEIGHTS[2][4] = {{0, 3, 5, 8}, {0, 4, 4, 8}};
+		
+		/// The lowest alpha which is stored as opaque, half way between the most opaque translucent colour and opaque.
+		const float OPAQUE_ALPHA = 246.5;
+	}
+	
+	static int expand3 (std::uint32_t value) {
+		return (int)((value << 2) | (value >> 1));
+	}
+	
+	static int expand4 (std::uint32_t value) {
+		return (int)((value << 1) | (value >> 3));
+	}
+	
+	static void unpackColorA (std::uint32_t color, int * result) {
+		if (color & 0x8000) {
+			result[0] = (color >> 10) & 0x1F;
+			result[1] = (color >> 5) & 0x1F;
+			result[2] = expand4((color >> 1) & 0xF);
+			result[3] = 0xF;
+		} else {
+			result[0] = expand4((color >> 8) & 0xF);
+			result[1] = expand4((color >> 4) & 0xF);
+			result[2] = expand3((color >> 1) & 0x7);
+			result[3] = ((color >> 12) & 0x7) << 1;
+		}
+	}
+	
+	static void unpackColorB (std::uint32_t color, int * result) {
+		if (color & 0x80000000) {
+			result[0] = (color >> 26) & 0x1F;
+			result[1] = (color >> 21) & 0x1F;
+			result[2] = (color >> 16) & 0x1F;
+			result[3] = 0xF;
+		} else {
+			result[0] = expand4((color >> 24) & 0xF);
+			result[1] = expand4((color >> 20) & 0xF);
+			result[2] = expand4((color >> 16) & 0xF);
+			result[3] = ((color >> 28) & 0x7) << 1;
+		}
+	}
+	
+	static std::uint32_t quantizeChannel (float value, int bits) {
+		int maximum = (1 << bits) - 1;
+		
+		return (std::uint32_t)std::max(0, std::min(maximum, (int)std::floor(value * maximum / 255.0f + 0.5f)));
+	}
+	
+	/// Bits 0 to 15 of the colour word, leaving the standard modulation mode.
+	static std::uint32_t packColorA (const float * color) {
+		if (color[3] >= OPAQUE_ALPHA)
+			return 0x8000 | quantizeChannel(color[0], 5) << 10 | quantizeChannel(color[1], 5) << 5 | quantizeChannel(color[2], 4) << 1;
+		else
+			return quantizeChannel(color[3], 3) << 12 | quantizeChannel(color[0], 4) << 8 | quantizeChannel(color[1], 4) << 4 | quantizeChannel(color[2], 3) << 1;
+	}
+	
+	/// Bits 16 to 31 of the colour word.
+	static std::uint32_t packColorB (const float * color) {
+		std::uint32_t packed;
+		
+		if (color[3] >= OPAQUE_ALPHA)
+			packed = 0x8000 | quantizeChannel(color[0], 5) << 10 | quantizeChannel(color[1], 5) << 5 | quantizeChannel(color[2], 5);
+		else
+			packed = quantizeChannel(color[3], 3) << 12 | quantizeChannel(color[0], 4) << 8 | quantizeChannel(color[1], 4) << 4 | quantizeChannel(color[2], 4);
+		
+		return packed << 16;
+	}
+	
+	/// The index of a block in twiddled order, where the bits of y and x alternate starting with y, followed by the remaining bits of the longer side.
+	static std::uint32_t twiddle (std::uint32_t x, std::uint32_t y, std::uint32_t blocksX, std::uint32_t blocksY) {
+		std::uint32_t minimum = std::min(blocksX, blocksY), index = 0, shift = 0;
+		
+		for (std::uint32_t bit = 1; bit < minimum; bit <<= 1, shift += 1) {
+			if (y & bit) index |= 1u << (2 * shift);
+			if (x & bit) index |= 2u << (2 * shift);
+		}
+		
+		std::uint32_t remaining = blocksX > blocksY ? x : y;
+		
+		return index | ((remaining >> shift) << (2 * shift));
+	}
+	
+	/// The colours A and B at the given pixel, in 8 bits per channel, interpolated between the centres of the four nearest blocks.
+	static void interpolateColors (const std::vector<BlockColors> & colors, std::uint32_t blocksX, std::uint32_t blocksY, std::uint32_t x, std::uint32_t y, int * a, int * b) {
+		// Offset by half a block, so that the weights are relative to the centre of the top left block:
+		std::uint32_t px = x + blocksX * 4 - 2, py = y + blocksY * 4 - 2;
+		std::uint32_t x0 = (px / 4) % blocksX, x1 = (x0 + 1) % blocksX, y0 = (py / 4) % blocksY, y1 = (y0 + 1) % blocksY;
+		int fx = px % 4, fy = py % 4;
+		
+		const BlockColors & p = colors[y0 * blocksX + x0], & q = colors[y0 * blocksX + x1], & r = colors[y1 * blocksX + x0], & s = colors[y1 * blocksX + x1];
+		
+		for (std::size_t c = 0; c < 4; c += 1) {
+			// Both are 16 times the interpolated colour:
+			int va = (p.a[c] * (4 - fx) + q.a[c] * fx) * (4 - fy) + (r.a[c] * (4 - fx) + s.a[c] * fx) * fy;
+			int vb = (p.b[c] * (4 - fx) + q.b[c] * fx) * (4 - fy) + (r.b[c] * (4 - fx) + s.b[c] * fx) * fy;
+			
+			if (c < 3) {
+				a[c] = (va >> 6) + (va >> 1);
+				b[c] = (vb >> 6) + (vb >> 1);
+			} else {
+				a[c] = (va >> 4) + va;
+				b[c] = (vb >> 4) + vb;
+			}
+		}
+	}
+	
+	static void modulate (const int * a, const int * b, int weight, bool transparent, std::uint8_t * pixel) {
+		for (std::size_t c = 0; c < 4; c += 1)
+			pixel[c] = (std::uint8_t)((a[c] * (8 - weight) + b[c] * weight) / 8);
+		
+		if (transparent)
+			pixel[3] = 0;
+	}
+	
+	/// The extremes of the pixels along the axis through their mean with the greatest variance. The axis is oriented so that the low extreme is the darker, otherwise interpolating between blocks would mix the light colours of some blocks with the dark colours of others.
+	static void principalExtremes (const float (* pixels)[4], std::size_t count, float * low, float * high) {
+		float mean[4] = {0, 0, 0, 0};
+		
+		for (std::size_t i = 0; i < count; i += 1)
+			for (std::size_t c = 0; c < 4; c += 1)
+				mean[c] += pixels[i][c] / count;
+		
+		float covariance[4][4] = {{0}};
+		
+		for (std::size_t i = 0; i < count; i += 1)
+			for (std::size_t j = 0; j < 4; j += 1)
+				for (std::size_t k = 0; k < 4; k += 1)
+					covariance[j][k] += (pixels[i][j] - mean[j]) * (pixels[i][k] - mean[k]);
+		
+		// Power iteration converges quickly for the small, usually elongated, clusters of colours in a block:
+		float axis[4] = {1, 1, 1, 1};
+		
+		for (std::size_t iteration = 0; iteration < 8; iteration += 1) {
+			float next[4] = {0, 0, 0, 0}, largest = 0;
+			
+			for (std::size_t j = 0; j < 4; j += 1) {
+				for (std::size_t k = 0; k < 4; k += 1)
+					next[j] += covariance[j][k] * axis[k];
+				
+				largest = std::max(largest, std::fabs(next[j]));
+			}
+			
+			if (largest == 0)
+				break;
+			
+			for (std::size_t j = 0; j < 4; j += 1)
+				axis[j] = next[j] / largest;
+		}
+		
+		float length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+		float sign = (axis[0] + axis[1] + axis[2] + axis[3]) < 0 ? -1 : 1;
+		
+		for (std::size_t c = 0; c < 4; c += 1)
+			axis[c] *= sign / length;
+		
+		float minimum = 0, maximum = 0;
+		
+		for (std::size_t i = 0; i < count; i += 1) {
+			float t = 0;
+			
+			for (std::size_t c = 0; c < 4; c += 1)
+				t += (pixels[i][c] - mean[c]) * axis[c];
+			
+			minimum = std::min(minimum, t);
+			maximum = std::max(maximum, t);
+		}
+		
+		for (std::size_t c = 0; c < 4; c += 1) {
+			low[c] = std::max(0.0f, std::min(255.0f, mean[c] + axis[c] * minimum));
+			high[c] = std::max(0.0f, std::min(255.0f, mean[c] + axis[c] * maximum));
+		}
+	}
+	
+	static void storeWord (std::uint8_t * data, std::uint32_t value) {
+		data[0] = value & 0xFF;
+		data[1] = (value >> 8) & 0xFF;
+		data[2] = (value >> 16) & 0xFF;
+		data[3] = (value >> 24) & 0xFF;
+	}
+	
+	static std::uint32_t loadWord (const std::uint8_t * data) {
+		return std::uint32_t(data[0]) | std::uint32_t(data[1]) << 8 | std::uint32_t(data[2]) << 16 | std::uint32_t(data[3]) << 24;
+	}
+	
+	std::size_t pvrtcSize (std::uint32_t width, std::uint32_t height) {
+		return std::size_t(std::max(width, 8u)) * std::max(height, 8u) / 2;
+	}
+	
+	/// Pack the unquantized colours A and B of each block, 8 floats per block, into the colour words of the blocks, and unpack the colours which will be decoded.
+	static void packBlocks (const std::vector<float> & endpoints, std::vector<PVRTCBlock> & blocks, std::vector<BlockColors> & colors) {
+		for (std::size_t i = 0; i < blocks.size(); i += 1) {
+			blocks[i].color = packColorA(&endpoints[i * 8]) | packColorB(&endpoints[i * 8 + 4]);
+			
+			unpackColorA(blocks[i].color, colors[i].a);
+			unpackColorB(blocks[i].color, colors[i].b);
+		}
+	}
+	
+	/// Choose the modulation of each pixel which decodes closest to it, given the colours interpolated from the neighbouring blocks.
+	/// @returns the total error of the decoded image, weighted as for peakSignalToNoise.
+	static std::uint64_t chooseModulation (const TextureImage & image, std::uint32_t blocksX, std::uint32_t blocksY, const std::vector<BlockColors> & colors, std::vector<PVRTCBlock> & blocks) {
+		std::uint64_t total = 0;
+		
+		for (std::size_t i = 0; i < blocks.size(); i += 1)
+			blocks[i].modulation = 0;
+		
+		for (std::uint32_t y = 0; y < blocksY * 4; y += 1) {
+			for (std::uint32_t x = 0; x < blocksX * 4; x += 1) {
+				const std::uint8_t * source = image.pixel(x % image.width, y % image.height);
+				int a[4], b[4];
+				
+				interpolateColors(colors, blocksX, blocksY, x, y, a, b);
+				
+				std::uint32_t best = 0;
+				int bestError = std::numeric_limits<int>::max();
+				
+				for (std::uint32_t m = 0; m < 4; m += 1) {
+					std::uint8_t candidate[4];
+					modulate(a, b, MODULATION_WEIGHTS[0][m], false, candidate);
+					
+					// The error of the colour is scaled by the alpha of the source, as it is when blended:
+					int error = (candidate[3] - source[3]) * (candidate[3] - source[3]) * 255;
+					
+					for (std::size_t c = 0; c < 3; c += 1)
+						error += (candidate[c] - source[c]) * (candidate[c] - source[c]) * source[3];
+					
+					if (error < bestError) {
+						best = m;
+						bestError = error;
+					}
+				}
+				
+				blocks[(y / 4) * blocksX + x / 4].modulation |= best << (2 * ((y % 4) * 4 + x % 4));
+				total += bestError;
+			}
+		}
+		
+		return total;
+	}
+	
+	/// Adjust the unquantized colours of each block in turn to minimise the error of the pixels it influences, by least squares given the current modulation and the colours of the neighbouring blocks. The colours chosen from a single block ignore the neighbours which they are interpolated with.
+	static void refineEndpoints (const TextureImage & image, std::uint32_t blocksX, std::uint32_t blocksY, const std::vector<PVRTCBlock> & blocks, std::vector<float> & endpoints) {
+		const std::uint32_t width = blocksX * 4, height = blocksY * 4;
+		
+		// The colours A and B interpolated at each pixel, updated as the blocks change:
+		std::vector<float> interpolated(std::size_t(width) * height * 8, 0.0f);
+		
+		for (std::uint32_t by = 0; by < blocksY; by += 1) {
+			for (std::uint32_t bx = 0; bx < blocksX; bx += 1) {
+				const float * endpoint = &endpoints[(by * blocksX + bx) * 8];
+				
+				// Each block influences the 7x7 pixels around its centre:
+				for (int dy = -3; dy <= 3; dy += 1) {
+					for (int dx = -3; dx <= 3; dx += 1) {
+						std::uint32_t x = (bx * 4 + 2 + dx + width) % width, y = (by * 4 + 2 + dy + height) % height;
+						float weight = (4 - std::abs(dx)) * (4 - std::abs(dy)) / 16.0f;
+						float * pixel = &interpolated[(std::size_t(y) * width + x) * 8];
+						
+						for (std::size_t c = 0; c < 8; c += 1)
+							pixel[c] += endpoint[c] * weight;
+					}
+				}
+			}
+		}
+		
+		for (std::uint32_t by = 0; by < blocksY; by += 1) {
+			for (std::uint32_t bx = 0; bx < blocksX; bx += 1) {
+				float * endpoint = &endpoints[(by * blocksX + bx) * 8];
+				
+				// The normal equations for the change of A and B in each channel, where u and v are the contributions of A and B to a pixel and e is its error:
+				double uu[4] = {0}, uv[4] = {0}, vv[4] = {0}, ue[4] = {0}, ve[4] = {0};
+				
+				for (int dy = -3; dy <= 3; dy += 1) {
+					for (int dx = -3; dx <= 3; dx += 1) {
+						std::uint32_t x = (bx * 4 + 2 + dx + width) % width, y = (by * 4 + 2 + dy + height) % height;
+						const PVRTCBlock & block = blocks[(y / 4) * blocksX + x / 4];
+						const std::uint8_t * source = image.pixel(x % image.width, y % image.height);
+						const float * pixel = &interpolated[(std::size_t(y) * width + x) * 8];
+						
+						float weight = (4 - std::abs(dx)) * (4 - std::abs(dy)) / 16.0f;
+						float m = MODULATION_WEIGHTS[0][(block.modulation >> (2 * ((y % 4) * 4 + x % 4))) & 3] / 8.0f;
+						float u = weight * (1 - m), v = weight * m;
+						
+						for (std::size_t c = 0; c < 4; c += 1) {
+							float scale = c < 3 ? source[3] / 255.0f : 1.0f;
+							float error = source[c] - (pixel[c] * (1 - m) + pixel[c + 4] * m);
+							
+							uu[c] += scale * u * u;
+							uv[c] += scale * u * v;
+							vv[c] += scale * v * v;
+							ue[c] += scale * u * error;
+							ve[c] += scale * v * error;
+						}
+					}
+				}
+				
+				float delta[8];
+				
+				for (std::size_t c = 0; c < 4; c += 1) {
+					// A small bias towards no change keeps the system solvable when only one colour, or no visible pixel, is used:
+					double suu = uu[c] + 0.01, svv = vv[c] + 0.01, determinant = suu * svv - uv[c] * uv[c];
+					
+					float a = endpoint[c] + (float)((ue[c] * svv - uv[c] * ve[c]) / determinant);
+					float b = endpoint[c + 4] + (float)((suu * ve[c] - uv[c] * ue[c]) / determinant);
+					
+					delta[c] = std::max(0.0f, std::min(255.0f, a)) - endpoint[c];
+					delta[c + 4] = std::max(0.0f, std::min(255.0f, b)) - endpoint[c + 4];
+				}
+				
+				for (std::size_t c = 0; c < 8; c += 1)
+					endpoint[c] += delta[c];
+				
+				for (int dy = -3; dy <= 3; dy += 1) {
+					for (int dx = -3; dx <= 3; dx += 1) {
+						std::uint32_t x = (bx * 4 + 2 + dx + width) % width, y = (by * 4 + 2 + dy + height) % height;
+						float weight = (4 - std::abs(dx)) * (4 - std::abs(dy)) / 16.0f;
+						float * pixel = &interpolated[(std::size_t(y) * width + x) * 8];
+						
+						for (std::size_t c = 0; c < 8; c += 1)
+							pixel[c] += delta[c] * weight;
+					}
+				}
+			}
+		}
+	}
+	
+	/// The most times the colours of the blocks are refined, which stops early once the error no longer improves.
+	static const std::size_t REFINEMENT_PASSES = 4;
+	
+	bool encodePVRTC (const TextureImage & image, std::vector<std::uint8_t> & data) {
+		if (!isPowerOfTwo(image.width) || !isPowerOfTwo(image.height))
+			return false;
+		
+		std::uint32_t blocksX = std::max(image.width, 8u) / 4, blocksY = std::max(image.height, 8u) / 4;
+		
+		std::vector<PVRTCBlock> blocks(blocksX * blocksY);
+		std::vector<BlockColors> colors(blocks.size());
+		std::vector<float> endpoints(blocks.size() * 8);
+		
+		for (std::uint32_t by = 0; by < blocksY; by += 1) {
+			for (std::uint32_t bx = 0; bx < blocksX; bx += 1) {
+				float pixels[16][4];
+				
+				for (std::uint32_t j = 0; j < 4; j += 1) {
+					for (std::uint32_t i = 0; i < 4; i += 1) {
+						const std::uint8_t * pixel = image.pixel((bx * 4 + i) % image.width, (by * 4 + j) % image.height);
+						
+						for (std::size_t c = 0; c < 4; c += 1)
+							pixels[j * 4 + i][c] = pixel[c];
+					}
+				}
+				
+				// The colour of transparent pixels isn't visible, so it is replaced by the mean colour of the block weighted by alpha, which leaves the endpoints to fit the visible pixels:
+				float visible[4] = {0, 0, 0, 0};
+				
+				for (std::size_t i = 0; i < 16; i += 1) {
+					for (std::size_t c = 0; c < 3; c += 1)
+						visible[c] += pixels[i][c] * pixels[i][3];
+					
+					visible[3] += pixels[i][3];
+				}
+				
+				for (std::size_t i = 0; i < 16 && visible[3] > 0; i += 1) {
+					float coverage = pixels[i][3] / 255.0f;
+					
+					for (std::size_t c = 0; c < 3; c += 1)
+						pixels[i][c] = pixels[i][c] * coverage + visible[c] / visible[3] * (1 - coverage);
+				}
+				
+				float * endpoint = &endpoints[(by * blocksX + bx) * 8];
+				principalExtremes(pixels, 16, endpoint, endpoint + 4);
+			}
+		}
+		
+		packBlocks(endpoints, blocks, colors);
+		std::uint64_t error = chooseModulation(image, blocksX, blocksY, colors, blocks);
+		
+		for (std::size_t pass = 0; pass < REFINEMENT_PASSES; pass += 1) {
+			std::vector<float> refinedEndpoints = endpoints;
+			refineEndpoints(image, blocksX, blocksY, blocks, refinedEndpoints);
+			
+			std::vector<PVRTCBlock> refinedBlocks(blocks.size());
+			std::vector<BlockColors> refinedColors(colors.size());
+			
+			packBlocks(refinedEndpoints, refinedBlocks, refinedColors);
+			std::uint64_t refinedError = chooseModulation(image, blocksX, blocksY, refinedColors, refinedBlocks);
+			
+			if (refinedError >= error)
+				break;
+			
+			endpoints.swap(refinedEndpoints);
+			blocks.swap(refinedBlocks);
+			colors.swap(refinedColors);
+			error = refinedError;
+		}
+		
+		data.resize(blocks.size() * 8);
+		
+		for (std::uint32_t by = 0; by < blocksY; by += 1) {
+			for (std::uint32_t bx = 0; bx < blocksX; bx += 1) {
+				const PVRTCBlock & block = blocks[by * blocksX + bx];
+				std::uint8_t * word = &data[twiddle(bx, by, blocksX, blocksY) * 8];
+				
+				storeWord(word, block.modulation);
+				storeWord(word + 4, block.color);
+			}
+		}
+		
+		return true;
+	}
+	
+	void decodePVRTC (const std::uint8_t * data, std::uint32_t width, std::uint32_t height, TextureImage & image) {
+		std::uint32_t blocksX = std::max(width, 8u) / 4, blocksY = std::max(height, 8u) / 4;
+		
+		std::vector<PVRTCBlock> blocks(blocksX * blocksY);
+		std::vector<BlockColors> colors(blocks.size());
+		
+		for (std::uint32_t by = 0; by < blocksY; by += 1) {
+			for (std::uint32_t bx = 0; bx < blocksX; bx += 1) {
+				const std::uint8_t * word = data + twiddle(bx, by, blocksX, blocksY) * 8;
+				std::size_t index = by * blocksX + bx;
+				
+				blocks[index].modulation = loadWord(word);
+				blocks[index].color = loadWord(word + 4);
+				
+				unpackColorA(blocks[index].color, colors[index].a);
+				unpackColorB(blocks[index].color, colors[index].b);
+			}
+		}
+		
+		image = TextureImage(width, height);
+		
+		for (std::uint32_t y = 0; y < height; y += 1) {
+			for (std::uint32_t x = 0; x < width; x += 1) {
+				const PVRTCBlock & block = blocks[(y / 4) * blocksX + x / 4];
+				int a[4], b[4];
+				
+				interpolateColors(colors, blocksX, blocksY, x, y, a, b);
+				
+				std::uint32_t mode = block.color & 1, value = (block.modulation >> (2 * ((y % 4) * 4 + x % 4))) & 3;
+				
+				modulate(a, b, MODULATION_WEIGHTS[mode][value], mode && value == 2, image.pixel(x, y));
+			}
+		}
+	}
+	
+	double peakSignalToNoise (const TextureImage & a, const TextureImage & b) {
+		double sum = 0;
+		
+		for (std::size_t i = 0; i < a.pixels.size(); i += 4) {
+			for (std::size_t c = 0; c < 4; c += 1) {
+				// Colours are premultiplied by alpha, as the colour of transparent pixels isn't visible:
+				double difference = c < 3 ? (double(a.pixels[i + c]) * a.pixels[i + 3] - double(b.pixels[i + c]) * b.pixels[i + 3]) / 255.0 : double(a.pixels[i + c]) - b.pixels[i + c];
+				sum += difference * difference;
+			}
+		}
+		
+		if (sum == 0)
+			return std::numeric_limits<double>::infinity();
+		
+		return 10.0 * std::log10(255.0 * 255.0 * a.pixels.size() / sum);
+	}
+}
@@ -0,0 +1,49 @@
+//
+//  ARTextureCompression.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_TEXTURE_COMPRESSION_H
+#define _ARBROWSER_TEXTURE_COMPRESSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ARBrowser {
+	/// An image with 8-bit red, green, blue and alpha channels, stored row by row from the top.
+	struct TextureImage {
+		std::uint32_t width, height;
+		std::vector<std::uint8_t> pixels;
+		
+		TextureImage () : width(0), height(0) {}
+		TextureImage (std::uint32_t _width, std::uint32_t _height) : width(_width), height(_height), pixels(std::size_t(_width) * _height * 4) {}
+		
+		std::uint8_t * pixel (std::uint32_t x, std::uint32_t y) { return &pixels[(std::size_t(y) * width + x) * 4]; }
+		const std::uint8_t * pixel (std::uint32_t x, std::uint32_t y) const { return &pixels[(std::size_t(y) * width + x) * 4]; }
+	};
+	
+	/// Resample the image to the given size with bilinear filtering, e.g. to make its sides powers of two.
+	void resizeImage (const TextureImage & source, std::uint32_t width, std::uint32_t height, TextureImage & result);
+	
+	/// Build the mip levels of the image, from a copy of the image down to 1x1. Each level averages 2x2 pixels of the previous level.
+	void buildMipChain (const TextureImage & image, std::vector<TextureImage> & levels);
+	
+	/// The size in bytes of an image compressed with encodePVRTC. Images smaller than 8x8 take as much space as 8x8.
+	std::size_t pvrtcSize (std::uint32_t width, std::uint32_t height);
+	
+	/// Compress the image using PVRTC with 4 bits per pixel, i.e. GL_COMPRESSED_RGBA_PVRTC_4BPPV1_IMG. Images smaller than 8x8 are repeated to fill 8x8. iOS requires the image to be square.
+	/// @returns false if the sides of the image are not powers of two.
+	bool encodePVRTC (const TextureImage & image, std::vector<std::uint8_t> & data);
+	
+	/// Decompress PVRTC data with 4 bits per pixel as the GPU does, e.g. to measure the error of encodePVRTC.
+	void decodePVRTC (const std::uint8_t * data, std::uint32_t width, std::uint32_t height, TextureImage & image);
+	
+	/// The peak signal to noise ratio between two images of the same size, over the colour premultiplied by alpha and alpha itself, in decibels. Identical images give infinity.
+	double peakSignalToNoise (const TextureImage & a, const TextureImage & b);
+}
+
+#endif
@@ -0,0 +1,103 @@
+//
+//  ARTripleBuffer.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_TRIPLE_BUFFER_H
+#define _ARBROWSER_TRIPLE_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace ARBrowser {
+	/// Passes values from one producer thread to one consumer thread without locking. The producer writes into back() and calls publish(), which never waits for the consumer. The consumer calls acquire() and reads front(), which is always the newest published value. Values published in between are dropped.
+	/// The producer owns one slot, the consumer owns another, and the third is exchanged atomically between them, so each side can use its own slot for as long as it likes. Slots are reused, so any storage they allocate is kept between frames.
+	template <typename ValueT>
+	class TripleBuffer {
+		protected:
+			enum : std::uint8_t {
+				INDEX = 0x3,
+				
+				/// Set when the shared slot holds a value which hasn't been acquired yet.
+				FRESH = 0x4,
+			};
+			
+			ValueT m_slots[3];
+			
+			/// The sequence number of the value in each slot, written by the producer before the slot is published.
+			std::uint64_t m_sequences[3];
+			
+			/// The index of the shared slot, and the FRESH flag.
+			std::atomic<std::uint8_t> m_shared;
+			
+			/// Only accessed by the producer:
+			std::uint8_t m_back;
+			std::uint64_t m_published;
+			
+			/// Only accessed by the consumer:
+			std::uint8_t m_front;
+			std::uint64_t m_acquired, m_dropped;
+		
+		public:
+			enum { SLOTS = 3 };
+			
+			TripleBuffer () : m_slots(), m_shared(1), m_back(0), m_published(0), m_front(2), m_acquired(0), m_dropped(0)
+			{
+				m_sequences[0] = m_sequences[1] = m_sequences[2] = 0;
+			}
+			
+			/// The slot the producer writes into. It may contain an old value.
+			ValueT & back () { return m_slots[m_back]; }
+			
+			/// Make the back slot available to the consumer, replacing any value it hasn't acquired yet, and take ownership of another slot.
+			void publish ()
+			{
+				m_sequences[m_back] = ++m_published;
+				
+				// The release makes the writes to the slot visible to the consumer, and the acquire makes the consumer's reads of the slot we get back complete before we write to it:
+				m_back = m_shared.exchange(m_back | FRESH, std::memory_order_acq_rel) & INDEX;
+			}
+			
+			/// The number of values published so far. Only valid on the producer thread.
+			std::uint64_t publishedCount () const { return m_published; }
+			
+			/// Take ownership of the newest published value, if there is one which hasn't already been acquired.
+			/// @returns false if nothing new was published, in which case front() is unchanged.
+			bool acquire ()
+			{
+				if (!(m_shared.load(std::memory_order_relaxed) & FRESH))
+					return false;
+				
+				m_front = m_shared.exchange(m_front, std::memory_order_acq_rel) & INDEX;
+				
+				std::uint64_t sequence = m_sequences[m_front];
+				m_dropped += sequence - m_acquired - 1;
+				m_acquired = sequence;
+				
+				return true;
+			}
+			
+			/// The most recently acquired value. Before the first successful acquire(), this is a default constructed value.
+			ValueT & front () { return m_slots[m_front]; }
+			const ValueT & front () const { return m_slots[m_front]; }
+			
+			/// The sequence number of the front value, starting from 1, or 0 if nothing has been acquired.
+			std::uint64_t frontSequence () const { return m_acquired; }
+			
+			/// The number of values which were published but replaced before they could be acquired.
+			std::uint64_t droppedCount () const { return m_dropped; }
+			
+			/// Access any slot, e.g. to set up or release storage. Only valid when neither thread is using the buffer.
+			ValueT & slot (std::size_t index) { return m_slots[index]; }
+		
+		private:
+			TripleBuffer (const TripleBuffer &);
+			TripleBuffer & operator= (const TripleBuffer &);
+	};
+}
+
+#endif
@@ -16,7 +16,7 @@
 #import <OpenGLES/ES1/gl.h>
 #import <OpenGLES/ES1/glext.h>
 
-// The number of buffers to allocate
+// The number of buffers to allocate, one each for the camera and the renderer, and one which is passed between them.
 enum {
 	ARVideoFrameBuffers = 3
 };
@@ -40,21 +40,20 @@ typedef struct {
 	
 	/// The actual image data:
 	unsigned char * data;
+	
+	/// The number of frames which were captured but replaced by newer frames since the previous call to -[ARVideoFrameController videoFrame]:
+	unsigned dropped;
 } ARVideoFrame;
 
 @class ARVideoFrameController;
 
 @protocol ARVideoFrameControllerDelegate <NSObject>
-- (void) videoFrameController:(ARVideoFrameController*)controller didCaptureFrame:(CGImageRef)buffer atTime:(CMTime)time;
+/// Called on the camera queue for every captured frame. The frame is only valid for the duration of the call, so the delegate must copy anything it wants to keep.
+- (void) videoFrameController:(ARVideoFrameController*)controller didCaptureFrame:(ARVideoFrame*)frame atTime:(CMTime)time;
 @end
 
 /// Provides simplea access to iPhone video camera in the form of ARVideoFrame data. This can then be provided to ARVideoBackground for rendering.
-@interface ARVideoFrameController : NSObject<AVCaptureVideoDataOutputSampleBufferDelegate> {
-	AVCaptureSession * captureSession;
-	ARVideoFrame videoFrames[ARVideoFrameBuffers];
-    
-	NSUInteger index;
-}
+@interface ARVideoFrameController : NSObject<AVCaptureVideoDataOutputSampleBufferDelegate>
 
 @property(nonatomic,weak) id<ARVideoFrameControllerDelegate> delegate;
 
@@ -69,11 +68,14 @@ typedef struct {
 /// Stop capturing video frames.
 - (void) stop;
 
-/// Grab the latest video frame from the camera.
-/// This video frame is buffered internally, so, the same pointer is returned every time.
+/// Grab the latest video frame from the camera. This should only be called from one thread, e.g. the renderer.
+/// The frame remains valid until the next call, and never changes while it is being used, since the camera writes into a different buffer.
 /// The ARVideoFrame::index frame counter will be incremented when the frame has changed.
 - (ARVideoFrame*) videoFrame;
 
+/// The total number of captured frames which were never returned by -videoFrame. Like -videoFrame, this should only be used by the renderer.
+@property(readonly) NSUInteger droppedFrameCount;
+
 /// @internal
 - (void) captureOutput:(AVCaptureOutput *)captureOutput didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer fromConnection:(AVCaptureConnection *)connection;
 
@@ -1,5 +1,5 @@
 //
-//  ARVideoFrameController.m
+//  ARVideoFrameController.mm
 //  This file is part of the "transform-flow" project, and is released under the MIT license.
 //
 //  Created by Samuel Williams on 5/04/11.
@@ -8,6 +8,20 @@
 
 #import "ARVideoFrameController.h"
 
+#include "ARTripleBuffer.h"
+
+@interface ARVideoFrameController () {
+	AVCaptureSession * captureSession;
+	
+	/// The camera writes into the back buffer while the renderer reads the front buffer, so neither ever waits for the other.
+	ARBrowser::TripleBuffer<ARVideoFrame> videoFrames;
+	
+	/// The number of frames captured, only used on the camera queue.
+	NSUInteger capturedCount;
+}
+
+@end
+
 @implementation ARVideoFrameController
 
 - init {
@@ -19,11 +33,6 @@
 	self = [super init];
 
 	if (self) {
-		for (NSUInteger i = 0; i < ARVideoFrameBuffers; ++i) {
-			videoFrames[i].data = NULL;
-			videoFrames[i].index = 0;
-		}
-
 		AVCaptureDevice * captureDevice = [AVCaptureDevice defaultDeviceWithMediaType:AVMediaTypeVideo];
 		
 		if (captureDevice == nil) {
@@ -76,9 +85,11 @@
 		]];
 		
 		for (NSUInteger i = 0; i < ARVideoFrameBuffers; ++i) {
-			videoFrames[i].internalFormat = GL_RGBA;
-			videoFrames[i].pixelFormat = GL_BGRA;
-			videoFrames[i].dataType = GL_UNSIGNED_BYTE;
+			ARVideoFrame & videoFrame = videoFrames.slot(i);
+			
+			videoFrame.internalFormat = GL_RGBA;
+			videoFrame.pixelFormat = GL_BGRA;
+			videoFrame.dataType = GL_UNSIGNED_BYTE;
 		}
 		
 		captureSession = [AVCaptureSession new];
@@ -135,8 +146,8 @@
 	}	
 
 	for (NSUInteger i = 0; i < ARVideoFrameBuffers; ++i) {
-		free(videoFrames[i].data);
-		videoFrames[i].data = NULL;
+		free(videoFrames.slot(i).data);
+		videoFrames.slot(i).data = NULL;
 	}
 }
 
@@ -149,14 +160,24 @@
 }
 
 - (ARVideoFrame*) videoFrame {
-	return videoFrames + (index % 2);
+	std::uint64_t dropped = videoFrames.droppedCount();
+	
+	// If there is no new frame, the previous one is returned again:
+	videoFrames.acquire();
+	videoFrames.front().dropped = (unsigned)(videoFrames.droppedCount() - dropped);
+	
+	return &videoFrames.front();
+}
+
+- (NSUInteger) droppedFrameCount {
+	return (NSUInteger)videoFrames.droppedCount();
 }
 
 - (void) captureOutput:(AVCaptureOutput *)captureOutput didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer fromConnection:(AVCaptureConnection *)connection 
 {
 	@autoreleasepool {
-		NSUInteger nextIndex = index + 1;
-		ARVideoFrame * videoFrame = videoFrames + (nextIndex % 2);
+		NSUInteger nextIndex = capturedCount + 1;
+		ARVideoFrame * videoFrame = &videoFrames.back();
 		
 		// Get the current frame time:
 		CMTime frameTime = CMSampleBufferGetPresentationTimeStamp(sampleBuffer);
@@ -174,12 +195,13 @@
 		
 		size_t count = bytesPerRow * height;
 		
-		if (index == 0) {
+		if (capturedCount == 0) {
 			NSLog(@"Image data dimensions = (%ld, %ld)", width, height);
 		}
 		
-		// Setup the video frame:
-		if (videoFrame->data == NULL) {
+		// Setup the video frame, which is reused unless the capture format changes:
+		if (videoFrame->data == NULL || videoFrame->bytesPerRow * videoFrame->size.height != count) {
+			free(videoFrame->data);
 			videoFrame->data = (unsigned char*)malloc(count);
 			
 			videoFrame->size.width = width;
@@ -189,21 +211,13 @@
 		
 		// Copy the pixel data to the video frame:
 		memcpy(videoFrame->data, baseAddress, bytesPerRow * height);
-		videoFrame->index = nextIndex;
-		index = nextIndex;
-
-		if (_delegate) {
-			CGColorSpaceRef colorSpace = CGColorSpaceCreateDeviceRGB();	
-			CGContextRef bitmapContext = CGBitmapContextCreate(baseAddress, width, height, 8, bytesPerRow, colorSpace, kCGBitmapByteOrder32Little | kCGImageAlphaPremultipliedFirst); 
-			CGImageRef bitmap = CGBitmapContextCreateImage(bitmapContext); 
-			
-			// Call the delegate with the bitmap image:
-			[_delegate videoFrameController:self didCaptureFrame:bitmap atTime:frameTime];
-			
-			CGContextRelease(bitmapContext); 
-			CGColorSpaceRelease(colorSpace);
-			CGImageRelease(bitmap);
-		}
+		videoFrame->index = (int)nextIndex;
+		capturedCount = nextIndex;
+		
+		// Hand the frame to the renderer. The camera doesn't get this buffer back until a later frame is published, so the delegate can still read it:
+		videoFrames.publish();
+		
+		[_delegate videoFrameController:self didCaptureFrame:videoFrame atTime:frameTime];
 		
 		// We unlock the pixel buffer
 		CVPixelBufferUnlockBaseAddress(imageBuffer, 0);
@@ -9,9 +9,18 @@
 #import "ARModel.h"
 
 #import "ARRendering.h"
+#import "ARBillboardAtlas.h"
 
+/// Draws a UIView as a billboard which faces the viewer. Billboards share a few large atlas textures, and only the part of the view which has changed is uploaded again.
+/// All methods must be called on the rendering thread.
 @interface ARViewModel : NSObject<ARRenderable> {
-	GLuint billboardTexture;
+	/// The billboard's place in the shared atlas, valid if _allocated is set.
+	std::size_t _page;
+	ARBrowser::AtlasRect _rect;
+	BOOL _allocated;
+	
+	/// Set once the billboard's rectangle holds its view, so that it can be drawn.
+	BOOL _uploaded;
 	
 	BOOL _dirty;
 	UIView * _overlay;
@@ -22,8 +31,14 @@
 @property(nonatomic, retain) IBOutlet UIView * overlay;
 @property(nonatomic, assign) float scale;
 
-/// Next time the billboard is generated, update the view.
+/// Upload pending billboard updates, until the given number of bytes has been uploaded. At least one update is uploaded if any are pending.
+/// @returns the number of bytes uploaded.
++ (NSUInteger) processPendingUpdatesWithinBytes: (NSUInteger)budget;
+
+/// Next time the billboard is drawn, schedule an upload of the view.
 - (void) setNeedsUpdate;
+
+/// Upload the view immediately, regardless of the budget.
 - (void) updateNow;
 
 @end
@@ -12,15 +12,208 @@
 #import <OpenGLES/ES1/gl.h>
 #import <OpenGLES/ES1/glext.h>
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using ARBrowser::AtlasRect;
+
+/// The size of each atlas texture, in pixels. Views larger than this can't be drawn.
+static const std::uint32_t ARViewModelAtlasSize = 1024;
+
+/// Each page uses 4MB of texture memory, so only a few are created. Once they are all full, fragmented pages are repacked instead.
+static const std::size_t ARViewModelMaximumPages = 4;
+
+/// Below this occupancy, a page which has no room for a billboard is considered fragmented and is repacked.
+static const double ARViewModelRepackOccupancy = 0.75;
+
+static const std::size_t ARViewModelPixelSize = 4;
+
+/// A texture holding many billboards.
+struct ARViewModelPage {
+	GLuint texture;
+	ARBrowser::SkylinePacker packer;
+	
+	/// A copy of the texture's contents, which new renderings of each view are compared against to find the part which changed.
+	std::vector<std::uint8_t> shadow;
+	
+	/// The billboards allocated in this page, so that they can be moved when it is repacked.
+	std::vector<__unsafe_unretained ARViewModel *> models;
+	
+	ARViewModelPage () : texture(0), packer(ARViewModelAtlasSize, ARViewModelAtlasSize) {
+	}
+};
+
+/// The atlas shared by all billboards, which is only accessed on the rendering thread.
+struct ARViewModelAtlas {
+	std::vector<ARViewModelPage *> pages;
+	ARBrowser::UploadScheduler scheduler;
+	
+	/// Views are rendered into the staging buffer, which is kept along with its bitmap context while views of the same size are rendered.
+	std::vector<std::uint8_t> staging;
+	CGContextRef context;
+	std::uint32_t contextWidth, contextHeight;
+	
+	/// The changed part of a view, packed for glTexSubImage2D.
+	std::vector<std::uint8_t> packed;
+	
+	ARViewModelAtlas () : context(NULL), contextWidth(0), contextHeight(0) {
+	}
+};
+
+static ARViewModelAtlas & sharedAtlas ()
+{
+	static ARViewModelAtlas * atlas = NULL;
+	static dispatch_once_t once;
+	
+	dispatch_once(&once, ^{
+		atlas = new ARViewModelAtlas;
+	});
+	
+	return *atlas;
+}
+
+static ARViewModelPage * createPage ()
+{
+	ARViewModelPage * page = new ARViewModelPage;
+	
+	page->shadow.assign(std::size_t(ARViewModelAtlasSize) * ARViewModelAtlasSize * ARViewModelPixelSize, 0);
+	
+	// Texture storage is allocated once, and billboards are uploaded into it with glTexSubImage2D:
+	glGenTextures(1, &page->texture);
+	glBindTexture(GL_TEXTURE_2D, page->texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ARViewModelAtlasSize, ARViewModelAtlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, page->shadow.data());
+	
+	return page;
+}
+
+/// Render the view into the staging buffer, with rows ordered as the texture expects them.
+static void renderView (ARViewModelAtlas & atlas, UIView * view, std::uint32_t width, std::uint32_t height)
+{
+	if (!atlas.context || atlas.contextWidth != width || atlas.contextHeight != height) {
+		if (atlas.context)
+			CGContextRelease(atlas.context);
+		
+		atlas.staging.resize(std::size_t(width) * height * ARViewModelPixelSize);
+		
+		CGColorSpaceRef colourSpace = CGColorSpaceCreateDeviceRGB();
+		atlas.context = CGBitmapContextCreate(atlas.staging.data(), width, height, 8, width * ARViewModelPixelSize, colourSpace, kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+		CGColorSpaceRelease(colourSpace);
+		
+		atlas.contextWidth = width;
+		atlas.contextHeight = height;
+	}
+	
+	// The view may be transparent, so the previous rendering must be cleared:
+	CGContextClearRect(atlas.context, CGRectMake(0, 0, width, height));
+	
+	[view.layer renderInContext:atlas.context];
+}
+
+@interface ARViewModel ()
+- (void) releaseRect;
+- (std::size_t) uploadView;
+@end
+
 @implementation ARViewModel
 
 @synthesize overlay = _overlay, scale = _scale;
 
+// These functions are defined within the implementation so that they can move billboards by updating their instance variables.
+
+/// Repack a fragmented page. Billboards which no longer fit lose their rectangle and are allocated elsewhere, and all of them are uploaded again before they are drawn.
+static void repackPage (ARViewModelAtlas & atlas, std::size_t index)
+{
+	ARViewModelPage * page = atlas.pages[index];
+	std::vector<AtlasRect> rects(page->models.size());
+	
+	for (std::size_t i = 0; i < page->models.size(); i += 1)
+		rects[i] = page->models[i]->_rect;
+	
+	page->packer.repack(rects);
+	
+	std::vector<__unsafe_unretained ARViewModel *> models;
+	models.swap(page->models);
+	
+	for (std::size_t i = 0; i < models.size(); i += 1) {
+		ARViewModel * model = models[i];
+		
+		model->_uploaded = NO;
+		
+		if (rects[i].area()) {
+			model->_rect = rects[i];
+			page->models.push_back(model);
+		} else {
+			model->_allocated = NO;
+		}
+		
+		[model setNeedsUpdate];
+	}
+}
+
+/// Find room for the given size in one of the pages, repacking or adding a page if required.
+static bool allocateRect (ARViewModelAtlas & atlas, ARViewModel * model, std::uint32_t width, std::uint32_t height, std::size_t & page, AtlasRect & rect)
+{
+	for (std::size_t i = 0; i < atlas.pages.size(); i += 1) {
+		if (atlas.pages[i]->packer.allocate(width, height, rect)) {
+			page = i;
+			atlas.pages[i]->models.push_back(model);
+			
+			return true;
+		}
+	}
+	
+	if (atlas.pages.size() < ARViewModelMaximumPages) {
+		atlas.pages.push_back(createPage());
+	} else {
+		// The least occupied page, if it is fragmented:
+		std::size_t emptiest = 0;
+		
+		for (std::size_t i = 1; i < atlas.pages.size(); i += 1) {
+			if (atlas.pages[i]->packer.statistics().occupancy() < atlas.pages[emptiest]->packer.statistics().occupancy())
+				emptiest = i;
+		}
+		
+		if (atlas.pages[emptiest]->packer.statistics().occupancy() > ARViewModelRepackOccupancy)
+			return false;
+		
+		repackPage(atlas, emptiest);
+		
+		// Try the repacked page first, since billboards which no longer fit in it can go elsewhere:
+		std::swap(atlas.pages[emptiest], atlas.pages.back());
+		
+		for (std::size_t i = 0; i < atlas.pages.size(); i += 1) {
+			for (std::size_t j = 0; j < atlas.pages[i]->models.size(); j += 1)
+				atlas.pages[i]->models[j]->_page = i;
+		}
+	}
+	
+	ARViewModelPage * last = atlas.pages.back();
+	
+	if (!last->packer.allocate(width, height, rect))
+		return false;
+	
+	page = atlas.pages.size() - 1;
+	last->models.push_back(model);
+	
+	return true;
+}
+
++ (NSUInteger) processPendingUpdatesWithinBytes: (NSUInteger)budget
+{
+	return sharedAtlas().scheduler.process(budget, [](const void * handle) {
+		ARViewModel * model = (__bridge ARViewModel *)handle;
+		
+		return [model uploadView];
+	});
+}
+
 - (id)init
 {
     self = [super init];
     if (self) {
-		glGenTextures(1, &billboardTexture);
 		_dirty = YES;
 		
 		_scale = 1.0;
@@ -30,43 +223,87 @@
 }
 
 - (void)dealloc {
-    glDeleteTextures(1, &billboardTexture);	
+	sharedAtlas().scheduler.cancel((__bridge const void *)self);
+	
+	[self releaseRect];
 }
 
-// http://stackoverflow.com/questions/4118778/render-contents-of-uiview-as-an-opengl-texture
-- (void) updateTextureWithView:(UIView *)view 
+- (void) releaseRect
 {
-    NSLog(@"Updating view texture...");
-	//GLuint saveName = 0;
-	//glGetIntegerv(GL_TEXTURE_BINDING_2D, &saveName);
+	if (!_allocated)
+		return;
 	
-	glBindTexture(GL_TEXTURE_2D, billboardTexture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	ARViewModelPage * page = sharedAtlas().pages[_page];
 	
-	// make space for an RGBA image of the view
-	GLubyte *pixelBuffer = (GLubyte *)malloc(4 * view.bounds.size.width * view.bounds.size.height);
+	page->packer.release(_rect);
+	page->models.erase(std::find(page->models.begin(), page->models.end(), self));
+	
+	_allocated = NO;
+	_uploaded = NO;
+}
 
-	// create a suitable CoreGraphics context
-	CGColorSpaceRef colourSpace = CGColorSpaceCreateDeviceRGB();
-	CGContextRef context = CGBitmapContextCreate(pixelBuffer, 
-		view.bounds.size.width, view.bounds.size.height, 
-		8, 4*view.bounds.size.width, 
-		colourSpace, 
-		kCGImageAlphaPremultipliedLast | kCGBitmapByteOrder32Big);
+/// Upload the part of the view which has changed since it was last uploaded.
+/// @returns the number of bytes uploaded.
+- (std::size_t) uploadView
+{
+	UIView * view = _overlay;
 	
-	CGColorSpaceRelease(colourSpace);
+	if (!view)
+		return 0;
 	
-	// draw the view to the buffer
-	[view.layer renderInContext:context];
+	std::uint32_t width = view.bounds.size.width, height = view.bounds.size.height;
 	
-	// upload to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, view.bounds.size.width, view.bounds.size.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixelBuffer);
-
-	// clean up
-	CGContextRelease(context);
-	free(pixelBuffer);
+	if (width == 0 || height == 0)
+		return 0;
+	
+	ARViewModelAtlas & atlas = sharedAtlas();
+	
+	if (!_allocated || _rect.width != width || _rect.height != height) {
+		[self releaseRect];
+		
+		if (!allocateRect(atlas, self, width, height, _page, _rect)) {
+			NSLog(@"No room in the billboard atlas for a view of size %dx%d", (int)width, (int)height);
+			
+			return 0;
+		}
+		
+		_allocated = YES;
+	}
+	
+	renderView(atlas, view, width, height);
+	
+	ARViewModelPage * page = atlas.pages[_page];
+	const std::size_t pageStride = ARViewModelAtlasSize * ARViewModelPixelSize, stride = width * ARViewModelPixelSize;
+	std::uint8_t * shadow = page->shadow.data() + _rect.y * pageStride + _rect.x * ARViewModelPixelSize;
+	
+	// The shadow always matches the texture, so only the part which differs from it needs to be uploaded, even if the rectangle was previously used by another billboard:
+	AtlasRect changed;
+	
+	if (!ARBrowser::changedRect(shadow, pageStride, atlas.staging.data(), stride, width, height, changed)) {
+		_uploaded = YES;
+		
+		return 0;
+	}
 	
-	//glBindTexture(GL_TEXTURE_2D, saveName);
+	for (std::uint32_t y = changed.y; y < changed.y + changed.height; y += 1)
+		std::memcpy(shadow + y * pageStride + changed.x * ARViewModelPixelSize, atlas.staging.data() + y * stride + changed.x * ARViewModelPixelSize, changed.width * ARViewModelPixelSize);
+	
+	// Rows of the full width are already contiguous in the staging buffer:
+	const std::uint8_t * pixels = atlas.staging.data() + changed.y * stride;
+	
+	if (changed.width != width) {
+		atlas.packed.resize(changed.area() * ARViewModelPixelSize);
+		ARBrowser::copyRect(atlas.staging.data(), stride, changed, atlas.packed.data());
+		
+		pixels = atlas.packed.data();
+	}
+	
+	glBindTexture(GL_TEXTURE_2D, page->texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, _rect.x + changed.x, _rect.y + changed.y, changed.width, changed.height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	
+	_uploaded = YES;
+	
+	return changed.area() * ARViewModelPixelSize;
 }
 
 - (void) setNeedsUpdate
@@ -76,19 +313,28 @@
 
 - (void) updateNow
 {
-	[self updateTextureWithView:_overlay];
+	sharedAtlas().scheduler.cancel((__bridge const void *)self);
+	
+	[self uploadView];
 	_dirty = NO;
 }
 
+
 - (void) draw
 {
 	using namespace Euclid::Numerics;
 
-	// We can only update if there was a view given.
+	// We can only update if there was a view given. The upload is done by +processPendingUpdatesWithinBytes:, and until the first one the billboard isn't drawn:
 	if (_dirty && _overlay) {
-		[self updateNow];
+		std::size_t bytes = _overlay.bounds.size.width * _overlay.bounds.size.height * ARViewModelPixelSize;
+		
+		sharedAtlas().scheduler.request((__bridge const void *)self, bytes);
+		_dirty = NO;
 	}
 	
+	if (!_uploaded)
+		return;
+	
 	// ARBrowser::renderMarker(1.0);
 	
 	// Draw view rectangle
@@ -100,11 +346,16 @@
 		 s,  s,  0,
 	};
 	
+	// The billboard's rectangle in the atlas, inset by half a pixel so that linear filtering never samples its neighbours:
+	const float size = ARViewModelAtlasSize;
+	float u0 = (_rect.x + 0.5) / size, u1 = (_rect.x + _rect.width - 0.5) / size;
+	float v0 = (_rect.y + 0.5) / size, v1 = (_rect.y + _rect.height - 0.5) / size;
+	
 	float texCoords[] = {
-		1.0, 0.0,
-		0.0, 0.0,
-		0.0, 1.0,
-		1.0, 1.0
+		u1, v0,
+		u0, v0,
+		u0, v1,
+		u1, v1
 	};
 	
 	Mat44 m;
@@ -164,7 +415,7 @@
 	}
 	
 	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, billboardTexture);
+	glBindTexture(GL_TEXTURE_2D, sharedAtlas().pages[_page]->texture);
 	
 	glEnable (GL_BLEND);
 	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -188,15 +439,17 @@
 
 - (ARBoundingSphere) boundingSphere
 {
-	// Billboard is always bounded by the sphere of size _scale, because it is always pointing at the user.
-	ARBoundingSphere sphere = {Vec3(0, 0, 0), _scale};
+	// Billboard is always bounded by the sphere through its corners, because it is always pointing at the user.
+	ARBoundingSphere sphere = {Vec3(0, 0, 0), _scale * (float)M_SQRT2};
 		
 	return sphere;
 }
 
 - (ARBrowser::BoundingBox) boundingBox
 {
-	ARBrowser::BoundingBox box(Vec3(-_scale, -_scale, -_scale), Vec3(_scale, _scale, _scale));
+	// The billboard turns to face the viewer, so the box must contain its bounding sphere rather than just the unrotated quad:
+	float extent = _scale * (float)M_SQRT2;
+	ARBrowser::BoundingBox box(Vec3(-extent, -extent, -extent), Vec3(extent, extent, extent));
 
 	return box;
 }
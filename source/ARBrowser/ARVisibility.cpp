@@ -0,0 +1,132 @@
+//
+//  ARVisibility.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#include "ARVisibility.h"
+
+#include <cmath>
+
+namespace ARBrowser {
+	VisibilityStage::VisibilityStage (double rebaseDistance) : m_rebaseDistance(rebaseDistance), m_hasReference(false), m_reference(0, 0, 0), m_generation(0) {
+		resetStatistics();
+	}
+	
+	void VisibilityStage::invalidate () {
+		m_hasReference = false;
+		m_cache.clear();
+	}
+	
+	void VisibilityStage::resetStatistics () {
+		m_statistics.recomputed = m_statistics.reused = m_statistics.rebases = m_statistics.updates = 0;
+	}
+	
+	void VisibilityStage::rebase (double latitude, double longitude, double altitude) {
+		m_reference = GeodeticOrigin(latitude, longitude, altitude);
+		m_hasReference = true;
+		
+		m_cache.clear();
+		m_statistics.rebases += 1;
+	}
+	
+	void VisibilityStage::recompute (const std::vector<VisibilityPoint> & points) {
+		std::size_t count = m_pending.size();
+		
+		if (count == 0) return;
+		
+		m_latitudes.resize(count); m_longitudes.resize(count); m_altitudes.resize(count);
+		m_east.resize(count); m_north.resize(count); m_up.resize(count);
+		
+		for (std::size_t i = 0; i < count; i += 1) {
+			const VisibilityPoint & point = points[m_pending[i]];
+			
+			m_latitudes[i] = point.latitude;
+			m_longitudes[i] = point.longitude;
+			m_altitudes[i] = point.altitude;
+		}
+		
+		m_reference.convertToENU(count, m_latitudes.data(), m_longitudes.data(), m_altitudes.data(), m_east.data(), m_north.data(), m_up.data());
+		
+		for (std::size_t i = 0; i < count; i += 1) {
+			const VisibilityPoint & point = points[m_pending[i]];
+			
+			Cached cached = {point.latitude, point.longitude, point.altitude, Vec3(m_east[i], m_north[i], m_up[i]), m_generation};
+			m_cache[point.handle] = cached;
+		}
+		
+		m_statistics.recomputed += count;
+	}
+	
+	void VisibilityStage::update (double latitude, double longitude, double altitude, const std::vector<VisibilityPoint> & points, const VisibilityParameters & parameters) {
+		m_generation += 1;
+		m_statistics.updates += 1;
+		
+		double east = 0, north = 0, up = 0;
+		
+		if (m_hasReference) {
+			m_reference.convertToENU(1, &latitude, &longitude, &altitude, &east, &north, &up);
+		}
+		
+		if (!m_hasReference || std::sqrt(east*east + north*north + up*up) > m_rebaseDistance) {
+			rebase(latitude, longitude, altitude);
+			
+			east = north = up = 0;
+		}
+		
+		// Find the points which are new or have moved:
+		m_pending.clear();
+		
+		for (std::size_t i = 0; i < points.size(); i += 1) {
+			const VisibilityPoint & point = points[i];
+			auto cached = m_cache.find(point.handle);
+			
+			if (cached != m_cache.end() && cached->second.latitude == point.latitude && cached->second.longitude == point.longitude && cached->second.altitude == point.altitude) {
+				cached->second.generation = m_generation;
+			} else {
+				m_pending.push_back(i);
+			}
+		}
+		
+		m_statistics.reused += points.size() - m_pending.size();
+		recompute(points);
+		
+		// Forget points which are no longer candidates, once they outnumber the current points:
+		if (m_cache.size() > points.size() * 2 + 64) {
+			for (auto i = m_cache.begin(); i != m_cache.end();) {
+				if (i->second.generation != m_generation)
+					i = m_cache.erase(i);
+				else
+					++i;
+			}
+		}
+		
+		// Build the table relative to the current location:
+		Vec3 offset(east, north, up);
+		
+		m_entries.clear();
+		
+		for (std::size_t i = 0; i < points.size(); i += 1) {
+			VisibilityEntry entry;
+			
+			entry.handle = points[i].handle;
+			entry.delta = m_cache[entry.handle].delta - offset;
+			entry.distance = std::sqrt(entry.delta[X] * entry.delta[X] + entry.delta[Y] * entry.delta[Y]);
+			entry.flags = 0;
+			
+			if (entry.distance >= parameters.minimumDistance && entry.distance <= parameters.maximumDistance)
+				entry.flags |= VisibilityEntry::VISIBLE;
+			
+			if (entry.distance <= parameters.radarDistance)
+				entry.flags |= VisibilityEntry::RADAR;
+			
+			if (entry.flags) {
+				entry.bearing = std::atan2(entry.delta[X], entry.delta[Y]) * (180.0 / M_PI);
+				
+				m_entries.push_back(entry);
+			}
+		}
+	}
+}
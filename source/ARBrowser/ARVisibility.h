@@ -0,0 +1,123 @@
+//
+//  ARVisibility.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#ifndef _ARBROWSER_VISIBILITY_H
+#define _ARBROWSER_VISIBILITY_H
+
+#include "ARGeodetic.h"
+
+#include <Euclid/Numerics/Vector.h>
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ARBrowser {
+	using namespace Euclid::Numerics;
+	
+	/// A candidate point, identified by an opaque handle, e.g. an ARWorldPoint.
+	struct VisibilityPoint {
+		const void * handle;
+		double latitude, longitude, altitude;
+	};
+	
+	/// The position of a point relative to the viewer.
+	struct VisibilityEntry {
+		enum Flags {
+			/// Within the distance range for drawing.
+			VISIBLE = 1,
+			/// Within the distance range of the radar.
+			RADAR = 2
+		};
+		
+		const void * handle;
+		
+		/// Local east, north, up offset from the viewer, in meters.
+		Vec3 delta;
+		
+		/// The distance ignoring altitude, i.e. as the bird flies.
+		float distance;
+		
+		/// Degrees clockwise from north.
+		float bearing;
+		
+		unsigned flags;
+	};
+	
+	struct VisibilityParameters {
+		/// Points closer than this are not visible.
+		float minimumDistance;
+		/// Points further away than this are not visible.
+		float maximumDistance;
+		/// Points further away than this are not shown on the radar.
+		float radarDistance;
+	};
+	
+	/// Calculates the position of points relative to the viewer once per frame, in a table which is shared by everything drawn that frame.
+	/// Offsets are calculated relative to a reference origin and cached for each point. While the viewer stays within the rebase distance of the reference origin, the cached offsets are translated rather than recalculated, so only points which have moved need any geodetic calculations.
+	class VisibilityStage {
+		public:
+			struct Statistics {
+				/// Points whose offset was calculated.
+				std::size_t recomputed;
+				/// Points whose cached offset was used.
+				std::size_t reused;
+				/// The number of times the reference origin moved.
+				std::size_t rebases;
+				std::size_t updates;
+			};
+			
+		protected:
+			struct Cached {
+				double latitude, longitude, altitude;
+				
+				/// The offset from the reference origin.
+				Vec3 delta;
+				
+				std::size_t generation;
+			};
+			
+			double m_rebaseDistance;
+			
+			bool m_hasReference;
+			GeodeticOrigin m_reference;
+			
+			std::unordered_map<const void *, Cached> m_cache;
+			std::size_t m_generation;
+			
+			std::vector<VisibilityEntry> m_entries;
+			
+			// Scratch buffers for batch calculations:
+			std::vector<std::size_t> m_pending;
+			std::vector<double> m_latitudes, m_longitudes, m_altitudes, m_east, m_north, m_up;
+			
+			Statistics m_statistics;
+			
+			void rebase (double latitude, double longitude, double altitude);
+			void recompute (const std::vector<VisibilityPoint> & points);
+			void collect ();
+			
+		public:
+			/// @param rebaseDistance how far the viewer can move, in meters, before all offsets are recalculated. Translating offsets ignores the curvature of the earth, so the error grows with this distance and with the distance of the points.
+			VisibilityStage (double rebaseDistance = 25.0);
+			
+			/// Update the table for the viewer at the given location, in degrees and meters.
+			void update (double latitude, double longitude, double altitude, const std::vector<VisibilityPoint> & points, const VisibilityParameters & parameters);
+			
+			/// Points with at least one flag set, in the order given to update.
+			const std::vector<VisibilityEntry> & entries () const { return m_entries; }
+			
+			/// Forget all cached offsets, e.g. if the point set is replaced.
+			void invalidate ();
+			
+			const Statistics & statistics () const { return m_statistics; }
+			void resetStatistics ();
+	};
+}
+
+#endif
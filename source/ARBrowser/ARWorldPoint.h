@@ -16,8 +16,12 @@ typedef struct {
 	float radius;
 } ARBoundingSphere;
 
+#include <memory>
+
 namespace ARBrowser {
 	class BoundingBox;
+	class TriangleHierarchy;
+	class RenderQueue;
 };
 
 /// Provides the basic interface for renderable objects on the screen.
@@ -30,6 +34,28 @@ namespace ARBrowser {
 
 /// Returns a bounding box for the object.
 - (ARBrowser::BoundingBox) boundingBox;
+
+@optional
+/// Returns NO while the object is loading, in which case a placeholder is drawn instead.
+- (BOOL) isReady;
+
+/// Called after drawing a frame in which the object was not drawn, e.g. because it was culled or left the visible range, so that it can release resources which are only needed for drawing.
+- (void) didBecomeHidden;
+
+/// Choose the level of detail to draw the object at, given the size of one unit of the object on screen in pixels, and the level it was previously drawn at. Level 0 is full detail.
+- (NSUInteger) levelOfDetailForPixelsPerUnit: (float)pixelsPerUnit previous: (NSUInteger)previous;
+
+/// Draw the object at a level of detail returned by -levelOfDetailForPixelsPerUnit:previous:.
+- (void) drawAtLevelOfDetail: (NSUInteger)level;
+
+/// Add the meshes of the object at the given level of detail to the queue, with the given world transform and distance from the viewer, instead of drawing them immediately. The queue draws the meshes of all objects in the order which changes the least state, before the end of the frame.
+- (void) enqueueAtLevelOfDetail: (NSUInteger)level transform: (const float *)transform depth: (float)depth inQueue: (ARBrowser::RenderQueue &)queue;
+
+/// The number of triangles drawn at the given level of detail, used by the render budget and for profiling.
+- (NSUInteger) triangleCountAtLevelOfDetail: (NSUInteger)level;
+
+/// The triangles of the object, used to select it exactly when tapped. If not implemented or NULL, the bounding box is used instead.
+- (std::shared_ptr<const ARBrowser::TriangleHierarchy>) triangleHierarchy;
 @end
 
 /// Provides a renderable model and associated metadata for a given ARWorldLocation.
@@ -48,6 +74,12 @@ namespace ARBrowser {
 /// Return true of the point will render using earth-centered earth-fixed coordinates:
 @property(nonatomic,assign) BOOL fixed;
 
+/// The level of detail the model was last drawn at, which is used to avoid switching back and forth when the model's size on screen is close to a threshold.
+@property(nonatomic,assign) NSUInteger levelOfDetail;
+
+/// The number of points this point stood for when it was last drawn, including itself, e.g. so that a billboard can show how many points it hides. Points which overlap on screen are drawn as one, the nearest.
+@property(nonatomic,assign) NSUInteger clusterSize;
+
 /// Title for MKAnnotation (returns metadata.title)
 - (NSString *)title;
 
@@ -7,6 +7,13 @@
 //
 
 #import "ARWorldPoint.h"
+#import "ARWorldPointIndex.h"
+
+@interface ARWorldPoint () {
+	/// The index which contains this point, which is updated when the point moves.
+	__weak ARWorldPointIndex * _index;
+}
+@end
 
 @implementation ARWorldPoint
 
@@ -27,6 +34,23 @@
 	self.metadata = nil;
 }
 
+- (ARWorldPointIndex *) index
+{
+	return _index;
+}
+
+- (void) setIndex: (ARWorldPointIndex *)index
+{
+	_index = index;
+}
+
+- (void) setCoordinate:(CLLocationCoordinate2D)coordinate altitude:(ARLocationAltitude)altitude
+{
+	[super setCoordinate:coordinate altitude:altitude];
+	
+	[_index updateWorldPoint:self];
+}
+
 - (NSString*) description {
 	id name = [_metadata objectForKey:@"name"];
 	
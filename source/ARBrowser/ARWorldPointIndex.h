@@ -0,0 +1,35 @@
+//
+//  ARWorldPointIndex.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "ARWorldPoint.h"
+
+/// A spatial index of world points, for finding the points near a given location without checking every point.
+/// Points which move, i.e. with -[ARWorldLocation setCoordinate:altitude:], are updated automatically. A point can only belong to one index at a time. This class is thread safe.
+@interface ARWorldPointIndex : NSObject
+
+/// The number of points in the index.
+@property(readonly) NSUInteger count;
+
+/// Add the point to the index, removing it from any other index.
+- (void) addWorldPoint: (ARWorldPoint*)point;
+
+/// Remove the point from the index.
+- (void) removeWorldPoint: (ARWorldPoint*)point;
+
+/// Replace the contents of the index with the given points.
+- (void) setWorldPoints: (NSArray*)points;
+
+/// Update the location of a point in the index. Called automatically when an indexed point moves.
+- (void) updateWorldPoint: (ARWorldPoint*)point;
+
+/// Returns all points within the given great circle distance of the location, in no particular order.
+- (NSArray*) pointsWithinDistance: (CLLocationDistance)distance ofLocation: (ARWorldLocation*)location;
+
+@end
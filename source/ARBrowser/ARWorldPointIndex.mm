@@ -0,0 +1,127 @@
+//
+//  ARWorldPointIndex.mm
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#import "ARWorldPointIndex.h"
+
+#include "ARSpatialIndex.h"
+
+#include <mutex>
+
+@interface ARWorldPoint (ARWorldPointIndex)
+@property(nonatomic,weak) ARWorldPointIndex * index;
+@end
+
+@interface ARWorldPointIndex () {
+	std::mutex _mutex;
+	ARBrowser::SpatialIndex _index;
+	
+	/// Retains the points, since the spatial index only holds their addresses.
+	NSMutableSet * _points;
+}
+@end
+
+@implementation ARWorldPointIndex
+
+- (id) init
+{
+	self = [super init];
+	
+	if (self) {
+		_points = [NSMutableSet new];
+	}
+	
+	return self;
+}
+
+- (void) dealloc
+{
+	for (ARWorldPoint * point in _points) {
+		if (point.index == self)
+			point.index = nil;
+	}
+}
+
+- (NSUInteger) count
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	
+	return _index.size();
+}
+
+- (void) addWorldPoint: (ARWorldPoint*)point
+{
+	ARWorldPointIndex * previous = point.index;
+	
+	if (previous && previous != self)
+		[previous removeWorldPoint:point];
+	
+	point.index = self;
+	
+	std::lock_guard<std::mutex> lock(_mutex);
+	
+	[_points addObject:point];
+	_index.insert((__bridge const void *)point, point.coordinate.latitude, point.coordinate.longitude);
+}
+
+- (void) removeWorldPoint: (ARWorldPoint*)point
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	
+	if ([_points containsObject:point]) {
+		if (point.index == self)
+			point.index = nil;
+		
+		_index.remove((__bridge const void *)point);
+		[_points removeObject:point];
+	}
+}
+
+- (void) setWorldPoints: (NSArray*)points
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		
+		for (ARWorldPoint * point in _points) {
+			if (point.index == self)
+				point.index = nil;
+		}
+		
+		_index.clear();
+		[_points removeAllObjects];
+	}
+	
+	for (ARWorldPoint * point in points)
+		[self addWorldPoint:point];
+}
+
+- (void) updateWorldPoint: (ARWorldPoint*)point
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	
+	if ([_points containsObject:point])
+		_index.move((__bridge const void *)point, point.coordinate.latitude, point.coordinate.longitude);
+}
+
+- (NSArray*) pointsWithinDistance: (CLLocationDistance)distance ofLocation: (ARWorldLocation*)location
+{
+	std::vector<ARBrowser::SpatialIndex::HandleT> handles;
+	
+	std::lock_guard<std::mutex> lock(_mutex);
+	
+	_index.query(location.coordinate.latitude, location.coordinate.longitude, distance, handles);
+	
+	NSMutableArray * points = [NSMutableArray arrayWithCapacity:handles.size()];
+	
+	for (std::size_t i = 0; i < handles.size(); i += 1) {
+		[points addObject:(__bridge ARWorldPoint *)handles[i]];
+	}
+	
+	return points;
+}
+
+@end
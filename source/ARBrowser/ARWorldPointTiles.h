@@ -0,0 +1,34 @@
+//
+//  ARWorldPointTiles.h
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#import <Foundation/Foundation.h>
+
+#import "ARWorldPoint.h"
+
+/// Points stored in a tiled .arpoi file, e.g. written by tools/poi-tile-build. The file is memory mapped and only the tiles near the viewer are read, so a whole region can be browsed without every point being in memory at once.
+/// Points are created when they come within range of a query and released when they leave it. The tiles the viewer is moving towards are read in the background. This class is thread safe.
+@interface ARWorldPointTiles : NSObject
+
+/// Map the given .arpoi file.
+/// @returns nil if the file can't be opened, or is not a valid .arpoi file.
+- (id) initWithPath: (NSString*)path;
+
+/// The number of points in the file.
+@property(readonly) NSUInteger count;
+
+/// Called for each point when it is created, e.g. to choose a model for its category. The point's metadata contains the "title", "subtitle" and "category" of the stored point. Called on the thread which queries the points, while the tiles are locked.
+@property(copy) void (^pointLoaded)(ARWorldPoint * point);
+
+/// How far ahead of the viewer tiles are read, in seconds at the viewer's current velocity. Defaults to 30 seconds.
+@property(assign) NSTimeInterval prefetchTime;
+
+/// Returns all points within the given great circle distance of the location, in no particular order. A point is the same object for as long as it stays within range.
+/// The viewer's velocity is estimated from the locations of successive queries, and used to read the tiles ahead of them.
+- (NSArray*) pointsWithinDistance: (CLLocationDistance)distance ofLocation: (ARWorldLocation*)location;
+
+@end
@@ -0,0 +1,99 @@
+//
+//  ARWorldPointTiles.mm
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+#import "ARWorldPointTiles.h"
+
+#include "ARPointTiles.h"
+
+#include <mutex>
+#include <unordered_map>
+
+@interface ARWorldPointTiles () {
+	std::mutex _mutex;
+	ARBrowser::PointTiles _tiles;
+	ARBrowser::MotionEstimate _motion;
+	
+	/// The points within range of the last query, by record, and scratch space for the next query.
+	std::unordered_map<std::uint32_t, ARWorldPoint *> _points, _nextPoints;
+	std::vector<std::uint32_t> _results;
+}
+@end
+
+@implementation ARWorldPointTiles
+
+- (id) initWithPath: (NSString*)path
+{
+	self = [super init];
+	
+	if (self) {
+		if (!_tiles.open([path fileSystemRepresentation])) {
+			NSLog(@"Couldn't open point tiles: %@", path);
+			
+			return nil;
+		}
+		
+		_prefetchTime = 30.0;
+	}
+	
+	return self;
+}
+
+- (NSUInteger) count
+{
+	return _tiles.size();
+}
+
+- (ARWorldPoint *) loadPoint: (std::uint32_t)index
+{
+	const ARBrowser::PointRecord & record = _tiles.record(index);
+	ARWorldPoint * point = [ARWorldPoint new];
+	
+	CLLocationCoordinate2D coordinate = {record.latitude / 1e7, record.longitude / 1e7};
+	[point setCoordinate:coordinate altitude:record.altitude];
+	
+	[point.metadata setObject:[NSString stringWithUTF8String:_tiles.string(record.title)] forKey:@"title"];
+	[point.metadata setObject:[NSString stringWithUTF8String:_tiles.string(record.subtitle)] forKey:@"subtitle"];
+	[point.metadata setObject:[NSString stringWithUTF8String:_tiles.string(record.category)] forKey:@"category"];
+	
+	if (_pointLoaded)
+		_pointLoaded(point);
+	
+	return point;
+}
+
+- (NSArray*) pointsWithinDistance: (CLLocationDistance)distance ofLocation: (ARWorldLocation*)location
+{
+	CLLocationCoordinate2D coordinate = location.coordinate;
+	
+	std::lock_guard<std::mutex> lock(_mutex);
+	
+	_results.clear();
+	_tiles.query(coordinate.latitude, coordinate.longitude, distance, _results);
+	
+	NSMutableArray * points = [NSMutableArray arrayWithCapacity:_results.size()];
+	
+	// Points which are still in range are reused, so that the browser view sees the same objects from one frame to the next:
+	for (std::uint32_t index : _results) {
+		auto existing = _points.find(index);
+		ARWorldPoint * point = existing != _points.end() ? existing->second : [self loadPoint:index];
+		
+		_nextPoints[index] = point;
+		[points addObject:point];
+	}
+	
+	// Points which are no longer in range are released:
+	_points.swap(_nextPoints);
+	_nextPoints.clear();
+	
+	_motion.update([NSProcessInfo processInfo].systemUptime, coordinate.latitude, coordinate.longitude);
+	_tiles.prefetch(coordinate.latitude, coordinate.longitude, distance, _motion.east(), _motion.north(), _prefetchTime);
+	
+	return points;
+}
+
+@end
@@ -0,0 +1,351 @@
+//
+//  armesh-bake.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Converts <tt>[directory]/[name].obj</tt> and <tt>[name].mtl</tt> into <tt>[directory]/[name].armesh</tt>, which ARBrowser::Model loads in preference to the .obj file. The levels of detail and the picking hierarchy are built here and stored in the file, so that loading the model doesn't have to build them. The baked file is read back and compared with the source meshes before the tool exits, and copies with corrupt indices are checked to be rejected.
+//
+// With --quantize, meshes are stored using QuantizedVertex, which is half the size of ObjMeshVertex, unless the error of the quantized vertices exceeds the tolerance, in which case the mesh is stored unchanged. The position tolerance is ERROR times the radius of the model, 0.0001 by default, normals may differ by up to 1 degree and texture coordinates by up to 1/8192. The error of each mesh is printed.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/armesh-bake.cpp source/ARBrowser/ARObjLoader.cpp source/ARBrowser/ARMappedFile.cpp source/ARBrowser/ARMesh.cpp source/ARBrowser/ARBakedMesh.cpp source/ARBrowser/ARLevelOfDetail.cpp source/ARBrowser/ARPicking.cpp -o armesh-bake
+//
+// Usage:
+//	armesh-bake [--quantize[=ERROR]] source/ARBrowser/models/coffee [model]
+
+#include "ARObjLoader.h"
+#include "ARBakedMesh.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace ARBrowser;
+
+static const float DEFAULT_POSITION_ERROR = 0.0001;
+static const float NORMAL_ERROR = 1.0;
+static const float TEXCOORD_ERROR = 1.0 / 8192.0;
+
+static bool verifyMesh (const IndexedMesh & source, const QuantizedMesh * quantized, const MeshBuffer & baked) {
+	if (source.material != *baked.material || source.vertices.size() != baked.vertexCount || source.indexCount() != baked.indexCount || source.usesShortIndices() != baked.shortIndices)
+		return false;
+	
+	MeshBuffer buffer = quantized ? quantized->buffer(source) : source.buffer();
+	std::size_t vertexSize = quantized ? sizeof(QuantizedVertex) : sizeof(ObjMeshVertex);
+	
+	if ((buffer.quantizedVertices == NULL) != (baked.quantizedVertices == NULL))
+		return false;
+	
+	if (quantized && std::memcmp(buffer.decode, baked.decode, sizeof(VertexDecode)) != 0)
+		return false;
+	
+	if (buffer.vertexCount && std::memcmp(buffer.vertexData(), baked.vertexData(), vertexSize * buffer.vertexCount) != 0)
+		return false;
+	
+	std::size_t indexSize = buffer.shortIndices ? 2 : 4;
+	
+	if (buffer.indexCount && std::memcmp(buffer.indices, baked.indices, indexSize * buffer.indexCount) != 0)
+		return false;
+	
+	return true;
+}
+
+static bool verifyIndices (const MeshBuffer & source, const MeshBuffer & baked) {
+	if (source.indexCount != baked.indexCount || source.shortIndices != baked.shortIndices || source.vertexData() != baked.vertexData())
+		return false;
+	
+	std::size_t indexSize = source.shortIndices ? 2 : 4;
+	
+	return source.indexCount == 0 || std::memcmp(source.indices, baked.indices, indexSize * source.indexCount) == 0;
+}
+
+static bool verifyDetail (const LevelOfDetail & source, const BakedMesh & baked) {
+	LevelOfDetail detail;
+	
+	if (!baked.loadDetail(detail) || detail.levelCount() != source.levelCount())
+		return false;
+	
+	for (std::size_t i = 0; i < detail.levelCount(); i += 1) {
+		const LevelOfDetail::Level & level = detail.level(i), & expected = source.level(i);
+		
+		if (level.error != expected.error || level.triangleCount != expected.triangleCount || level.meshes.size() != baked.meshCount())
+			return false;
+		
+		// The levels must share the vertices of the baked meshes:
+		for (std::size_t j = 0; j < level.meshes.size(); j += 1) {
+			MeshBuffer mesh = baked.mesh(j);
+			
+			if (i > 0) {
+				mesh.indices = expected.meshes[j].indices;
+				mesh.indexCount = expected.meshes[j].indexCount;
+			}
+			
+			if (!verifyIndices(mesh, level.meshes[j]))
+				return false;
+		}
+	}
+	
+	return true;
+}
+
+static bool verifyHierarchy (const TriangleHierarchy & source, const BakedMesh & baked) {
+	TriangleHierarchy triangles;
+	
+	if (!baked.loadHierarchy(triangles) || triangles.nodeCount() != source.nodeCount() || triangles.triangleCount() != source.triangleCount())
+		return false;
+	
+	return std::memcmp(triangles.nodes(), source.nodes(), sizeof(HierarchyNode) * source.nodeCount()) == 0
+		&& std::memcmp(triangles.triangles(), source.triangles(), sizeof(float) * 9 * source.triangleCount()) == 0;
+}
+
+static bool verify (const std::string & path, const std::vector<IndexedMesh> & meshes, const std::vector<QuantizedMesh> & quantized, const std::vector<MaterialDescription> & materials, const LevelOfDetail & detail, const TriangleHierarchy & triangles) {
+	BakedMesh baked;
+	
+	if (!baked.open(path))
+		return false;
+	
+	if (baked.meshCount() != meshes.size() || baked.materialCount() != materials.size()) {
+		std::cerr << "Mesh or material count differs!" << std::endl;
+		return false;
+	}
+	
+	for (std::size_t i = 0; i < meshes.size(); i += 1) {
+		const QuantizedMesh * mesh = (quantized.empty() || quantized[i].vertices.empty()) ? NULL : &quantized[i];
+		
+		if (!verifyMesh(meshes[i], mesh, baked.mesh(i))) {
+			std::cerr << "Mesh " << i << " differs!" << std::endl;
+			return false;
+		}
+	}
+	
+	for (std::size_t i = 0; i < materials.size(); i += 1) {
+		MaterialDescription material = baked.material(i);
+		
+		if (material.name != materials[i].name || material.diffuseMapPath != materials[i].diffuseMapPath || std::memcmp(&material.ambient, &materials[i].ambient, sizeof(Color4f)) != 0) {
+			std::cerr << "Material " << materials[i].name << " differs!" << std::endl;
+			return false;
+		}
+	}
+	
+	if (!verifyDetail(detail, baked)) {
+		std::cerr << "Levels of detail differ!" << std::endl;
+		return false;
+	}
+	
+	if (!triangles.empty() && !verifyHierarchy(triangles, baked)) {
+		std::cerr << "Picking hierarchy differs!" << std::endl;
+		return false;
+	}
+	
+	return true;
+}
+
+/// Write a copy of the baked file with the given change, and check that it can't be opened.
+template <typename FunctionT>
+static bool rejectsCorruption (const std::string & path, const std::vector<char> & data, FunctionT corrupt) {
+	std::vector<char> copy = data;
+	corrupt(copy.data());
+	
+	std::string corruptPath = path + ".corrupt";
+	std::ofstream(corruptPath.c_str(), std::ios::binary).write(copy.data(), copy.size());
+	
+	// The error is expected, so don't print it:
+	std::ostringstream errors;
+	std::streambuf * previous = std::cerr.rdbuf(errors.rdbuf());
+	
+	BakedMesh baked;
+	bool opened = baked.open(corruptPath);
+	
+	std::cerr.rdbuf(previous);
+	baked.close();
+	std::remove(corruptPath.c_str());
+	
+	return !opened;
+}
+
+/// Indices beyond the vertices of their mesh, or which don't form whole triangles, would be read outside the vertex array when drawing or picking.
+static bool verifyCorruptIndices (const std::string & path) {
+	std::ifstream input(path.c_str(), std::ios::binary);
+	std::vector<char> data((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	
+	const BakedMeshHeader * header = (const BakedMeshHeader *)data.data();
+	const BakedMeshRecord * meshes = (const BakedMeshRecord *)(header + 1);
+	const BakedIndexRecord * levels = (const BakedIndexRecord *)((const char *)(meshes + header->meshCount) + sizeof(BakedMaterialRecord) * header->materialCount + sizeof(BakedLevelRecord) * header->levelCount);
+	
+	for (std::size_t i = 0; i < header->meshCount; i += 1) {
+		const std::size_t recordOffset = sizeof(BakedMeshHeader) + sizeof(BakedMeshRecord) * i;
+		const BakedMeshRecord record = meshes[i];
+		
+		if (record.indexCount < 3)
+			continue;
+		
+		// The last index refers to the vertex after the last one:
+		bool outOfRange = rejectsCorruption(path, data, [&](char * file) {
+			char * index = file + record.indexOffset + record.indexSize * (record.indexCount - 1);
+			
+			if (record.indexSize == 2)
+				*(std::uint16_t *)index = (std::uint16_t)record.vertexCount;
+			else
+				*(std::uint32_t *)index = record.vertexCount;
+		});
+		
+		// A partial triangle at the end:
+		bool partial = rejectsCorruption(path, data, [&](char * file) {
+			((BakedMeshRecord *)(file + recordOffset))->indexCount -= 1;
+		});
+		
+		if (!outOfRange || !partial) {
+			std::cerr << "Mesh " << i << " with corrupt indices was not rejected!" << std::endl;
+			return false;
+		}
+		
+		// The same for the first simplified level, whose indices refer to the same vertices:
+		if (header->levelCount > 1 && levels[i].indexCount >= 3) {
+			const BakedIndexRecord level = levels[i];
+			
+			bool levelOutOfRange = rejectsCorruption(path, data, [&](char * file) {
+				char * index = file + level.indexOffset;
+				
+				if (record.indexSize == 2)
+					*(std::uint16_t *)index = (std::uint16_t)record.vertexCount;
+				else
+					*(std::uint32_t *)index = record.vertexCount;
+			});
+			
+			if (!levelOutOfRange) {
+				std::cerr << "Level of detail 1 of mesh " << i << " with corrupt indices was not rejected!" << std::endl;
+				return false;
+			}
+		}
+		
+		// One mesh is enough to check each case:
+		break;
+	}
+	
+	return true;
+}
+
+int main (int argc, char ** argv) {
+	bool quantize = false;
+	float positionError = DEFAULT_POSITION_ERROR;
+	
+	if (argc > 1 && std::strncmp(argv[1], "--quantize", 10) == 0) {
+		quantize = true;
+		
+		if (argv[1][10] == '=')
+			positionError = std::atof(argv[1] + 11);
+		
+		argc -= 1;
+		argv += 1;
+	}
+	
+	if (argc < 2 || !(positionError > 0)) {
+		std::cerr << "Usage: " << argv[0] << " [--quantize[=ERROR]] directory [name]" << std::endl;
+		return 1;
+	}
+	
+	std::string directory = argv[1];
+	std::string name = argc > 2 ? argv[2] : "model";
+	std::string path = directory + "/" + name;
+	
+	std::vector<ObjMesh> faces;
+	std::vector<MaterialDescription> materials;
+	
+	if (!loadObjMesh(path + ".obj", faces))
+		return 2;
+	
+	// A model without materials is still valid:
+	loadObjMaterials(path + ".mtl", materials);
+	
+	std::vector<IndexedMesh> meshes(faces.size());
+	std::size_t faceCount = 0, vertexCount = 0;
+	
+	for (std::size_t i = 0; i < faces.size(); i += 1) {
+		weldMesh(faces[i], meshes[i]);
+		
+		faceCount += faces[i].faces.size();
+		vertexCount += meshes[i].vertices.size();
+	}
+	
+	std::vector<QuantizedMesh> quantized;
+	std::size_t quantizedCount = 0;
+	
+	if (quantize) {
+		float radius = 0;
+		
+		for (std::size_t i = 0; i < meshes.size(); i += 1) {
+			for (std::size_t j = 0; j < meshes[i].vertices.size(); j += 1)
+				radius = std::max(radius, (float)meshes[i].vertices[j].pos.length());
+		}
+		
+		QuantizationError tolerance = {positionError * radius, NORMAL_ERROR, TEXCOORD_ERROR};
+		quantized.resize(meshes.size());
+		
+		for (std::size_t i = 0; i < meshes.size(); i += 1) {
+			QuantizationError error;
+			bool acceptable = quantizeMesh(meshes[i], quantized[i], tolerance, error);
+			
+			std::cout << "Mesh " << i << " (" << meshes[i].material << "): position error " << error.position << ", normal error " << error.normal << " degrees, texture coordinate error " << error.texcoord;
+			
+			if (acceptable) {
+				quantizedCount += 1;
+				std::cout << "." << std::endl;
+			} else {
+				quantized[i].vertices.clear();
+				std::cout << ", which exceeds the tolerance, so it is not quantized." << std::endl;
+			}
+		}
+	}
+	
+	// Build the levels of detail and the picking hierarchy from the vertices as they are stored, which is what the model would otherwise do when it is loaded:
+	std::vector<MeshBuffer> buffers;
+	Vec3 min(0, 0, 0), max(0, 0, 0);
+	bool first = true;
+	
+	for (std::size_t i = 0; i < meshes.size(); i += 1) {
+		bool isQuantized = !quantized.empty() && !quantized[i].vertices.empty();
+		buffers.push_back(isQuantized ? quantized[i].buffer(meshes[i]) : meshes[i].buffer());
+		
+		for (std::size_t j = 0; j < meshes[i].vertices.size(); j += 1) {
+			const Vec3 & pos = meshes[i].vertices[j].pos;
+			
+			for (std::size_t k = 0; k < 3; k += 1) {
+				if (first || pos[k] < min[k]) min[k] = pos[k];
+				if (first || pos[k] > max[k]) max[k] = pos[k];
+			}
+			
+			first = false;
+		}
+	}
+	
+	LevelOfDetail detail;
+	TriangleHierarchy triangles;
+	
+	// The same bounding box radius as ARBrowser::BoundingBox:
+	detail.build(buffers, (max - min).length() / 2.0 * MAXIMUM_DETAIL_ERROR);
+	triangles.build(buffers);
+	
+	if (!writeBakedMesh(path + ".armesh", meshes, materials, quantized, &detail, &triangles))
+		return 3;
+	
+	if (!verify(path + ".armesh", meshes, quantized, materials, detail, triangles)) {
+		std::cerr << "Verification of " << path << ".armesh failed!" << std::endl;
+		return 4;
+	}
+	
+	if (!verifyCorruptIndices(path + ".armesh")) {
+		std::cerr << "Verification of " << path << ".armesh failed!" << std::endl;
+		return 4;
+	}
+	
+	std::cout << path << ".armesh: " << meshes.size() << " meshes, " << materials.size() << " materials, " << faceCount << " faces, " << vertexCount << " vertices (from " << (faceCount * 3) << "), " << quantizedCount << " meshes quantized, " << detail.levelCount() << " levels of detail, " << triangles.nodeCount() << " hierarchy nodes." << std::endl;
+	
+	return 0;
+}
@@ -0,0 +1,321 @@
+//
+//  artex-bake.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Converts a PNG image into a .artex file, which ARBrowser::Model loads in preference to the image, so that textures are uploaded with mip levels and PVRTC compression without decoding an image on the device. The image is resized to a square with power of two sides, and the baked file is read back and every level is decompressed and compared with the source before the tool exits. The time to decode the PNG, as GLKTextureLoader does, is compared with the time to map the baked file and read the levels which are uploaded, along with the texture memory used by each.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/artex-bake.cpp source/ARBrowser/ARBakedTexture.cpp source/ARBrowser/ARTextureCompression.cpp source/ARBrowser/ARMappedFile.cpp -lz -o artex-bake
+//
+// Usage:
+//	artex-bake [--no-fallback] [--size=SIZE] image.png [image.artex]
+//
+// The baked file defaults to the image path with the extension replaced by .artex, e.g. source/ARBrowser/models/coffee/coffee.artex. The size defaults to the smallest power of two which holds the larger side of the image, up to 2048. Without --no-fallback, the uncompressed levels are also stored, for devices without PVRTC. Exits with a non-zero status if any check fails.
+
+#include "ARBakedTexture.h"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// The smallest peak signal to noise ratio accepted for the first compressed level, and for the others, in decibels. Each colour of a smaller level is blended over more of the image, e.g. an 8x8 level has only four pairs of colours, so the other levels are only checked for gross errors, and levels smaller than 8x8, which have a single pair, are only reported.
+static const double MINIMUM_PSNR = 30.0, MINIMUM_MIP_PSNR = 16.0;
+
+static std::uint32_t readBigEndian (const unsigned char * data) {
+	return std::uint32_t(data[0]) << 24 | std::uint32_t(data[1]) << 16 | std::uint32_t(data[2]) << 8 | data[3];
+}
+
+static int paethPredictor (int a, int b, int c) {
+	int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+	
+	if (pa <= pb && pa <= pc) return a;
+	if (pb <= pc) return b;
+	return c;
+}
+
+/// Decodes non-interlaced PNG images of every colour type, with 8 or 16 bits per channel, or fewer for palette and greyscale images.
+static bool loadPNG (const std::string & path, TextureImage & image) {
+	std::ifstream input(path.c_str(), std::ios::binary);
+	std::vector<unsigned char> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	
+	static const unsigned char SIGNATURE[8] = {137, 'P', 'N', 'G', 13, 10, 26, 10};
+	
+	if (file.size() < 8 || std::memcmp(&file[0], SIGNATURE, 8) != 0) {
+		std::cerr << "Couldn't read " << path << " as a PNG image!" << std::endl;
+		return false;
+	}
+	
+	std::uint32_t width = 0, height = 0;
+	int bitDepth = 0, colorType = 0, interlace = 0;
+	std::vector<unsigned char> compressed, palette, transparency;
+	
+	for (std::size_t offset = 8; offset + 12 <= file.size(); ) {
+		std::uint32_t length = readBigEndian(&file[offset]);
+		std::string type(file.begin() + offset + 4, file.begin() + offset + 8);
+		const unsigned char * data = &file[offset + 8];
+		
+		if (offset + 12 + length > file.size())
+			break;
+		
+		if (type == "IHDR" && length >= 13) {
+			width = readBigEndian(data);
+			height = readBigEndian(data + 4);
+			bitDepth = data[8];
+			colorType = data[9];
+			interlace = data[12];
+		} else if (type == "PLTE") {
+			palette.assign(data, data + length);
+		} else if (type == "tRNS") {
+			transparency.assign(data, data + length);
+		} else if (type == "IDAT") {
+			compressed.insert(compressed.end(), data, data + length);
+		} else if (type == "IEND") {
+			break;
+		}
+		
+		offset += 12 + length;
+	}
+	
+	static const int CHANNELS[7] = {1, 0, 3, 1, 2, 0, 4};
+	
+	if (width == 0 || height == 0 || colorType > 6 || CHANNELS[colorType] == 0 || interlace != 0 || (colorType == 3 && palette.empty())) {
+		std::cerr << "Unsupported PNG image " << path << "!" << std::endl;
+		return false;
+	}
+	
+	int channels = CHANNELS[colorType];
+	std::size_t rowBytes = (std::size_t(width) * channels * bitDepth + 7) / 8, pixelBytes = std::max(1, channels * bitDepth / 8);
+	uLongf size = (uLongf)((rowBytes + 1) * height);
+	std::vector<unsigned char> filtered(size);
+	
+	if (uncompress(&filtered[0], &size, &compressed[0], (uLong)compressed.size()) != Z_OK || size != filtered.size()) {
+		std::cerr << "Corrupt PNG image " << path << "!" << std::endl;
+		return false;
+	}
+	
+	std::vector<unsigned char> rows(rowBytes * height), zero(rowBytes, 0);
+	
+	for (std::uint32_t y = 0; y < height; y += 1) {
+		int filter = filtered[y * (rowBytes + 1)];
+		const unsigned char * source = &filtered[y * (rowBytes + 1) + 1];
+		unsigned char * row = &rows[y * rowBytes];
+		const unsigned char * previous = y > 0 ? row - rowBytes : &zero[0];
+		
+		for (std::size_t i = 0; i < rowBytes; i += 1) {
+			int a = i >= pixelBytes ? row[i - pixelBytes] : 0, b = previous[i], c = i >= pixelBytes ? previous[i - pixelBytes] : 0;
+			int predictor = 0;
+			
+			switch (filter) {
+				case 1: predictor = a; break;
+				case 2: predictor = b; break;
+				case 3: predictor = (a + b) / 2; break;
+				case 4: predictor = paethPredictor(a, b, c); break;
+			}
+			
+			row[i] = (unsigned char)(source[i] + predictor);
+		}
+	}
+	
+	image = TextureImage(width, height);
+	
+	for (std::uint32_t y = 0; y < height; y += 1) {
+		const unsigned char * row = &rows[y * rowBytes];
+		
+		for (std::uint32_t x = 0; x < width; x += 1) {
+			int samples[4];
+			
+			// Each sample scaled to 8 bits:
+			for (int c = 0; c < channels; c += 1) {
+				std::size_t index = std::size_t(x) * channels + c;
+				
+				if (bitDepth == 16) {
+					samples[c] = row[index * 2];
+				} else if (bitDepth == 8) {
+					samples[c] = row[index];
+				} else {
+					int value = (row[index * bitDepth / 8] >> (8 - bitDepth - (index * bitDepth) % 8)) & ((1 << bitDepth) - 1);
+					samples[c] = colorType == 3 ? value : value * 255 / ((1 << bitDepth) - 1);
+				}
+			}
+			
+			std::uint8_t * pixel = image.pixel(x, y);
+			
+			if (colorType == 3) {
+				std::size_t index = std::min<std::size_t>(samples[0], palette.size() / 3 - 1);
+				
+				pixel[0] = palette[index * 3];
+				pixel[1] = palette[index * 3 + 1];
+				pixel[2] = palette[index * 3 + 2];
+				pixel[3] = index < transparency.size() ? transparency[index] : 255;
+			} else if (channels <= 2) {
+				pixel[0] = pixel[1] = pixel[2] = (std::uint8_t)samples[0];
+				pixel[3] = channels == 2 ? (std::uint8_t)samples[1] : 255;
+			} else {
+				pixel[0] = (std::uint8_t)samples[0];
+				pixel[1] = (std::uint8_t)samples[1];
+				pixel[2] = (std::uint8_t)samples[2];
+				pixel[3] = channels == 4 ? (std::uint8_t)samples[3] : 255;
+			}
+		}
+	}
+	
+	return true;
+}
+
+static bool verify (const std::string & path, const std::vector<TextureImage> & levels, bool fallback) {
+	BakedTexture baked;
+	
+	if (!baked.open(path))
+		return false;
+	
+	const BakedTextureLevel * compressed = baked.levels(BAKED_TEXTURE_PVRTC_4BPP), * uncompressed = baked.levels(BAKED_TEXTURE_RGBA8);
+	
+	if (baked.levelCount() != levels.size() || !compressed || (uncompressed != NULL) != fallback) {
+		std::cerr << "Level count or formats differ!" << std::endl;
+		return false;
+	}
+	
+	bool success = true;
+	
+	for (std::size_t i = 0; i < levels.size(); i += 1) {
+		TextureImage decoded;
+		decodePVRTC(baked.data(compressed[i]), compressed[i].width, compressed[i].height, decoded);
+		
+		double psnr = peakSignalToNoise(decoded, levels[i]), minimum = i == 0 ? MINIMUM_PSNR : MINIMUM_MIP_PSNR;
+		
+		std::printf("Level %lu, %ux%u: %lu bytes compressed, %0.1fdB\n", (unsigned long)i, compressed[i].width, compressed[i].height, (unsigned long)compressed[i].size, psnr);
+		
+		if (levels[i].width >= 8 && psnr < minimum) {
+			std::printf("FAILED: level %lu is below %0.0fdB\n", (unsigned long)i, minimum);
+			success = false;
+		}
+		
+		if (uncompressed && std::memcmp(baked.data(uncompressed[i]), &levels[i].pixels[0], levels[i].pixels.size()) != 0) {
+			std::printf("FAILED: uncompressed level %lu differs\n", (unsigned long)i);
+			success = false;
+		}
+	}
+	
+	return success;
+}
+
+/// Map the baked file and read every byte of the levels which would be uploaded, as TextureSource::upload does.
+static std::size_t loadBaked (const std::string & path, std::uint32_t & checksum) {
+	BakedTexture baked;
+	
+	if (!baked.open(path))
+		return 0;
+	
+	const BakedTextureLevel * levels = baked.levels(BAKED_TEXTURE_PVRTC_4BPP);
+	std::size_t size = 0;
+	
+	for (std::size_t i = 0; i < baked.levelCount(); i += 1) {
+		const std::uint8_t * data = baked.data(levels[i]);
+		
+		for (std::size_t j = 0; j < levels[i].size; j += 1)
+			checksum += data[j];
+		
+		size += levels[i].size;
+	}
+	
+	return size;
+}
+
+int main (int argc, char ** argv) {
+	bool fallback = true;
+	std::uint32_t maximumSize = 2048;
+	
+	while (argc > 1 && std::strncmp(argv[1], "--", 2) == 0) {
+		if (std::strcmp(argv[1], "--no-fallback") == 0) {
+			fallback = false;
+		} else if (std::strncmp(argv[1], "--size=", 7) == 0) {
+			maximumSize = (std::uint32_t)std::strtoul(argv[1] + 7, NULL, 10);
+		} else {
+			break;
+		}
+		
+		argc -= 1;
+		argv += 1;
+	}
+	
+	if (argc != 2 && argc != 3) {
+		std::cerr << "Usage: " << argv[0] << " [--no-fallback] [--size=SIZE] image.png [image.artex]" << std::endl;
+		return 1;
+	}
+	
+	std::string inputPath = argv[1], outputPath = argc == 3 ? argv[2] : bakedTexturePath(inputPath);
+	TextureImage image;
+	
+	ClockT::time_point start = ClockT::now();
+	
+	if (!loadPNG(inputPath, image))
+		return 2;
+	
+	double decodeTime = elapsed(start);
+	
+	std::uint32_t size = 1;
+	
+	while (size < std::max(image.width, image.height) && size < maximumSize)
+		size *= 2;
+	
+	TextureImage square;
+	
+	if (image.width != size || image.height != size)
+		resizeImage(image, size, size, square);
+	else
+		square = image;
+	
+	std::vector<TextureImage> levels;
+	buildMipChain(square, levels);
+	
+	start = ClockT::now();
+	
+	if (!writeBakedTexture(outputPath, levels, fallback))
+		return 3;
+	
+	double encodeTime = elapsed(start);
+	
+	if (!verify(outputPath, levels, fallback)) {
+		std::cerr << "Verification of " << outputPath << " failed!" << std::endl;
+		return 4;
+	}
+	
+	// The file was just written, so both loads read from the page cache:
+	std::uint32_t checksum = 0;
+	start = ClockT::now();
+	
+	std::size_t compressedSize = loadBaked(outputPath, checksum);
+	double loadTime = elapsed(start);
+	
+	start = ClockT::now();
+	loadPNG(inputPath, image);
+	decodeTime = std::min(decodeTime, elapsed(start));
+	
+	BakedTexture baked;
+	baked.open(outputPath);
+	
+	std::printf("Wrote %s: %ux%u from %ux%u, %lu levels, encoded in %0.1fms, %lu bytes\n", outputPath.c_str(), size, size, image.width, image.height, (unsigned long)levels.size(), encodeTime * 1000.0, (unsigned long)baked.fileSize());
+	std::printf("Loading: decoding the PNG took %0.3fms, reading the compressed levels took %0.3fms (checksum %u)\n", decodeTime * 1000.0, loadTime * 1000.0, checksum);
+	std::printf("Texture memory: %lu bytes as RGBA8 without mip levels, %lu bytes as PVRTC with mip levels\n", (unsigned long)image.width * image.height * 4, (unsigned long)compressedSize);
+	
+	return 0;
+}
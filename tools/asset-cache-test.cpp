@@ -0,0 +1,230 @@
+//
+//  asset-cache-test.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Checks ARBrowser::AssetCache with several threads looking up, inserting, holding, removing and evicting assets under a budget much smaller than the working set, as the render thread and resource loader workers do. Every asset which is held must stay cached under its key, the statistics must account for every lookup, and the resident size must be back within the budget once nothing is held. Also checks that evicted assets are released outside the lock, since their destructors may use the cache, and reports the throughput of lookups. Run it under ThreadSanitizer to check the synchronisation.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -pthread -Isource/ARBrowser tools/asset-cache-test.cpp source/ARBrowser/ARAssetCache.cpp -o asset-cache-test
+//	c++ -std=c++11 -O1 -g -fsanitize=thread -Isource/ARBrowser tools/asset-cache-test.cpp source/ARBrowser/ARAssetCache.cpp -o asset-cache-test
+//
+// Usage:
+//	asset-cache-test
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARAssetCache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// The number of assets which have not been destroyed.
+static std::atomic<int> liveAssets(0);
+
+class TestAsset : public AssetCache::Asset {
+	protected:
+		std::size_t m_key, m_size;
+		
+		/// If set, the destructor reads the statistics of the cache, which would deadlock if the asset was released with the lock held.
+		AssetCache * m_cache;
+	
+	public:
+		TestAsset (std::size_t key, std::size_t size, AssetCache * cache = NULL) : m_key(key), m_size(size), m_cache(cache) {
+			liveAssets += 1;
+		}
+		
+		virtual ~TestAsset () {
+			if (m_cache)
+				m_cache->statistics();
+			
+			liveAssets -= 1;
+		}
+		
+		std::size_t key () const { return m_key; }
+		
+		virtual std::size_t residentSize () const { return m_size; }
+};
+
+static std::string keyName (std::size_t key) {
+	return "asset/" + std::to_string(key);
+}
+
+/// The size of each asset, so that only a fraction of the working set fits in the budget.
+static const std::size_t ASSET_SIZE = 1000;
+
+static bool testConcurrent (std::size_t threadCount) {
+	const std::size_t KEYS = 200, REMOVABLE_KEYS = 20, OPERATIONS = 50000, BUDGET = 20 * ASSET_SIZE;
+	
+	AssetCache cache(BUDGET);
+	std::atomic<std::size_t> lookups(0), failures(0);
+	
+	ClockT::time_point start = ClockT::now();
+	std::vector<std::thread> threads;
+	
+	for (std::size_t t = 0; t < threadCount; t += 1) {
+		threads.push_back(std::thread([&, t]() {
+			std::mt19937 generator(t + 1);
+			
+			// Most lookups are for a few popular assets, as with models shared by many points:
+			std::geometric_distribution<std::size_t> popular(0.05);
+			std::uniform_int_distribution<std::size_t> removable(KEYS, KEYS + REMOVABLE_KEYS - 1), action(0, 99);
+			
+			std::vector<std::shared_ptr<TestAsset>> held;
+			std::size_t count = 0;
+			
+			for (std::size_t i = 0; i < OPERATIONS; i += 1) {
+				std::size_t choice = action(generator);
+				
+				if (choice < 2) {
+					// Removed assets are never held, so that held assets must stay in the cache:
+					cache.remove(keyName(removable(generator)));
+				} else if (choice < 3) {
+					cache.setBudget(BUDGET / 2 + (i % 2) * BUDGET / 2);
+				} else if (choice < 4) {
+					cache.purge();
+				} else {
+					bool hold = choice >= 80;
+					std::size_t key = hold ? popular(generator) % KEYS : removable(generator);
+					
+					std::shared_ptr<TestAsset> asset = cache.lookup<TestAsset>(keyName(key));
+					count += 1;
+					
+					// Another thread may have inserted the same key in the meantime, in which case its asset is returned:
+					if (!asset)
+						asset = cache.insert(keyName(key), std::make_shared<TestAsset>(key, ASSET_SIZE));
+					
+					if (!asset || asset->key() != key) {
+						failures += 1;
+						
+						continue;
+					}
+					
+					if (hold) {
+						held.push_back(asset);
+						
+						// Release the oldest held asset, after checking that it was never evicted:
+						if (held.size() > 8) {
+							std::shared_ptr<TestAsset> oldest = held.front();
+							held.erase(held.begin());
+							
+							if (cache.lookup<TestAsset>(keyName(oldest->key())) != oldest)
+								failures += 1;
+							
+							count += 1;
+						}
+					}
+				}
+			}
+			
+			lookups += count;
+		}));
+	}
+	
+	for (std::size_t t = 0; t < threads.size(); t += 1)
+		threads[t].join();
+	
+	double duration = elapsed(start);
+	bool success = true;
+	
+	if (failures > 0) {
+		std::printf("FAILED: %lu lookups returned the wrong asset, or a held asset was evicted\n", (unsigned long)failures.load());
+		success = false;
+	}
+	
+	AssetCache::Statistics statistics = cache.statistics();
+	
+	if (statistics.hits + statistics.misses != lookups) {
+		std::printf("FAILED: %lu hits and %lu misses for %lu lookups\n", (unsigned long)statistics.hits, (unsigned long)statistics.misses, (unsigned long)lookups.load());
+		success = false;
+	}
+	
+	if (statistics.residentSize != statistics.count * ASSET_SIZE || (int)statistics.count != liveAssets) {
+		std::printf("FAILED: Resident size %lu does not match %lu cached assets, with %d alive\n", (unsigned long)statistics.residentSize, (unsigned long)statistics.count, liveAssets.load());
+		success = false;
+	}
+	
+	// Nothing is held now, so restoring the budget evicts down to it:
+	cache.setBudget(BUDGET);
+	statistics = cache.statistics();
+	
+	if (statistics.residentSize > BUDGET) {
+		std::printf("FAILED: Resident size %lu exceeds the budget of %lu\n", (unsigned long)statistics.residentSize, (unsigned long)BUDGET);
+		success = false;
+	}
+	
+	std::printf("%lu threads: %lu lookups in %0.1fms (%0.0f per second), %lu hits, %lu misses, %lu evictions\n", (unsigned long)threadCount, (unsigned long)lookups.load(), duration * 1000.0, lookups / duration, (unsigned long)statistics.hits, (unsigned long)statistics.misses, (unsigned long)statistics.evictions);
+	
+	return success;
+}
+
+static bool testEviction () {
+	AssetCache cache(3 * ASSET_SIZE);
+	bool success = true;
+	
+	std::shared_ptr<TestAsset> held = cache.insert(keyName(0), std::make_shared<TestAsset>(0, ASSET_SIZE, &cache));
+	
+	for (std::size_t key = 1; key < 5; key += 1)
+		cache.insert(keyName(key), std::make_shared<TestAsset>(key, ASSET_SIZE, &cache));
+	
+	// The held asset is the least recently used, but evicting it wouldn't free anything:
+	if (cache.lookup<TestAsset>(keyName(0)) != held || cache.lookup(keyName(1)) || !cache.lookup(keyName(4))) {
+		std::printf("FAILED: Eviction did not skip the held asset and evict the least recently used\n");
+		success = false;
+	}
+	
+	// Insert returns the asset which is already cached:
+	std::shared_ptr<TestAsset> duplicate = std::make_shared<TestAsset>(0, ASSET_SIZE, &cache);
+	
+	if (cache.insert(keyName(0), duplicate) != held) {
+		std::printf("FAILED: Inserting an existing key did not return the cached asset\n");
+		success = false;
+	}
+	
+	duplicate.reset();
+	
+	// Each of these destroys assets whose destructors use the cache:
+	cache.remove(keyName(4));
+	cache.setBudget(ASSET_SIZE);
+	held.reset();
+	cache.purge();
+	
+	if (cache.statistics().count != 0 || liveAssets != 0) {
+		std::printf("FAILED: %lu assets cached and %d alive after purging\n", (unsigned long)cache.statistics().count, liveAssets.load());
+		success = false;
+	}
+	
+	std::printf("Eviction: held assets are kept, and evicted assets are released outside the lock\n");
+	
+	return success;
+}
+
+int main () {
+	bool success = true;
+	
+	success = testEviction() && success;
+	success = testConcurrent(1) && success;
+	success = testConcurrent(4) && success;
+	success = testConcurrent(8) && success;
+	
+	if (liveAssets != 0) {
+		std::printf("FAILED: %d assets were never destroyed\n", liveAssets.load());
+		success = false;
+	}
+	
+	return success ? 0 : 1;
+}
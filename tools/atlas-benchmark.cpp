@@ -0,0 +1,378 @@
+//
+//  atlas-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Exercises the portable parts of the billboard atlas used by ARViewModel. Fills an atlas with billboards of random sizes and reports how much of it is used, then replaces billboards at random for a while, repacking when the atlas is fragmented, and reports the occupancy and fragmentation once released rectangles are being reused. Also checks that the upload scheduler keeps within its byte budget and does every upload exactly once in order, and that changedRect finds exactly the pixels which changed.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/atlas-benchmark.cpp source/ARBrowser/ARBillboardAtlas.cpp -o atlas-benchmark
+//
+// Usage:
+//	atlas-benchmark [atlas size] [replacements]
+//
+// The atlas size defaults to 1024, the size of the pages used by ARViewModel. Much smaller atlases hold too few billboards to pack well.
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARBillboardAtlas.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static const std::uint32_t PADDING = 1;
+
+/// Marks the area reserved by each live rectangle, including padding, to check that they never overlap.
+class Coverage {
+	protected:
+		std::uint32_t m_width, m_height;
+		std::vector<std::uint8_t> m_cells;
+	
+	public:
+		std::size_t errors;
+		
+		Coverage (std::uint32_t width, std::uint32_t height) : m_width(width + PADDING), m_height(height + PADDING), m_cells(std::size_t(m_width) * m_height), errors(0) {
+		}
+		
+		void mark (const AtlasRect & rect, bool used) {
+			for (std::uint32_t y = rect.y; y < rect.y + rect.height + PADDING; y += 1) {
+				for (std::uint32_t x = rect.x; x < rect.x + rect.width + PADDING; x += 1) {
+					std::uint8_t & cell = m_cells[std::size_t(y) * m_width + x];
+					
+					if (cell == used)
+						errors += 1;
+					
+					cell = used;
+				}
+			}
+		}
+};
+
+/// Billboards are mostly wide labels, between 64x32 and 256x128.
+static void randomSize (std::mt19937 & random, std::uint32_t & width, std::uint32_t & height) {
+	width = 64 + (random() % 13) * 16;
+	height = 32 + (random() % 7) * 16;
+}
+
+static bool checkRect (const SkylinePacker & packer, const AtlasRect & rect, std::uint32_t width, std::uint32_t height) {
+	return rect.width == width && rect.height == height && rect.x + rect.width <= packer.width() && rect.y + rect.height <= packer.height();
+}
+
+static void printStatistics (const char * name, const SkylinePacker::Statistics & statistics) {
+	std::printf("%s: %lu billboards, occupancy %0.1f%%, fragmentation %0.1f%%, %0.1f%% of the atlas released and waiting to be reused\n", name, (unsigned long)statistics.allocations, statistics.occupancy() * 100.0, statistics.fragmentation() * 100.0, 100.0 * statistics.freeArea / statistics.totalArea);
+}
+
+/// Below this occupancy, a failed allocation repacks the atlas.
+static const double REPACK_OCCUPANCY = 0.75;
+
+/// Repack the live rectangles. Any which no longer fit are dropped, as ARViewModel would move them to another page.
+/// @returns the number dropped.
+static std::size_t repack (SkylinePacker & packer, Coverage & coverage, std::vector<AtlasRect> & live) {
+	for (std::size_t i = 0; i < live.size(); i += 1)
+		coverage.mark(live[i], false);
+	
+	std::size_t dropped = 0;
+	
+	if (!packer.repack(live)) {
+		std::size_t count = live.size();
+		
+		live.erase(std::remove_if(live.begin(), live.end(), [](const AtlasRect & rect) { return rect.area() == 0; }), live.end());
+		dropped = count - live.size();
+	}
+	
+	for (std::size_t i = 0; i < live.size(); i += 1)
+		coverage.mark(live[i], true);
+	
+	return dropped;
+}
+
+static bool testPacking (std::uint32_t size, std::size_t replacements) {
+	bool failed = false;
+	std::mt19937 random(3);
+	
+	SkylinePacker packer(size, size, PADDING);
+	Coverage coverage(size, size);
+	std::vector<AtlasRect> live;
+	
+	// Fill the atlas until several allocations in a row fail:
+	ClockT::time_point start = ClockT::now();
+	std::size_t failures = 0, outside = 0;
+	
+	while (failures < 20) {
+		std::uint32_t width, height;
+		randomSize(random, width, height);
+		
+		AtlasRect rect;
+		
+		if (!packer.allocate(width, height, rect)) {
+			failures += 1;
+			continue;
+		}
+		
+		if (!checkRect(packer, rect, width, height))
+			outside += 1;
+		
+		coverage.mark(rect, true);
+		live.push_back(rect);
+	}
+	
+	double fillTime = elapsed(start);
+	
+	printStatistics("Filled", packer.statistics());
+	std::printf("Filled: %0.2fus per allocation\n", fillTime * 1e6 / live.size());
+	
+	// Replace random billboards with new ones of random sizes, keeping the atlas about 80% full:
+	std::size_t target = live.size() * 8 / 10, rejected = 0, repacks = 0;
+	
+	while (live.size() > target) {
+		std::size_t index = random() % live.size();
+		
+		coverage.mark(live[index], false);
+		packer.release(live[index]);
+		
+		live[index] = live.back();
+		live.pop_back();
+	}
+	
+	start = ClockT::now();
+	
+	for (std::size_t i = 0; i < replacements; i += 1) {
+		// An allocation which found no room leaves the atlas below the target until a later one succeeds:
+		if (live.size() >= target) {
+			std::size_t index = random() % live.size();
+			
+			coverage.mark(live[index], false);
+			packer.release(live[index]);
+			
+			live[index] = live.back();
+			live.pop_back();
+		}
+		
+		std::uint32_t width, height;
+		randomSize(random, width, height);
+		
+		AtlasRect rect;
+		
+		if (!packer.allocate(width, height, rect)) {
+			// As the atlas in ARViewModel does, repack when allocation fails but there should be plenty of room:
+			if (packer.statistics().occupancy() > REPACK_OCCUPANCY) {
+				rejected += 1;
+				continue;
+			}
+			
+			repacks += 1;
+			rejected += repack(packer, coverage, live);
+			
+			if (!packer.allocate(width, height, rect)) {
+				rejected += 1;
+				continue;
+			}
+		}
+		
+		if (!checkRect(packer, rect, width, height))
+			outside += 1;
+		
+		coverage.mark(rect, true);
+		live.push_back(rect);
+	}
+	
+	double churnTime = elapsed(start);
+	
+	printStatistics("Churned", packer.statistics());
+	std::printf("Churned: %lu replacements, %lu reused a released rectangle, %lu repacked the atlas, %lu found no room or were dropped, %0.2fus per replacement\n", (unsigned long)replacements, (unsigned long)packer.statistics().recycled, (unsigned long)repacks, (unsigned long)rejected, churnTime * 1e6 / replacements);
+	
+	if (coverage.errors || outside) {
+		std::printf("FAILED: %lu overlapping pixels, %lu rectangles outside the atlas\n", (unsigned long)coverage.errors, (unsigned long)outside);
+		failed = true;
+	}
+	
+	// With repacking, an allocation should only fail, or a billboard be dropped, when the atlas really is full:
+	if (rejected > replacements / 100) {
+		std::printf("FAILED: %lu billboards found no room or were dropped\n", (unsigned long)rejected);
+		failed = true;
+	}
+	
+	if (packer.statistics().allocations != live.size()) {
+		std::printf("FAILED: %lu allocations counted, %lu live\n", (unsigned long)packer.statistics().allocations, (unsigned long)live.size());
+		failed = true;
+	}
+	
+	return !failed;
+}
+
+static bool testScheduler () {
+	const std::size_t BUDGET = 256 * 1024, REQUESTS = 10000;
+	
+	std::mt19937 random(5);
+	UploadScheduler scheduler;
+	
+	// Handles are indices into a table, so that the order and count of uploads can be checked:
+	std::vector<std::size_t> bytes(REQUESTS), uploads(REQUESTS, 0);
+	std::vector<char> handles(REQUESTS);
+	std::size_t next = 0, done = 0, outOfOrder = 0, overBudget = 0, duplicates = 0, frames = 0;
+	
+	while (done < REQUESTS) {
+		// A few billboards change each frame, some of them more than once:
+		for (std::size_t i = 0; i < 8 && next < REQUESTS; i += 1, next += 1) {
+			std::uint32_t width, height;
+			randomSize(random, width, height);
+			
+			bytes[next] = std::size_t(width) * height * 4;
+			scheduler.request(&handles[next], bytes[next]);
+			
+			if (!scheduler.request(&handles[next], bytes[next]))
+				duplicates += 1;
+		}
+		
+		std::size_t last = done, count = 0;
+		
+		std::size_t spent = scheduler.process(BUDGET, [&](const void * handle) {
+			std::size_t index = (const char *)handle - handles.data();
+			
+			if (index != last)
+				outOfOrder += 1;
+			
+			last = index + 1;
+			uploads[index] += 1;
+			count += 1;
+			
+			return bytes[index];
+		});
+		
+		if (spent > BUDGET && count > 1)
+			overBudget += 1;
+		
+		done += count;
+		frames += 1;
+	}
+	
+	std::size_t wrong = 0;
+	
+	for (std::size_t i = 0; i < REQUESTS; i += 1) {
+		if (uploads[i] != 1)
+			wrong += 1;
+	}
+	
+	std::printf("Scheduler: %lu uploads over %lu frames with a budget of %luKB per frame\n", (unsigned long)REQUESTS, (unsigned long)frames, (unsigned long)(BUDGET / 1024));
+	
+	if (duplicates != REQUESTS || wrong || outOfOrder || overBudget) {
+		std::printf("FAILED: %lu repeated requests coalesced, %lu uploads not done exactly once, %lu out of order, %lu frames over budget\n", (unsigned long)duplicates, (unsigned long)wrong, (unsigned long)outOfOrder, (unsigned long)overBudget);
+		return false;
+	}
+	
+	// Cancelled uploads must never be done:
+	char a, b, c;
+	std::size_t cancelled = 0;
+	
+	scheduler.request(&a, 1);
+	scheduler.request(&b, 1);
+	scheduler.request(&c, 1);
+	scheduler.cancel(&b);
+	
+	scheduler.process(BUDGET, [&](const void * handle) {
+		if (handle == &b)
+			cancelled += 1;
+		
+		return std::size_t(1);
+	});
+	
+	if (cancelled || scheduler.pendingCount()) {
+		std::printf("FAILED: a cancelled upload was done\n");
+		return false;
+	}
+	
+	return true;
+}
+
+static bool testChangedRect () {
+	const std::uint32_t WIDTH = 256, HEIGHT = 128;
+	const std::size_t STRIDE = WIDTH * 4;
+	
+	std::mt19937 random(11);
+	std::vector<std::uint8_t> previous(STRIDE * HEIGHT), current;
+	std::size_t wrong = 0, uploaded = 0, total = 0;
+	
+	for (std::size_t i = 0; i < previous.size(); i += 1)
+		previous[i] = random();
+	
+	for (std::size_t trial = 0; trial < 1000; trial += 1) {
+		current = previous;
+		
+		AtlasRect expected = {0, 0, 0, 0}, found;
+		bool changed = trial % 10 != 0;
+		
+		if (changed) {
+			expected.x = random() % WIDTH;
+			expected.y = random() % HEIGHT;
+			expected.width = 1 + random() % (WIDTH - expected.x);
+			expected.height = 1 + random() % (HEIGHT - expected.y);
+			
+			// Change the corners, so that the bounding rectangle is exact, and some pixels inside:
+			std::uint32_t corners[4][2] = {{expected.x, expected.y}, {expected.x + expected.width - 1, expected.y}, {expected.x, expected.y + expected.height - 1}, {expected.x + expected.width - 1, expected.y + expected.height - 1}};
+			
+			for (std::size_t j = 0; j < 4; j += 1)
+				current[corners[j][1] * STRIDE + corners[j][0] * 4 + j % 4] ^= 0xFF;
+			
+			for (std::size_t j = 0; j < 16; j += 1)
+				current[(expected.y + random() % expected.height) * STRIDE + (expected.x + random() % expected.width) * 4 + random() % 4] ^= 0x01;
+		}
+		
+		bool result = changedRect(previous.data(), STRIDE, current.data(), STRIDE, WIDTH, HEIGHT, found);
+		
+		if (result != changed || (changed && (found.x != expected.x || found.y != expected.y || found.width != expected.width || found.height != expected.height))) {
+			wrong += 1;
+			continue;
+		}
+		
+		if (changed) {
+			// The packed copy of the rectangle must match the source:
+			std::vector<std::uint8_t> packed(found.area() * 4);
+			copyRect(current.data(), STRIDE, found, packed.data());
+			
+			for (std::uint32_t y = 0; y < found.height; y += 1) {
+				if (std::memcmp(packed.data() + y * found.width * 4, current.data() + (found.y + y) * STRIDE + found.x * 4, found.width * 4) != 0)
+					wrong += 1;
+			}
+			
+			uploaded += found.area();
+		}
+		
+		total += std::size_t(WIDTH) * HEIGHT;
+	}
+	
+	std::printf("Changed rectangles: %0.1f%% of the pixels uploaded for random changes\n", 100.0 * uploaded / total);
+	
+	if (wrong) {
+		std::printf("FAILED: %lu changed rectangles were wrong\n", (unsigned long)wrong);
+		return false;
+	}
+	
+	return true;
+}
+
+int main (int argc, char ** argv) {
+	std::uint32_t size = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 1024;
+	std::size_t replacements = argc > 2 ? std::strtoul(argv[2], NULL, 10) : 100000;
+	
+	bool success = testPacking(size, replacements);
+	success = testScheduler() && success;
+	success = testChangedRect() && success;
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+//
+//  clustering-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Scatters points around a viewer who walks through them, and bins them for the radar with ARBrowser::RadarClusters and on the screen with ARBrowser::ScreenClusters. Reports the time per frame and the number of points drawn, compared with drawing every point as ARBrowserView did, and checks the radar bins, whose points are only rebuilt when the counts change, against a fresh instance and the screen clusters against a brute force search.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/clustering-benchmark.cpp source/ARBrowser/ARClustering.cpp -o clustering-benchmark
+//
+// Usage:
+//	clustering-benchmark [points...]
+//
+// By default, 10000 and 100000 points are tested. Exits with a non-zero status if any check fails.
+
+#include "ARClustering.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static const float MAXIMUM_DISTANCE = 500, RADAR_RADIUS = 20;
+static const std::size_t FRAMES = 200;
+
+/// The visibility table for a viewer at the given position, as VisibilityStage builds it.
+static void buildEntries (const std::vector<Vec3> & positions, float x, float y, std::vector<VisibilityEntry> & entries) {
+	entries.clear();
+	
+	for (std::size_t i = 0; i < positions.size(); i += 1) {
+		VisibilityEntry entry;
+		
+		entry.handle = &positions[i];
+		entry.delta = Vec3(positions[i][X] - x, positions[i][Y] - y, positions[i][Z]);
+		entry.distance = std::sqrt(entry.delta[X] * entry.delta[X] + entry.delta[Y] * entry.delta[Y]);
+		entry.bearing = std::atan2(entry.delta[X], entry.delta[Y]) * (180.0 / M_PI);
+		entry.flags = entry.distance <= MAXIMUM_DISTANCE * 2 ? VisibilityEntry::RADAR : 0;
+		
+		if (entry.distance <= MAXIMUM_DISTANCE)
+			entry.flags |= VisibilityEntry::VISIBLE;
+		
+		entries.push_back(entry);
+	}
+}
+
+/// The points ARBrowserView used to draw on the radar, one for every point.
+static std::size_t naiveRadar (const std::vector<VisibilityEntry> & entries, std::vector<Vec3> & points, std::vector<Vec3> & edgePoints) {
+	points.clear();
+	edgePoints.clear();
+	
+	for (std::size_t i = 0; i < entries.size(); i += 1) {
+		const VisibilityEntry & entry = entries[i];
+		
+		if (!(entry.flags & VisibilityEntry::RADAR))
+			continue;
+		
+		Vec3 delta = entry.delta;
+		delta[Z] = 0;
+		
+		float length = std::sqrt(entry.distance / MAXIMUM_DISTANCE);
+		delta = delta.normalize();
+		
+		if (length <= 1.0)
+			points.push_back(delta * (length * RADAR_RADIUS));
+		else
+			edgePoints.push_back(delta * RADAR_RADIUS);
+	}
+	
+	return points.size() + edgePoints.size();
+}
+
+static bool samePoints (const RadarClusters & a, const RadarClusters & b) {
+	for (std::size_t edge = 0; edge < 2; edge += 1) {
+		for (std::size_t i = 0; i < RadarClusters::SIZE_CLASSES; i += 1) {
+			const std::vector<Vec3> & pa = a.points(edge, i), & pb = b.points(edge, i);
+			
+			if (pa.size() != pb.size())
+				return false;
+			
+			for (std::size_t j = 0; j < pa.size(); j += 1) {
+				if (pa[j][X] != pb[j][X] || pa[j][Y] != pb[j][Y])
+					return false;
+			}
+		}
+	}
+	
+	return true;
+}
+
+static bool testRadar (std::size_t count) {
+	std::mt19937 random(13);
+	std::uniform_real_distribution<float> unit(0, 1);
+	
+	// Denser towards the middle, as in a city centre:
+	std::vector<Vec3> positions(count);
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		float angle = unit(random) * 2 * M_PI, distance = unit(random) * unit(random) * MAXIMUM_DISTANCE * 2.5;
+		positions[i] = Vec3(std::sin(angle) * distance, std::cos(angle) * distance, 0);
+	}
+	
+	RadarClusters clusters;
+	std::vector<VisibilityEntry> entries;
+	std::vector<Vec3> points, edgePoints;
+	
+	double clusteredTime = 0, naiveTime = 0;
+	std::size_t drawn = 0, naiveDrawn = 0, rebuilt = 0, mismatches = 0, wrongCounts = 0;
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		// Walking north east at about 1.4m/s and 60 frames per second:
+		float walked = frame * (1.4 / 60.0);
+		buildEntries(positions, walked, walked, entries);
+		
+		ClockT::time_point start = ClockT::now();
+		
+		if (clusters.update(entries, MAXIMUM_DISTANCE, RADAR_RADIUS))
+			rebuilt += 1;
+		
+		clusteredTime += elapsed(start);
+		
+		start = ClockT::now();
+		naiveDrawn += naiveRadar(entries, points, edgePoints);
+		naiveTime += elapsed(start);
+		
+		const RadarClusters::Statistics & statistics = clusters.statistics();
+		
+		drawn += statistics.bins;
+		
+		if (statistics.points != points.size() + edgePoints.size())
+			wrongCounts += 1;
+		
+		// Points which weren't rebuilt must still match the counts:
+		if (frame % 20 == 0) {
+			RadarClusters fresh;
+			fresh.update(entries, MAXIMUM_DISTANCE, RADAR_RADIUS);
+			
+			if (!samePoints(clusters, fresh))
+				mismatches += 1;
+		}
+	}
+	
+	std::printf("Radar, %lu points: %0.1fus per frame binned (rebuilt in %lu of %lu frames), %0.1fus per frame for every point\n", (unsigned long)count, clusteredTime * 1e6 / FRAMES, (unsigned long)rebuilt, (unsigned long)FRAMES, naiveTime * 1e6 / FRAMES);
+	std::printf("Radar, %lu points: %0.0f points drawn per frame in at most %lu draw calls, %0.0f for every point\n", (unsigned long)count, (double)drawn / FRAMES, (unsigned long)(RadarClusters::SIZE_CLASSES * 2 * 2), (double)naiveDrawn / FRAMES);
+	
+	if (mismatches || wrongCounts) {
+		std::printf("FAILED: %lu frames where the bins differ from a fresh count, %lu where the points were miscounted\n", (unsigned long)mismatches, (unsigned long)wrongCounts);
+		return false;
+	}
+	
+	return true;
+}
+
+static bool testScreen (std::size_t count) {
+	const float WIDTH = 320, HEIGHT = 480, CELL = 48;
+	
+	std::mt19937 random(17);
+	std::uniform_real_distribution<float> unit(0, 1);
+	
+	// Some points are just outside the viewport, as their bounding boxes may still be visible:
+	std::vector<float> xs(count), ys(count), depths(count);
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		xs[i] = unit(random) * WIDTH * 1.2 - WIDTH * 0.1;
+		ys[i] = unit(random) * HEIGHT * 1.2 - HEIGHT * 0.1;
+		depths[i] = unit(random) * MAXIMUM_DISTANCE;
+	}
+	
+	ScreenClusters clusters(CELL);
+	std::vector<std::uint32_t> assignments(count);
+	
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		clusters.clear(WIDTH, HEIGHT);
+		
+		for (std::size_t i = 0; i < count; i += 1)
+			assignments[i] = clusters.add(i, xs[i], ys[i], depths[i]);
+	}
+	
+	double frameTime = elapsed(start) / FRAMES;
+	
+	// Every point must be in its own cell's cluster, which is represented by the nearest point in the cell:
+	const std::size_t columns = std::ceil(WIDTH / CELL), rows = std::ceil(HEIGHT / CELL);
+	std::vector<std::uint32_t> nearest(columns * rows, ScreenClusters::NONE), counts(columns * rows, 0);
+	std::size_t outside = 0, wrong = 0;
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		if (xs[i] < 0 || ys[i] < 0 || xs[i] >= columns * CELL || ys[i] >= rows * CELL) {
+			outside += 1;
+			
+			if (assignments[i] != ScreenClusters::NONE)
+				wrong += 1;
+			
+			continue;
+		}
+		
+		std::size_t cell = std::size_t(ys[i] / CELL) * columns + std::size_t(xs[i] / CELL);
+		
+		if (nearest[cell] == ScreenClusters::NONE || depths[i] < depths[nearest[cell]])
+			nearest[cell] = i;
+		
+		counts[cell] += 1;
+	}
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		if (assignments[i] == ScreenClusters::NONE)
+			continue;
+		
+		const ScreenClusters::Cluster & cluster = clusters.cluster(assignments[i]);
+		std::size_t cell = std::size_t(ys[i] / CELL) * columns + std::size_t(xs[i] / CELL);
+		
+		if (cluster.point != nearest[cell] || cluster.count != counts[cell])
+			wrong += 1;
+	}
+	
+	std::printf("Screen, %lu points: %0.1fus per frame, %lu clusters drawn in %lu cells, %lu points outside the viewport drawn as they are\n", (unsigned long)count, frameTime * 1e6, (unsigned long)clusters.clusters().size(), (unsigned long)clusters.cellCount(), (unsigned long)outside);
+	
+	if (wrong || clusters.clusters().size() > clusters.cellCount()) {
+		std::printf("FAILED: %lu points in the wrong cluster\n", (unsigned long)wrong);
+		return false;
+	}
+	
+	return true;
+}
+
+int main (int argc, char ** argv) {
+	std::vector<std::size_t> counts;
+	
+	for (int i = 1; i < argc; i += 1)
+		counts.push_back(std::strtoul(argv[i], NULL, 10));
+	
+	if (counts.empty()) {
+		counts.push_back(10000);
+		counts.push_back(100000);
+	}
+	
+	bool success = true;
+	
+	for (std::size_t i = 0; i < counts.size(); i += 1) {
+		success = testRadar(counts[i]) && success;
+		success = testScreen(counts[i]) && success;
+	}
+	
+	return success ? 0 : 1;
+}
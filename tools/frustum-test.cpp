@@ -0,0 +1,411 @@
+//
+//  frustum-test.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Checks every path of ARBrowser::Frustum against brute force tests in double precision: a box is outside a plane if all eight corners are, and a sphere if its furthest point along the plane normal is. The scalar path (intersectsBox and intersectsSphere, also used for the last few objects of a batch), the vector path of cullBoxes and cullSpheres (SSE on x86, NEON on ARM) and a lane by lane copy of the NEON arithmetic, so that it is also checked on x86, are tested with random boxes and spheres in random frustums. Objects within rounding error of a plane are skipped there, so a frustum whose planes are exact in floating point is then used to check that objects exactly touching a plane, including points on a plane, are visible in every path, and objects just beyond it are not. Finally reports the throughput of each path.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/frustum-test.cpp source/ARBrowser/ARFrustum.cpp -o frustum-test
+//
+// Usage:
+//	frustum-test
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARFrustum.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// Separate arrays of centres and half extents, or radii in extentX, as given to cullBoxes and cullSpheres.
+struct Objects {
+	std::vector<float> x, y, z, extentX, extentY, extentZ;
+	
+	void add (float _x, float _y, float _z, float _extentX, float _extentY, float _extentZ) {
+		x.push_back(_x); y.push_back(_y); z.push_back(_z);
+		extentX.push_back(_extentX); extentY.push_back(_extentY); extentZ.push_back(_extentZ);
+	}
+	
+	std::size_t size () const { return x.size(); }
+};
+
+/// The signed distance of the corner of the box furthest inside the least favourable plane, in double precision. The box is visible if it is not negative.
+static double boxMargin (const Frustum & frustum, const Objects & boxes, std::size_t i) {
+	double margin = INFINITY;
+	
+	for (std::size_t j = 0; j < Frustum::PLANES; j += 1) {
+		const float * plane = frustum.plane((Frustum::Plane)j);
+		double furthest = -INFINITY;
+		
+		for (std::size_t corner = 0; corner < 8; corner += 1) {
+			double x = (double)boxes.x[i] + ((corner & 1) ? boxes.extentX[i] : -boxes.extentX[i]);
+			double y = (double)boxes.y[i] + ((corner & 2) ? boxes.extentY[i] : -boxes.extentY[i]);
+			double z = (double)boxes.z[i] + ((corner & 4) ? boxes.extentZ[i] : -boxes.extentZ[i]);
+			
+			furthest = std::max(furthest, plane[0] * x + plane[1] * y + plane[2] * z + plane[3]);
+		}
+		
+		margin = std::min(margin, furthest);
+	}
+	
+	return margin;
+}
+
+/// The signed distance of the point of the sphere furthest inside the least favourable plane, in double precision.
+static double sphereMargin (const Frustum & frustum, const Objects & spheres, std::size_t i) {
+	double margin = INFINITY;
+	
+	for (std::size_t j = 0; j < Frustum::PLANES; j += 1) {
+		const float * plane = frustum.plane((Frustum::Plane)j);
+		
+		// The planes are normalized, so the furthest point is the centre plus the radius along the normal:
+		double x = spheres.x[i] + (double)plane[0] * spheres.extentX[i];
+		double y = spheres.y[i] + (double)plane[1] * spheres.extentX[i];
+		double z = spheres.z[i] + (double)plane[2] * spheres.extentX[i];
+		
+		margin = std::min(margin, plane[0] * x + plane[1] * y + plane[2] * z + plane[3]);
+	}
+	
+	return margin;
+}
+
+/// The same operations in the same order as one lane of the NEON path of cullBoxes.
+static bool neonBox (const Frustum & frustum, const Objects & boxes, std::size_t i) {
+	for (std::size_t j = 0; j < Frustum::PLANES; j += 1) {
+		const float * plane = frustum.plane((Frustum::Plane)j);
+		
+		float d = plane[3];
+		d = d + boxes.x[i] * plane[0];
+		d = d + boxes.y[i] * plane[1];
+		d = d + boxes.z[i] * plane[2];
+		d = d + boxes.extentX[i] * std::fabs(plane[0]);
+		d = d + boxes.extentY[i] * std::fabs(plane[1]);
+		d = d + boxes.extentZ[i] * std::fabs(plane[2]);
+		
+		if (d < 0) return false;
+	}
+	
+	return true;
+}
+
+/// The same operations in the same order as one lane of the NEON path of cullSpheres.
+static bool neonSphere (const Frustum & frustum, const Objects & spheres, std::size_t i) {
+	for (std::size_t j = 0; j < Frustum::PLANES; j += 1) {
+		const float * plane = frustum.plane((Frustum::Plane)j);
+		
+		float d = plane[3];
+		d = d + spheres.x[i] * plane[0];
+		d = d + spheres.y[i] * plane[1];
+		d = d + spheres.z[i] * plane[2];
+		
+		if (d < -spheres.extentX[i]) return false;
+	}
+	
+	return true;
+}
+
+static bool scalarBox (const Frustum & frustum, const Objects & boxes, std::size_t i) {
+	float min[3] = {boxes.x[i] - boxes.extentX[i], boxes.y[i] - boxes.extentY[i], boxes.z[i] - boxes.extentZ[i]};
+	float max[3] = {boxes.x[i] + boxes.extentX[i], boxes.y[i] + boxes.extentY[i], boxes.z[i] + boxes.extentZ[i]};
+	
+	return frustum.intersectsBox(min, max);
+}
+
+static bool scalarSphere (const Frustum & frustum, const Objects & spheres, std::size_t i) {
+	float center[3] = {spheres.x[i], spheres.y[i], spheres.z[i]};
+	
+	return frustum.intersectsSphere(center, spheres.extentX[i]);
+}
+
+/// Compare every path with the brute force test, except for objects whose margin is within the tolerance, where rounding decides.
+/// @returns the number of mismatches.
+static std::size_t compare (const char * name, const Frustum & frustum, const Objects & objects, bool boxes, double tolerance, std::size_t & ambiguous) {
+	std::vector<std::uint8_t> batch(objects.size());
+	
+	if (boxes)
+		frustum.cullBoxes(objects.size(), objects.x.data(), objects.y.data(), objects.z.data(), objects.extentX.data(), objects.extentY.data(), objects.extentZ.data(), batch.data());
+	else
+		frustum.cullSpheres(objects.size(), objects.x.data(), objects.y.data(), objects.z.data(), objects.extentX.data(), batch.data());
+	
+	std::size_t mismatches = 0;
+	
+	for (std::size_t i = 0; i < objects.size(); i += 1) {
+		double margin = boxes ? boxMargin(frustum, objects, i) : sphereMargin(frustum, objects, i);
+		
+		if (std::fabs(margin) <= tolerance) {
+			ambiguous += 1;
+			
+			continue;
+		}
+		
+		bool expected = margin >= 0;
+		bool scalar = boxes ? scalarBox(frustum, objects, i) : scalarSphere(frustum, objects, i);
+		bool neon = boxes ? neonBox(frustum, objects, i) : neonSphere(frustum, objects, i);
+		
+		if (scalar != expected || (batch[i] != 0) != expected || neon != expected) {
+			if (mismatches < 5)
+				std::printf("FAILED: %s %lu with margin %g: expected %d, scalar %d, vector %d, NEON equivalent %d\n", name, (unsigned long)i, margin, expected, scalar, batch[i], neon);
+			
+			mismatches += 1;
+		}
+	}
+	
+	return mismatches;
+}
+
+static void perspective (float fieldOfView, float aspect, float near, float far, float * matrix) {
+	float f = 1.0f / std::tan(fieldOfView / 2.0f);
+	
+	for (std::size_t i = 0; i < 16; i += 1)
+		matrix[i] = 0;
+	
+	matrix[0] = f / aspect;
+	matrix[5] = f;
+	matrix[10] = (far + near) / (near - far);
+	matrix[11] = -1;
+	matrix[14] = 2.0f * far * near / (near - far);
+}
+
+/// A rotation by yaw about Y and then pitch about X, followed by a translation, in column major order.
+static void view (float yaw, float pitch, const float * translation, float * matrix) {
+	float cy = std::cos(yaw), sy = std::sin(yaw), cp = std::cos(pitch), sp = std::sin(pitch);
+	
+	float rotation[9] = {
+		cy, sp * sy, -cp * sy,
+		0, cp, sp,
+		sy, -sp * cy, cp * cy
+	};
+	
+	for (std::size_t column = 0; column < 3; column += 1) {
+		for (std::size_t row = 0; row < 3; row += 1)
+			matrix[column * 4 + row] = rotation[column * 3 + row];
+		
+		matrix[column * 4 + 3] = 0;
+	}
+	
+	for (std::size_t row = 0; row < 3; row += 1)
+		matrix[12 + row] = translation[row];
+	
+	matrix[15] = 1;
+}
+
+static bool testRandom () {
+	const std::size_t FRUSTUMS = 50, COUNT = 10003;
+	
+	std::mt19937 generator(9);
+	std::uniform_real_distribution<float> unit(0, 1), position(-150, 150), angle(-3.14159f, 3.14159f);
+	
+	std::size_t mismatches = 0, ambiguous = 0, tested = 0;
+	
+	for (std::size_t f = 0; f < FRUSTUMS; f += 1) {
+		float projection[16], modelView[16];
+		float translation[3] = {position(generator) * 0.1f, position(generator) * 0.1f, position(generator) * 0.1f};
+		
+		perspective(0.5f + unit(generator) * 1.5f, 0.5f + unit(generator) * 1.5f, 0.1f + unit(generator), 50 + unit(generator) * 150, projection);
+		view(angle(generator), angle(generator) * 0.5f, translation, modelView);
+		
+		Frustum frustum(projection, modelView);
+		Objects boxes, spheres;
+		
+		for (std::size_t i = 0; i < COUNT; i += 1) {
+			boxes.add(position(generator), position(generator), position(generator), unit(generator) * 10, unit(generator) * 10, unit(generator) * 10);
+			spheres.add(position(generator), position(generator), position(generator), unit(generator) * 10, 0, 0);
+		}
+		
+		// Rounding differs between paths by a few units in the last place of the largest term:
+		double tolerance = 1e-4;
+		
+		mismatches += compare("Box", frustum, boxes, true, tolerance, ambiguous);
+		mismatches += compare("Sphere", frustum, spheres, false, tolerance, ambiguous);
+		tested += COUNT * 2;
+	}
+	
+	std::printf("Random: %lu boxes and spheres in %lu frustums, %lu within rounding error of a plane, %lu mismatches\n", (unsigned long)tested, (unsigned long)FRUSTUMS, (unsigned long)ambiguous, (unsigned long)mismatches);
+	
+	return mismatches == 0;
+}
+
+/// An orthographic frustum from -4 to 4 on each axis, whose planes are exact in floating point, so every path computes the same distances.
+static Frustum exactFrustum () {
+	float matrix[16] = {
+		0.25f, 0, 0, 0,
+		0, 0.25f, 0, 0,
+		0, 0, -0.25f, 0,
+		0, 0, 0, 1
+	};
+	
+	return Frustum(matrix);
+}
+
+/// Check the vector path and the scalar path used for the remainder of a batch, by starting the batch at each offset.
+static bool checkExact (const char * name, const Frustum & frustum, const Objects & objects, bool boxes, const std::vector<bool> & expected) {
+	bool success = true;
+	
+	for (std::size_t offset = 0; offset < 4; offset += 1) {
+		std::size_t count = objects.size() - offset;
+		std::vector<std::uint8_t> batch(count);
+		
+		if (boxes)
+			frustum.cullBoxes(count, objects.x.data() + offset, objects.y.data() + offset, objects.z.data() + offset, objects.extentX.data() + offset, objects.extentY.data() + offset, objects.extentZ.data() + offset, batch.data());
+		else
+			frustum.cullSpheres(count, objects.x.data() + offset, objects.y.data() + offset, objects.z.data() + offset, objects.extentX.data() + offset, batch.data());
+		
+		for (std::size_t i = 0; i < count; i += 1) {
+			std::size_t index = i + offset;
+			
+			bool scalar = boxes ? scalarBox(frustum, objects, index) : scalarSphere(frustum, objects, index);
+			bool neon = boxes ? neonBox(frustum, objects, index) : neonSphere(frustum, objects, index);
+			bool brute = (boxes ? boxMargin(frustum, objects, index) : sphereMargin(frustum, objects, index)) >= 0;
+			
+			if (scalar != expected[index] || (batch[i] != 0) != expected[index] || neon != expected[index] || brute != expected[index]) {
+				std::printf("FAILED: %s %lu at (%g, %g, %g): expected %d, scalar %d, vector %d, NEON equivalent %d, brute force %d\n", name, (unsigned long)index, objects.x[index], objects.y[index], objects.z[index], (int)expected[index], scalar, batch[i], neon, brute);
+				success = false;
+			}
+		}
+	}
+	
+	return success;
+}
+
+static bool testExact () {
+	Frustum frustum = exactFrustum();
+	
+	// Check that the planes really are exact, otherwise the expectations below don't hold:
+	for (std::size_t j = 0; j < Frustum::PLANES; j += 1) {
+		const float * plane = frustum.plane((Frustum::Plane)j);
+		
+		if (std::fabs(plane[0]) + std::fabs(plane[1]) + std::fabs(plane[2]) != 1 || plane[3] != 4) {
+			std::printf("FAILED: Plane %lu of the orthographic frustum is not exact\n", (unsigned long)j);
+			
+			return false;
+		}
+	}
+	
+	const float EPSILON = 1.0f / 1024;
+	
+	Objects boxes, spheres, points;
+	std::vector<bool> boxesVisible, spheresVisible, pointsVisible;
+	
+	for (std::size_t axis = 0; axis < 3; axis += 1) {
+		for (float side = -1; side <= 1; side += 2) {
+			float center[3] = {0, 0, 0}, extent[3] = {1, 1, 1};
+			
+			// A box touching the plane from outside is visible, but not once it is moved just beyond it:
+			center[axis] = side * 5;
+			boxes.add(center[0], center[1], center[2], extent[0], extent[1], extent[2]);
+			boxesVisible.push_back(true);
+			
+			center[axis] = side * (5 + EPSILON);
+			boxes.add(center[0], center[1], center[2], extent[0], extent[1], extent[2]);
+			boxesVisible.push_back(false);
+			
+			// A sphere touching the plane from outside, and one slightly too small:
+			center[axis] = side * 5;
+			spheres.add(center[0], center[1], center[2], 1, 0, 0);
+			spheresVisible.push_back(true);
+			
+			spheres.add(center[0], center[1], center[2], 1 - EPSILON, 0, 0);
+			spheresVisible.push_back(false);
+			
+			// A point on the plane, on the plane at a corner of the frustum, and just outside:
+			center[axis] = side * 4;
+			points.add(center[0], center[1], center[2], 0, 0, 0);
+			pointsVisible.push_back(true);
+			
+			float corner[3] = {4, -4, 4};
+			corner[axis] = side * 4;
+			points.add(corner[0], corner[1], corner[2], 0, 0, 0);
+			pointsVisible.push_back(true);
+			
+			center[axis] = side * (4 + EPSILON);
+			points.add(center[0], center[1], center[2], 0, 0, 0);
+			pointsVisible.push_back(false);
+		}
+	}
+	
+	bool success = true;
+	
+	success = checkExact("Touching box", frustum, boxes, true, boxesVisible) && success;
+	success = checkExact("Touching sphere", frustum, spheres, false, spheresVisible) && success;
+	
+	// Points are boxes with no extent, and spheres with no radius:
+	success = checkExact("Point box", frustum, points, true, pointsVisible) && success;
+	success = checkExact("Point sphere", frustum, points, false, pointsVisible) && success;
+	
+	std::printf("Exact: %lu boxes, spheres and points touching or just beyond a plane\n", (unsigned long)(boxes.size() + spheres.size() + points.size()));
+	
+	return success;
+}
+
+static void benchmark () {
+	const std::size_t COUNT = 100000, REPEATS = 20;
+	
+	std::mt19937 generator(3);
+	std::uniform_real_distribution<float> unit(0, 1), position(-150, 150);
+	
+	float projection[16], modelView[16], translation[3] = {0, 0, 0};
+	perspective(1.0f, 0.75f, 0.1f, 1000, projection);
+	view(0.3f, 0.1f, translation, modelView);
+	
+	Frustum frustum(projection, modelView);
+	Objects boxes;
+	
+	for (std::size_t i = 0; i < COUNT; i += 1)
+		boxes.add(position(generator), position(generator), position(generator), unit(generator) * 10, unit(generator) * 10, unit(generator) * 10);
+	
+	std::vector<std::uint8_t> visible(COUNT);
+	std::size_t total[3] = {0, 0, 0};
+	double times[3];
+	
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::size_t r = 0; r < REPEATS; r += 1)
+		total[0] += frustum.cullBoxes(COUNT, boxes.x.data(), boxes.y.data(), boxes.z.data(), boxes.extentX.data(), boxes.extentY.data(), boxes.extentZ.data(), visible.data());
+	
+	times[0] = elapsed(start);
+	start = ClockT::now();
+	
+	for (std::size_t r = 0; r < REPEATS; r += 1)
+		for (std::size_t i = 0; i < COUNT; i += 1)
+			total[1] += scalarBox(frustum, boxes, i);
+	
+	times[1] = elapsed(start);
+	start = ClockT::now();
+	
+	for (std::size_t r = 0; r < REPEATS; r += 1)
+		for (std::size_t i = 0; i < COUNT; i += 1)
+			total[2] += neonBox(frustum, boxes, i);
+	
+	times[2] = elapsed(start);
+	
+	const char * names[3] = {"cullBoxes", "intersectsBox", "NEON equivalent"};
+	
+	for (std::size_t i = 0; i < 3; i += 1)
+		std::printf("%s: %0.1f million boxes per second, %lu visible\n", names[i], COUNT * REPEATS / times[i] / 1e6, (unsigned long)(total[i] / REPEATS));
+}
+
+int main () {
+	bool success = true;
+	
+	success = testRandom() && success;
+	success = testExact() && success;
+	
+	benchmark();
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,207 @@
+//
+//  geodetic-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Checks the accuracy of the ARBrowser::GeodeticOrigin batch functions against the scalar functions in ARWorldLocation.mm, and reports the throughput of both in points per second. Exits with an error if any result is outside the tolerance.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/geodetic-benchmark.cpp source/ARBrowser/ARGeodetic.cpp -o geodetic-benchmark
+//
+// Add -mavx to test the AVX implementation.
+
+#include "ARGeodetic.h"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ARBrowser;
+
+// The scalar functions from ARWorldLocation.mm, which depend on CoreLocation types:
+namespace Reference {
+	const double D2R = (M_PI / 180.0);
+	const double R2D = (180.0 / M_PI);
+	const double WGS84_A = 6378137.0;
+	const double WGS84_E = 8.1819190842622e-2;
+	
+	void convertLocationToECEF(double lat, double lon, double alt, double *x, double *y, double *z) {
+		double clat = cos(lat * D2R);
+		double slat = sin(lat * D2R);
+		double clon = cos(lon * D2R);
+		double slon = sin(lon * D2R);
+		
+		double N = WGS84_A / sqrt(1.0 - WGS84_E * WGS84_E * slat * slat);
+		
+		*x = (N + alt) * clat * clon;
+		*y = (N + alt) * clat * slon;
+		*z = (N * (1.0 - WGS84_E * WGS84_E) + alt) * slat;
+	}
+	
+	void convertECEFtoENU(double lat, double lon, double x, double y, double z, double xr, double yr, double zr, double *e, double *n, double *u) {
+		double clat = cos(lat * D2R);
+		double slat = sin(lat * D2R);
+		double clon = cos(lon * D2R);
+		double slon = sin(lon * D2R);
+		double dx = x - xr;
+		double dy = y - yr;
+		double dz = z - zr;
+		
+		*e = -slon*dx  + clon*dy;
+		*n = -slat*clon*dx - slat*slon*dy + clat*dz;
+		*u = clat*clon*dx + clat*slon*dy + slat*dz;
+	}
+	
+	double calculateBearingBetween(double fromLatitude, double fromLongitude, double toLatitude, double toLongitude) {
+		double bearing = atan2(sin(toLongitude - fromLongitude) * cos(toLatitude),
+			cos(fromLatitude) * sin(toLatitude) - sin(fromLatitude) * cos(toLatitude) * cos(toLongitude - fromLongitude));
+		
+		return bearing * R2D;
+	}
+	
+	double calculateDistanceBetween(double aLatitude, double aLongitude, double bLatitude, double bLongitude, double altitude) {
+		altitude += WGS84_A;
+		
+		double sx = sin((bLatitude - aLatitude)/2.0), sy = sin((bLongitude - aLongitude)/2.0);
+		double t = sx*sx + cos(aLatitude) * cos(bLatitude) * sy*sy;
+		double c = 2.0 * atan2(sqrt(t), sqrt(1.0-t));
+		
+		return fabs(altitude * c);
+	}
+}
+
+struct Points {
+	std::vector<double> latitudes, longitudes, altitudes;
+	
+	void resize (std::size_t size) {
+		latitudes.resize(size); longitudes.resize(size); altitudes.resize(size);
+	}
+};
+
+int main () {
+	typedef std::chrono::steady_clock ClockT;
+	
+	const std::size_t SIZE = 100003;
+	const int ROUNDS = 20;
+	
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> unit(-1.0, 1.0);
+	
+	std::cout << "Instruction set: " << geodeticInstructionSet() << std::endl;
+	
+	bool failed = false;
+	
+	// Points from a few meters to the other side of the earth, around origins including the poles and the antimeridian:
+	double extents[] = {0.0001, 0.01, 1.0, 90.0};
+	double origins[][2] = {{-43.5321, 172.6362}, {51.4779, -0.0015}, {0.0, 179.9999}, {89.9999, 0.0}, {-89.9, -179.0}};
+	
+	for (auto & center : origins) {
+		GeodeticOrigin origin(center[0], center[1], 20.0);
+		
+		for (double extent : extents) {
+			Points points;
+			points.resize(SIZE);
+			
+			for (std::size_t i = 0; i < SIZE; i += 1) {
+				points.latitudes[i] = std::max(-90.0, std::min(90.0, center[0] + unit(generator) * extent));
+				points.longitudes[i] = center[1] + unit(generator) * extent * 2.0;
+				points.altitudes[i] = unit(generator) * 100.0;
+			}
+			
+			std::vector<double> east(SIZE), north(SIZE), up(SIZE), distances(SIZE), bearings(SIZE);
+			
+			origin.convertToENU(SIZE, points.latitudes.data(), points.longitudes.data(), points.altitudes.data(), east.data(), north.data(), up.data());
+			origin.calculateDistanceAndBearing(SIZE, points.latitudes.data(), points.longitudes.data(), distances.data(), bearings.data());
+			
+			double ox, oy, oz;
+			Reference::convertLocationToECEF(center[0], center[1], 20.0, &ox, &oy, &oz);
+			
+			double positionError = 0, distanceError = 0, bearingError = 0;
+			
+			for (std::size_t i = 0; i < SIZE; i += 1) {
+				double x, y, z, e, n, u;
+				Reference::convertLocationToECEF(points.latitudes[i], points.longitudes[i], points.altitudes[i], &x, &y, &z);
+				Reference::convertECEFtoENU(center[0], center[1], x, y, z, ox, oy, oz, &e, &n, &u);
+				
+				positionError = std::max(positionError, std::max(std::fabs(e - east[i]), std::max(std::fabs(n - north[i]), std::fabs(u - up[i]))));
+				
+				double fromLatitude = center[0] * Reference::D2R, fromLongitude = center[1] * Reference::D2R;
+				double toLatitude = points.latitudes[i] * Reference::D2R, toLongitude = points.longitudes[i] * Reference::D2R;
+				
+				double distance = Reference::calculateDistanceBetween(fromLatitude, fromLongitude, toLatitude, toLongitude, 20.0);
+				distanceError = std::max(distanceError, std::fabs(distance - distances[i]));
+				
+				// Both bearing calculations are poorly conditioned for nearby points, so compare the lateral offset which the difference in bearing would cause at that distance:
+				double bearing = Reference::calculateBearingBetween(fromLatitude, fromLongitude, toLatitude, toLongitude);
+				double difference = std::fabs(std::remainder(bearing - bearings[i], 360.0));
+				
+				bearingError = std::max(bearingError, difference * Reference::D2R * distance);
+			}
+			
+			// Allow for a few ulp of difference in the trigonometry, at the scale of the earth:
+			bool ok = positionError < 1e-6 && distanceError < 1e-6 && bearingError < 1e-6;
+			
+			std::cout << "origin " << center[0] << ", " << center[1] << " extent " << extent << " degrees: position error " << positionError << "m, distance error " << distanceError << "m, bearing error " << bearingError << "m" << (ok ? "" : " FAILED") << std::endl;
+			
+			if (!ok) failed = true;
+		}
+	}
+	
+	// Throughput, for points within a few kilometers as used by ARBrowserView:
+	{
+		GeodeticOrigin origin(-43.5321, 172.6362, 20.0);
+		Points points;
+		points.resize(SIZE);
+		
+		for (std::size_t i = 0; i < SIZE; i += 1) {
+			points.latitudes[i] = -43.5321 + unit(generator) * 0.05;
+			points.longitudes[i] = 172.6362 + unit(generator) * 0.05;
+			points.altitudes[i] = unit(generator) * 100.0;
+		}
+		
+		std::vector<double> east(SIZE), north(SIZE), up(SIZE), distances(SIZE), bearings(SIZE);
+		double checksum = 0;
+		
+		ClockT::time_point start = ClockT::now();
+		for (int round = 0; round < ROUNDS; round += 1) {
+			origin.convertToENU(SIZE, points.latitudes.data(), points.longitudes.data(), points.altitudes.data(), east.data(), north.data(), up.data());
+			origin.calculateDistanceAndBearing(SIZE, points.latitudes.data(), points.longitudes.data(), distances.data(), bearings.data());
+			checksum += east[round] + distances[round];
+		}
+		double batchTime = std::chrono::duration<double>(ClockT::now() - start).count();
+		
+		double ox, oy, oz;
+		start = ClockT::now();
+		for (int round = 0; round < ROUNDS; round += 1) {
+			for (std::size_t i = 0; i < SIZE; i += 1) {
+				double x, y, z;
+				Reference::convertLocationToECEF(-43.5321, 172.6362, 20.0, &ox, &oy, &oz);
+				Reference::convertLocationToECEF(points.latitudes[i], points.longitudes[i], points.altitudes[i], &x, &y, &z);
+				Reference::convertECEFtoENU(-43.5321, 172.6362, x, y, z, ox, oy, oz, &east[i], &north[i], &up[i]);
+				
+				double fromLatitude = -43.5321 * Reference::D2R, fromLongitude = 172.6362 * Reference::D2R;
+				double toLatitude = points.latitudes[i] * Reference::D2R, toLongitude = points.longitudes[i] * Reference::D2R;
+				
+				distances[i] = Reference::calculateDistanceBetween(fromLatitude, fromLongitude, toLatitude, toLongitude, 20.0);
+				bearings[i] = Reference::calculateBearingBetween(fromLatitude, fromLongitude, toLatitude, toLongitude);
+			}
+			checksum += east[round] + distances[round];
+		}
+		double scalarTime = std::chrono::duration<double>(ClockT::now() - start).count();
+		
+		double count = double(SIZE) * ROUNDS;
+		
+		std::cout << "Scalar: " << (count / scalarTime / 1e6) << " million points per second" << std::endl;
+		std::cout << "Batch: " << (count / batchTime / 1e6) << " million points per second (" << (scalarTime / batchTime) << "x)" << std::endl;
+		
+		// Prevent the loops from being optimised away:
+		if (checksum == 0) std::cout << std::endl;
+	}
+	
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+//
+//  hud-allocations.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Checks the shared heads up display geometry in ARBrowser::HudGeometry: the unit ring must match the ring which renderRing used to generate by repeated rotation, the grid must match generateGrid, and walking every primitive for many frames, as the heads up display does when drawing, must not allocate any memory. Allocations are counted by replacing the global operator new.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/hud-allocations.cpp source/ARBrowser/ARHudGeometry.cpp -o hud-allocations
+//
+// Usage:
+//	hud-allocations [frames]
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARHudGeometry.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+using namespace ARBrowser;
+
+static std::atomic<std::size_t> allocations(0);
+
+void * operator new (std::size_t size) {
+	allocations += 1;
+	
+	if (void * pointer = std::malloc(size ? size : 1))
+		return pointer;
+	
+	throw std::bad_alloc();
+}
+
+void operator delete (void * pointer) noexcept {
+	std::free(pointer);
+}
+
+static const char * NAMES[HUD_PRIMITIVES] = {"ring", "radar crosshair", "radar forward", "radar field of view", "axis", "grid"};
+
+/// The ring which renderRing generated every time it was called, by rotating a point 32 times.
+static std::vector<float> rotatedRing (float radius) {
+	const unsigned STEPS = 32;
+	const float angle = 2.0 * M_PI / STEPS;
+	
+	std::vector<float> points;
+	float x = radius, y = 0;
+	
+	for (unsigned i = 0; i < STEPS; i++) {
+		points.push_back(x);
+		points.push_back(y);
+		
+		float rx = std::cos(angle) * x - std::sin(angle) * y;
+		float ry = std::sin(angle) * x + std::cos(angle) * y;
+		
+		x = rx; y = ry;
+	}
+	
+	return points;
+}
+
+/// The grid generated by generateGrid.
+static std::vector<float> generatedGrid () {
+	const float LOWER = -10;
+	const float UPPER = 10;
+	const float STEP = 0.5;
+	
+	std::vector<float> points;
+	
+	for (float x = LOWER; x <= UPPER; x += STEP) {
+		const float lines[4][2] = {{x, LOWER}, {x, UPPER}, {LOWER, x}, {UPPER, x}};
+		
+		for (std::size_t i = 0; i < 4; i += 1) {
+			points.push_back(lines[i][0]);
+			points.push_back(lines[i][1]);
+		}
+	}
+	
+	return points;
+}
+
+int main (int argc, char ** argv) {
+	std::size_t frames = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 100000;
+	bool failed = false;
+	
+	std::size_t before = allocations.load();
+	const HudGeometry & geometry = HudGeometry::shared();
+	std::size_t setup = allocations.load() - before;
+	
+	std::printf("Geometry: %lu vertices, %lu bytes, %lu allocations to generate\n", (unsigned long)HudGeometry::VERTEX_COUNT, (unsigned long)sizeof(HudGeometry), (unsigned long)setup);
+	
+	for (std::size_t primitive = 0; primitive < HUD_PRIMITIVES; primitive += 1) {
+		const HudRange & range = geometry.range((HudPrimitive)primitive);
+		std::printf("\t%-20s first %3lu, count %3lu\n", NAMES[primitive], (unsigned long)range.first, (unsigned long)range.count);
+		
+		if (range.first + range.count > HudGeometry::VERTEX_COUNT) {
+			std::printf("FAILED: %s is outside the vertex buffer\n", NAMES[primitive]);
+			failed = true;
+		}
+	}
+	
+	// Rings are drawn by scaling the unit ring, which must match the rings generated before, for the radii used by the browser and the radar:
+	const float RADII[] = {2, 4, 5, 10, 15, 20, 100, 500};
+	const HudRange & ring = geometry.range(HUD_RING);
+	float ringError = 0;
+	
+	for (float radius : RADII) {
+		std::vector<float> expected = rotatedRing(radius);
+		
+		for (std::size_t i = 0; i < ring.count; i += 1) {
+			const HudVertex & vertex = geometry.vertices()[ring.first + i];
+			
+			ringError = std::max(ringError, std::fabs(vertex.position[0] * radius - expected[i*2]) / radius);
+			ringError = std::max(ringError, std::fabs(vertex.position[1] * radius - expected[i*2 + 1]) / radius);
+		}
+	}
+	
+	std::printf("Ring: largest error relative to the radius %0.2e\n", ringError);
+	
+	if (ringError > 1e-5) {
+		std::printf("FAILED: the unit ring doesn't match the generated ring\n");
+		failed = true;
+	}
+	
+	std::vector<float> grid = generatedGrid();
+	const HudRange & gridRange = geometry.range(HUD_GRID);
+	std::size_t gridErrors = 0;
+	
+	if (grid.size() != gridRange.count * 2) {
+		gridErrors += 1;
+	} else {
+		for (std::size_t i = 0; i < gridRange.count; i += 1) {
+			const HudVertex & vertex = geometry.vertices()[gridRange.first + i];
+			
+			if (vertex.position[0] != grid[i*2] || vertex.position[1] != grid[i*2 + 1] || vertex.position[2] != 0)
+				gridErrors += 1;
+		}
+	}
+	
+	if (gridErrors) {
+		std::printf("FAILED: the grid doesn't match generateGrid\n");
+		failed = true;
+	}
+	
+	// Walk every primitive each frame, as drawing the heads up display does, and make sure nothing allocates:
+	before = allocations.load();
+	float checksum = 0;
+	
+	for (std::size_t frame = 0; frame < frames; frame += 1) {
+		const HudGeometry & shared = HudGeometry::shared();
+		
+		for (std::size_t primitive = 0; primitive < HUD_PRIMITIVES; primitive += 1) {
+			const HudRange & range = shared.range((HudPrimitive)primitive);
+			
+			for (std::size_t i = range.first; i < range.first + range.count; i += 1)
+				checksum += shared.vertices()[i].position[0] + shared.vertices()[i].color[3];
+		}
+	}
+	
+	std::size_t perFrame = allocations.load() - before;
+	
+	std::printf("Frames: %lu, %lu allocations (checksum %0.1f)\n", (unsigned long)frames, (unsigned long)perFrame, checksum);
+	
+	if (setup || perFrame) {
+		std::printf("FAILED: the heads up display geometry allocated memory\n");
+		failed = true;
+	}
+	
+	return failed ? 1 : 0;
+}
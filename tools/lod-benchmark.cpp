@@ -0,0 +1,195 @@
+//
+//  lod-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Builds the level of detail chain for a model, then simulates walking through a dense scene of instances and reports how many vertices and triangles are drawn using ARBrowser::LevelOfDetail, compared with always drawing full detail.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/lod-benchmark.cpp source/ARBrowser/ARLevelOfDetail.cpp source/ARBrowser/ARObjLoader.cpp source/ARBrowser/ARMappedFile.cpp source/ARBrowser/ARMesh.cpp -o lod-benchmark
+//
+// Usage:
+//	lod-benchmark [directory name]
+//
+// Without arguments, a finely tessellated sphere of radius 1m is used.
+
+#include "ARLevelOfDetail.h"
+#include "ARObjLoader.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static void generateSphere (IndexedMesh & mesh, std::size_t rings, std::size_t segments) {
+	for (std::size_t i = 0; i <= rings; i += 1) {
+		for (std::size_t j = 0; j <= segments; j += 1) {
+			double theta = M_PI * i / rings, phi = 2.0 * M_PI * (j % segments) / segments;
+			
+			ObjMeshVertex vertex;
+			vertex.pos = Vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+			vertex.normal = vertex.pos;
+			vertex.texcoord = Vec2((float)j / segments, (float)i / rings);
+			
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	
+	std::vector<std::uint32_t> indices;
+	
+	for (std::size_t i = 0; i < rings; i += 1) {
+		for (std::size_t j = 0; j < segments; j += 1) {
+			std::uint32_t a = (std::uint32_t)(i * (segments + 1) + j), b = a + 1, c = a + (std::uint32_t)segments + 1, d = c + 1;
+			
+			if (i != 0) {
+				indices.push_back(a); indices.push_back(c); indices.push_back(b);
+			}
+			
+			if (i != rings - 1) {
+				indices.push_back(b); indices.push_back(c); indices.push_back(d);
+			}
+		}
+	}
+	
+	optimizeVertexCache(indices, mesh.vertices.size());
+	mesh.assignIndices(indices);
+}
+
+/// The number of distinct vertices referenced by the level, which is the number the GPU has to transform at best.
+static std::size_t vertexCount (const LevelOfDetail::Level & level) {
+	std::size_t count = 0;
+	
+	for (std::size_t i = 0; i < level.meshes.size(); i += 1) {
+		const MeshBuffer & mesh = level.meshes[i];
+		std::vector<bool> used(mesh.vertexCount, false);
+		
+		for (std::size_t j = 0; j < mesh.indexCount; j += 1) {
+			std::uint32_t index = mesh.shortIndices ? ((const std::uint16_t *)mesh.indices)[j] : ((const std::uint32_t *)mesh.indices)[j];
+			
+			if (!used[index]) {
+				used[index] = true;
+				count += 1;
+			}
+		}
+	}
+	
+	return count;
+}
+
+int main (int argc, char ** argv) {
+	// The scene, roughly matching a phone held in portrait:
+	const std::size_t INSTANCES = 500, FRAMES = 600;
+	const float AREA = 400, FIELD_OF_VIEW = 60 * M_PI / 180, SURFACE_HEIGHT = 1136, NEAR_DISTANCE = 10;
+	
+	// Walking speed in meters per frame, at 30 frames per second:
+	const float SPEED = 1.4 / 30;
+	
+	std::vector<IndexedMesh> meshes;
+	
+	if (argc > 2) {
+		std::vector<ObjMesh> faces;
+		std::string path = std::string(argv[1]) + "/" + argv[2] + ".obj";
+		
+		if (!loadObjMesh(path, faces))
+			return 2;
+		
+		meshes.resize(faces.size());
+		
+		for (std::size_t i = 0; i < faces.size(); i += 1)
+			weldMesh(faces[i], meshes[i]);
+	} else {
+		meshes.resize(1);
+		generateSphere(meshes[0], 128, 256);
+	}
+	
+	std::vector<MeshBuffer> buffers;
+	float radius = 0;
+	
+	for (std::size_t i = 0; i < meshes.size(); i += 1) {
+		buffers.push_back(meshes[i].buffer());
+		
+		for (std::size_t j = 0; j < meshes[i].vertices.size(); j += 1)
+			radius = std::max(radius, (float)meshes[i].vertices[j].pos.length());
+	}
+	
+	// The same relative error as ARBrowser::Model:
+	LevelOfDetail detail;
+	
+	ClockT::time_point start = ClockT::now();
+	detail.build(buffers, radius * 0.05);
+	double buildTime = elapsed(start);
+	
+	std::printf("Built %lu levels in %0.1fms (%lu bytes of indices):\n", (unsigned long)detail.levelCount(), buildTime * 1000.0, (unsigned long)detail.residentSize());
+	
+	std::vector<std::size_t> levelVertices(detail.levelCount());
+	
+	for (std::size_t i = 0; i < detail.levelCount(); i += 1) {
+		const LevelOfDetail::Level & level = detail.level(i);
+		levelVertices[i] = vertexCount(level);
+		
+		std::printf("\tLevel %lu: %8lu triangles, %8lu vertices, error %0.5f\n", (unsigned long)i, (unsigned long)level.triangleCount, (unsigned long)levelVertices[i], level.error);
+	}
+	
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> coordinate(-AREA / 2, AREA / 2);
+	
+	std::vector<Vec3> instances(INSTANCES);
+	
+	for (std::size_t i = 0; i < INSTANCES; i += 1)
+		instances[i] = Vec3(coordinate(generator), coordinate(generator), 0);
+	
+	std::vector<std::size_t> previous(INSTANCES, 0), usage(detail.levelCount(), 0);
+	
+	const float focalLength = SURFACE_HEIGHT * 0.5 / std::tan(FIELD_OF_VIEW / 2);
+	double fullVertices = 0, fullTriangles = 0, drawnVertices = 0, drawnTriangles = 0;
+	std::size_t switches = 0;
+	
+	start = ClockT::now();
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		Vec3 viewer(-AREA / 4 + frame * SPEED, 0, 1.5);
+		
+		for (std::size_t i = 0; i < INSTANCES; i += 1) {
+			float distance = (instances[i] - viewer).length();
+			std::size_t level = 0;
+			
+			if (distance > NEAR_DISTANCE)
+				level = detail.select(focalLength / distance, previous[i]);
+			
+			if (level != previous[i])
+				switches += 1;
+			
+			previous[i] = level;
+			usage[level] += 1;
+			
+			fullVertices += levelVertices[0];
+			fullTriangles += detail.level(0).triangleCount;
+			drawnVertices += levelVertices[level];
+			drawnTriangles += detail.level(level).triangleCount;
+		}
+	}
+	
+	double selectTime = elapsed(start);
+	
+	std::printf("Scene: %lu instances over %0.0fm x %0.0fm, %lu frames:\n", (unsigned long)INSTANCES, AREA, AREA, (unsigned long)FRAMES);
+	
+	for (std::size_t i = 0; i < usage.size(); i += 1)
+		std::printf("\tLevel %lu drawn %0.1f%% of the time\n", (unsigned long)i, 100.0 * usage[i] / (INSTANCES * FRAMES));
+	
+	std::printf("Vertices per frame: %0.0f full detail, %0.0f with levels of detail (%0.1f%% saved)\n", fullVertices / FRAMES, drawnVertices / FRAMES, 100.0 * (1.0 - drawnVertices / fullVertices));
+	std::printf("Triangles per frame: %0.0f full detail, %0.0f with levels of detail (%0.1f%% saved)\n", fullTriangles / FRAMES, drawnTriangles / FRAMES, 100.0 * (1.0 - drawnTriangles / fullTriangles));
+	std::printf("Level switches: %0.2f per frame, selection took %0.3fus per instance\n", (double)switches / FRAMES, selectTime * 1e6 / (INSTANCES * FRAMES));
+	
+	return 0;
+}
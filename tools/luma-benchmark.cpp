@@ -0,0 +1,169 @@
+//
+//  luma-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Checks that the vector implementations in ARLumaPyramid match the scalar implementations exactly, for random frame sizes, row padding and regions, then reports the throughput of converting a camera frame to luminance and building a pyramid.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/luma-benchmark.cpp source/ARBrowser/ARLumaPyramid.cpp -o luma-benchmark
+//
+// Add -mavx2 to use AVX2 rather than SSE2 on x86.
+//
+// Usage:
+//	luma-benchmark [width height]
+//
+// Exits with a non-zero status if any result differs from the scalar implementation.
+
+#include "ARLumaPyramid.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// Build the same pyramid as LumaPyramid using only the scalar functions, one level at a time.
+static void referencePyramid (const std::vector<std::uint8_t> & frame, std::size_t bytesPerRow, const LumaPyramid::Region & region, std::size_t levels, std::vector<std::vector<std::uint8_t>> & output) {
+	std::size_t width = region.width, height = region.height, previousWidth = 0, previousHeight = 0;
+	
+	output.clear();
+	
+	for (std::size_t i = 0; i < levels && width > 0 && height > 0; i += 1) {
+		output.push_back(std::vector<std::uint8_t>(width * height));
+		
+		if (i == 0)
+			convertBGRAToLumaScalar(frame.data() + region.y * bytesPerRow + region.x * 4, bytesPerRow, width, height, output[i].data(), width);
+		else
+			downsampleLumaScalar(output[i-1].data(), previousWidth, previousWidth, previousHeight, output[i].data(), width);
+		
+		previousWidth = width;
+		previousHeight = height;
+		
+		width /= 2;
+		height /= 2;
+	}
+}
+
+static std::size_t checkExact (std::mt19937 & generator) {
+	std::uniform_int_distribution<std::size_t> size(1, 300), padding(0, 9), levels(1, 4);
+	std::uniform_int_distribution<int> byte(0, 255);
+	
+	std::size_t mismatches = 0;
+	
+	for (std::size_t test = 0; test < 500; test += 1) {
+		std::size_t width = size(generator), height = size(generator);
+		std::size_t bytesPerRow = width * 4 + padding(generator) * 4;
+		
+		std::vector<std::uint8_t> frame(bytesPerRow * height);
+		
+		for (std::size_t i = 0; i < frame.size(); i += 1)
+			frame[i] = (std::uint8_t)byte(generator);
+		
+		// The extreme values are the most likely to overflow:
+		if (test % 10 == 0)
+			std::memset(frame.data(), test % 20 ? 0xFF : 0x00, frame.size());
+		
+		LumaPyramid::Region region = {0, 0, width, height};
+		
+		if (test % 2) {
+			std::uniform_int_distribution<std::size_t> x(0, width - 1), y(0, height - 1);
+			region.x = x(generator);
+			region.y = y(generator);
+			region.width = std::uniform_int_distribution<std::size_t>(1, width - region.x)(generator);
+			region.height = std::uniform_int_distribution<std::size_t>(1, height - region.y)(generator);
+		}
+		
+		std::size_t levelCount = levels(generator);
+		
+		LumaPyramid pyramid;
+		pyramid.update(frame.data(), bytesPerRow, width, height, levelCount, &region);
+		
+		std::vector<std::vector<std::uint8_t>> expected;
+		referencePyramid(frame, bytesPerRow, region, levelCount, expected);
+		
+		if (pyramid.levelCount() != expected.size()) {
+			mismatches += 1;
+			continue;
+		}
+		
+		for (std::size_t i = 0; i < expected.size(); i += 1) {
+			const LumaPyramid::Level & level = pyramid.level(i);
+			
+			if (std::memcmp(level.data, expected[i].data(), expected[i].size()) != 0) {
+				mismatches += 1;
+				
+				if (mismatches <= 5)
+					std::printf("\tMismatch: %lux%lu frame, region %lu,%lu %lux%lu, level %lu\n", (unsigned long)width, (unsigned long)height, (unsigned long)region.x, (unsigned long)region.y, (unsigned long)region.width, (unsigned long)region.height, (unsigned long)i);
+			}
+		}
+	}
+	
+	return mismatches;
+}
+
+int main (int argc, char ** argv) {
+	std::size_t width = 1280, height = 720;
+	
+	if (argc > 2) {
+		width = std::strtoul(argv[1], NULL, 10);
+		height = std::strtoul(argv[2], NULL, 10);
+	}
+	
+	std::mt19937 generator(5);
+	
+	std::printf("Kernel: %s\n", lumaKernelName());
+	
+	std::size_t mismatches = checkExact(generator);
+	std::printf("Exactness: 500 random frames, %lu mismatches\n", (unsigned long)mismatches);
+	
+	// Camera frames usually have rows padded to a multiple of 64 bytes:
+	std::size_t bytesPerRow = (width * 4 + 63) & ~(std::size_t)63;
+	std::vector<std::uint8_t> frame(bytesPerRow * height), luma(width * height);
+	
+	for (std::size_t i = 0; i < frame.size(); i += 1)
+		frame[i] = (std::uint8_t)generator();
+	
+	const std::size_t ITERATIONS = 200;
+	const double megapixels = (double)width * height * ITERATIONS / 1e6;
+	
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::size_t i = 0; i < ITERATIONS; i += 1)
+		convertBGRAToLumaScalar(frame.data(), bytesPerRow, width, height, luma.data(), width);
+	
+	double scalarTime = elapsed(start);
+	
+	start = ClockT::now();
+	
+	for (std::size_t i = 0; i < ITERATIONS; i += 1)
+		convertBGRAToLuma(frame.data(), bytesPerRow, width, height, luma.data(), width);
+	
+	double vectorTime = elapsed(start);
+	
+	LumaPyramid pyramid;
+	start = ClockT::now();
+	
+	for (std::size_t i = 0; i < ITERATIONS; i += 1)
+		pyramid.update(frame.data(), bytesPerRow, width, height, 3);
+	
+	double pyramidTime = elapsed(start);
+	
+	std::printf("Frame: %lux%lu, %lu bytes per row, %lu iterations\n", (unsigned long)width, (unsigned long)height, (unsigned long)bytesPerRow, (unsigned long)ITERATIONS);
+	std::printf("Luminance (scalar): %0.1f megapixels/s\n", megapixels / scalarTime);
+	std::printf("Luminance (%s): %0.1f megapixels/s (%0.1fx)\n", lumaKernelName(), megapixels / vectorTime, scalarTime / vectorTime);
+	std::printf("Luminance + 3 level pyramid (%s): %0.1f megapixels/s, %0.2fms per frame\n", lumaKernelName(), megapixels / pyramidTime, pyramidTime * 1000.0 / ITERATIONS);
+	
+	return mismatches ? 1 : 0;
+}
@@ -0,0 +1,319 @@
+//
+//  mesh-quantize-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Quantizes generated meshes with ARBrowser::quantizeMesh and checks that the position, normal and texture coordinate errors are within the bounds of the quantization, that the decoding matrices agree with VertexDecode, and that quantized meshes survive a round trip through a .armesh file. Then compares the size of the baked files and the time to read every vertex, for ObjMeshVertex and QuantizedVertex.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/mesh-quantize-benchmark.cpp source/ARBrowser/ARMesh.cpp source/ARBrowser/ARBakedMesh.cpp source/ARBrowser/ARMappedFile.cpp source/ARBrowser/ARLevelOfDetail.cpp source/ARBrowser/ARPicking.cpp -o mesh-quantize-benchmark
+//
+// Usage:
+//	mesh-quantize-benchmark [directory]
+//
+// Temporary .armesh files are written to the directory, which defaults to the current directory, and removed afterwards. Exits with a non-zero status if any check fails.
+
+#include "ARBakedMesh.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// An ellipsoid with the given radii and center, whose texture coordinates repeat the given number of times around it.
+static void generateEllipsoid (IndexedMesh & mesh, std::size_t rings, std::size_t segments, const Vec3 & radii, const Vec3 & center, float repeat) {
+	for (std::size_t i = 0; i <= rings; i += 1) {
+		for (std::size_t j = 0; j <= segments; j += 1) {
+			double theta = M_PI * i / rings, phi = 2.0 * M_PI * (j % segments) / segments;
+			double x = std::sin(theta) * std::cos(phi), y = std::sin(theta) * std::sin(phi), z = std::cos(theta);
+			
+			ObjMeshVertex vertex;
+			vertex.pos = Vec3(center[X] + radii[X] * x, center[Y] + radii[Y] * y, center[Z] + radii[Z] * z);
+			vertex.normal = Vec3(x / radii[X], y / radii[Y], z / radii[Z]);
+			vertex.normal = vertex.normal * (1.0f / vertex.normal.length());
+			vertex.texcoord = Vec2(repeat * j / segments, repeat * i / rings);
+			
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	
+	std::vector<std::uint32_t> indices;
+	
+	for (std::size_t i = 0; i < rings; i += 1) {
+		for (std::size_t j = 0; j < segments; j += 1) {
+			std::uint32_t a = (std::uint32_t)(i * (segments + 1) + j), b = a + 1, c = a + (std::uint32_t)segments + 1, d = c + 1;
+			
+			if (i != 0) {
+				indices.push_back(a); indices.push_back(c); indices.push_back(b);
+			}
+			
+			if (i != rings - 1) {
+				indices.push_back(b); indices.push_back(c); indices.push_back(d);
+			}
+		}
+	}
+	
+	optimizeVertexCache(indices, mesh.vertices.size());
+	mesh.assignIndices(indices);
+}
+
+/// Points scattered through a box, with normals in every direction, which are not meant to be drawn.
+static void generateScattered (IndexedMesh & mesh, std::size_t count) {
+	std::mt19937 generator(7);
+	std::uniform_real_distribution<float> position(-20, 20), texcoord(-1, 2);
+	std::normal_distribution<float> normal;
+	
+	std::vector<std::uint32_t> indices;
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		ObjMeshVertex vertex;
+		vertex.pos = Vec3(position(generator), position(generator) * 0.1f, position(generator));
+		vertex.normal = Vec3(normal(generator), normal(generator), normal(generator));
+		vertex.texcoord = Vec2(texcoord(generator), texcoord(generator));
+		
+		mesh.vertices.push_back(vertex);
+		indices.push_back((std::uint32_t)i);
+	}
+	
+	indices.resize(count - count % 3);
+	mesh.assignIndices(indices);
+}
+
+static void multiply (const float * matrix, const float * vector, float * result) {
+	for (std::size_t i = 0; i < 4; i += 1)
+		result[i] = matrix[i] * vector[0] + matrix[4 + i] * vector[1] + matrix[8 + i] * vector[2] + matrix[12 + i] * vector[3];
+}
+
+/// The largest angle between a normal and its quantized version: each component is within 1/255 of the unit normal, so the decoded normal is within sqrt(3)/255 of it.
+static double normalErrorBound () {
+	double distance = std::sqrt(3.0) / 255.0;
+	
+	return std::asin(distance / (1.0 - distance)) * 180.0 / M_PI;
+}
+
+static bool testAccuracy (const char * name, const IndexedMesh & mesh) {
+	QuantizedMesh quantized;
+	QuantizationError error, unlimited = {FLT_MAX, FLT_MAX, FLT_MAX};
+	
+	ClockT::time_point start = ClockT::now();
+	bool acceptable = quantizeMesh(mesh, quantized, unlimited, error);
+	double quantizeTime = elapsed(start);
+	
+	const VertexDecode & decode = quantized.decode;
+	
+	// Half a step on each axis, plus the rounding of the source and decoded positions:
+	float largest = 0, texcoordLargest = 0;
+	
+	for (std::size_t i = 0; i < mesh.vertices.size(); i += 1) {
+		for (std::size_t k = 0; k < 3; k += 1)
+			largest = std::max(largest, std::fabs(mesh.vertices[i].pos[k]));
+		
+		for (std::size_t k = 0; k < 2; k += 1)
+			texcoordLargest = std::max(texcoordLargest, std::fabs(mesh.vertices[i].texcoord[k]));
+	}
+	
+	double positionBound = std::sqrt(3.0) * (decode.positionScale / 2 + 2 * largest * FLT_EPSILON);
+	double texcoordBound = std::max(decode.texcoordScale[X], decode.texcoordScale[Y]) / 2 + 2 * texcoordLargest * FLT_EPSILON;
+	
+	std::printf("%s, %lu vertices: quantized in %0.1fms, position error %g (bound %g), normal error %0.3f degrees (bound %0.3f), texture coordinate error %g (bound %g)\n", name, (unsigned long)mesh.vertices.size(), quantizeTime * 1000.0, error.position, positionBound, error.normal, normalErrorBound(), error.texcoord, texcoordBound);
+	
+	bool success = acceptable;
+	
+	if (error.position > positionBound || error.normal > normalErrorBound() || error.texcoord > texcoordBound) {
+		std::printf("FAILED: error exceeds the bound\n");
+		success = false;
+	}
+	
+	// The matrices applied by OpenGL must decode the same values as VertexDecode:
+	float positionMatrix[16], texcoordMatrix[16];
+	decode.positionMatrix(positionMatrix);
+	decode.texcoordMatrix(texcoordMatrix);
+	
+	std::size_t mismatches = 0;
+	
+	for (std::size_t i = 0; i < quantized.vertices.size(); i += 1) {
+		const QuantizedVertex & vertex = quantized.vertices[i];
+		
+		float position[4] = {(float)vertex.pos[X], (float)vertex.pos[Y], (float)vertex.pos[Z], 1}, texcoord[4] = {(float)vertex.texcoord[X], (float)vertex.texcoord[Y], 0, 1};
+		float decodedPosition[4], decodedTexcoord[4];
+		
+		multiply(positionMatrix, position, decodedPosition);
+		multiply(texcoordMatrix, texcoord, decodedTexcoord);
+		
+		Vec3 expectedPosition = decode.position(vertex);
+		Vec2 expectedTexcoord = decode.texcoord(vertex);
+		
+		for (std::size_t k = 0; k < 3; k += 1) {
+			if (std::fabs(decodedPosition[k] - expectedPosition[k]) > 2 * largest * FLT_EPSILON)
+				mismatches += 1;
+		}
+		
+		for (std::size_t k = 0; k < 2; k += 1) {
+			if (std::fabs(decodedTexcoord[k] - expectedTexcoord[k]) > 2 * texcoordLargest * FLT_EPSILON)
+				mismatches += 1;
+		}
+	}
+	
+	if (mismatches) {
+		std::printf("FAILED: %lu components decoded differently by the matrices\n", (unsigned long)mismatches);
+		success = false;
+	}
+	
+	// A tolerance smaller than the measured error must be rejected:
+	QuantizationError tolerance = error, unused;
+	tolerance.position = error.position * 0.5f;
+	
+	if (error.position > 0 && quantizeMesh(mesh, quantized, tolerance, unused)) {
+		std::printf("FAILED: quantized with an error larger than the tolerance\n");
+		success = false;
+	}
+	
+	return success;
+}
+
+static bool testBaking (const std::string & directory, const std::vector<IndexedMesh> & meshes) {
+	std::vector<QuantizedMesh> quantized(meshes.size());
+	QuantizationError unlimited = {FLT_MAX, FLT_MAX, FLT_MAX}, error;
+	
+	// Leave the last mesh unquantized, so that both formats are stored in the same file:
+	for (std::size_t i = 0; i + 1 < meshes.size(); i += 1)
+		quantizeMesh(meshes[i], quantized[i], unlimited, error);
+	
+	std::vector<MaterialDescription> materials;
+	std::string floatPath = directory + "/mesh-quantize-float.armesh", quantizedPath = directory + "/mesh-quantize-quantized.armesh";
+	
+	bool success = writeBakedMesh(floatPath, meshes, materials) && writeBakedMesh(quantizedPath, meshes, materials, quantized);
+	
+	BakedMesh floatMesh, quantizedMesh;
+	
+	if (!success || !floatMesh.open(floatPath) || !quantizedMesh.open(quantizedPath)) {
+		std::printf("FAILED: couldn't write and open the baked meshes\n");
+		std::remove(floatPath.c_str());
+		std::remove(quantizedPath.c_str());
+		
+		return false;
+	}
+	
+	std::size_t floatVertexBytes = 0, quantizedVertexBytes = 0;
+	
+	for (std::size_t i = 0; i < meshes.size(); i += 1) {
+		MeshBuffer expected = quantized[i].vertices.empty() ? meshes[i].buffer() : quantized[i].buffer(meshes[i]);
+		MeshBuffer baked = quantizedMesh.mesh(i);
+		
+		std::size_t vertexSize = expected.quantizedVertices ? sizeof(QuantizedVertex) : sizeof(ObjMeshVertex);
+		
+		floatVertexBytes += sizeof(ObjMeshVertex) * meshes[i].vertices.size();
+		quantizedVertexBytes += vertexSize * meshes[i].vertices.size();
+		
+		bool equal = (expected.quantizedVertices == NULL) == (baked.quantizedVertices == NULL)
+			&& expected.vertexCount == baked.vertexCount
+			&& expected.indexCount == baked.indexCount
+			&& std::memcmp(expected.vertexData(), baked.vertexData(), vertexSize * expected.vertexCount) == 0
+			&& (!expected.quantizedVertices || std::memcmp(expected.decode, baked.decode, sizeof(VertexDecode)) == 0);
+		
+		for (std::size_t j = 0; equal && j < baked.vertexCount; j += 1) {
+			Vec3 a = expected.position(j), b = baked.position(j);
+			equal = a[X] == b[X] && a[Y] == b[Y] && a[Z] == b[Z];
+		}
+		
+		if (!equal) {
+			std::printf("FAILED: baked mesh %lu differs\n", (unsigned long)i);
+			success = false;
+		}
+	}
+	
+	std::printf("Baked %lu meshes: %lu bytes with ObjMeshVertex, %lu bytes with QuantizedVertex (%0.0f%%); vertex arrays %lu and %lu bytes (%0.0f%%)\n", (unsigned long)meshes.size(), (unsigned long)floatMesh.fileSize(), (unsigned long)quantizedMesh.fileSize(), 100.0 * quantizedMesh.fileSize() / floatMesh.fileSize(), (unsigned long)floatVertexBytes, (unsigned long)quantizedVertexBytes, 100.0 * quantizedVertexBytes / floatVertexBytes);
+	
+	floatMesh.close();
+	quantizedMesh.close();
+	
+	std::remove(floatPath.c_str());
+	std::remove(quantizedPath.c_str());
+	
+	return success;
+}
+
+/// Reads every position of the mesh, as the vertex fetch of a draw call would.
+static float readPositions (const MeshBuffer & mesh) {
+	float sum = 0;
+	
+	if (mesh.quantizedVertices) {
+		std::int64_t total = 0;
+		
+		for (std::size_t i = 0; i < mesh.vertexCount; i += 1)
+			total += mesh.quantizedVertices[i].pos[X] + mesh.quantizedVertices[i].pos[Y] + mesh.quantizedVertices[i].pos[Z] + mesh.quantizedVertices[i].normal[X];
+		
+		sum = total * mesh.decode->positionScale;
+	} else {
+		for (std::size_t i = 0; i < mesh.vertexCount; i += 1)
+			sum += mesh.vertices[i].pos[X] + mesh.vertices[i].pos[Y] + mesh.vertices[i].pos[Z] + mesh.vertices[i].normal[X];
+	}
+	
+	return sum;
+}
+
+static void benchmarkReading (const IndexedMesh & mesh) {
+	const std::size_t ITERATIONS = 20;
+	
+	QuantizedMesh quantized;
+	QuantizationError unlimited = {FLT_MAX, FLT_MAX, FLT_MAX}, error;
+	quantizeMesh(mesh, quantized, unlimited, error);
+	
+	MeshBuffer buffers[2] = {mesh.buffer(), quantized.buffer(mesh)};
+	double times[2];
+	volatile float sink = 0;
+	
+	for (std::size_t i = 0; i < 2; i += 1) {
+		ClockT::time_point start = ClockT::now();
+		
+		for (std::size_t j = 0; j < ITERATIONS; j += 1)
+			sink = sink + readPositions(buffers[i]);
+		
+		times[i] = elapsed(start) / ITERATIONS;
+	}
+	
+	std::printf("Reading %lu vertices: %0.2fms with ObjMeshVertex (%lu bytes), %0.2fms with QuantizedVertex (%lu bytes)\n", (unsigned long)mesh.vertices.size(), times[0] * 1000.0, (unsigned long)(mesh.vertices.size() * sizeof(ObjMeshVertex)), times[1] * 1000.0, (unsigned long)(mesh.vertices.size() * sizeof(QuantizedVertex)));
+}
+
+int main (int argc, char ** argv) {
+	std::string directory = argc > 1 ? argv[1] : ".";
+	
+	std::vector<IndexedMesh> meshes(4);
+	generateEllipsoid(meshes[0], 128, 256, Vec3(1, 1, 1), Vec3(0, 0, 0), 1);
+	generateEllipsoid(meshes[1], 64, 128, Vec3(5, 5, 5), Vec3(250, -40, 1200), 8);
+	generateEllipsoid(meshes[2], 64, 128, Vec3(10, 10, 0.1), Vec3(0, 2, 0), 1);
+	generateScattered(meshes[3], 30000);
+	
+	const char * names[4] = {"Unit sphere", "Distant sphere", "Flat ellipsoid", "Scattered normals"};
+	
+	bool success = true;
+	
+	for (std::size_t i = 0; i < meshes.size(); i += 1)
+		success = testAccuracy(names[i], meshes[i]) && success;
+	
+	// A small mesh which is stored unquantized:
+	meshes.push_back(IndexedMesh());
+	generateEllipsoid(meshes.back(), 8, 16, Vec3(1, 1, 1), Vec3(0, 0, 0), 1);
+	
+	success = testBaking(directory, meshes) && success;
+	
+	IndexedMesh large;
+	generateEllipsoid(large, 1024, 1024, Vec3(1, 1, 1), Vec3(0, 0, 0), 1);
+	benchmarkReading(large);
+	
+	return success ? 0 : 1;
+}
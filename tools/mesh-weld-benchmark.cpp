@@ -0,0 +1,287 @@
+//
+//  mesh-weld-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Welds generated meshes, and optionally a given model, with ARBrowser::weldMesh, with and without optimizeVertexCache, and checks that the result draws exactly the same triangles as the input: both are expanded to lists of triangles and compared as multisets, so that reordering is allowed but a lost, duplicated or rewound triangle is not. The meshes include signed zeros, which must be welded together, and degenerate triangles, which must be kept. Also checks that each distinct vertex is stored once, in the order it is first used, and reports the vertex cache miss ratio before and after optimization.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/mesh-weld-benchmark.cpp source/ARBrowser/ARMesh.cpp source/ARBrowser/ARObjLoader.cpp source/ARBrowser/ARMappedFile.cpp -o mesh-weld-benchmark
+//
+// Usage:
+//	mesh-weld-benchmark [model.obj]
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARObjLoader.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <random>
+#include <set>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// The 8 components of a vertex, with -0 replaced by +0, as weldMesh compares vertices by value.
+typedef std::array<float, 8> VertexKey;
+
+/// The vertices of a triangle, rotated so that the smallest comes first, which keeps the winding.
+typedef std::array<VertexKey, 3> TriangleKey;
+
+static VertexKey vertexKey (const ObjMeshVertex & vertex) {
+	VertexKey key = {{
+		vertex.pos[X], vertex.pos[Y], vertex.pos[Z],
+		vertex.texcoord[X], vertex.texcoord[Y],
+		vertex.normal[X], vertex.normal[Y], vertex.normal[Z]
+	}};
+	
+	// Adding +0 turns -0 into +0 and leaves everything else unchanged:
+	for (std::size_t i = 0; i < key.size(); i += 1)
+		key[i] += 0.0f;
+	
+	return key;
+}
+
+static TriangleKey triangleKey (const VertexKey & a, const VertexKey & b, const VertexKey & c) {
+	if (b < a && b < c) return TriangleKey{{b, c, a}};
+	if (c < a && c < b) return TriangleKey{{c, a, b}};
+	
+	return TriangleKey{{a, b, c}};
+}
+
+static std::vector<TriangleKey> expand (const ObjMesh & mesh) {
+	std::vector<TriangleKey> triangles;
+	
+	for (std::size_t i = 0; i < mesh.faces.size(); i += 1) {
+		const ObjMeshVertex * vertices = mesh.faces[i].vertices;
+		triangles.push_back(triangleKey(vertexKey(vertices[0]), vertexKey(vertices[1]), vertexKey(vertices[2])));
+	}
+	
+	std::sort(triangles.begin(), triangles.end());
+	
+	return triangles;
+}
+
+static std::vector<TriangleKey> expand (const IndexedMesh & mesh) {
+	std::vector<TriangleKey> triangles;
+	
+	for (std::size_t i = 0; i + 2 < mesh.indexCount(); i += 3) {
+		const ObjMeshVertex & a = mesh.vertices[mesh.index(i)], & b = mesh.vertices[mesh.index(i + 1)], & c = mesh.vertices[mesh.index(i + 2)];
+		triangles.push_back(triangleKey(vertexKey(a), vertexKey(b), vertexKey(c)));
+	}
+	
+	std::sort(triangles.begin(), triangles.end());
+	
+	return triangles;
+}
+
+/// The average number of vertices transformed per triangle with a FIFO post-transform cache of the given size.
+static double averageCacheMissRatio (const std::vector<std::uint32_t> & indices, std::size_t cacheSize) {
+	std::deque<std::uint32_t> cache;
+	std::size_t misses = 0;
+	
+	for (std::size_t i = 0; i < indices.size(); i += 1) {
+		if (std::find(cache.begin(), cache.end(), indices[i]) == cache.end()) {
+			misses += 1;
+			cache.push_back(indices[i]);
+			
+			if (cache.size() > cacheSize)
+				cache.pop_front();
+		}
+	}
+	
+	return indices.empty() ? 0 : double(misses) / (indices.size() / 3);
+}
+
+static std::vector<std::uint32_t> indices (const IndexedMesh & mesh) {
+	std::vector<std::uint32_t> result(mesh.indexCount());
+	
+	for (std::size_t i = 0; i < result.size(); i += 1)
+		result[i] = mesh.index(i);
+	
+	return result;
+}
+
+static bool testWeld (const char * name, const ObjMesh & mesh) {
+	std::vector<TriangleKey> expected = expand(mesh);
+	
+	std::set<VertexKey> distinct;
+	
+	for (std::size_t i = 0; i < mesh.faces.size(); i += 1)
+		for (std::size_t j = 0; j < 3; j += 1)
+			distinct.insert(vertexKey(mesh.faces[i].vertices[j]));
+	
+	bool success = true;
+	double ratios[2] = {0, 0}, times[2] = {0, 0};
+	
+	for (std::size_t optimize = 0; optimize < 2; optimize += 1) {
+		IndexedMesh welded;
+		
+		ClockT::time_point start = ClockT::now();
+		weldMesh(mesh, welded, optimize != 0);
+		times[optimize] = elapsed(start);
+		
+		const char * variant = optimize ? "optimized" : "unoptimized";
+		
+		if (welded.material != mesh.material || welded.indexCount() != mesh.faces.size() * 3 || welded.usesShortIndices() != (welded.vertices.size() <= 0x10000)) {
+			std::printf("FAILED: %s %s mesh has the wrong material, number of indices or index type\n", name, variant);
+			success = false;
+			
+			continue;
+		}
+		
+		std::vector<std::uint32_t> order = indices(welded);
+		
+		if (!order.empty() && *std::max_element(order.begin(), order.end()) >= welded.vertices.size()) {
+			std::printf("FAILED: %s %s mesh has an index out of range\n", name, variant);
+			success = false;
+			
+			continue;
+		}
+		
+		if (expand(welded) != expected) {
+			std::printf("FAILED: %s %s mesh doesn't draw the same triangles\n", name, variant);
+			success = false;
+		}
+		
+		if (welded.vertices.size() != distinct.size()) {
+			std::printf("FAILED: %s %s mesh has %lu vertices, expected %lu distinct vertices\n", name, variant, (unsigned long)welded.vertices.size(), (unsigned long)distinct.size());
+			success = false;
+		}
+		
+		// Both orders store vertices as they are first used:
+		std::uint32_t next = 0;
+		
+		for (std::size_t i = 0; i < order.size(); i += 1) {
+			if (order[i] == next) {
+				next += 1;
+			} else if (order[i] > next) {
+				std::printf("FAILED: %s %s mesh vertices aren't in the order they are first used\n", name, variant);
+				success = false;
+				
+				break;
+			}
+		}
+		
+		ratios[optimize] = averageCacheMissRatio(order, 16);
+	}
+	
+	std::printf("%s, %lu triangles, %lu vertices: welded in %0.1fms, optimized in %0.1fms, cache miss ratio %0.3f before and %0.3f after optimization\n", name, (unsigned long)mesh.faces.size(), (unsigned long)distinct.size(), times[0] * 1000.0, times[1] * 1000.0, ratios[0], ratios[1]);
+	
+	return success;
+}
+
+static ObjMeshVertex makeVertex (float x, float y, float z, float u, float v) {
+	ObjMeshVertex vertex;
+	vertex.pos = Vec3(x, y, z);
+	vertex.texcoord = Vec2(u, v);
+	vertex.normal = Vec3(0, 1, 0);
+	
+	return vertex;
+}
+
+/// A grid of squares, each made of two triangles, in a random order, as exported by many modelling tools.
+static ObjMesh generateGrid (std::size_t size, std::mt19937 & generator) {
+	ObjMesh mesh;
+	mesh.material = "grid";
+	
+	for (std::size_t y = 0; y < size; y += 1) {
+		for (std::size_t x = 0; x < size; x += 1) {
+			ObjMeshVertex a = makeVertex(x, 0, y, float(x) / size, float(y) / size), b = makeVertex(x + 1, 0, y, float(x + 1) / size, float(y) / size);
+			ObjMeshVertex c = makeVertex(x, 0, y + 1, float(x) / size, float(y + 1) / size), d = makeVertex(x + 1, 0, y + 1, float(x + 1) / size, float(y + 1) / size);
+			
+			ObjMeshFace first = {{a, c, b}}, second = {{b, c, d}};
+			mesh.faces.push_back(first);
+			mesh.faces.push_back(second);
+		}
+	}
+	
+	std::shuffle(mesh.faces.begin(), mesh.faces.end(), generator);
+	
+	return mesh;
+}
+
+/// The grid, with every zero component of some triangles negated, which must still be welded with the positive zeros of their neighbours.
+static ObjMesh generateSignedZeros (std::size_t size, std::mt19937 & generator) {
+	ObjMesh mesh = generateGrid(size, generator);
+	std::bernoulli_distribution negate(0.5);
+	
+	for (std::size_t i = 0; i < mesh.faces.size(); i += 1) {
+		if (!negate(generator))
+			continue;
+		
+		for (std::size_t j = 0; j < 3; j += 1) {
+			ObjMeshVertex & vertex = mesh.faces[i].vertices[j];
+			
+			for (std::size_t k = 0; k < 3; k += 1) {
+				if (vertex.pos[k] == 0) vertex.pos[k] = -0.0f;
+				if (vertex.normal[k] == 0) vertex.normal[k] = -0.0f;
+			}
+			
+			for (std::size_t k = 0; k < 2; k += 1) {
+				if (vertex.texcoord[k] == 0) vertex.texcoord[k] = -0.0f;
+			}
+		}
+	}
+	
+	return mesh;
+}
+
+/// A small mesh with triangles that repeat a vertex, collapse to a point or a line, and appear more than once, or with the opposite winding.
+static ObjMesh generateDegenerate () {
+	ObjMesh mesh;
+	mesh.material = "degenerate";
+	
+	ObjMeshVertex a = makeVertex(0, 0, 0, 0, 0), b = makeVertex(1, 0, 0, 1, 0), c = makeVertex(0, 1, 0, 0, 1), d = makeVertex(2, 0, 0, 1, 1);
+	
+	ObjMeshFace faces[] = {
+		{{a, b, c}},
+		{{a, b, c}},
+		{{a, c, b}},
+		{{a, a, b}},
+		{{b, a, a}},
+		{{c, c, c}},
+		{{a, b, d}},
+		{{d, b, a}},
+		{{c, a, b}},
+	};
+	
+	mesh.faces.assign(faces, faces + sizeof(faces) / sizeof(faces[0]));
+	
+	return mesh;
+}
+
+int main (int argc, char ** argv) {
+	std::mt19937 generator(42);
+	bool success = true;
+	
+	success = testWeld("Grid", generateGrid(100, generator)) && success;
+	success = testWeld("Signed zeros", generateSignedZeros(40, generator)) && success;
+	success = testWeld("Degenerate triangles", generateDegenerate()) && success;
+	success = testWeld("Grid with 32-bit indices", generateGrid(300, generator)) && success;
+	success = testWeld("Empty", ObjMesh()) && success;
+	
+	if (argc > 1) {
+		std::vector<ObjMesh> meshes;
+		
+		if (!loadObjMesh(argv[1], meshes))
+			return 2;
+		
+		for (std::size_t i = 0; i < meshes.size(); i += 1)
+			success = testWeld(meshes[i].material.c_str(), meshes[i]) && success;
+	}
+	
+	return success ? 0 : 1;
+}
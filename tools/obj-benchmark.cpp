@@ -0,0 +1,332 @@
+//
+//  obj-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Parses a generated .obj file, and optionally a given one, with ARBrowser::loadObjMesh and with the stringstream loader which it replaced, checks that both produce the same meshes, and reports the time taken by each. Then checks faces which only the new parser handles: polygons, negative indices, missing attributes and invalid faces, which must not leave any triangles behind.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/obj-benchmark.cpp source/ARBrowser/ARObjLoader.cpp source/ARBrowser/ARMappedFile.cpp source/ARBrowser/ARMesh.cpp -o obj-benchmark
+//
+// Usage:
+//	obj-benchmark [directory] [model.obj]
+//
+// A temporary .obj file is written to the directory, which defaults to the current directory, and removed afterwards. The given model, e.g. source/ARBrowser/models/coffee/model.obj, must only contain triangles, as the old loader doesn't handle anything else. Exits with a non-zero status if any check fails.
+
+#include "ARObjLoader.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// The loader which ARObjLoader replaced, unchanged except that missing texture coordinates and normals are zeroed rather than left uninitialized, as the new parser does.
+static void loadMeshStringStream (std::string filename, std::vector<ObjMesh> & mesh) {
+	const char * TOKEN_VERTEX_POS = "v";
+	const char * TOKEN_VERTEX_NOR = "vn";
+	const char * TOKEN_VERTEX_TEX = "vt";
+	const char * TOKEN_FACE = "f";
+	const char * TOKEN_USE_MATERIAL = "usemtl";
+	
+	struct _ObjMeshFaceIndex {
+		_ObjMeshFaceIndex() {
+			pos_index[0] = pos_index[1] = pos_index[2] = 0;
+			tex_index[0] = tex_index[1] = tex_index[2] = -1;
+			nor_index[0] = nor_index[1] = nor_index[2] = -1;
+		}
+		
+		std::string material;
+		int pos_index[3];
+		int tex_index[3];
+		int nor_index[3];
+	};
+	
+	std::vector<Vec3> positions;
+	std::vector<Vec2> texcoords;
+	std::vector<Vec3> normals;
+	std::vector<_ObjMeshFaceIndex> faces;
+	std::string currentMaterial = "";
+	
+	unsigned materialCount = 1;
+	
+	std::ifstream filestream;
+	filestream.open(filename.c_str());
+	
+	if (!filestream) {
+		std::cerr << "Couldn't load file: " << filename << std::endl;
+	}
+	
+	std::string line_stream;
+	while(std::getline(filestream, line_stream)) {
+		std::stringstream str_stream(line_stream);
+		std::string type_str;
+		str_stream >> type_str;
+		if (type_str == TOKEN_VERTEX_POS) {
+			Vec3 pos;
+			str_stream >> pos[X] >> pos[Y] >> pos[Z];
+			positions.push_back(pos);
+		} else if (type_str == TOKEN_VERTEX_TEX) {
+			Vec2 tex;
+			str_stream >> tex[X] >> tex[Y];
+			// Inverse y coordinates
+			tex[Y] = 1.0 - tex[Y];
+			texcoords.push_back(tex);
+		} else if (type_str == TOKEN_VERTEX_NOR) {
+			Vec3 nor;
+			str_stream >> nor[X] >> nor[Y] >> nor[Z];
+			normals.push_back(nor);
+		} else if (type_str == TOKEN_FACE) {
+			_ObjMeshFaceIndex face_index;
+			face_index.material = currentMaterial;
+			
+			char interrupt;
+			for(int i = 0; i < 3; ++i) {
+				std::string vertex;
+				str_stream >> vertex;
+				
+				std::stringstream vertex_stream;
+				vertex_stream.str(vertex);
+				
+				vertex_stream >> face_index.pos_index[i] >> interrupt >> face_index.tex_index[i] >> interrupt >> face_index.nor_index[i];
+			}
+			faces.push_back(face_index);
+		} else if (type_str == TOKEN_USE_MATERIAL) {
+			str_stream >> currentMaterial;
+			materialCount++;
+		}
+	}
+	filestream.close();
+	
+	currentMaterial = "";
+	mesh.reserve(materialCount);
+	ObjMesh * currentMesh = NULL;
+	
+	for (size_t i = 0; i < faces.size(); ++i) {
+		ObjMeshFace face;
+		
+		if (currentMesh != NULL && currentMaterial != faces[i].material) {
+			currentMesh = NULL;
+		}
+		
+		if (currentMesh == NULL) {
+			mesh.resize(mesh.size() + 1);
+			currentMesh = &mesh.back();
+			currentMesh->material = faces[i].material;
+			
+			currentMaterial = faces[i].material;
+		}
+		
+		for(size_t j = 0; j < 3; ++j) {
+			face.vertices[j].pos = positions[faces[i].pos_index[j] - 1];
+			face.vertices[j].texcoord = Vec2(0, 0);
+			face.vertices[j].normal = Vec3(0, 0, 0);
+			
+			if (faces[i].tex_index[j] != -1)
+				face.vertices[j].texcoord = texcoords[faces[i].tex_index[j] - 1];
+			
+			if (faces[i].nor_index[j] != -1)
+				face.vertices[j].normal = normals[faces[i].nor_index[j] - 1];
+		}
+		
+		currentMesh->faces.push_back(face);
+	}
+}
+
+/// A grid of triangles with positions, texture coordinates and normals, switching between materials every few rows.
+static void generateObj (const std::string & path, std::size_t size, std::mt19937 & generator) {
+	std::uniform_real_distribution<float> height(-2.0f, 2.0f);
+	FILE * file = std::fopen(path.c_str(), "w");
+	
+	std::fprintf(file, "# Generated by obj-benchmark\n");
+	
+	for (std::size_t y = 0; y <= size; y += 1) {
+		for (std::size_t x = 0; x <= size; x += 1) {
+			std::fprintf(file, "v %f %f %f\n", x * 0.25, height(generator), y * -0.25);
+			std::fprintf(file, "vt %f %f\n", double(x) / size, double(y) / size);
+			std::fprintf(file, "vn %f %f %f\n", height(generator) / 4, 1.0, height(generator) / 4);
+		}
+	}
+	
+	for (std::size_t y = 0; y < size; y += 1) {
+		if (y % 16 == 0)
+			std::fprintf(file, "usemtl material%lu\n", (unsigned long)(y / 16 % 3));
+		
+		for (std::size_t x = 0; x < size; x += 1) {
+			unsigned long a = (unsigned long)(y * (size + 1) + x + 1), b = a + 1, c = a + (unsigned long)size + 1, d = c + 1;
+			
+			std::fprintf(file, "f %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu\n", a, a, a, c, c, c, b, b, b);
+			std::fprintf(file, "f %lu/%lu/%lu %lu/%lu/%lu %lu/%lu/%lu\n", b, b, b, c, c, c, d, d, d);
+		}
+	}
+	
+	std::fclose(file);
+}
+
+static bool equalVertices (const ObjMeshVertex & a, const ObjMeshVertex & b) {
+	return a.pos[X] == b.pos[X] && a.pos[Y] == b.pos[Y] && a.pos[Z] == b.pos[Z]
+		&& a.texcoord[X] == b.texcoord[X] && a.texcoord[Y] == b.texcoord[Y]
+		&& a.normal[X] == b.normal[X] && a.normal[Y] == b.normal[Y] && a.normal[Z] == b.normal[Z];
+}
+
+/// Both loaders must produce the same materials and triangles in the same order. The stringstream loader rounds floats correctly, so this also checks the float parser.
+static bool compareLoaders (const char * name, const std::string & path) {
+	const std::size_t ITERATIONS = 3;
+	
+	std::vector<ObjMesh> expected, meshes;
+	double oldTime = INFINITY, newTime = INFINITY;
+	
+	for (std::size_t i = 0; i < ITERATIONS; i += 1) {
+		expected.clear();
+		ClockT::time_point start = ClockT::now();
+		loadMeshStringStream(path, expected);
+		oldTime = std::min(oldTime, elapsed(start));
+		
+		meshes.clear();
+		start = ClockT::now();
+		loadObjMesh(path, meshes);
+		newTime = std::min(newTime, elapsed(start));
+	}
+	
+	std::size_t faces = 0, mismatches = 0;
+	
+	for (std::size_t i = 0; i < expected.size(); i += 1)
+		faces += expected[i].faces.size();
+	
+	std::printf("%s, %lu faces: %0.1fms with the stringstream loader, %0.1fms with loadObjMesh (%0.1fx)\n", name, (unsigned long)faces, oldTime * 1000.0, newTime * 1000.0, oldTime / newTime);
+	
+	if (expected.size() != meshes.size()) {
+		std::printf("FAILED: %lu meshes, expected %lu\n", (unsigned long)meshes.size(), (unsigned long)expected.size());
+		
+		return false;
+	}
+	
+	for (std::size_t i = 0; i < expected.size(); i += 1) {
+		if (expected[i].material != meshes[i].material || expected[i].faces.size() != meshes[i].faces.size()) {
+			std::printf("FAILED: mesh %lu has a different material or number of faces\n", (unsigned long)i);
+			
+			return false;
+		}
+		
+		for (std::size_t j = 0; j < expected[i].faces.size(); j += 1) {
+			for (std::size_t k = 0; k < 3; k += 1) {
+				if (!equalVertices(expected[i].faces[j].vertices[k], meshes[i].faces[j].vertices[k]))
+					mismatches += 1;
+			}
+		}
+	}
+	
+	if (mismatches) {
+		std::printf("FAILED: %lu vertices differ\n", (unsigned long)mismatches);
+		
+		return false;
+	}
+	
+	return true;
+}
+
+static std::size_t countFaces (const std::vector<ObjMesh> & meshes) {
+	std::size_t count = 0;
+	
+	for (std::size_t i = 0; i < meshes.size(); i += 1)
+		count += meshes[i].faces.size();
+	
+	return count;
+}
+
+static bool testFaces () {
+	const char * source =
+		"v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\nv 0.5 1.5e0 -2.5E-1\n"
+		"vt 0 0\nvt 1 1\n"
+		"vn 0 0 1\n"
+		// A pentagon, which is triangulated as a fan:
+		"usemtl polygon\n"
+		"f 1 2 3 4 5\n"
+		// Relative indices and missing texture coordinates:
+		"usemtl relative\n"
+		"f -5//-1 -4//-1 -3//-1 # comment\n"
+		// A quad whose last vertex doesn't exist must add nothing, not the first triangle:
+		"usemtl invalid\n"
+		"f 1/1 2/2 3/2 9/1\n"
+		"f 1 2\n"
+		"f 1 2 0\n"
+		"usemtl relative\n"
+		"f 1/2 2/1 3/2\r\n";
+	
+	std::vector<ObjMesh> meshes;
+	parseObjMesh(source, source + std::strlen(source), meshes);
+	
+	bool success = true;
+	
+	// No mesh is made for the invalid faces, so the faces of the second run of "relative" join the first:
+	if (meshes.size() != 2 || meshes[0].material != "polygon" || meshes[1].material != "relative") {
+		std::printf("FAILED: expected 2 meshes, one for each material with valid faces, got %lu\n", (unsigned long)meshes.size());
+		
+		return false;
+	}
+	
+	if (meshes[0].faces.size() != 3 || meshes[1].faces.size() != 2 || countFaces(meshes) != 5) {
+		std::printf("FAILED: expected 3 and 2 faces, got %lu and %lu\n", (unsigned long)meshes[0].faces.size(), (unsigned long)meshes[1].faces.size());
+		
+		return false;
+	}
+	
+	// The fan shares the first vertex, and the last triangle ends at the fifth vertex:
+	const ObjMeshFace & last = meshes[0].faces[2];
+	
+	if (last.vertices[0].pos[X] != 0 || last.vertices[1].pos[Y] != 1 || last.vertices[2].pos[Y] != 1.5f || last.vertices[2].pos[Z] != -0.25f) {
+		std::printf("FAILED: polygon wasn't triangulated as a fan\n");
+		success = false;
+	}
+	
+	const ObjMeshFace & relative = meshes[1].faces[0];
+	
+	if (relative.vertices[0].pos[X] != 0 || relative.vertices[2].pos[Y] != 1 || relative.vertices[0].normal[Z] != 1 || relative.vertices[0].texcoord[X] != 0 || relative.vertices[0].texcoord[Y] != 0) {
+		std::printf("FAILED: relative indices or missing texture coordinates\n");
+		success = false;
+	}
+	
+	// Texture coordinates are flipped vertically:
+	const ObjMeshFace & flipped = meshes[1].faces[1];
+	
+	if (flipped.vertices[0].texcoord[X] != 1 || flipped.vertices[0].texcoord[Y] != 0 || flipped.vertices[1].texcoord[Y] != 1 || flipped.vertices[0].normal[Z] != 0) {
+		std::printf("FAILED: texture coordinates of the last face\n");
+		success = false;
+	}
+	
+	std::printf("Faces: polygons, relative indices and invalid faces %s\n", success ? "passed" : "failed");
+	
+	return success;
+}
+
+int main (int argc, char ** argv) {
+	std::string directory = argc > 1 ? argv[1] : ".";
+	std::string path = directory + "/obj-benchmark.obj";
+	std::mt19937 generator(42);
+	
+	generateObj(path, 400, generator);
+	
+	bool success = compareLoaders("Generated grid", path);
+	std::remove(path.c_str());
+	
+	if (argc > 2)
+		success = compareLoaders(argv[2], argv[2]) && success;
+	
+	success = testFaces() && success;
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,249 @@
+//
+//  picking-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Scatters instances of a model around the viewer and picks them with rays in random directions, using ARBrowser::InstanceHierarchy and ARBrowser::TriangleHierarchy, and compares the results and latency with a linear scan which tests the bounding box of every instance and every triangle of the instances it hits.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/picking-benchmark.cpp source/ARBrowser/ARPicking.cpp source/ARBrowser/ARMesh.cpp -o picking-benchmark
+//
+// Usage:
+//	picking-benchmark [instances]
+//
+// Exits with a non-zero status if any pick differs from brute force.
+
+#include "ARPicking.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static void generateSphere (IndexedMesh & mesh, std::size_t rings, std::size_t segments) {
+	for (std::size_t i = 0; i <= rings; i += 1) {
+		for (std::size_t j = 0; j <= segments; j += 1) {
+			double theta = M_PI * i / rings, phi = 2.0 * M_PI * j / segments;
+			
+			ObjMeshVertex vertex;
+			vertex.pos = Vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+			vertex.normal = vertex.pos;
+			
+			mesh.vertices.push_back(vertex);
+		}
+	}
+	
+	std::vector<std::uint32_t> indices;
+	
+	for (std::size_t i = 0; i < rings; i += 1) {
+		for (std::size_t j = 0; j < segments; j += 1) {
+			std::uint32_t a = (std::uint32_t)(i * (segments + 1) + j), b = a + 1, c = a + (std::uint32_t)segments + 1, d = c + 1;
+			
+			indices.push_back(a); indices.push_back(c); indices.push_back(b);
+			indices.push_back(b); indices.push_back(c); indices.push_back(d);
+		}
+	}
+	
+	mesh.assignIndices(indices);
+}
+
+/// A plain Möller-Trumbore test in double precision, independent of the one in ARPicking.
+static bool intersectTriangle (const float * a, const float * b, const float * c, const double * origin, const double * direction, double & t) {
+	double e1[3], e2[3], s[3];
+	
+	for (std::size_t i = 0; i < 3; i += 1) {
+		e1[i] = b[i] - a[i];
+		e2[i] = c[i] - a[i];
+		s[i] = origin[i] - a[i];
+	}
+	
+	double p[3] = {direction[1] * e2[2] - direction[2] * e2[1], direction[2] * e2[0] - direction[0] * e2[2], direction[0] * e2[1] - direction[1] * e2[0]};
+	double determinant = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+	
+	if (determinant == 0)
+		return false;
+	
+	double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / determinant;
+	
+	if (u < 0 || u > 1)
+		return false;
+	
+	double q[3] = {s[1] * e1[2] - s[2] * e1[1], s[2] * e1[0] - s[0] * e1[2], s[0] * e1[1] - s[1] * e1[0]};
+	double v = (direction[0] * q[0] + direction[1] * q[1] + direction[2] * q[2]) / determinant;
+	
+	if (v < 0 || u + v > 1)
+		return false;
+	
+	t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / determinant;
+	
+	return t >= 0;
+}
+
+/// An instance is scaled by (scale, scale, height), rotated around Z, then translated, which is how the browser places models.
+struct Placement {
+	double scale, height, angle, position[3];
+};
+
+int main (int argc, char ** argv) {
+	const std::size_t INSTANCES = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 2000, RAYS = 1000;
+	const float AREA = 400, MAXIMUM_DISTANCE = 500;
+	
+	IndexedMesh mesh;
+	generateSphere(mesh, 32, 64);
+	
+	std::vector<MeshBuffer> buffers(1, mesh.buffer());
+	const MeshBuffer & buffer = buffers[0];
+	
+	TriangleHierarchy triangles;
+	
+	ClockT::time_point start = ClockT::now();
+	triangles.build(buffers);
+	double triangleBuildTime = elapsed(start);
+	
+	std::printf("Model: %lu triangles, hierarchy built in %0.2fms (%lu bytes)\n", (unsigned long)triangles.triangleCount(), triangleBuildTime * 1000.0, (unsigned long)triangles.residentSize());
+	
+	std::mt19937 generator(11);
+	std::uniform_real_distribution<double> unit(-1, 1), coordinate(-AREA / 2, AREA / 2), scale(0.5, 3), angle(0, 2 * M_PI);
+	
+	InstanceHierarchy hierarchy;
+	std::vector<InstanceHierarchy::Instance> & instances = hierarchy.instances();
+	std::vector<Placement> placements(INSTANCES);
+	
+	for (std::size_t i = 0; i < INSTANCES; i += 1) {
+		Placement & placement = placements[i];
+		placement.scale = scale(generator);
+		placement.height = placement.scale * 0.5;
+		placement.angle = angle(generator);
+		placement.position[0] = coordinate(generator);
+		placement.position[1] = coordinate(generator);
+		placement.position[2] = unit(generator) * 5;
+		
+		double c = std::cos(placement.angle), s = std::sin(placement.angle);
+		float transform[16] = {
+			(float)(c * placement.scale), (float)(s * placement.scale), 0, 0,
+			(float)(-s * placement.scale), (float)(c * placement.scale), 0, 0,
+			0, 0, (float)placement.height, 0,
+			(float)placement.position[0], (float)placement.position[1], (float)placement.position[2], 1
+		};
+		
+		InstanceHierarchy::Instance instance;
+		std::copy(transform, transform + 16, instance.transform);
+		
+		// The world bounding box of the unit sphere:
+		for (std::size_t axis = 0; axis < 3; axis += 1) {
+			float extent = std::fabs(transform[axis]) + std::fabs(transform[4 + axis]) + std::fabs(transform[8 + axis]);
+			instance.min[axis] = transform[12 + axis] - extent;
+			instance.max[axis] = transform[12 + axis] + extent;
+		}
+		
+		instance.triangles = &triangles;
+		instance.handle = &placement;
+		
+		instances.push_back(instance);
+	}
+	
+	start = ClockT::now();
+	hierarchy.build();
+	double buildTime = elapsed(start);
+	
+	start = ClockT::now();
+	hierarchy.refit();
+	double refitTime = elapsed(start);
+	
+	std::printf("Scene: %lu instances over %0.0fm x %0.0fm, built in %0.1fus, refit in %0.1fus\n", (unsigned long)INSTANCES, AREA, AREA, buildTime * 1e6, refitTime * 1e6);
+	
+	double pickTime = 0, bruteForceTime = 0;
+	std::size_t hits = 0, mismatches = 0;
+	
+	for (std::size_t i = 0; i < RAYS; i += 1) {
+		// Rays from eye height, roughly towards the horizon:
+		double direction[3] = {unit(generator), unit(generator), unit(generator) * 0.05};
+		double length = std::sqrt(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+		
+		for (std::size_t axis = 0; axis < 3; axis += 1)
+			direction[axis] /= length;
+		
+		const double origin[3] = {0, 0, 1.5};
+		
+		float rayOrigin[3] = {(float)origin[0], (float)origin[1], (float)origin[2]}, rayDirection[3] = {(float)direction[0], (float)direction[1], (float)direction[2]};
+		
+		start = ClockT::now();
+		InstanceHierarchy::Hit hit;
+		bool picked = hierarchy.pick(rayOrigin, rayDirection, MAXIMUM_DISTANCE, hit);
+		pickTime += elapsed(start);
+		
+		// Test the bounding box of every instance, and every triangle of the instances which are hit:
+		start = ClockT::now();
+		const Placement * nearest = NULL;
+		double nearestDistance = MAXIMUM_DISTANCE;
+		
+		for (std::size_t j = 0; j < INSTANCES; j += 1) {
+			const InstanceHierarchy::Instance & instance = instances[j];
+			double entry = 0, exit = nearestDistance;
+			
+			for (std::size_t axis = 0; axis < 3; axis += 1) {
+				double near = (instance.min[axis] - origin[axis]) / direction[axis], far = (instance.max[axis] - origin[axis]) / direction[axis];
+				
+				if (near > far)
+					std::swap(near, far);
+				
+				entry = std::max(entry, near);
+				exit = std::min(exit, far);
+			}
+			
+			if (entry > exit)
+				continue;
+			
+			const Placement & placement = placements[j];
+			double c = std::cos(placement.angle), s = std::sin(placement.angle);
+			double x = origin[0] - placement.position[0], y = origin[1] - placement.position[1], z = origin[2] - placement.position[2];
+			
+			double localOrigin[3] = {(c * x + s * y) / placement.scale, (-s * x + c * y) / placement.scale, z / placement.height};
+			double localDirection[3] = {(c * direction[0] + s * direction[1]) / placement.scale, (-s * direction[0] + c * direction[1]) / placement.scale, direction[2] / placement.height};
+			
+			const std::uint16_t * indices = (const std::uint16_t *)buffer.indices;
+			
+			for (std::size_t k = 0; k < buffer.indexCount; k += 3) {
+				double t;
+				
+				if (intersectTriangle(buffer.vertices[indices[k]].pos.data(), buffer.vertices[indices[k+1]].pos.data(), buffer.vertices[indices[k+2]].pos.data(), localOrigin, localDirection, t) && t < nearestDistance) {
+					nearestDistance = t;
+					nearest = &placement;
+				}
+			}
+		}
+		
+		bruteForceTime += elapsed(start);
+		
+		if (picked)
+			hits += 1;
+		
+		// Hits on different instances at the same distance (e.g. where they overlap) are equally correct:
+		if ((picked ? hit.handle : NULL) != nearest) {
+			if (!(picked && nearest && std::fabs(hit.distance - nearestDistance) < 1e-3)) {
+				mismatches += 1;
+				
+				if (mismatches <= 5)
+					std::printf("\tMismatch: picked %p at %0.4f, expected %p at %0.4f\n", picked ? hit.handle : NULL, picked ? hit.distance : -1.0, (const void *)nearest, nearestDistance);
+			}
+		}
+	}
+	
+	std::printf("Rays: %lu, %lu hits, %lu mismatches\n", (unsigned long)RAYS, (unsigned long)hits, (unsigned long)mismatches);
+	std::printf("Picking: %0.2fus per ray, brute force: %0.1fus per ray (%0.0fx faster)\n", pickTime * 1e6 / RAYS, bruteForceTime * 1e6 / RAYS, bruteForceTime / pickTime);
+	
+	return mismatches ? 1 : 0;
+}
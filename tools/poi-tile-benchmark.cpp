@@ -0,0 +1,342 @@
+//
+//  poi-tile-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Writes millions of points of interest scattered over a city to a .arpoi file, and drives through them querying ARBrowser::PointTiles as ARBrowserView does. Reports the query latency with and without prefetching the tiles ahead of the viewer, starting each time with the file out of the page cache, and the memory used by the mapped file compared with its size and with keeping every point in an ARBrowser::SpatialIndex. Checks the query results against testing every point.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/poi-tile-benchmark.cpp source/ARBrowser/ARPointTiles.cpp source/ARBrowser/ARMappedFile.cpp source/ARBrowser/ARSpatialIndex.cpp -o poi-tile-benchmark
+//
+// Usage:
+//	poi-tile-benchmark [points] [path]
+//
+// By default, 2,000,000 points are written to poi-tile-benchmark.arpoi in the current directory, which is removed afterwards. The file should be on a disk rather than e.g. tmpfs, otherwise it can't be removed from the page cache and the resident memory isn't checked. Exits with a non-zero status if any check fails.
+
+#include "ARPointTiles.h"
+#include "ARSpatialIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static const double D2R = M_PI / 180.0;
+
+/// A city about 40km across, in the southern hemisphere.
+static const double CENTER_LATITUDE = -43.5321, CENTER_LONGITUDE = 172.6362, CITY_RADIUS = 20000;
+
+/// Points are found within the radar distance, as ARBrowserView does with a maximum distance of 500m.
+static const double QUERY_DISTANCE = 1000;
+
+/// Driving at 15m/s, with a query every 100ms, and prefetching where the viewer will be in 30 seconds.
+static const double SPEED = 15, QUERY_INTERVAL = 0.1, PREFETCH_TIME = 30;
+static const std::size_t QUERIES = 1200;
+
+/// Move the given distance east and north, in meters.
+static void offset (double latitude, double longitude, double east, double north, double & resultLatitude, double & resultLongitude) {
+	resultLatitude = latitude + north / SpatialIndex::RADIUS / D2R;
+	resultLongitude = longitude + east / (SpatialIndex::RADIUS * std::cos(latitude * D2R)) / D2R;
+}
+
+static void generatePoints (std::size_t count, std::vector<PointDescription> & points) {
+	std::mt19937 random(29);
+	std::uniform_real_distribution<double> unit(0, 1);
+	std::normal_distribution<double> normal(0, 1);
+	
+	// Most points are clustered around neighbourhood centres, and the rest are spread evenly:
+	std::vector<std::pair<double, double>> centres(200);
+	
+	for (std::size_t i = 0; i < centres.size(); i += 1) {
+		double angle = unit(random) * 2 * M_PI, distance = std::sqrt(unit(random)) * CITY_RADIUS;
+		centres[i] = std::make_pair(std::sin(angle) * distance, std::cos(angle) * distance);
+	}
+	
+	points.resize(count);
+	
+	char buffer[64];
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		double east, north;
+		
+		if (i % 4 == 0) {
+			double angle = unit(random) * 2 * M_PI, distance = std::sqrt(unit(random)) * CITY_RADIUS;
+			
+			east = std::sin(angle) * distance;
+			north = std::cos(angle) * distance;
+		} else {
+			const std::pair<double, double> & centre = centres[random() % centres.size()];
+			
+			east = centre.first + normal(random) * 800;
+			north = centre.second + normal(random) * 800;
+		}
+		
+		PointDescription & point = points[i];
+		offset(CENTER_LATITUDE, CENTER_LONGITUDE, east, north, point.latitude, point.longitude);
+		point.altitude = unit(random) * 20;
+		
+		std::snprintf(buffer, sizeof(buffer), "Point %lu", (unsigned long)i);
+		point.title = buffer;
+		
+		std::snprintf(buffer, sizeof(buffer), "%lu Street %lu", (unsigned long)(random() % 200), (unsigned long)(random() % 5000));
+		point.subtitle = buffer;
+		
+		std::snprintf(buffer, sizeof(buffer), "category-%lu", (unsigned long)(random() % 16));
+		point.category = buffer;
+	}
+}
+
+/// Write any dirty pages and remove the file from the page cache, so that it is read from the disk again.
+static void dropFromCache (const std::string & path) {
+	int descriptor = open(path.c_str(), O_RDONLY);
+	
+	if (descriptor == -1)
+		return;
+	
+	fsync(descriptor);
+	posix_fadvise(descriptor, 0, 0, POSIX_FADV_DONTNEED);
+	close(descriptor);
+}
+
+/// The records within the distance, found by testing every record.
+static void bruteForce (const PointTiles & tiles, double latitude, double longitude, double distance, std::vector<std::uint32_t> & results) {
+	double lat = latitude * D2R, lon = longitude * D2R;
+	double x = std::cos(lat) * std::cos(lon), y = std::cos(lat) * std::sin(lon), z = std::sin(lat);
+	double threshold = std::cos(distance / SpatialIndex::RADIUS);
+	
+	for (std::uint32_t i = 0; i < tiles.size(); i += 1) {
+		const PointRecord & record = tiles.record(i);
+		double pointLatitude = record.latitude * (D2R / 1e7), pointLongitude = record.longitude * (D2R / 1e7);
+		double c = std::cos(pointLatitude);
+		
+		if (c * std::cos(pointLongitude) * x + c * std::sin(pointLongitude) * y + std::sin(pointLatitude) * z >= threshold)
+			results.push_back(i);
+	}
+}
+
+static double percentile (std::vector<double> values, double fraction) {
+	std::sort(values.begin(), values.end());
+	
+	return values[std::min(values.size() - 1, (std::size_t)(fraction * values.size()))];
+}
+
+/// The resident size of the process in bytes, on Linux.
+static std::size_t processResidentSize () {
+	std::FILE * file = std::fopen("/proc/self/statm", "r");
+	unsigned long size = 0, resident = 0;
+	
+	if (file) {
+		if (std::fscanf(file, "%lu %lu", &size, &resident) != 2)
+			resident = 0;
+		
+		std::fclose(file);
+	}
+	
+	return resident * sysconf(_SC_PAGESIZE);
+}
+
+struct DriveResult {
+	std::vector<double> times;
+	std::size_t results, wrong, resident;
+	PointTiles::Statistics statistics;
+};
+
+struct CheckedQuery {
+	double latitude, longitude;
+	std::vector<std::uint32_t> results;
+};
+
+/// Drive through the city from west to east, querying and optionally prefetching as ARWorldPointTiles does.
+static bool drive (const std::string & path, bool prefetching, DriveResult & result) {
+	dropFromCache(path);
+	
+	PointTiles tiles;
+	
+	if (!tiles.open(path))
+		return false;
+	
+	MotionEstimate motion;
+	std::vector<std::uint32_t> results, expected;
+	std::vector<CheckedQuery> checked;
+	
+	result.results = result.wrong = 0;
+	
+	for (std::size_t i = 0; i < QUERIES; i += 1) {
+		double time = i * QUERY_INTERVAL, latitude, longitude;
+		
+		// Along a road which bends gently to the north:
+		offset(CENTER_LATITUDE, CENTER_LONGITUDE, SPEED * time - QUERIES * QUERY_INTERVAL * SPEED / 2, std::sin(time / 60) * 3000, latitude, longitude);
+		
+		results.clear();
+		
+		ClockT::time_point start = ClockT::now();
+		
+		tiles.query(latitude, longitude, QUERY_DISTANCE, results);
+		
+		if (prefetching) {
+			motion.update(time, latitude, longitude);
+			tiles.prefetch(latitude, longitude, QUERY_DISTANCE, motion.east(), motion.north(), PREFETCH_TIME);
+		}
+		
+		result.times.push_back(elapsed(start));
+		result.results += results.size();
+		
+		// The first query reads the tiles around the viewer, which can't have been prefetched:
+		if (i == 0)
+			tiles.resetStatistics();
+		
+		if (i % 100 == 0) {
+			CheckedQuery query = {latitude, longitude, results};
+			checked.push_back(query);
+		}
+		
+		// Give the kernel time to read the prefetched tiles, as it would have while the viewer moves:
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	
+	result.resident = tiles.residentSize();
+	result.statistics = tiles.statistics();
+	
+	// Testing every point reads the whole file, so it is done after measuring what the queries read:
+	for (CheckedQuery & query : checked) {
+		expected.clear();
+		bruteForce(tiles, query.latitude, query.longitude, QUERY_DISTANCE, expected);
+		
+		std::sort(query.results.begin(), query.results.end());
+		
+		if (query.results != expected)
+			result.wrong += 1;
+	}
+	
+	return true;
+}
+
+int main (int argc, char ** argv) {
+	std::size_t count = argc > 1 ? std::strtoul(argv[1], NULL, 10) : 2000000;
+	std::string path = argc > 2 ? argv[2] : "poi-tile-benchmark.arpoi";
+	
+	std::vector<PointDescription> points;
+	generatePoints(count, points);
+	
+	ClockT::time_point start = ClockT::now();
+	
+	if (!writePointTiles(path, points)) {
+		std::printf("FAILED: couldn't write %s\n", path.c_str());
+		return 1;
+	}
+	
+	double writeTime = elapsed(start);
+	
+	bool success = true;
+	
+	{
+		dropFromCache(path);
+		
+		PointTiles tiles;
+		
+		if (!tiles.open(path)) {
+			std::printf("FAILED: couldn't open %s\n", path.c_str());
+			return 1;
+		}
+		
+		std::printf("Wrote %lu points in %lu tiles, %0.1fMB, in %0.1fs. %0.1fMB resident after opening.\n", (unsigned long)count, (unsigned long)tiles.tileCount(), tiles.fileSize() / 1e6, writeTime, tiles.residentSize() / 1e6);
+	}
+	
+	bool cached = false;
+	
+	// Cold, i.e. reading tiles as the queries need them, and then reading them ahead of the viewer:
+	for (std::size_t pass = 0; pass < 2; pass += 1) {
+		DriveResult result;
+		
+		if (!drive(path, pass == 1, result)) {
+			std::printf("FAILED: couldn't open %s\n", path.c_str());
+			return 1;
+		}
+		
+		const PointTiles::Statistics & statistics = result.statistics;
+		std::size_t fileSize = 0;
+		
+		{
+			PointTiles tiles;
+			tiles.open(path);
+			fileSize = tiles.fileSize();
+		}
+		
+		std::printf("%s: %0.1fus median, %0.1fus 99th percentile, %0.1fus maximum per query, %0.0f points per query, %0.1fMB resident (%0.1f%% of the file)\n", pass == 0 ? "Without prefetching" : "With prefetching", percentile(result.times, 0.5) * 1e6, percentile(result.times, 0.99) * 1e6, percentile(result.times, 1.0) * 1e6, (double)result.results / QUERIES, result.resident / 1e6, 100.0 * result.resident / fileSize);
+		
+		if (pass == 1)
+			std::printf("Prefetching: %lu tiles prefetched, %lu of %lu tiles entered were prefetched\n", (unsigned long)statistics.tilesPrefetched, (unsigned long)statistics.prefetchHits, (unsigned long)(statistics.prefetchHits + statistics.prefetchMisses));
+		
+		if (result.wrong) {
+			std::printf("FAILED: %lu queries differ from testing every point\n", (unsigned long)result.wrong);
+			success = false;
+		}
+		
+		// The drive covers a strip about 2km wide across a city 40km across, so most of the file should never be read. If the file couldn't be removed from the page cache, this can't be checked:
+		if (result.resident > fileSize / 2)
+			cached = true;
+		else if (result.resident > fileSize / 4) {
+			std::printf("FAILED: more of the file is resident than the drive should have read\n");
+			success = false;
+		}
+		
+		if (pass == 1 && statistics.prefetchHits < (statistics.prefetchHits + statistics.prefetchMisses) * 9 / 10) {
+			std::printf("FAILED: fewer than 90%% of the tiles entered were prefetched\n");
+			success = false;
+		}
+	}
+	
+	if (cached)
+		std::printf("The file couldn't be removed from the page cache, e.g. because it is on tmpfs, so the resident memory wasn't checked.\n");
+	
+	// Every point in memory, as ARWorldPointIndex keeps them, for comparison:
+	{
+		std::size_t before = processResidentSize();
+		
+		PointTiles tiles;
+		tiles.open(path);
+		
+		SpatialIndex index;
+		
+		for (std::uint32_t i = 0; i < tiles.size(); i += 1)
+			index.insert(&tiles.record(i), tiles.record(i).latitude / 1e7, tiles.record(i).longitude / 1e7);
+		
+		std::vector<SpatialIndex::HandleT> handles;
+		std::vector<double> times;
+		
+		for (std::size_t i = 0; i < QUERIES; i += 1) {
+			double time = i * QUERY_INTERVAL, latitude, longitude;
+			offset(CENTER_LATITUDE, CENTER_LONGITUDE, SPEED * time - QUERIES * QUERY_INTERVAL * SPEED / 2, std::sin(time / 60) * 3000, latitude, longitude);
+			
+			handles.clear();
+			
+			ClockT::time_point start = ClockT::now();
+			index.query(latitude, longitude, QUERY_DISTANCE, handles);
+			times.push_back(elapsed(start));
+		}
+		
+		// Not including the ARWorldPoint objects, which would be several times larger again:
+		std::printf("Spatial index of every point: %0.1fus median per query, %0.1fMB resident\n", percentile(times, 0.5) * 1e6, (processResidentSize() - before) / 1e6);
+	}
+	
+	std::remove(path.c_str());
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+//
+//  poi-tile-build.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Converts a CSV file of points of interest into a tiled .arpoi file, which ARWorldPointTiles memory maps so that only the tiles near the viewer are read. Each line has the fields latitude, longitude, altitude, title, subtitle and category, where latitude and longitude are in degrees and the category is passed to the application to choose a model. Fields may be quoted, with "" for a quote, but can't contain line breaks. A first line which doesn't start with a number is skipped as a header. The file is read back and every point is checked before the tool exits.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/poi-tile-build.cpp source/ARBrowser/ARPointTiles.cpp source/ARBrowser/ARMappedFile.cpp -o poi-tile-build
+//
+// Usage:
+//	poi-tile-build points.csv points.arpoi [zoom]
+//
+// The zoom level defaults to 15, i.e. tiles about 1.2km across at the equator. Exits with a non-zero status if any check fails.
+
+#include "ARPointTiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <tuple>
+
+using namespace ARBrowser;
+
+static std::vector<std::string> splitFields (const std::string & line) {
+	std::vector<std::string> fields(1);
+	bool quoted = false;
+	
+	for (std::size_t i = 0; i < line.size(); i += 1) {
+		char c = line[i];
+		
+		if (quoted) {
+			if (c == '"' && i + 1 < line.size() && line[i + 1] == '"') {
+				fields.back() += '"';
+				i += 1;
+			} else if (c == '"') {
+				quoted = false;
+			} else {
+				fields.back() += c;
+			}
+		} else if (c == '"') {
+			quoted = true;
+		} else if (c == ',') {
+			fields.push_back(std::string());
+		} else if (c != '\r') {
+			fields.back() += c;
+		}
+	}
+	
+	return fields;
+}
+
+static bool parseNumber (const std::string & field, double & value) {
+	char * end = NULL;
+	value = std::strtod(field.c_str(), &end);
+	
+	return !field.empty() && *end == '\0' && std::isfinite(value);
+}
+
+static bool readPoints (const std::string & path, std::vector<PointDescription> & points) {
+	std::ifstream input(path.c_str());
+	
+	if (!input) {
+		std::cerr << "Couldn't open " << path << "!" << std::endl;
+		return false;
+	}
+	
+	std::string line;
+	std::size_t number = 0;
+	
+	while (std::getline(input, line)) {
+		number += 1;
+		
+		if (line.empty() || line == "\r")
+			continue;
+		
+		std::vector<std::string> fields = splitFields(line);
+		double latitude, longitude, altitude;
+		
+		if (number == 1 && !parseNumber(fields[0], latitude))
+			continue;
+		
+		if (fields.size() != 6 || !parseNumber(fields[0], latitude) || !parseNumber(fields[1], longitude) || !parseNumber(fields[2], altitude) || std::fabs(latitude) > 90) {
+			std::cerr << path << ":" << number << ": expected latitude, longitude, altitude, title, subtitle, category!" << std::endl;
+			return false;
+		}
+		
+		PointDescription point = {latitude, longitude, (float)altitude, fields[3], fields[4], fields[5]};
+		points.push_back(point);
+	}
+	
+	return true;
+}
+
+typedef std::tuple<std::int32_t, std::int32_t, std::string, std::string, std::string> PointKeyT;
+
+static bool verify (const std::string & path, const std::vector<PointDescription> & points, std::uint32_t zoom) {
+	PointTiles tiles;
+	
+	if (!tiles.open(path))
+		return false;
+	
+	if (tiles.size() != points.size() || tiles.zoom() != zoom) {
+		std::cerr << "Point count or zoom level differs!" << std::endl;
+		return false;
+	}
+	
+	std::vector<PointKeyT> expected, stored;
+	
+	for (std::size_t i = 0; i < points.size(); i += 1) {
+		double longitude = std::fmod(points[i].longitude + 180.0, 360.0);
+		if (longitude < 0) longitude += 360.0;
+		
+		expected.push_back(PointKeyT((std::int32_t)std::lround(points[i].latitude * 1e7), (std::int32_t)std::lround((longitude - 180.0) * 1e7), points[i].title, points[i].subtitle, points[i].category));
+	}
+	
+	// Every record must be in the tile which contains it:
+	for (std::uint32_t i = 0; i < tiles.tileCount(); i += 1) {
+		const PointTileRecord & tile = tiles.tile(i);
+		
+		for (std::uint32_t j = tile.firstRecord; j < tile.firstRecord + tile.recordCount; j += 1) {
+			const PointRecord & record = tiles.record(j);
+			std::uint32_t x, y;
+			
+			pointTile(record.latitude / 1e7, record.longitude / 1e7, zoom, x, y);
+			
+			if (pointTileQuadkey(x, y) != tile.quadkey) {
+				std::cerr << "Point " << j << " is in the wrong tile!" << std::endl;
+				return false;
+			}
+			
+			stored.push_back(PointKeyT(record.latitude, record.longitude, tiles.string(record.title), tiles.string(record.subtitle), tiles.string(record.category)));
+		}
+	}
+	
+	std::sort(expected.begin(), expected.end());
+	std::sort(stored.begin(), stored.end());
+	
+	if (expected != stored) {
+		std::cerr << "Stored points differ from the input!" << std::endl;
+		return false;
+	}
+	
+	return true;
+}
+
+int main (int argc, char ** argv) {
+	if (argc != 3 && argc != 4) {
+		std::cerr << "Usage: " << argv[0] << " points.csv points.arpoi [zoom]" << std::endl;
+		return 1;
+	}
+	
+	std::string inputPath = argv[1], outputPath = argv[2];
+	std::uint32_t zoom = argc == 4 ? (std::uint32_t)std::strtoul(argv[3], NULL, 10) : 15;
+	
+	std::vector<PointDescription> points;
+	
+	if (!readPoints(inputPath, points))
+		return 1;
+	
+	if (!writePointTiles(outputPath, points, zoom))
+		return 1;
+	
+	if (!verify(outputPath, points, zoom)) {
+		std::cerr << "Verification of " << outputPath << " failed!" << std::endl;
+		return 1;
+	}
+	
+	PointTiles tiles;
+	tiles.open(outputPath);
+	
+	std::cout << "Wrote " << points.size() << " points in " << tiles.tileCount() << " tiles at zoom level " << zoom << " to " << outputPath << " (" << tiles.fileSize() << " bytes)" << std::endl;
+	
+	return 0;
+}
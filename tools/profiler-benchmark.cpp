@@ -0,0 +1,125 @@
+//
+//  profiler-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Measures the overhead of ARBrowser::FrameProfiler scopes and counters, and checks the percentiles it reports for frames with known stage times while another thread reads summaries concurrently.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/profiler-benchmark.cpp source/ARBrowser/ARFrameProfiler.cpp -lpthread -o profiler-benchmark
+//
+// Exits with a non-zero status if a summary is wrong.
+
+#define AR_PROFILING 1
+
+#include "ARFrameProfiler.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// Prevents the compiler from removing the loop being measured.
+static volatile std::size_t sink;
+
+static double measureOverhead (FrameProfiler & profiler, bool profiled) {
+	const std::size_t FRAMES = 20000, SCOPES = 50;
+	
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		if (profiled) profiler.beginFrame();
+		
+		for (std::size_t i = 0; i < SCOPES; i += 1) {
+			if (profiled) {
+				AR_PROFILE_SCOPE(profiler, STAGE_DRAW);
+				AR_PROFILE_COUNT(profiler, COUNTER_DRAWN, 1);
+				sink = sink + i;
+			} else {
+				sink = sink + i;
+			}
+		}
+		
+		if (profiled) profiler.endFrame();
+	}
+	
+	return elapsed(start) / (FRAMES * SCOPES);
+}
+
+static bool near (double value, double expected) {
+	return std::fabs(value - expected) <= expected * 0.01 + 1e-6;
+}
+
+int main () {
+	FrameProfiler profiler;
+	
+	double baseline = measureOverhead(profiler, false);
+	double profiled = measureOverhead(profiler, true);
+	
+	std::printf("Overhead: %0.1fns per scope and counter\n", (profiled - baseline) * 1e9);
+	
+	// Record frames with known stage times, while another thread reads summaries:
+	FrameProfiler known;
+	std::atomic<bool> done(false);
+	std::size_t inconsistent = 0, summaries = 0;
+	
+	std::thread reader([&]() {
+		std::vector<FrameSample> samples(FrameProfiler::CAPACITY);
+		
+		while (!done.load()) {
+			std::size_t count = known.recentFrames(samples.data());
+			
+			// Every stage of a frame is written together, so a torn copy would show different values:
+			for (std::size_t i = 0; i < count; i += 1) {
+				if (samples[i].stages[STAGE_SORT] != samples[i].counters[COUNTER_DRAWN] * 1000)
+					inconsistent += 1;
+			}
+			
+			summaries += 1;
+		}
+	});
+	
+	const std::size_t FRAMES = 100000;
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		known.beginFrame();
+		
+		// The last 256 frames have sort times of 1 to 256 microseconds:
+		std::size_t value = frame % FrameProfiler::CAPACITY + 1;
+		known.addTime(STAGE_SORT, std::chrono::microseconds(value));
+		known.addCount(COUNTER_DRAWN, value);
+		
+		known.endFrame();
+	}
+	
+	done = true;
+	reader.join();
+	
+	FrameProfiler::Summary summary = known.summary();
+	const FrameProfiler::Percentiles & sort = summary.stages[STAGE_SORT];
+	
+	std::printf("%s", FrameProfiler::describe(summary).c_str());
+	std::printf("Concurrent reads: %lu summaries, %lu inconsistent frames\n", (unsigned long)summaries, (unsigned long)inconsistent);
+	
+	bool correct = summary.frames == FrameProfiler::CAPACITY
+		&& near(sort.p50, 0.128) && near(sort.p95, 0.243) && near(sort.p99, 0.253) && near(sort.maximum, 0.256)
+		&& summary.counters[COUNTER_DRAWN].maximum == 256
+		&& inconsistent == 0;
+	
+	if (!correct)
+		std::printf("Summary is wrong!\n");
+	
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,282 @@
+//
+//  recycling-pool-test.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Checks ARBrowser::RecyclingPool: a released value is reused rather than allocated, the pool grows up to its capacity while values are in use and allocates values it doesn't keep beyond that, and clearing it doesn't free values which are still in use. Then hands buffers from the pool to a worker thread, which checks and overwrites them before releasing them, as the camera callback does with images handed to the tracking thread. The pool must never hand out a buffer the worker still refers to, and the worker's writes must be visible when a buffer is reused. Run it under ThreadSanitizer to check the synchronisation.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -pthread -Isource/ARBrowser tools/recycling-pool-test.cpp -o recycling-pool-test
+//	c++ -std=c++11 -O1 -g -fsanitize=thread -Isource/ARBrowser tools/recycling-pool-test.cpp -o recycling-pool-test
+//
+// Usage:
+//	recycling-pool-test
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARRecyclingPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// The number of buffers which have not been destroyed.
+static std::atomic<int> liveBuffers(0);
+
+struct Buffer {
+	std::vector<int> data;
+	
+	Buffer (std::size_t size) : data(size, -1) {
+		liveBuffers += 1;
+	}
+	
+	~Buffer () {
+		liveBuffers -= 1;
+	}
+};
+
+typedef std::shared_ptr<Buffer> BufferPointer;
+typedef RecyclingPool<BufferPointer> BufferPool;
+
+static BufferPointer makeBuffer () {
+	return std::make_shared<Buffer>(16);
+}
+
+static bool testReuse () {
+	BufferPool pool(2);
+	bool success = true;
+	
+	BufferPointer first = pool.acquire(makeBuffer);
+	Buffer * address = first.get();
+	first.reset();
+	
+	// Once released, the same value is handed out again:
+	BufferPointer second = pool.acquire(makeBuffer);
+	
+	if (second.get() != address || pool.statistics().allocations != 1 || pool.statistics().reuses != 1) {
+		std::printf("FAILED: A released value was not reused\n");
+		success = false;
+	}
+	
+	// While it is in use, another value is created:
+	BufferPointer third = pool.acquire(makeBuffer);
+	
+	if (third.get() == address || pool.statistics().allocations != 2) {
+		std::printf("FAILED: A value in use was handed out again\n");
+		success = false;
+	}
+	
+	std::printf("Reuse: released values are reused, values in use are not\n");
+	
+	return success;
+}
+
+static bool testGrowth () {
+	const std::size_t CAPACITY = 4;
+	
+	BufferPool pool(CAPACITY);
+	bool success = true;
+	
+	std::vector<BufferPointer> held;
+	
+	for (std::size_t i = 0; i < CAPACITY + 2; i += 1)
+		held.push_back(pool.acquire(makeBuffer));
+	
+	const BufferPool::Statistics & statistics = pool.statistics();
+	
+	if (pool.size() != CAPACITY || statistics.allocations != CAPACITY || statistics.overflows != 2 || statistics.reuses != 0) {
+		std::printf("FAILED: Holding %lu values with a capacity of %lu kept %lu, with %lu allocations and %lu overflows\n", (unsigned long)held.size(), (unsigned long)CAPACITY, (unsigned long)pool.size(), (unsigned long)statistics.allocations, (unsigned long)statistics.overflows);
+		success = false;
+	}
+	
+	// Values which weren't kept are freed as soon as they are released:
+	held.resize(CAPACITY);
+	
+	if (liveBuffers != (int)CAPACITY) {
+		std::printf("FAILED: %d values alive after releasing the overflow\n", liveBuffers.load());
+		success = false;
+	}
+	
+	held.clear();
+	
+	for (std::size_t i = 0; i < CAPACITY; i += 1)
+		held.push_back(pool.acquire(makeBuffer));
+	
+	if (statistics.allocations != CAPACITY || statistics.reuses != CAPACITY) {
+		std::printf("FAILED: Reacquiring %lu values allocated %lu in total\n", (unsigned long)CAPACITY, (unsigned long)statistics.allocations);
+		success = false;
+	}
+	
+	// Clearing the pool leaves values in use alone:
+	pool.clear();
+	
+	if (pool.size() != 0 || liveBuffers != (int)CAPACITY) {
+		std::printf("FAILED: Clearing the pool freed values which were in use\n");
+		success = false;
+	}
+	
+	held.clear();
+	
+	if (liveBuffers != 0) {
+		std::printf("FAILED: %d values alive after clearing the pool and releasing them\n", liveBuffers.load());
+		success = false;
+	}
+	
+	std::printf("Growth: the pool keeps at most %lu values, and clearing it frees them once released\n", (unsigned long)CAPACITY);
+	
+	return success;
+}
+
+/// A queue of buffers handed from the producer to the worker.
+class BufferQueue {
+	protected:
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		std::deque<std::pair<int, BufferPointer>> m_buffers;
+		bool m_closed;
+	
+	public:
+		BufferQueue () : m_closed(false) {}
+		
+		void push (int frame, const BufferPointer & buffer) {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_buffers.push_back(std::make_pair(frame, buffer));
+			m_condition.notify_one();
+		}
+		
+		void close () {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_closed = true;
+			m_condition.notify_one();
+		}
+		
+		bool pop (int & frame, BufferPointer & buffer) {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			
+			while (m_buffers.empty() && !m_closed)
+				m_condition.wait(lock);
+			
+			if (m_buffers.empty())
+				return false;
+			
+			frame = m_buffers.front().first;
+			buffer.swap(m_buffers.front().second);
+			m_buffers.pop_front();
+			
+			return true;
+		}
+		
+		std::size_t size () {
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_buffers.size();
+		}
+};
+
+static bool testCrossThread () {
+	const int FRAMES = 20000;
+	const std::size_t CAPACITY = 3, BACKLOG = 4;
+	
+	BufferPool pool(CAPACITY);
+	BufferQueue queue;
+	std::atomic<std::size_t> corrupt(0);
+	
+	ClockT::time_point start = ClockT::now();
+	
+	// The worker checks each buffer holds its frame, then marks it as consumed before releasing it:
+	std::thread worker([&]() {
+		int frame;
+		BufferPointer buffer;
+		
+		while (queue.pop(frame, buffer)) {
+			for (std::size_t i = 0; i < buffer->data.size(); i += 1) {
+				if (buffer->data[i] != frame) {
+					corrupt += 1;
+					break;
+				}
+				
+				buffer->data[i] = -1;
+			}
+			
+			buffer.reset();
+		}
+	});
+	
+	std::size_t stale = 0;
+	
+	for (int frame = 0; frame < FRAMES; frame += 1) {
+		// Drop frames rather than queue them without limit, as the camera does when tracking falls behind:
+		if (queue.size() >= BACKLOG) {
+			std::this_thread::yield();
+			continue;
+		}
+		
+		BufferPointer buffer = pool.acquire(makeBuffer);
+		
+		// Every buffer is new, or was marked as consumed by the worker before it was released:
+		for (std::size_t i = 0; i < buffer->data.size(); i += 1) {
+			if (buffer->data[i] != -1) {
+				stale += 1;
+				break;
+			}
+		}
+		
+		std::fill(buffer->data.begin(), buffer->data.end(), frame);
+		queue.push(frame, buffer);
+	}
+	
+	queue.close();
+	worker.join();
+	
+	double duration = elapsed(start);
+	const BufferPool::Statistics & statistics = pool.statistics();
+	bool success = true;
+	
+	if (corrupt || stale) {
+		std::printf("FAILED: %lu buffers were overwritten while the worker used them, and %lu were reused before the worker finished with them\n", (unsigned long)corrupt.load(), (unsigned long)stale);
+		success = false;
+	}
+	
+	if (statistics.allocations > CAPACITY || statistics.allocations + statistics.reuses + statistics.overflows == 0) {
+		std::printf("FAILED: %lu allocations with a capacity of %lu\n", (unsigned long)statistics.allocations, (unsigned long)CAPACITY);
+		success = false;
+	}
+	
+	if (liveBuffers != (int)pool.size()) {
+		std::printf("FAILED: %d buffers alive, but the pool only keeps %lu\n", liveBuffers.load(), (unsigned long)pool.size());
+		success = false;
+	}
+	
+	std::printf("Cross thread: %lu buffers handed to the worker in %0.1fms, %lu allocations, %lu reuses, %lu overflows\n", (unsigned long)(statistics.allocations + statistics.reuses + statistics.overflows), duration * 1000.0, (unsigned long)statistics.allocations, (unsigned long)statistics.reuses, (unsigned long)statistics.overflows);
+	
+	return success;
+}
+
+int main () {
+	bool success = true;
+	
+	success = testReuse() && success;
+	success = testGrowth() && success;
+	success = testCrossThread() && success;
+	
+	if (liveBuffers != 0) {
+		std::printf("FAILED: %d buffers were never destroyed\n", liveBuffers.load());
+		success = false;
+	}
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,269 @@
+//
+//  render-budget-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Walks a viewer through scattered points and, each frame, selects the points in view within a render budget with ARBrowser::RenderBudget and keeps only the drawn points ordered far to near with ARBrowser::DrawOrder, as ARBrowserView does, checking the order against sorting every visible point. Then selects points within the budget with every point as a candidate, checking that the limits are respected, that required points are always drawn and that no deferred point should have been drawn instead of a lower priority one.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/render-budget-benchmark.cpp source/ARBrowser/ARRenderBudget.cpp -o render-budget-benchmark
+//
+// Usage:
+//	render-budget-benchmark [points...]
+//
+// By default, 1000, 10000 and 100000 points are tested. Exits with a non-zero status if any check fails.
+
+#include "ARRenderBudget.h"
+#include "ARVisibility.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static const float MAXIMUM_DISTANCE = 500;
+static const std::size_t FRAMES = 200;
+static const std::size_t MAXIMUM_DRAWS = 256, MAXIMUM_TRIANGLES = 250000;
+
+/// As ARBrowserVisibleWorldPoint, which holds the object transform.
+struct RebuiltPoint {
+	float distance;
+	Vec3 delta;
+	const void * handle;
+	float transform[16];
+	
+	bool operator< (const RebuiltPoint & other) const {
+		return this->distance > other.distance;
+	}
+};
+
+/// The visibility table for a viewer at the given position, as VisibilityStage builds it.
+static void buildEntries (const std::vector<Vec3> & positions, float x, float y, std::vector<VisibilityEntry> & entries) {
+	entries.clear();
+	
+	for (std::size_t i = 0; i < positions.size(); i += 1) {
+		VisibilityEntry entry;
+		
+		entry.handle = &positions[i];
+		entry.delta = Vec3(positions[i][X] - x, positions[i][Y] - y, positions[i][Z]);
+		entry.distance = std::sqrt(entry.delta[X] * entry.delta[X] + entry.delta[Y] * entry.delta[Y]);
+		entry.bearing = 0;
+		entry.flags = entry.distance <= MAXIMUM_DISTANCE ? VisibilityEntry::VISIBLE : 0;
+		
+		if (entry.flags)
+			entries.push_back(entry);
+	}
+}
+
+/// The item for a point at the given distance: priority is the size on screen, and the triangles drawn depend on the level of detail chosen for that size.
+static RenderBudget::Item budgetItem (float distance, bool required) {
+	RenderBudget::Item item;
+	
+	item.priority = 500.0 / std::max(distance, 1.0f);
+	item.triangles = item.priority > 20 ? 5000 : item.priority > 5 ? 1200 : 300;
+	item.required = required;
+	
+	return item;
+}
+
+/// Compares drawing a frame as ARBrowserView does, where only the points which survive culling are budgeted and only the points which are drawn are kept in order far to near between frames, against sorting every visible point as it did before.
+static bool testFrame (std::size_t count) {
+	std::mt19937 random(19);
+	std::uniform_real_distribution<float> unit(0, 1);
+	
+	// A 1.5km square, so that points enter and leave the visible range as the viewer walks:
+	std::vector<Vec3> positions(count);
+	
+	for (std::size_t i = 0; i < count; i += 1)
+		positions[i] = Vec3((unit(random) - 0.5) * 1500, (unit(random) - 0.5) * 1500, 0);
+	
+	RenderBudget budget(MAXIMUM_DRAWS, MAXIMUM_TRIANGLES);
+	DrawOrder drawOrder;
+	std::vector<VisibilityEntry> entries;
+	std::vector<std::uint32_t> candidates, order;
+	std::vector<RebuiltPoint> rebuilt;
+	
+	double frameTime = 0, rebuiltTime = 0;
+	std::size_t visible = 0, culled = 0, drawn = 0, added = 0, moves = 0, wrong = 0;
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		// Walking east at about 1.4m/s and 60 frames per second, while points come and go at the edge of the visible range:
+		float walked = frame * (1.4 / 60.0);
+		buildEntries(positions, walked, 0, entries);
+		
+		ClockT::time_point start = ClockT::now();
+		
+		// Facing east with a 60 degree field of view, standing in for the frustum culling:
+		candidates.clear();
+		budget.clear();
+		
+		for (std::size_t i = 0; i < entries.size(); i += 1) {
+			const VisibilityEntry & entry = entries[i];
+			
+			if (entry.delta[X] > 0 && std::abs(entry.delta[Y]) < entry.delta[X] * 0.577f) {
+				budget.add(budgetItem(entry.distance, candidates.size() == 0));
+				candidates.push_back((std::uint32_t)i);
+			}
+		}
+		
+		budget.select();
+		
+		drawOrder.clear();
+		
+		for (std::size_t i = 0; i < candidates.size(); i += 1) {
+			if (budget.accepted(i)) {
+				const VisibilityEntry & entry = entries[candidates[i]];
+				drawOrder.add((DrawOrder::Item){entry.handle, entry.distance, candidates[i]});
+			}
+		}
+		
+		drawOrder.sort();
+		
+		frameTime += elapsed(start);
+		
+		order.clear();
+		
+		for (const DrawOrder::Item & item : drawOrder.items())
+			order.push_back(item.index);
+		
+		start = ClockT::now();
+		
+		rebuilt.clear();
+		
+		for (std::size_t i = 0; i < entries.size(); i += 1) {
+			RebuiltPoint point = {entries[i].distance, entries[i].delta, entries[i].handle, {0}};
+			rebuilt.push_back(point);
+		}
+		
+		std::sort(rebuilt.begin(), rebuilt.end());
+		
+		rebuiltTime += elapsed(start);
+		
+		visible += entries.size();
+		culled += candidates.size();
+		drawn += order.size();
+		added += drawOrder.statistics().added;
+		moves += drawOrder.statistics().moves;
+		
+		// The drawn points appear in the same order as in the sorted list of every visible point, comparing distances as points at the same distance may be in either order:
+		std::size_t next = 0;
+		
+		for (std::size_t i = 0; i < rebuilt.size() && next < order.size(); i += 1) {
+			if (rebuilt[i].distance == entries[order[next]].distance)
+				next += 1;
+		}
+		
+		if (next != order.size())
+			wrong += 1;
+	}
+	
+	std::printf("Frame, %lu points, %0.0f visible, %0.0f after culling, %0.0f drawn, %0.1f newly drawn and %0.1f moves per frame: %0.1fus per frame to budget and order the drawn points, %0.1fus per frame to sort every visible point\n", (unsigned long)count, (double)visible / FRAMES, (double)culled / FRAMES, (double)drawn / FRAMES, (double)added / FRAMES, (double)moves / FRAMES, frameTime * 1e6 / FRAMES, rebuiltTime * 1e6 / FRAMES);
+	
+	if (wrong) {
+		std::printf("FAILED: %lu frames drawn in the wrong order\n", (unsigned long)wrong);
+		return false;
+	}
+	
+	return true;
+}
+
+static bool testBudget (std::size_t count) {
+	std::mt19937 random(23);
+	std::uniform_real_distribution<float> unit(0, 1);
+	
+	RenderBudget budget(MAXIMUM_DRAWS, MAXIMUM_TRIANGLES);
+	std::vector<RenderBudget::Item> items(count);
+	
+	// Every point is a candidate, as if none were culled:
+	for (std::size_t i = 0; i < count; i += 1)
+		items[i] = budgetItem(5 + unit(random) * MAXIMUM_DISTANCE, i % 1000 == 0);
+	
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		budget.clear();
+		
+		for (std::size_t i = 0; i < count; i += 1)
+			budget.add(items[i]);
+		
+		budget.select();
+	}
+	
+	double frameTime = elapsed(start) / FRAMES;
+	
+	const RenderBudget::Statistics & statistics = budget.statistics();
+	std::size_t required = 0, overBudget = 0, missed = 0;
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		if (items[i].required && !budget.accepted(i))
+			required += 1;
+	}
+	
+	if (statistics.drawn > std::max<std::size_t>(MAXIMUM_DRAWS, count / 1000 + 1) || statistics.triangles > MAXIMUM_TRIANGLES + (count / 1000 + 1) * 5000)
+		overBudget += 1;
+	
+	// A deferred item which was no more expensive than a lower priority item which was drawn should have been drawn instead:
+	float lowest = 1e30f;
+	std::uint32_t cheapest = ~std::uint32_t(0);
+	
+	for (std::size_t i = 0; i < count; i += 1) {
+		if (budget.accepted(i) && !items[i].required) {
+			lowest = std::min(lowest, items[i].priority);
+			cheapest = std::min(cheapest, items[i].triangles);
+		}
+	}
+	
+	const std::vector<std::uint32_t> & deferred = budget.deferred();
+	
+	for (std::size_t i = 0; i < deferred.size(); i += 1) {
+		const RenderBudget::Item & item = items[deferred[i]];
+		
+		if (item.priority > lowest && item.triangles <= cheapest)
+			missed += 1;
+	}
+	
+	std::printf("Budget, %lu points: %0.1fus per frame, %lu drawn with %lu triangles, %lu deferred with %lu triangles\n", (unsigned long)count, frameTime * 1e6, (unsigned long)statistics.drawn, (unsigned long)statistics.triangles, (unsigned long)statistics.deferred, (unsigned long)statistics.deferredTriangles);
+	
+	if (required || overBudget || missed || statistics.drawn + statistics.deferred != count) {
+		std::printf("FAILED: %lu required points deferred, %s, %lu points deferred in favour of lower priority points\n", (unsigned long)required, overBudget ? "over budget" : "within budget", (unsigned long)missed);
+		return false;
+	}
+	
+	return true;
+}
+
+int main (int argc, char ** argv) {
+	std::vector<std::size_t> counts;
+	
+	for (int i = 1; i < argc; i += 1)
+		counts.push_back(std::strtoul(argv[i], NULL, 10));
+	
+	if (counts.empty()) {
+		counts.push_back(1000);
+		counts.push_back(10000);
+		counts.push_back(100000);
+	}
+	
+	bool success = true;
+	
+	for (std::size_t i = 0; i < counts.size(); i += 1) {
+		success = testFrame(counts[i]) && success;
+		success = testBudget(counts[i]) && success;
+	}
+	
+	return success ? 0 : 1;
+}
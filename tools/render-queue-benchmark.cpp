@@ -0,0 +1,324 @@
+//
+//  render-queue-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Scatters instances of several models, with a mix of textured, untextured and translucent materials, around the viewer and draws them with ARBrowser::RenderQueue into a backend which records every call instead of using OpenGL. Compares the number of state changes with drawing each model in turn, far to near, as Model::render does, and checks that the queue never makes a redundant state change, draws every mesh exactly once, and keeps opaque meshes front to back within each group and translucent meshes back to front.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/render-queue-benchmark.cpp source/ARBrowser/ARRenderQueue.cpp -o render-queue-benchmark
+//
+// Usage:
+//	render-queue-benchmark [--instancing] [instances]
+//
+// With --instancing, the backend claims to support instanced drawing. Exits with a non-zero status if any check fails.
+
+#include "ARRenderQueue.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// A model with a few meshes, each with its own vertex array and material.
+struct TestModel {
+	std::vector<std::vector<ObjMeshVertex>> vertices;
+	std::vector<MeshBuffer> meshes;
+	std::vector<std::uint32_t> textures;
+	std::vector<Color4f> colors;
+};
+
+struct TestInstance {
+	std::size_t model;
+	float depth;
+	float transform[16];
+};
+
+/// Records the calls made by the queue, and checks that each one changes the state.
+class RecordingBackend : public RenderBackend {
+	public:
+		struct Draw {
+			const MeshBuffer * mesh;
+			
+			/// The translation of the model-view matrix, which identifies the instance.
+			float x;
+			
+			std::uint32_t texture;
+			bool blending;
+		};
+		
+		std::vector<Draw> draws;
+		std::size_t calls, redundant;
+	
+	protected:
+		bool m_instancing;
+		
+		bool m_blending;
+		std::uint32_t m_texture;
+		Color4f m_color;
+		const void * m_vertices;
+		const float * m_transform;
+	
+	public:
+		RecordingBackend (bool instancing) : calls(0), redundant(0), m_instancing(instancing) {
+		}
+		
+		virtual void begin () {
+			draws.clear();
+			calls = redundant = 0;
+			
+			m_blending = false;
+			m_texture = ~std::uint32_t(0);
+			m_color.r = -1;
+			m_vertices = NULL;
+			m_transform = NULL;
+		}
+		
+		virtual void setBlending (bool enabled) {
+			if (calls > 0 && enabled == m_blending)
+				redundant += 1;
+			
+			m_blending = enabled;
+			calls += 1;
+		}
+		
+		virtual void setTexture (std::uint32_t texture) {
+			if (texture == m_texture)
+				redundant += 1;
+			
+			m_texture = texture;
+			calls += 1;
+		}
+		
+		virtual void setColor (const Color4f & color) {
+			if (std::memcmp(&color, &m_color, sizeof(color)) == 0)
+				redundant += 1;
+			
+			m_color = color;
+			calls += 1;
+		}
+		
+		virtual void setVertices (const MeshBuffer & mesh) {
+			if (mesh.vertexData() == m_vertices)
+				redundant += 1;
+			
+			m_vertices = mesh.vertexData();
+			calls += 1;
+		}
+		
+		virtual void setTransform (const float * matrix) {
+			if (matrix == m_transform)
+				redundant += 1;
+			
+			m_transform = matrix;
+			calls += 1;
+		}
+		
+		virtual void drawElements (const MeshBuffer & mesh) {
+			draws.push_back((Draw){&mesh, m_transform[12], m_texture, m_blending});
+			calls += 1;
+		}
+		
+		virtual bool supportsInstancing () const {
+			return m_instancing;
+		}
+		
+		virtual void drawInstanced (const MeshBuffer & mesh, const float * transforms, std::size_t count) {
+			for (std::size_t i = 0; i < count; i += 1)
+				draws.push_back((Draw){&mesh, transforms[i * 16 + 12], m_texture, m_blending});
+			
+			m_transform = NULL;
+			calls += 1;
+		}
+};
+
+/// The calls made by drawing each instance in turn, far to near, as Model::render does: every mesh enables and then resets its material and sets its arrays.
+static std::size_t naiveCalls (const std::vector<TestModel> & models, const std::vector<TestInstance> & instances) {
+	std::size_t calls = 0;
+	
+	for (std::size_t i = 0; i < instances.size(); i += 1) {
+		const TestModel & model = models[instances[i].model];
+		
+		// Push, multiply and pop the matrix:
+		calls += 3;
+		
+		for (std::size_t j = 0; j < model.meshes.size(); j += 1) {
+			// Bind the texture and set the colour, enable texturing and the texture coordinate array and set its pointer, then undo it all afterwards:
+			if (model.textures[j])
+				calls += 2 + 3 + 2 + 2;
+			
+			// Enable and set the vertex and normal arrays, and draw:
+			calls += 4 + 1;
+		}
+		
+		// Disable the vertex and normal arrays:
+		calls += 2;
+	}
+	
+	return calls;
+}
+
+static void translation (float * matrix, float x, float y, float z) {
+	std::memset(matrix, 0, sizeof(float) * 16);
+	
+	matrix[0] = matrix[5] = matrix[10] = matrix[15] = 1;
+	matrix[12] = x; matrix[13] = y; matrix[14] = z;
+}
+
+int main (int argc, char ** argv) {
+	bool instancing = false;
+	std::size_t instanceCount = 500;
+	
+	for (int i = 1; i < argc; i += 1) {
+		if (std::strcmp(argv[i], "--instancing") == 0)
+			instancing = true;
+		else
+			instanceCount = std::strtoul(argv[i], NULL, 10);
+	}
+	
+	std::mt19937 random(7);
+	std::uniform_real_distribution<float> unit(0, 1);
+	
+	// 12 models sharing 6 textures, with 1 to 4 meshes each. Some meshes are untextured, and a few are translucent:
+	std::vector<TestModel> models(12);
+	
+	for (std::size_t i = 0; i < models.size(); i += 1) {
+		TestModel & model = models[i];
+		std::size_t meshCount = 1 + random() % 4;
+		
+		model.vertices.resize(meshCount, std::vector<ObjMeshVertex>(24));
+		
+		for (std::size_t j = 0; j < meshCount; j += 1) {
+			MeshBuffer mesh = {NULL, model.vertices[j].data(), NULL, NULL, 24, NULL, 36, true};
+			model.meshes.push_back(mesh);
+			
+			std::uint32_t texture = (random() % 4 == 0) ? 0 : 1 + random() % 6;
+			Color4f color = {1, 1, 1, 1};
+			
+			if (texture) {
+				color.r = color.g = color.b = 0.8;
+				
+				if (random() % 5 == 0)
+					color.a = 0.5;
+			}
+			
+			model.textures.push_back(texture);
+			model.colors.push_back(color);
+		}
+	}
+	
+	std::vector<TestInstance> instances(instanceCount);
+	
+	for (std::size_t i = 0; i < instances.size(); i += 1) {
+		TestInstance & instance = instances[i];
+		
+		instance.model = random() % models.size();
+		
+		float x = unit(random) * 200 - 100, z = unit(random) * 200 - 100;
+		instance.depth = std::sqrt(x*x + z*z);
+		translation(instance.transform, x, 0, z);
+	}
+	
+	// As ARBrowserView orders points, far to near:
+	std::sort(instances.begin(), instances.end(), [](const TestInstance & a, const TestInstance & b) { return a.depth > b.depth; });
+	
+	RenderQueue queue;
+	RecordingBackend backend(instancing);
+	
+	float view[16];
+	translation(view, 0, 0, -0.2);
+	
+	const std::size_t FRAMES = 200;
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::size_t frame = 0; frame < FRAMES; frame += 1) {
+		queue.clear();
+		
+		for (std::size_t i = 0; i < instances.size(); i += 1) {
+			const TestInstance & instance = instances[i];
+			const TestModel & model = models[instance.model];
+			
+			std::uint32_t transform = queue.addTransform(instance.transform);
+			
+			for (std::size_t j = 0; j < model.meshes.size(); j += 1) {
+				DrawItem item = {&model.meshes[j], model.textures[j], model.colors[j], model.colors[j].a < 1, instance.depth, transform};
+				queue.add(item);
+			}
+		}
+		
+		queue.submit(backend, view);
+	}
+	
+	double frameTime = elapsed(start) / FRAMES;
+	
+	const RenderQueue::Statistics & statistics = queue.statistics();
+	std::size_t naive = naiveCalls(models, instances);
+	bool failed = false;
+	
+	std::printf("Instances: %lu, meshes: %lu\n", (unsigned long)instances.size(), (unsigned long)statistics.items);
+	std::printf("Queue: %0.1fus per frame to gather, sort and submit\n", frameTime * 1e6);
+	std::printf("Calls: %lu by the queue, %lu drawing each model in turn (%0.1fx fewer)\n", (unsigned long)backend.calls, (unsigned long)naive, (double)naive / backend.calls);
+	std::printf("Draw calls: %lu\n", (unsigned long)statistics.draws);
+	std::printf("State changes: blending %lu, texture %lu, colour %lu, vertices %lu, transform %lu\n", (unsigned long)statistics.blendingChanges, (unsigned long)statistics.textureChanges, (unsigned long)statistics.colorChanges, (unsigned long)statistics.vertexChanges, (unsigned long)statistics.transformChanges);
+	
+	if (backend.redundant) {
+		std::printf("FAILED: %lu redundant state changes\n", (unsigned long)backend.redundant);
+		failed = true;
+	}
+	
+	// Every mesh of every instance must be drawn exactly once:
+	std::set<std::pair<const MeshBuffer *, float>> expected, drawn;
+	
+	for (std::size_t i = 0; i < instances.size(); i += 1) {
+		const TestModel & model = models[instances[i].model];
+		
+		for (std::size_t j = 0; j < model.meshes.size(); j += 1)
+			expected.insert(std::make_pair(&model.meshes[j], instances[i].transform[12]));
+	}
+	
+	for (std::size_t i = 0; i < backend.draws.size(); i += 1)
+		drawn.insert(std::make_pair(backend.draws[i].mesh, backend.draws[i].x));
+	
+	if (backend.draws.size() != statistics.items || drawn != expected) {
+		std::printf("FAILED: %lu meshes drawn, %lu expected\n", (unsigned long)backend.draws.size(), (unsigned long)expected.size());
+		failed = true;
+	}
+	
+	// The order in which items were drawn:
+	std::size_t orderErrors = 0;
+	
+	for (std::size_t i = 1; i < queue.size(); i += 1) {
+		const DrawItem & previous = queue.item(i - 1), & current = queue.item(i);
+		
+		if (previous.blended && !current.blended)
+			orderErrors += 1;
+		else if (current.blended && previous.blended && current.depth > previous.depth)
+			orderErrors += 1;
+		else if (!current.blended && current.texture == previous.texture && current.mesh->vertices == previous.mesh->vertices && current.depth < previous.depth)
+			orderErrors += 1;
+	}
+	
+	if (orderErrors) {
+		std::printf("FAILED: %lu items out of order\n", (unsigned long)orderErrors);
+		failed = true;
+	}
+	
+	return failed ? 1 : 0;
+}
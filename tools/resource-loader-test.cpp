@@ -0,0 +1,474 @@
+//
+//  resource-loader-test.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Checks ARBrowser::ResourceLoader with synthetic resources: loads run in the order they were queued and each upload follows its load, released requests are skipped whether they are waiting for a worker or for an upload, failures and exceptions finish the request as FAILED, and processUploads stops once its budget has been used but always makes progress. Then many requests are loaded, released and uploaded at random by several workers, checking that every request which is kept is finished exactly once. Run it under ThreadSanitizer to check the synchronisation.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -pthread -Isource/ARBrowser tools/resource-loader-test.cpp source/ARBrowser/ARResourceLoader.cpp -o resource-loader-test
+//	c++ -std=c++11 -O1 -g -fsanitize=thread -Isource/ARBrowser tools/resource-loader-test.cpp source/ARBrowser/ARResourceLoader.cpp -o resource-loader-test
+//
+// Usage:
+//	resource-loader-test
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARResourceLoader.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <stdexcept>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+typedef std::shared_ptr<ResourceLoader::Request> RequestT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// Blocks worker threads until it is opened, so that requests can be released while they are waiting.
+class Gate {
+	protected:
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_open;
+	
+	public:
+		Gate () : m_open(false) {}
+		
+		void open () {
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				m_open = true;
+			}
+			
+			m_condition.notify_all();
+		}
+		
+		void wait () {
+			std::unique_lock<std::mutex> lock(m_mutex);
+			
+			while (!m_open)
+				m_condition.wait(lock);
+		}
+};
+
+/// Busy wait, so that the time taken doesn't depend on the scheduler.
+static void work (double duration) {
+	ClockT::time_point start = ClockT::now();
+	
+	while (elapsed(start) < duration);
+}
+
+/// Process uploads until the loader has nothing outstanding, or a few seconds have passed.
+static bool drain (ResourceLoader & loader) {
+	ClockT::time_point start = ClockT::now();
+	
+	while (loader.outstandingCount() > 0) {
+		if (elapsed(start) > 5.0)
+			return false;
+		
+		loader.processUploads(0.001);
+		std::this_thread::yield();
+	}
+	
+	return true;
+}
+
+/// Wait until the request is in the given state, or a few seconds have passed.
+static bool waitFor (const RequestT & request, ResourceLoader::State state) {
+	ClockT::time_point start = ClockT::now();
+	
+	while (request->state() != state) {
+		if (elapsed(start) > 5.0)
+			return false;
+		
+		std::this_thread::yield();
+	}
+	
+	return true;
+}
+
+static bool testOrdering () {
+	const std::size_t COUNT = 100;
+	
+	// With one worker, loads run in the order they were queued, and are uploaded in the same order:
+	ResourceLoader loader(1);
+	
+	std::mutex mutex;
+	std::vector<std::size_t> loads, uploads;
+	std::vector<RequestT> requests;
+	bool success = true;
+	
+	for (std::size_t i = 0; i < COUNT; i += 1) {
+		requests.push_back(loader.load([&, i]() {
+			std::lock_guard<std::mutex> lock(mutex);
+			loads.push_back(i);
+			
+			return true;
+		}, [&, i]() {
+			std::lock_guard<std::mutex> lock(mutex);
+			
+			// The load must have finished before the upload:
+			if (std::find(loads.begin(), loads.end(), i) == loads.end()) {
+				std::printf("FAILED: Request %lu was uploaded before it was loaded\n", (unsigned long)i);
+				success = false;
+			}
+			
+			uploads.push_back(i);
+			
+			return true;
+		}));
+	}
+	
+	if (!drain(loader)) {
+		std::printf("FAILED: Ordered requests did not finish\n");
+		
+		return false;
+	}
+	
+	std::lock_guard<std::mutex> lock(mutex);
+	
+	for (std::size_t i = 0; i < COUNT; i += 1) {
+		if (!requests[i]->ready()) {
+			std::printf("FAILED: Request %lu is not ready\n", (unsigned long)i);
+			success = false;
+		}
+	}
+	
+	if (loads.size() != COUNT || uploads.size() != COUNT) {
+		std::printf("FAILED: Expected %lu loads and uploads, got %lu and %lu\n", (unsigned long)COUNT, (unsigned long)loads.size(), (unsigned long)uploads.size());
+		
+		return false;
+	}
+	
+	for (std::size_t i = 0; i < COUNT; i += 1) {
+		if (loads[i] != i || uploads[i] != i) {
+			std::printf("FAILED: Request %lu was loaded or uploaded out of order\n", (unsigned long)i);
+			
+			return false;
+		}
+	}
+	
+	std::printf("Ordering: %lu requests loaded and uploaded in order\n", (unsigned long)COUNT);
+	
+	return success;
+}
+
+static bool testCancellation () {
+	ResourceLoader loader(1);
+	Gate gate;
+	
+	std::atomic<std::size_t> loads(0), uploads(0);
+	std::atomic<bool> releasedRan(false);
+	
+	// Hold the only worker, so that the following requests are waiting when they are released:
+	RequestT blocker = loader.load([&]() {
+		gate.wait();
+		
+		return true;
+	}, ResourceLoader::UploadFunctionT());
+	
+	std::vector<RequestT> kept;
+	
+	for (std::size_t i = 0; i < 20; i += 1) {
+		bool keep = (i % 2) == 0;
+		
+		RequestT request = loader.load([&, keep]() {
+			if (!keep) releasedRan = true;
+			loads += 1;
+			
+			return true;
+		}, [&, keep]() {
+			if (!keep) releasedRan = true;
+			uploads += 1;
+			
+			return true;
+		});
+		
+		if (keep) kept.push_back(request);
+	}
+	
+	// Release a request after it has loaded, but before it is uploaded:
+	RequestT loaded = loader.load([]() {
+		return true;
+	}, [&]() {
+		releasedRan = true;
+		
+		return true;
+	});
+	
+	gate.open();
+	
+	bool success = true;
+	
+	if (!waitFor(loaded, ResourceLoader::UPLOADING)) {
+		std::printf("FAILED: Request was never loaded\n");
+		success = false;
+	}
+	
+	loaded.reset();
+	
+	if (!drain(loader)) {
+		std::printf("FAILED: Cancelled requests did not finish\n");
+		
+		return false;
+	}
+	
+	if (releasedRan) {
+		std::printf("FAILED: A released request was loaded or uploaded\n");
+		success = false;
+	}
+	
+	if (loads != kept.size() || uploads != kept.size()) {
+		std::printf("FAILED: Expected %lu loads and uploads, got %lu and %lu\n", (unsigned long)kept.size(), (unsigned long)loads.load(), (unsigned long)uploads.load());
+		success = false;
+	}
+	
+	for (std::size_t i = 0; i < kept.size(); i += 1) {
+		if (!kept[i]->ready()) {
+			std::printf("FAILED: Kept request %lu is not ready\n", (unsigned long)i);
+			success = false;
+		}
+	}
+	
+	if (!blocker->ready()) {
+		std::printf("FAILED: Request without an upload function is not ready\n");
+		success = false;
+	}
+	
+	std::printf("Cancellation: %lu of 21 requests released and skipped\n", (unsigned long)(21 - kept.size()));
+	
+	return success;
+}
+
+static bool testFailures () {
+	ResourceLoader loader(2);
+	std::atomic<bool> uploaded(false);
+	
+	RequestT requests[] = {
+		loader.load([]() {return false;}, [&]() {uploaded = true; return true;}),
+		loader.load([]() -> bool {throw std::runtime_error("load");}, [&]() {uploaded = true; return true;}),
+		loader.load([]() {return true;}, []() {return false;}),
+		loader.load([]() {return true;}, []() -> bool {throw std::runtime_error("upload");}),
+	};
+	
+	if (!drain(loader)) {
+		std::printf("FAILED: Failing requests did not finish\n");
+		
+		return false;
+	}
+	
+	bool success = true;
+	
+	for (std::size_t i = 0; i < 4; i += 1) {
+		if (requests[i]->state() != ResourceLoader::FAILED) {
+			std::printf("FAILED: Failing request %lu finished in state %d\n", (unsigned long)i, (int)requests[i]->state());
+			success = false;
+		}
+	}
+	
+	if (uploaded) {
+		std::printf("FAILED: A request which failed to load was uploaded\n");
+		success = false;
+	}
+	
+	std::printf("Failures: every failing load and upload finished the request as FAILED\n");
+	
+	return success;
+}
+
+static bool testBudget () {
+	const std::size_t COUNT = 20;
+	const double COST = 0.001, BUDGET = 0.0035;
+	
+	ResourceLoader loader(2);
+	std::vector<RequestT> requests;
+	
+	for (std::size_t i = 0; i < COUNT; i += 1) {
+		requests.push_back(loader.load([]() {return true;}, [=]() {work(COST); return true;}));
+	}
+	
+	for (std::size_t i = 0; i < COUNT; i += 1) {
+		if (!waitFor(requests[i], ResourceLoader::UPLOADING)) {
+			std::printf("FAILED: Budget request %lu was never loaded\n", (unsigned long)i);
+			
+			return false;
+		}
+	}
+	
+	bool success = true;
+	std::size_t total = 0, frames = 0;
+	double worst = 0;
+	
+	// Each upload takes 1ms, so the budget is used up by the fourth and the frame overruns it by at most one upload:
+	while (total < COUNT) {
+		ClockT::time_point start = ClockT::now();
+		std::size_t count = loader.processUploads(BUDGET);
+		double duration = elapsed(start);
+		
+		if (count == 0) {
+			std::printf("FAILED: No uploads processed with %lu outstanding\n", (unsigned long)(COUNT - total));
+			
+			return false;
+		}
+		
+		if (count > 4) {
+			std::printf("FAILED: Processed %lu uploads of %0.1fms within a budget of %0.1fms\n", (unsigned long)count, COST * 1000.0, BUDGET * 1000.0);
+			success = false;
+		}
+		
+		worst = std::max(worst, duration);
+		total += count;
+		frames += 1;
+	}
+	
+	// A budget of zero still makes progress:
+	RequestT last = loader.load([]() {return true;}, []() {return true;});
+	
+	if (!waitFor(last, ResourceLoader::UPLOADING) || loader.processUploads(0) != 1 || !last->ready()) {
+		std::printf("FAILED: A budget of zero did not process exactly one upload\n");
+		success = false;
+	}
+	
+	std::printf("Budget: %lu uploads of %0.1fms in %lu frames with a budget of %0.1fms, longest frame %0.2fms\n", (unsigned long)COUNT, COST * 1000.0, (unsigned long)frames, BUDGET * 1000.0, worst * 1000.0);
+	
+	return success;
+}
+
+static bool testStress () {
+	const std::size_t ROUNDS = 20, COUNT = 500;
+	
+	std::mt19937 generator(7);
+	std::uniform_int_distribution<int> choice(0, 9);
+	
+	bool success = true;
+	std::size_t released = 0;
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::size_t round = 0; round < ROUNDS; round += 1) {
+		ResourceLoader loader(4);
+		
+		std::vector<RequestT> requests;
+		std::vector<std::atomic<int>> loads(COUNT), uploads(COUNT);
+		std::vector<bool> kept(COUNT), fails(COUNT);
+		
+		for (std::size_t i = 0; i < COUNT; i += 1) {
+			loads[i] = 0;
+			uploads[i] = 0;
+			fails[i] = choice(generator) == 0;
+			
+			bool fail = fails[i];
+			
+			requests.push_back(loader.load([&, i, fail]() {
+				loads[i] += 1;
+				
+				return !fail;
+			}, [&, i]() {
+				uploads[i] += 1;
+				
+				return true;
+			}));
+			
+			// Interleave uploads with queueing new requests, as the render thread does:
+			if (i % 50 == 0)
+				loader.processUploads(0.0001);
+		}
+		
+		// Release some requests at random, while the workers are busy:
+		for (std::size_t i = 0; i < COUNT; i += 1) {
+			kept[i] = choice(generator) >= 3;
+			
+			if (!kept[i]) {
+				requests[i].reset();
+				released += 1;
+			}
+		}
+		
+		if (!drain(loader)) {
+			std::printf("FAILED: Round %lu did not finish\n", (unsigned long)round);
+			
+			return false;
+		}
+		
+		for (std::size_t i = 0; i < COUNT; i += 1) {
+			if (loads[i] > 1 || uploads[i] > 1) {
+				std::printf("FAILED: Request %lu was loaded %d times and uploaded %d times\n", (unsigned long)i, loads[i].load(), uploads[i].load());
+				success = false;
+			}
+			
+			if (!kept[i])
+				continue;
+			
+			ResourceLoader::State expected = fails[i] ? ResourceLoader::FAILED : ResourceLoader::READY;
+			
+			if (requests[i]->state() != expected || loads[i] != 1 || uploads[i] != (fails[i] ? 0 : 1)) {
+				std::printf("FAILED: Kept request %lu finished in state %d after %d loads and %d uploads\n", (unsigned long)i, (int)requests[i]->state(), loads[i].load(), uploads[i].load());
+				success = false;
+			}
+		}
+		
+		if (!success)
+			break;
+	}
+	
+	std::printf("Stress: %lu requests, %lu released, in %0.1fms\n", (unsigned long)(ROUNDS * COUNT), (unsigned long)released, elapsed(start) * 1000.0);
+	
+	return success;
+}
+
+static bool testShutdown () {
+	Gate gate;
+	std::atomic<bool> ran(false);
+	
+	std::unique_ptr<ResourceLoader> loader(new ResourceLoader(1));
+	
+	RequestT blocker = loader->load([&]() {gate.wait(); return true;}, ResourceLoader::UploadFunctionT());
+	RequestT pending = loader->load([&]() {ran = true; return true;}, ResourceLoader::UploadFunctionT());
+	
+	if (!waitFor(blocker, ResourceLoader::LOADING)) {
+		std::printf("FAILED: Shutdown request was never loaded\n");
+		
+		return false;
+	}
+	
+	// The destructor waits for the load in progress, which can only finish once the gate is opened, long after the destructor has started:
+	std::thread opener([&]() {
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		gate.open();
+	});
+	
+	loader.reset();
+	opener.join();
+	
+	if (ran || pending->state() != ResourceLoader::PENDING) {
+		std::printf("FAILED: A pending request was loaded during shutdown\n");
+		
+		return false;
+	}
+	
+	std::printf("Shutdown: pending requests are left unfinished\n");
+	
+	return true;
+}
+
+int main () {
+	bool success = true;
+	
+	success = testOrdering() && success;
+	success = testCancellation() && success;
+	success = testFailures() && success;
+	success = testBudget() && success;
+	success = testStress() && success;
+	success = testShutdown() && success;
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,347 @@
+//
+//  sensor-fusion-test.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Drives the lock-free sensor pipeline with synthetic producers, as the motion and camera callbacks do on the device. Several threads push numbered values through ARBrowser::ConcurrentQueue while one thread pops them, which must arrive without loss and in order for each producer. Then several motion producers and a camera producer, whose timestamps are jittered so that events arrive out of order, and one of which lags by more than the reorder window so that its events arrive late, push events through ARBrowser::FusionThread, whose handler publishes a pose through ARBrowser::Seqlock to reader threads. Every motion event must be processed exactly once, in order for each producer and in timestamp order apart from late events, and every camera frame must be either processed or coalesced, with the newest always processed. Finally, several readers load a value from a Seqlock while it is rewritten as fast as possible, and must never see a torn value or go backwards. Run it under ThreadSanitizer to check the synchronisation.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -pthread -Isource/ARBrowser tools/sensor-fusion-test.cpp -o sensor-fusion-test
+//	c++ -std=c++11 -O1 -g -fsanitize=thread -Isource/ARBrowser tools/sensor-fusion-test.cpp -o sensor-fusion-test
+//
+// Usage:
+//	sensor-fusion-test
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARConcurrentQueue.h"
+#include "ARFusionThread.h"
+#include "ARSeqlock.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+struct QueueValue {
+	std::uint32_t producer;
+	std::uint64_t sequence;
+	
+	/// Checks that values are moved through the queue and freed with it.
+	std::shared_ptr<int> payload;
+};
+
+static bool testQueue (std::size_t producerCount) {
+	const std::uint64_t VALUES = 100000;
+	
+	ConcurrentQueue<QueueValue> * queue = new ConcurrentQueue<QueueValue>;
+	std::shared_ptr<int> payload = std::make_shared<int>(0);
+	
+	ClockT::time_point start = ClockT::now();
+	std::vector<std::thread> producers;
+	
+	for (std::size_t p = 0; p < producerCount; p += 1) {
+		producers.push_back(std::thread([&, p]() {
+			for (std::uint64_t i = 1; i <= VALUES; i += 1) {
+				QueueValue value = {(std::uint32_t)p, i, payload};
+				queue->push(std::move(value));
+			}
+		}));
+	}
+	
+	// The next sequence number expected from each producer:
+	std::vector<std::uint64_t> expected(producerCount, 1);
+	std::uint64_t received = 0, reordered = 0, corrupt = 0;
+	
+	while (received < VALUES * producerCount) {
+		QueueValue value;
+		
+		if (!queue->pop(value)) {
+			std::this_thread::yield();
+			continue;
+		}
+		
+		received += 1;
+		
+		if (value.producer >= producerCount || value.payload != payload) {
+			corrupt += 1;
+		} else if (value.sequence != expected[value.producer]) {
+			reordered += 1;
+			expected[value.producer] = value.sequence + 1;
+		} else {
+			expected[value.producer] += 1;
+		}
+	}
+	
+	for (std::size_t p = 0; p < producers.size(); p += 1)
+		producers[p].join();
+	
+	double duration = elapsed(start);
+	bool success = true;
+	
+	if (corrupt || reordered || !queue->empty()) {
+		std::printf("FAILED: %lu producers: %lu corrupt values and %lu out of order, with %s left in the queue\n", (unsigned long)producerCount, (unsigned long)corrupt, (unsigned long)reordered, queue->empty() ? "nothing" : "values");
+		success = false;
+	}
+	
+	// Values left in the queue are freed with it:
+	for (std::size_t i = 0; i < 10; i += 1) {
+		QueueValue value = {0, i, payload};
+		queue->push(std::move(value));
+	}
+	
+	delete queue;
+	
+	if (payload.use_count() != 1) {
+		std::printf("FAILED: %lu values were not freed with the queue\n", (unsigned long)(payload.use_count() - 1));
+		success = false;
+	}
+	
+	std::printf("Queue, %lu producers: %lu values in %0.1fms (%0.0f per second)\n", (unsigned long)producerCount, (unsigned long)received, duration * 1000.0, received / duration);
+	
+	return success;
+}
+
+struct SensorEvent {
+	double time;
+	bool coalescable;
+	
+	std::uint32_t producer;
+	std::uint64_t sequence;
+};
+
+/// The pose published by the fusion handler. Every component is derived from the sequence number, so a torn copy can be detected.
+struct TestPose {
+	std::uint64_t sequence;
+	double rotation[4];
+	double position[3];
+	
+	void set (std::uint64_t value) {
+		sequence = value;
+		
+		for (std::size_t i = 0; i < 4; i += 1) rotation[i] = value * (i + 1);
+		for (std::size_t i = 0; i < 3; i += 1) position[i] = value * -(double)(i + 1);
+	}
+	
+	bool consistent () const {
+		TestPose expected;
+		expected.set(sequence);
+		
+		for (std::size_t i = 0; i < 4; i += 1) if (rotation[i] != expected.rotation[i]) return false;
+		for (std::size_t i = 0; i < 3; i += 1) if (position[i] != expected.position[i]) return false;
+		
+		return true;
+	}
+};
+
+/// Read the seqlock until stopped, counting values which are torn or older than the previous one.
+static void readPoses (const Seqlock<TestPose> & pose, const std::atomic<bool> & stopped, std::atomic<std::size_t> & reads, std::atomic<std::size_t> & failures) {
+	std::uint64_t previous = 0;
+	std::size_t count = 0;
+	
+	while (!stopped.load(std::memory_order_relaxed)) {
+		TestPose value = pose.load();
+		count += 1;
+		
+		if (!value.consistent() || value.sequence < previous)
+			failures += 1;
+		
+		previous = value.sequence;
+	}
+	
+	reads += count;
+}
+
+static bool testFusion () {
+	const std::size_t MOTION_PRODUCERS = 3, READERS = 2;
+	const std::uint64_t MOTION_EVENTS = 4000, CAMERA_FRAMES = 400;
+	const std::uint32_t CAMERA = MOTION_PRODUCERS;
+	const double WINDOW = 0.005, JITTER = 0.002;
+	
+	std::vector<SensorEvent> processed;
+	Seqlock<TestPose> pose;
+	std::uint64_t published = 0;
+	
+	FusionThread<SensorEvent> fusion([&](SensorEvent & event) {
+		processed.push_back(event);
+		
+		TestPose value;
+		value.set(++published);
+		pose.store(value);
+	}, WINDOW);
+	
+	std::atomic<bool> stopped(false);
+	std::atomic<std::size_t> reads(0), torn(0);
+	std::vector<std::thread> readers;
+	
+	for (std::size_t r = 0; r < READERS; r += 1)
+		readers.push_back(std::thread([&]() { readPoses(pose, stopped, reads, torn); }));
+	
+	fusion.start();
+	
+	ClockT::time_point start = ClockT::now();
+	std::vector<std::thread> producers;
+	
+	for (std::uint32_t p = 0; p <= CAMERA; p += 1) {
+		producers.push_back(std::thread([&, p]() {
+			std::mt19937 generator(p + 1);
+			std::uniform_real_distribution<double> jitter(0, JITTER);
+			
+			bool camera = (p == CAMERA);
+			std::uint64_t count = camera ? CAMERA_FRAMES : MOTION_EVENTS;
+			std::chrono::microseconds interval(camera ? 1000 : 100);
+			double previous = 0;
+			
+			for (std::uint64_t i = 1; i <= count; i += 1) {
+				// Each source's timestamps increase, but lag the clock by a varying amount, so sources arrive out of order with respect to each other. The first source lags by more than the window, so many of its events arrive late:
+				double lag = jitter(generator) + (p == 0 ? WINDOW * 2 : 0);
+				double time = std::max(previous, elapsed(start) - lag);
+				previous = time;
+				
+				SensorEvent event = {time, camera, p, i};
+				fusion.push(event);
+				
+				std::this_thread::sleep_for(interval);
+			}
+		}));
+	}
+	
+	for (std::size_t p = 0; p < producers.size(); p += 1)
+		producers[p].join();
+	
+	// Every event pushed before stopping is processed:
+	fusion.stop();
+	
+	stopped = true;
+	
+	for (std::size_t r = 0; r < readers.size(); r += 1)
+		readers[r].join();
+	
+	FusionThread<SensorEvent>::Statistics statistics = fusion.statistics();
+	bool success = true;
+	
+	std::vector<std::uint64_t> expected(MOTION_PRODUCERS, 1);
+	std::uint64_t lastFrame = 0, reordered = 0, outOfTime = 0, frames = 0;
+	double latest = 0;
+	
+	for (std::size_t i = 0; i < processed.size(); i += 1) {
+		const SensorEvent & event = processed[i];
+		
+		if (event.producer == CAMERA) {
+			// Frames may be coalesced, but are never processed out of order:
+			if (event.sequence <= lastFrame) reordered += 1;
+			
+			lastFrame = event.sequence;
+			frames += 1;
+		} else {
+			if (event.sequence != expected[event.producer]) reordered += 1;
+			
+			expected[event.producer] = event.sequence + 1;
+		}
+		
+		if (event.time < latest) outOfTime += 1;
+		
+		latest = std::max(latest, event.time);
+	}
+	
+	for (std::size_t p = 0; p < MOTION_PRODUCERS; p += 1) {
+		if (expected[p] != MOTION_EVENTS + 1) {
+			std::printf("FAILED: Motion producer %lu: only %lu of %lu events were processed in order\n", (unsigned long)p, (unsigned long)(expected[p] - 1), (unsigned long)MOTION_EVENTS);
+			success = false;
+		}
+	}
+	
+	if (reordered) {
+		std::printf("FAILED: %lu events were processed out of order for their producer\n", (unsigned long)reordered);
+		success = false;
+	}
+	
+	// Only events which arrived after a later event was processed may go back in time:
+	if (outOfTime > statistics.late) {
+		std::printf("FAILED: %lu events were processed out of timestamp order, but only %lu arrived late\n", (unsigned long)outOfTime, (unsigned long)statistics.late);
+		success = false;
+	}
+	
+	if (frames + statistics.coalesced != CAMERA_FRAMES || lastFrame != CAMERA_FRAMES || statistics.processed != processed.size()) {
+		std::printf("FAILED: %lu frames processed and %lu coalesced of %lu, the last being %lu\n", (unsigned long)frames, (unsigned long)statistics.coalesced, (unsigned long)CAMERA_FRAMES, (unsigned long)lastFrame);
+		success = false;
+	}
+	
+	if (torn) {
+		std::printf("FAILED: %lu poses read by the readers were torn or went backwards\n", (unsigned long)torn.load());
+		success = false;
+	}
+	
+	if (pose.load().sequence != processed.size()) {
+		std::printf("FAILED: The final pose is %lu, but %lu events were processed\n", (unsigned long)pose.load().sequence, (unsigned long)processed.size());
+		success = false;
+	}
+	
+	std::printf("Fusion: %lu events processed, %lu coalesced and %lu late, while %lu poses were read\n", (unsigned long)statistics.processed, (unsigned long)statistics.coalesced, (unsigned long)statistics.late, (unsigned long)reads.load());
+	
+	return success;
+}
+
+static bool testSeqlock (std::size_t readerCount) {
+	const std::uint64_t WRITES = 200000;
+	
+	Seqlock<TestPose> pose;
+	std::atomic<bool> stopped(false);
+	std::atomic<std::size_t> reads(0), torn(0);
+	std::vector<std::thread> readers;
+	
+	for (std::size_t r = 0; r < readerCount; r += 1)
+		readers.push_back(std::thread([&]() { readPoses(pose, stopped, reads, torn); }));
+	
+	ClockT::time_point start = ClockT::now();
+	
+	for (std::uint64_t i = 1; i <= WRITES; i += 1) {
+		TestPose value;
+		value.set(i);
+		pose.store(value);
+	}
+	
+	double duration = elapsed(start);
+	
+	stopped = true;
+	
+	for (std::size_t r = 0; r < readers.size(); r += 1)
+		readers[r].join();
+	
+	bool success = true;
+	
+	if (torn || pose.load().sequence != WRITES) {
+		std::printf("FAILED: %lu readers: %lu values were torn or went backwards\n", (unsigned long)readerCount, (unsigned long)torn.load());
+		success = false;
+	}
+	
+	std::printf("Seqlock, %lu readers: %lu writes in %0.1fms, %lu reads\n", (unsigned long)readerCount, (unsigned long)WRITES, duration * 1000.0, (unsigned long)reads.load());
+	
+	return success;
+}
+
+int main () {
+	bool success = true;
+	
+	success = testQueue(1) && success;
+	success = testQueue(4) && success;
+	success = testFusion() && success;
+	success = testSeqlock(1) && success;
+	success = testSeqlock(3) && success;
+	
+	return success ? 0 : 1;
+}
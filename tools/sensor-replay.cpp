@@ -0,0 +1,238 @@
+//
+//  sensor-replay.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Replays a .arsensors log, recorded by setting ARMotionModelController.recordingPath, through a TransformFlow motion model. Reports the throughput of the motion model, the time taken by each kind of update, and the final pose. The pose after every update can be written to a file, which can be compared between builds to check that a change doesn't affect tracking.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser -I$(TEAPOT_PLATFORM_PATH)/include tools/sensor-replay.cpp source/ARBrowser/ARSensorLog.cpp source/ARBrowser/ARMappedFile.cpp -L$(TEAPOT_PLATFORM_PATH)/lib -lTransformFlow -lDreamImaging -lDream -lopencv_video -lopencv_imgproc -lopencv_core -o sensor-replay
+//
+// Usage:
+//	sensor-replay [--realtime] [--basic] [--trajectory trajectory.csv] walk.arsensors
+//
+// By default updates are replayed as fast as possible. With --realtime, they are replayed at the rate they were recorded. The HybridMotionModel is used unless --basic is given, in which case the BasicSensorMotionModel is used.
+
+#include "ARSensorLog.h"
+
+#include <TransformFlow/BasicSensorMotionModel.h>
+#include <TransformFlow/HybridMotionModel.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+static void update (TransformFlow::MotionModel & motionModel, const SensorLogReader::Record & record) {
+	switch (record.kind) {
+		case SENSOR_MOTION: {
+			const SensorMotion & motion = record.motion();
+			TransformFlow::MotionUpdate motion_update;
+			
+			for (std::size_t i = 0; i < 3; i += 1) {
+				motion_update.gravity[i] = motion.gravity[i];
+				motion_update.rotation_rate[i] = motion.rotationRate[i];
+				motion_update.acceleration[i] = motion.acceleration[i];
+			}
+			
+			motion_update.time_offset = record.time;
+			
+			motionModel.update(motion_update);
+			break;
+		}
+		case SENSOR_LOCATION: {
+			const SensorLocation & location = record.location();
+			TransformFlow::LocationUpdate location_update;
+			
+			location_update.time_offset = record.time;
+			
+			location_update.latitude = location.latitude;
+			location_update.longitude = location.longitude;
+			
+			location_update.horizontal_accuracy = location.horizontalAccuracy;
+			location_update.vertical_accuracy = location.verticalAccuracy;
+			
+			motionModel.update(location_update);
+			break;
+		}
+		case SENSOR_HEADING: {
+			const SensorHeading & heading = record.heading();
+			TransformFlow::HeadingUpdate heading_update;
+			
+			heading_update.time_offset = record.time;
+			
+			heading_update.true_bearing = heading.trueBearing;
+			heading_update.magnetic_bearing = heading.magneticBearing;
+			
+			motionModel.update(heading_update);
+			break;
+		}
+		case SENSOR_IMAGE: {
+			const SensorImage & image = record.image();
+			TransformFlow::ImageUpdate image_update;
+			
+			Dream::Imaging::PixelFormat pixelFormat = image.channels == 1 ? Dream::Imaging::PixelFormat::L : Dream::Imaging::PixelFormat::BGRA;
+			image_update.image_buffer = new Dream::Imaging::Image({image.width, image.height}, pixelFormat, Dream::Imaging::DataType::BYTE);
+			
+			Dream::Core::StaticBuffer pixel_buffer(record.pixels(), (std::size_t)image.width * image.height * image.channels);
+			image_update.image_buffer->buffer().assign(pixel_buffer);
+			
+			image_update.time_offset = record.time;
+			image_update.field_of_view = TransformFlow::degrees(image.fieldOfView);
+			
+			motionModel.update(image_update);
+			break;
+		}
+	}
+}
+
+int main (int argc, char ** argv) {
+	bool realtime = false, basic = false;
+	const char * trajectoryPath = NULL;
+	const char * logPath = NULL;
+	
+	for (int i = 1; i < argc; i += 1) {
+		if (std::strcmp(argv[i], "--realtime") == 0)
+			realtime = true;
+		else if (std::strcmp(argv[i], "--basic") == 0)
+			basic = true;
+		else if (std::strcmp(argv[i], "--trajectory") == 0 && i + 1 < argc)
+			trajectoryPath = argv[++i];
+		else
+			logPath = argv[i];
+	}
+	
+	if (!logPath) {
+		std::fprintf(stderr, "Usage: %s [--realtime] [--basic] [--trajectory trajectory.csv] walk.arsensors\n", argv[0]);
+		return 1;
+	}
+	
+	SensorLogReader log;
+	
+	if (!log.open(logPath))
+		return 1;
+	
+	std::FILE * trajectory = NULL;
+	
+	if (trajectoryPath) {
+		trajectory = std::fopen(trajectoryPath, "w");
+		
+		if (!trajectory) {
+			std::fprintf(stderr, "Couldn't open %s for writing!\n", trajectoryPath);
+			return 1;
+		}
+		
+		std::fprintf(trajectory, "time,kind,latitude,longitude,altitude,bearing,valid\n");
+	}
+	
+	Dream::Ref<TransformFlow::MotionModel> motionModel;
+	
+	if (basic)
+		motionModel = new TransformFlow::BasicSensorMotionModel;
+	else
+		motionModel = new TransformFlow::HybridMotionModel;
+	
+	// The time taken by each update, in seconds, by kind:
+	std::vector<double> durations[SENSOR_KINDS];
+	std::size_t skipped = 0;
+	
+	SensorLogReader::Record record;
+	double firstTime = 0, lastTime = 0, lateness = 0;
+	bool first = true;
+	
+	ClockT::time_point start = ClockT::now();
+	double busy = 0;
+	
+	while (log.next(record)) {
+		if (record.kind == 0 || record.kind >= SENSOR_KINDS) {
+			skipped += 1;
+			continue;
+		}
+		
+		if (first) {
+			firstTime = record.time;
+			first = false;
+		}
+		
+		lastTime = record.time;
+		
+		if (realtime) {
+			ClockT::time_point due = start + std::chrono::duration_cast<ClockT::duration>(std::chrono::duration<double>(record.time - firstTime));
+			
+			if (ClockT::now() < due)
+				std::this_thread::sleep_until(due);
+			else
+				lateness = std::max(lateness, std::chrono::duration<double>(ClockT::now() - due).count());
+		}
+		
+		ClockT::time_point before = ClockT::now();
+		update(*motionModel, record);
+		double duration = elapsed(before);
+		
+		durations[record.kind].push_back(duration);
+		busy += duration;
+		
+		if (trajectory) {
+			auto position = motionModel->position();
+			
+			std::fprintf(trajectory, "%0.6f,%s,%0.9f,%0.9f,%0.3f,%0.6f,%d\n", record.time, sensorKindName(record.kind), (double)position[0], (double)position[1], (double)position[2], (double)(motionModel->bearing() * TransformFlow::R2D), motionModel->localization_valid() ? 1 : 0);
+		}
+	}
+	
+	double total = elapsed(start);
+	
+	if (trajectory)
+		std::fclose(trajectory);
+	
+	std::size_t count = 0;
+	
+	for (std::size_t kind = 1; kind < SENSOR_KINDS; kind += 1)
+		count += durations[kind].size();
+	
+	std::printf("Log: %s, %lu updates over %0.1fs of recording\n", logPath, (unsigned long)count, lastTime - firstTime);
+	
+	if (log.truncated())
+		std::printf("Log: the last record is incomplete, and was ignored\n");
+	
+	if (skipped)
+		std::printf("Log: %lu records of unknown kinds were skipped\n", (unsigned long)skipped);
+	
+	std::printf("Model: %s\n", basic ? "BasicSensorMotionModel" : "HybridMotionModel");
+	std::printf("Throughput: %0.0f updates/s in the motion model, %0.0f updates/s overall in %0.2fs\n", count / busy, count / total, total);
+	
+	if (realtime)
+		std::printf("Realtime: at most %0.2fms behind the recording\n", lateness * 1000.0);
+	
+	for (std::size_t kind = 1; kind < SENSOR_KINDS; kind += 1) {
+		std::vector<double> & samples = durations[kind];
+		
+		if (samples.empty())
+			continue;
+		
+		std::sort(samples.begin(), samples.end());
+		
+		double sum = 0;
+		for (std::size_t i = 0; i < samples.size(); i += 1)
+			sum += samples[i];
+		
+		std::printf("Latency (%s): %lu updates, mean %0.1fus, p50 %0.1fus, p99 %0.1fus, max %0.1fus\n", sensorKindName(kind), (unsigned long)samples.size(), sum / samples.size() * 1e6, samples[samples.size() / 2] * 1e6, samples[samples.size() * 99 / 100] * 1e6, samples.back() * 1e6);
+	}
+	
+	auto position = motionModel->position();
+	std::printf("Final pose: latitude %0.9f, longitude %0.9f, altitude %0.3f, bearing %0.6f, localization %s\n", (double)position[0], (double)position[1], (double)position[2], (double)(motionModel->bearing() * TransformFlow::R2D), motionModel->localization_valid() ? "valid" : "invalid");
+	
+	return 0;
+}
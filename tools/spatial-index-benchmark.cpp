@@ -0,0 +1,121 @@
+//
+//  spatial-index-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Measures the latency of ARBrowser::SpatialIndex queries against the number of indexed points, compared with the linear scan which ARBrowserView used to do every frame. Results of both are checked against each other.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/spatial-index-benchmark.cpp source/ARBrowser/ARSpatialIndex.cpp -o spatial-index-benchmark
+//
+// Usage:
+//	spatial-index-benchmark [query distance in meters, default 1000]
+
+#include "ARSpatialIndex.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <random>
+
+using namespace ARBrowser;
+
+struct Point {
+	double latitude, longitude;
+};
+
+static const double D2R = M_PI / 180.0;
+
+// The same haversine formula as calculateDistanceBetween:
+static double haversineDistance (const Point & a, const Point & b) {
+	double sx = std::sin((b.latitude - a.latitude) * D2R / 2.0), sy = std::sin((b.longitude - a.longitude) * D2R / 2.0);
+	double t = sx*sx + std::cos(a.latitude * D2R) * std::cos(b.latitude * D2R) * sy*sy;
+	
+	return SpatialIndex::RADIUS * 2.0 * std::atan2(std::sqrt(t), std::sqrt(1.0 - t));
+}
+
+int main (int argc, char ** argv) {
+	typedef std::chrono::steady_clock ClockT;
+	
+	double distance = argc > 1 ? std::atof(argv[1]) : 1000.0;
+	
+	// Points are scattered over a city sized area, roughly 20km across:
+	const Point center = {-43.5321, 172.6362};
+	const double extent = 0.1;
+	const std::size_t QUERIES = 1000;
+	
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> offset(-extent, extent);
+	
+	std::cout << std::setw(10) << "points" << std::setw(12) << "results" << std::setw(14) << "index (us)" << std::setw(14) << "p99 (us)" << std::setw(14) << "linear (us)" << std::endl;
+	
+	std::size_t sizes[] = {1000, 10000, 50000, 100000, 500000};
+	
+	for (std::size_t size : sizes) {
+		std::vector<Point> points(size);
+		SpatialIndex index;
+		
+		for (std::size_t i = 0; i < size; i += 1) {
+			points[i].latitude = center.latitude + offset(generator);
+			points[i].longitude = center.longitude + offset(generator);
+			
+			index.insert(&points[i], points[i].latitude, points[i].longitude);
+		}
+		
+		std::vector<double> latencies;
+		std::vector<SpatialIndex::HandleT> results;
+		std::size_t total = 0;
+		double linearTime = 0;
+		
+		for (std::size_t q = 0; q < QUERIES; q += 1) {
+			Point origin = {center.latitude + offset(generator), center.longitude + offset(generator)};
+			
+			results.clear();
+			
+			ClockT::time_point start = ClockT::now();
+			index.query(origin.latitude, origin.longitude, distance, results);
+			latencies.push_back(std::chrono::duration<double, std::micro>(ClockT::now() - start).count());
+			
+			total += results.size();
+			
+			// The linear scan is slow, so only run it for some of the queries:
+			if (q % 10 == 0) {
+				std::size_t expected = 0;
+				
+				start = ClockT::now();
+				for (std::size_t i = 0; i < size; i += 1) {
+					double d = haversineDistance(origin, points[i]);
+					
+					// Allow for rounding differences right on the boundary:
+					if (d <= distance * (1.0 - 1e-9))
+						expected += 1;
+					else if (d <= distance * (1.0 + 1e-9))
+						expected += std::count(results.begin(), results.end(), &points[i]);
+				}
+				linearTime += std::chrono::duration<double, std::micro>(ClockT::now() - start).count();
+				
+				if (expected != results.size()) {
+					std::cerr << "Query returned " << results.size() << " points, expected " << expected << "!" << std::endl;
+					
+					return 1;
+				}
+			}
+		}
+		
+		std::sort(latencies.begin(), latencies.end());
+		
+		double mean = 0;
+		for (double latency : latencies) mean += latency;
+		mean /= latencies.size();
+		
+		std::cout << std::setw(10) << size << std::setw(12) << (total / QUERIES) << std::fixed << std::setprecision(1) << std::setw(14) << mean << std::setw(14) << latencies[latencies.size() * 99 / 100] << std::setw(14) << (linearTime / (QUERIES / 10)) << std::endl;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,377 @@
+//
+//  texture-compression-benchmark.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Compresses generated images with ARBrowser::encodePVRTC, decompresses every mip level on the CPU and checks the error against the source, checks images which the encoder must reject or repeat, and checks that textures survive a round trip through a .artex file and that corrupt files are rejected. Then compares the time to compress a large texture, and the time to read and the texture memory of the levels which are uploaded, for RGBA8 as loaded by GLKTextureLoader and for PVRTC.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -Isource/ARBrowser tools/texture-compression-benchmark.cpp source/ARBrowser/ARBakedTexture.cpp source/ARBrowser/ARTextureCompression.cpp source/ARBrowser/ARMappedFile.cpp -o texture-compression-benchmark
+//
+// Usage:
+//	texture-compression-benchmark [directory]
+//
+// Temporary .artex files are written to the directory, which defaults to the current directory, and removed afterwards. Exits with a non-zero status if any check fails.
+
+#include "ARBakedTexture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <random>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// The smallest peak signal to noise ratio accepted for the levels after the first, in decibels, which catches gross errors such as blocks in the wrong order. Levels smaller than 8x8 are repeated to fill 8x8, so every pixel blends the same pair of colours, which can't follow a gradient in two directions, and they are only reported.
+static const double MINIMUM_MIP_PSNR = 16.0;
+
+static std::uint8_t clampChannel (double value) {
+	return (std::uint8_t)std::max(0.0, std::min(255.0, value + 0.5));
+}
+
+/// Smooth changes of colour in two directions, like the sky or a painted wall.
+static TextureImage generateGradient (std::uint32_t size) {
+	TextureImage image(size, size);
+	
+	for (std::uint32_t y = 0; y < size; y += 1) {
+		for (std::uint32_t x = 0; x < size; x += 1) {
+			std::uint8_t * pixel = image.pixel(x, y);
+			double u = double(x) / size, v = double(y) / size;
+			
+			pixel[0] = clampChannel(255 * u);
+			pixel[1] = clampChannel(255 * v);
+			pixel[2] = clampChannel(128 + 100 * std::sin(6.0 * (u + v)));
+			pixel[3] = 255;
+		}
+	}
+	
+	return image;
+}
+
+/// Overlapping waves of varying frequency with a little noise, like the detail of a photograph.
+static TextureImage generateDetail (std::uint32_t size, std::mt19937 & generator) {
+	std::normal_distribution<double> noise(0.0, 3.0);
+	TextureImage image(size, size);
+	
+	for (std::uint32_t y = 0; y < size; y += 1) {
+		for (std::uint32_t x = 0; x < size; x += 1) {
+			std::uint8_t * pixel = image.pixel(x, y);
+			double u = 2.0 * M_PI * x / size, v = 2.0 * M_PI * y / size;
+			double luminance = 120 + 50 * std::sin(3 * u + 2 * v) + 30 * std::sin(11 * u - 7 * v) + 15 * std::cos(23 * v);
+			
+			pixel[0] = clampChannel(luminance * 1.1 + noise(generator));
+			pixel[1] = clampChannel(luminance * 0.9 + noise(generator));
+			pixel[2] = clampChannel(luminance * 0.7 + 20 * std::sin(5 * u) + noise(generator));
+			pixel[3] = 255;
+		}
+	}
+	
+	return image;
+}
+
+/// A disc with a soft edge on a transparent background, like a sign or an icon, whose transparent pixels are black.
+static TextureImage generateDisc (std::uint32_t size) {
+	TextureImage image(size, size);
+	double radius = size * 0.4, edge = size / 64.0;
+	
+	for (std::uint32_t y = 0; y < size; y += 1) {
+		for (std::uint32_t x = 0; x < size; x += 1) {
+			std::uint8_t * pixel = image.pixel(x, y);
+			double dx = x + 0.5 - size / 2.0, dy = y + 0.5 - size / 2.0, distance = std::sqrt(dx * dx + dy * dy);
+			double coverage = std::max(0.0, std::min(1.0, (radius - distance) / edge + 0.5));
+			
+			if (coverage > 0) {
+				pixel[0] = clampChannel(220 - 100 * distance / radius);
+				pixel[1] = clampChannel(60 + 120 * distance / radius);
+				pixel[2] = 40;
+			}
+			
+			pixel[3] = clampChannel(255 * coverage);
+		}
+	}
+	
+	return image;
+}
+
+/// A single colour, which should be almost exactly preserved.
+static TextureImage generateSolid (std::uint32_t size) {
+	TextureImage image(size, size);
+	
+	for (std::size_t i = 0; i < image.pixels.size(); i += 4) {
+		image.pixels[i] = 200;
+		image.pixels[i + 1] = 120;
+		image.pixels[i + 2] = 30;
+		image.pixels[i + 3] = 255;
+	}
+	
+	return image;
+}
+
+/// Compress and decompress every level of the image, and check that the error of the first level is within the given bound.
+static bool testQuality (const char * name, const TextureImage & image, double minimum) {
+	std::vector<TextureImage> levels;
+	buildMipChain(image, levels);
+	
+	bool success = true;
+	double worst = INFINITY;
+	
+	std::vector<std::uint8_t> data;
+	TextureImage decoded;
+	
+	for (std::size_t i = 0; i < levels.size(); i += 1) {
+		if (!encodePVRTC(levels[i], data) || data.size() != pvrtcSize(levels[i].width, levels[i].height)) {
+			std::printf("FAILED: couldn't compress level %lu\n", (unsigned long)i);
+			
+			return false;
+		}
+		
+		decodePVRTC(&data[0], levels[i].width, levels[i].height, decoded);
+		
+		double psnr = peakSignalToNoise(decoded, levels[i]);
+		
+		if (i == 0) {
+			std::printf("%s, %ux%u: %0.1fdB (minimum %0.0fdB)", name, image.width, image.height, psnr, minimum);
+			
+			if (psnr < minimum) {
+				std::printf("\nFAILED: the first level is below the minimum\n");
+				success = false;
+			}
+		} else if (levels[i].width >= 8) {
+			worst = std::min(worst, psnr);
+			
+			if (psnr < MINIMUM_MIP_PSNR) {
+				std::printf("\nFAILED: level %lu is %0.1fdB\n", (unsigned long)i, psnr);
+				success = false;
+			}
+		}
+	}
+	
+	std::printf(", worst other level from 8x8 %0.1fdB\n", worst);
+	
+	return success;
+}
+
+/// Images whose sides aren't powers of two must be rejected, and images smaller than 8x8 are repeated to fill the smallest size the GPU accepts.
+static bool testSizes (std::mt19937 & generator) {
+	bool success = true;
+	std::vector<std::uint8_t> data;
+	
+	if (encodePVRTC(TextureImage(48, 32), data) || encodePVRTC(TextureImage(0, 0), data)) {
+		std::printf("FAILED: compressed an image whose sides aren't powers of two\n");
+		success = false;
+	}
+	
+	TextureImage solid = generateSolid(8), decoded;
+	
+	for (std::uint32_t size = 1; size <= 4; size *= 2) {
+		TextureImage small;
+		resizeImage(solid, size, size, small);
+		
+		if (!encodePVRTC(small, data) || data.size() != 32 || pvrtcSize(size, size) != 32) {
+			std::printf("FAILED: a %ux%u image wasn't compressed into 32 bytes\n", size, size);
+			success = false;
+			
+			continue;
+		}
+		
+		decodePVRTC(&data[0], size, size, decoded);
+		
+		if (peakSignalToNoise(decoded, small) < 38) {
+			std::printf("FAILED: a %ux%u image of a single colour wasn't preserved\n", size, size);
+			success = false;
+		}
+	}
+	
+	// Rectangular images are valid PVRTC, although iOS only accepts square ones. The detail repeats seamlessly, as PVRTC blends opposite edges:
+	TextureImage detail = generateDetail(64, generator), wide;
+	resizeImage(detail, 64, 16, wide);
+	
+	if (!encodePVRTC(wide, data) || data.size() != pvrtcSize(64, 16)) {
+		std::printf("FAILED: couldn't compress a rectangular image\n");
+		success = false;
+	} else {
+		decodePVRTC(&data[0], 64, 16, decoded);
+		std::printf("Rectangular detail, 64x16: %0.1fdB\n", peakSignalToNoise(decoded, wide));
+		
+		if (peakSignalToNoise(decoded, wide) < 28) {
+			std::printf("FAILED: rectangular image below 28dB\n");
+			success = false;
+		}
+	}
+	
+	return success;
+}
+
+static bool testBaking (const std::string & directory, const TextureImage & image) {
+	std::vector<TextureImage> levels;
+	buildMipChain(image, levels);
+	
+	std::string path = directory + "/texture-compression.artex", compressedPath = directory + "/texture-compression-compressed.artex", truncatedPath = directory + "/texture-compression-truncated.artex";
+	bool success = true;
+	
+	if (bakedTexturePath("models/coffee/coffee.png") != "models/coffee/coffee.artex" || bakedTexturePath("models/coffee.v2/texture") != "models/coffee.v2/texture.artex") {
+		std::printf("FAILED: baked texture path\n");
+		success = false;
+	}
+	
+	// A mip chain which doesn't end at 1x1 must be rejected:
+	std::vector<TextureImage> incomplete(levels.begin(), levels.end() - 1);
+	
+	if (writeBakedTexture(path, incomplete)) {
+		std::printf("FAILED: wrote an incomplete mip chain\n");
+		success = false;
+	}
+	
+	BakedTexture baked, compressed;
+	
+	if (!writeBakedTexture(path, levels) || !writeBakedTexture(compressedPath, levels, false) || !baked.open(path) || !compressed.open(compressedPath)) {
+		std::printf("FAILED: couldn't write and open the baked textures\n");
+		std::remove(path.c_str());
+		std::remove(compressedPath.c_str());
+		
+		return false;
+	}
+	
+	const BakedTextureLevel * pvrtc = baked.levels(BAKED_TEXTURE_PVRTC_4BPP), * rgba = baked.levels(BAKED_TEXTURE_RGBA8);
+	
+	if (baked.width() != image.width || baked.height() != image.height || baked.levelCount() != levels.size() || !pvrtc || !rgba || compressed.levels(BAKED_TEXTURE_RGBA8) != NULL) {
+		std::printf("FAILED: baked texture has the wrong size, levels or formats\n");
+		success = false;
+	} else {
+		std::vector<std::uint8_t> data;
+		
+		for (std::size_t i = 0; i < levels.size(); i += 1) {
+			encodePVRTC(levels[i], data);
+			
+			const BakedTextureLevel & level = compressed.levels(BAKED_TEXTURE_PVRTC_4BPP)[i];
+			
+			bool equal = pvrtc[i].size == data.size() && std::memcmp(baked.data(pvrtc[i]), &data[0], data.size()) == 0
+				&& level.size == data.size() && std::memcmp(compressed.data(level), &data[0], data.size()) == 0
+				&& rgba[i].size == levels[i].pixels.size() && std::memcmp(baked.data(rgba[i]), &levels[i].pixels[0], levels[i].pixels.size()) == 0
+				&& ((std::uintptr_t)baked.data(pvrtc[i]) % 16) == 0 && ((std::uintptr_t)baked.data(rgba[i]) % 16) == 0;
+			
+			if (!equal) {
+				std::printf("FAILED: baked level %lu differs\n", (unsigned long)i);
+				success = false;
+			}
+		}
+	}
+	
+	std::printf("Baked %ux%u, %lu levels: %lu bytes with the uncompressed levels, %lu bytes without\n", image.width, image.height, (unsigned long)levels.size(), (unsigned long)baked.fileSize(), (unsigned long)compressed.fileSize());
+	
+	// Copies truncated within the header, the level records and the data must be rejected rather than read beyond the end of the file:
+	std::ifstream input(compressedPath.c_str(), std::ios::binary);
+	std::vector<char> file((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	
+	const std::size_t sizes[4] = {sizeof(BakedTextureHeader) - 1, sizeof(BakedTextureHeader) + sizeof(BakedTextureLevel), file.size() / 2, file.size() - 1};
+	
+	for (std::size_t size : sizes) {
+		std::ofstream(truncatedPath.c_str(), std::ios::binary).write(file.data(), size);
+		
+		BakedTexture truncated;
+		
+		if (truncated.open(truncatedPath)) {
+			std::printf("FAILED: opened a baked texture truncated to %lu bytes\n", (unsigned long)size);
+			success = false;
+		}
+	}
+	
+	baked.close();
+	compressed.close();
+	
+	std::remove(path.c_str());
+	std::remove(compressedPath.c_str());
+	std::remove(truncatedPath.c_str());
+	
+	return success;
+}
+
+/// Reads every byte which would be uploaded, as glTexImage2D or glCompressedTexImage2D would.
+static std::uint32_t readBytes (const std::uint8_t * data, std::size_t size) {
+	std::uint32_t sum = 0;
+	
+	for (std::size_t i = 0; i < size; i += 1)
+		sum += data[i];
+	
+	return sum;
+}
+
+static void benchmarkLoading (const std::string & directory, const TextureImage & image) {
+	const std::size_t ITERATIONS = 20;
+	
+	std::vector<TextureImage> levels;
+	buildMipChain(image, levels);
+	
+	std::string path = directory + "/texture-compression-benchmark.artex";
+	
+	ClockT::time_point start = ClockT::now();
+	writeBakedTexture(path, levels, false);
+	double encodeTime = elapsed(start);
+	
+	volatile std::uint32_t sink = 0;
+	std::size_t compressedSize = 0, mippedSize = 0;
+	
+	start = ClockT::now();
+	
+	for (std::size_t i = 0; i < ITERATIONS; i += 1)
+		sink = sink + readBytes(&image.pixels[0], image.pixels.size());
+	
+	double uncompressedTime = elapsed(start) / ITERATIONS;
+	
+	start = ClockT::now();
+	
+	for (std::size_t i = 0; i < ITERATIONS; i += 1) {
+		BakedTexture baked;
+		baked.open(path);
+		
+		const BakedTextureLevel * pvrtc = baked.levels(BAKED_TEXTURE_PVRTC_4BPP);
+		compressedSize = 0;
+		
+		for (std::size_t j = 0; j < baked.levelCount(); j += 1) {
+			sink = sink + readBytes(baked.data(pvrtc[j]), pvrtc[j].size);
+			compressedSize += pvrtc[j].size;
+		}
+	}
+	
+	double compressedTime = elapsed(start) / ITERATIONS;
+	
+	for (std::size_t i = 0; i < levels.size(); i += 1)
+		mippedSize += levels[i].pixels.size();
+	
+	std::printf("Compressing %ux%u with %lu levels: %0.0fms\n", image.width, image.height, (unsigned long)levels.size(), encodeTime * 1000.0);
+	std::printf("Reading the uploaded levels: %0.2fms for RGBA8 without mip levels, %0.2fms for PVRTC with mip levels, from the mapped file\n", uncompressedTime * 1000.0, compressedTime * 1000.0);
+	std::printf("Texture memory: %lu bytes as RGBA8 without mip levels, %lu bytes as RGBA8 with mip levels, %lu bytes as PVRTC with mip levels (%0.1f%%)\n", (unsigned long)image.pixels.size(), (unsigned long)mippedSize, (unsigned long)compressedSize, 100.0 * compressedSize / image.pixels.size());
+	
+	std::remove(path.c_str());
+}
+
+int main (int argc, char ** argv) {
+	std::string directory = argc > 1 ? argv[1] : ".";
+	std::mt19937 generator(42);
+	
+	bool success = true;
+	
+	success = testQuality("Solid colour", generateSolid(64), 38) && success;
+	success = testQuality("Gradient", generateGradient(256), 36) && success;
+	success = testQuality("Detail", generateDetail(256, generator), 30) && success;
+	success = testQuality("Disc with alpha", generateDisc(256), 30) && success;
+	success = testSizes(generator) && success;
+	success = testBaking(directory, generateDisc(128)) && success;
+	
+	benchmarkLoading(directory, generateDetail(1024, generator));
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+//
+//  triple-buffer-test.cpp
+//  This file is part of the "transform-flow" project, and is released under the MIT license.
+//
+//  Created by Samuel Williams on 17/10/26.
+//  Copyright, 2026, by Samuel G. D. Williams.
+//
+
+// Passes values from one producer thread to one consumer thread through ARBrowser::TripleBuffer, as the camera callback does with video frames, with either side running faster. Each value is filled with its sequence number, so the consumer checks that it never sees a value which is partly written, that sequence numbers only increase, and that the dropped count matches the values it skipped. Once the producer has finished, the newest value must still be acquired, and every published value must have been either acquired or dropped. Run it under ThreadSanitizer to check the synchronisation.
+//
+// Build from the repository root, e.g.:
+//	c++ -std=c++11 -O2 -pthread -Isource/ARBrowser tools/triple-buffer-test.cpp -o triple-buffer-test
+//	c++ -std=c++11 -O1 -g -fsanitize=thread -Isource/ARBrowser tools/triple-buffer-test.cpp -o triple-buffer-test
+//
+// Usage:
+//	triple-buffer-test
+//
+// Exits with a non-zero status if any check fails.
+
+#include "ARTripleBuffer.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace ARBrowser;
+
+typedef std::chrono::steady_clock ClockT;
+
+static double elapsed (ClockT::time_point start) {
+	return std::chrono::duration<double>(ClockT::now() - start).count();
+}
+
+/// A value large enough that a torn read would be visible, which keeps its storage between frames like a video frame.
+struct TestValue {
+	std::uint64_t sequence;
+	std::vector<std::uint64_t> payload;
+	
+	TestValue () : sequence(0) {}
+	
+	void fill (std::uint64_t value, std::size_t size) {
+		sequence = value;
+		payload.assign(size, value);
+	}
+	
+	bool consistent () const {
+		for (std::size_t i = 0; i < payload.size(); i += 1)
+			if (payload[i] != sequence) return false;
+		
+		return true;
+	}
+};
+
+static bool testSequential () {
+	TripleBuffer<TestValue> buffer;
+	bool success = true;
+	
+	if (buffer.acquire() || buffer.frontSequence() != 0) {
+		std::printf("FAILED: Acquired a value before anything was published\n");
+		success = false;
+	}
+	
+	for (std::uint64_t i = 1; i <= 3; i += 1) {
+		buffer.back().fill(i, 4);
+		buffer.publish();
+	}
+	
+	// Only the newest value is kept:
+	if (!buffer.acquire() || buffer.front().sequence != 3 || buffer.frontSequence() != 3 || buffer.droppedCount() != 2) {
+		std::printf("FAILED: After publishing 3 values, acquired %lu with %lu dropped\n", (unsigned long)buffer.frontSequence(), (unsigned long)buffer.droppedCount());
+		success = false;
+	}
+	
+	if (buffer.acquire() || buffer.front().sequence != 3) {
+		std::printf("FAILED: Acquired the same value twice\n");
+		success = false;
+	}
+	
+	buffer.back().fill(4, 4);
+	buffer.publish();
+	
+	if (!buffer.acquire() || buffer.front().sequence != 4 || buffer.droppedCount() != 2) {
+		std::printf("FAILED: Acquiring each value as it is published dropped values\n");
+		success = false;
+	}
+	
+	std::printf("Sequential: the newest value is acquired once, and replaced values are dropped\n");
+	
+	return success;
+}
+
+/// Publish count values, with the producer and consumer each pausing for the given time after every value.
+static bool testConcurrent (const char * name, std::uint64_t count, std::chrono::microseconds producerDelay, std::chrono::microseconds consumerDelay) {
+	const std::size_t PAYLOAD_SIZE = 64;
+	
+	TripleBuffer<TestValue> buffer;
+	std::atomic<bool> finished(false);
+	
+	ClockT::time_point start = ClockT::now();
+	
+	std::thread producer([&]() {
+		for (std::uint64_t i = 1; i <= count; i += 1) {
+			buffer.back().fill(i, PAYLOAD_SIZE);
+			buffer.publish();
+			
+			if (producerDelay.count())
+				std::this_thread::sleep_for(producerDelay);
+		}
+		
+		finished = true;
+	});
+	
+	std::uint64_t acquired = 0, torn = 0, reordered = 0, miscounted = 0, previous = 0;
+	
+	while (true) {
+		// Read the flag first, so that a value published before it was set is still acquired below:
+		bool done = finished;
+		
+		while (buffer.acquire()) {
+			const TestValue & value = buffer.front();
+			acquired += 1;
+			
+			if (value.sequence != buffer.frontSequence() || !value.consistent() || value.payload.size() != PAYLOAD_SIZE)
+				torn += 1;
+			
+			if (value.sequence <= previous)
+				reordered += 1;
+			
+			// Every value before this one was either acquired or dropped:
+			if (buffer.droppedCount() != value.sequence - acquired)
+				miscounted += 1;
+			
+			previous = value.sequence;
+			
+			if (consumerDelay.count())
+				std::this_thread::sleep_for(consumerDelay);
+		}
+		
+		if (done) break;
+		
+		std::this_thread::yield();
+	}
+	
+	producer.join();
+	
+	double duration = elapsed(start);
+	bool success = true;
+	
+	if (torn || reordered || miscounted) {
+		std::printf("FAILED: %s: %lu torn values, %lu out of order, %lu with the wrong dropped count\n", name, (unsigned long)torn, (unsigned long)reordered, (unsigned long)miscounted);
+		success = false;
+	}
+	
+	if (previous != count || acquired + buffer.droppedCount() != count) {
+		std::printf("FAILED: %s: Last acquired %lu of %lu, with %lu acquired and %lu dropped\n", name, (unsigned long)previous, (unsigned long)count, (unsigned long)acquired, (unsigned long)buffer.droppedCount());
+		success = false;
+	}
+	
+	std::printf("%s: %lu values published in %0.1fms, %lu acquired, %lu dropped\n", name, (unsigned long)count, duration * 1000.0, (unsigned long)acquired, (unsigned long)buffer.droppedCount());
+	
+	return success;
+}
+
+int main () {
+	bool success = true;
+	
+	success = testSequential() && success;
+	success = testConcurrent("Unpaced", 200000, std::chrono::microseconds(0), std::chrono::microseconds(0)) && success;
+	success = testConcurrent("Slow consumer", 20000, std::chrono::microseconds(0), std::chrono::microseconds(50)) && success;
+	success = testConcurrent("Slow producer", 2000, std::chrono::microseconds(50), std::chrono::microseconds(0)) && success;
+	
+	return success ? 0 : 1;
+}